@@ -229,6 +229,24 @@ static inline block_t *block_Duplicate( block_t *p_block )
  */
 VLC_API block_t *block_heap_Alloc(void *, size_t) VLC_USED VLC_MALLOC;
 
+/**
+ * References a part of a block.
+ *
+ * Creates a block pointing to a part of the payload of another block, without
+ * copying the data. The memory is released with the last block referencing
+ * it. To that end, the original block may be replaced by an equivalent one
+ * with the same payload, meta-data and successor: *pp is updated then.
+ *
+ * The new block has no meta-data and no room around its payload, so that it
+ * cannot overwrite data outside of the referenced part.
+ *
+ * @param pp pointer to the block to reference [IN/OUT]
+ * @param offset offset of the part within the payload
+ * @param length bytes length of the part
+ * @return the new block, or NULL on memory error (*pp remains valid).
+ */
+VLC_API block_t *block_Slice(block_t **pp, size_t offset, size_t length) VLC_USED;
+
 /**
  * Wraps a memory mapping in a block
  *
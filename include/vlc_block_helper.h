@@ -217,6 +217,69 @@ static inline int block_GetBytes( block_bytestream_t *p_bytestream,
     return VLC_SUCCESS;
 }
 
+/**
+ * Gets bytes as a chain of blocks referencing the byte stream data, instead
+ * of copying it. A single block is returned if the data is contiguous.
+ *
+ * \return the block chain, or NULL if not enough data or on memory error
+ */
+VLC_USED
+static inline block_t *block_GetChain( block_bytestream_t *p_bytestream,
+                                       size_t i_data )
+{
+    if( i_data == 0 || block_BytestreamRemaining( p_bytestream ) < i_data )
+        return NULL;
+
+    block_t *p_chain = NULL, **pp_chain_last = &p_chain;
+    block_t **pp = &p_bytestream->p_chain;
+    size_t i_offset = p_bytestream->i_block_offset;
+    size_t i_base_offset = p_bytestream->i_base_offset;
+    size_t i_size = i_data;
+
+    while( *pp != p_bytestream->p_block )
+        pp = &(*pp)->p_next;
+
+    for( ;; )
+    {
+        block_t *p_block = *pp;
+        size_t i_copy = __MIN( i_size, p_block->i_buffer - i_offset );
+
+        if( i_copy )
+        {
+            block_t *p_slice = block_Slice( pp, i_offset, i_copy );
+            if( unlikely(p_slice == NULL) )
+            {
+                block_ChainRelease( p_chain );
+                return NULL;
+            }
+
+            /* The byte stream block may have been replaced */
+            if( p_bytestream->p_block == p_block )
+                p_bytestream->p_block = *pp;
+            if( p_bytestream->pp_last == &p_block->p_next )
+                p_bytestream->pp_last = &(*pp)->p_next;
+
+            block_ChainLastAppend( &pp_chain_last, p_slice );
+        }
+
+        i_size -= i_copy;
+        if( i_size == 0 )
+        {
+            i_offset += i_copy;
+            break;
+        }
+
+        i_base_offset += (*pp)->i_buffer;
+        i_offset = 0;
+        pp = &(*pp)->p_next;
+    }
+
+    p_bytestream->p_block = *pp;
+    p_bytestream->i_block_offset = i_offset;
+    p_bytestream->i_base_offset = i_base_offset;
+    return p_chain;
+}
+
 static inline int block_SkipBytes( block_bytestream_t *p_bytestream,
                                    size_t i_data )
 {
@@ -26,6 +26,7 @@
 #define VLC_FILTER_H 1
 
 #include <vlc_es.h>
+#include <vlc_picture.h>
 
 /**
  * \defgroup filter Filters
@@ -255,6 +256,52 @@ VLC_API void filter_DelProxyCallbacks( vlc_object_t *obj, filter_t *filter,
 # define filter_DelProxyCallbacks(a, b, c) \
     filter_DelProxyCallbacks(VLC_OBJECT(a), b, c)
 
+typedef void (*filter_slice_cb)( filter_t *, void *opaque,
+                                 unsigned i_first, unsigned i_last );
+
+/**
+ * This function processes the horizontal bands of a picture in parallel.
+ *
+ * The lines [0, i_lines) are split into bands, which are processed by a
+ * pool of threads shared by the video filters (see "filter-threads") and by
+ * the calling thread. pf_slice is called once per band with its first and
+ * last (excluded) lines, possibly from several threads at the same time,
+ * and must only write to the lines of its band. This function returns when
+ * all the bands are processed.
+ *
+ * The band boundaries are multiples of 16 lines, except for the end of the
+ * picture, so that they map to whole lines of subsampled planes.
+ */
+VLC_API void filter_RunSlices( filter_t *, unsigned i_lines,
+                               filter_slice_cb pf_slice, void *opaque );
+
+/**
+ * This function restricts a picture to a band of lines.
+ *
+ * p_band describes the lines [i_first, i_last) of the first plane of p_pic,
+ * and the matching lines of the other planes, out of i_lines. It shares the
+ * pixels of p_pic and must be neither held nor released.
+ */
+static inline void filter_SlicePicture( picture_t *p_band,
+                                        const picture_t *p_pic,
+                                        unsigned i_first, unsigned i_last,
+                                        unsigned i_lines )
+{
+    *p_band = *p_pic;
+    p_band->format.i_height = p_band->format.i_visible_height =
+        i_last - i_first;
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        const plane_t *p = &p_pic->p[i];
+        unsigned i_plane_first = (uint64_t)i_first * p->i_visible_lines / i_lines;
+        unsigned i_plane_last = (uint64_t)i_last * p->i_visible_lines / i_lines;
+
+        p_band->p[i].p_pixels = p->p_pixels + i_plane_first * p->i_pitch;
+        p_band->p[i].i_lines =
+        p_band->p[i].i_visible_lines = i_plane_last - i_plane_first;
+    }
+}
+
 /**
  * It creates a blend filter.
  *
@@ -368,7 +368,9 @@ typedef enum input_item_meta_request_option_t
     META_REQUEST_OPTION_SCOPE_LOCAL   = 0x01,
     META_REQUEST_OPTION_SCOPE_NETWORK = 0x02,
     META_REQUEST_OPTION_SCOPE_ANY     = 0x03,
-    META_REQUEST_OPTION_DO_INTERACT   = 0x04
+    META_REQUEST_OPTION_DO_INTERACT   = 0x04,
+    META_REQUEST_OPTION_PRIORITY      = 0x08, /**< process before the
+                                                   other requests */
 } input_item_meta_request_option_t;
 
 /* status of the vlc_InputItemPreparseEnded event */
@@ -415,6 +417,10 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+
+    /* Block pool (process-wide, see --block-pool) */
+    int64_t i_block_pool_hits;
+    int64_t i_block_pool_misses;
 };
 
 /**
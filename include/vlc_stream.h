@@ -313,6 +313,20 @@ static inline int vlc_stream_Control(stream_t *s, int query, ...)
 }
 
 VLC_API block_t *vlc_stream_Block(stream_t *s, size_t);
+
+/**
+ * Reads data into a chain of blocks.
+ *
+ * This function reads the requested number of bytes like vlc_stream_Block(),
+ * but the data may be returned in several blocks linked through p_next.
+ * The blocks reference the data blocks of the stream back-end whenever
+ * possible, instead of copying them.
+ *
+ * \param size number of bytes to read
+ * \return a chain of blocks (shorter than requested if the end-of-stream is
+ * reached), or NULL on error or at end-of-stream
+ */
+VLC_API block_t *vlc_stream_ReadChain(stream_t *s, size_t size) VLC_USED;
 VLC_API char *vlc_stream_ReadLine(stream_t *);
 
 /**
@@ -801,8 +801,11 @@ static int media_parse(libvlc_media_t *media, bool b_async,
          * by libvlc_MetadataRequest */
         if (parse_flag & libvlc_media_fetch_network)
         {
-            ret = libvlc_ArtRequest(libvlc, item,
-                                    META_REQUEST_OPTION_SCOPE_NETWORK);
+            input_item_meta_request_option_t fetch_scope =
+                META_REQUEST_OPTION_SCOPE_NETWORK;
+            if (parse_flag & libvlc_media_parse_priority)
+                fetch_scope |= META_REQUEST_OPTION_PRIORITY;
+            ret = libvlc_ArtRequest(libvlc, item, fetch_scope);
             if (ret != VLC_SUCCESS)
                 return ret;
         }
@@ -811,6 +814,8 @@ static int media_parse(libvlc_media_t *media, bool b_async,
             parse_scope |= META_REQUEST_OPTION_SCOPE_NETWORK;
         if (parse_flag & libvlc_media_do_interact)
             parse_scope |= META_REQUEST_OPTION_DO_INTERACT;
+        if (parse_flag & libvlc_media_parse_priority)
+            parse_scope |= META_REQUEST_OPTION_PRIORITY;
         ret = libvlc_MetadataRequest(libvlc, item, parse_scope, timeout, media);
         if (ret != VLC_SUCCESS)
             return ret;
@@ -24,30 +24,132 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_access.h>
+#include <vlc_interrupt.h>
+
+#define LOOKAHEAD_MAX 16
 
 struct access_entry
 {
-    struct access_entry *next;
-    char mrl[1];
+    char *mrl;
+    stream_t *stream; /**< opened in advance, or NULL */
+    uint64_t offset; /**< start in the concatenated stream */
+    bool opening;
+    bool failed;
 };
 
 typedef struct
 {
     stream_t *access;
-    struct access_entry *next;
-    struct access_entry *first;
+    struct access_entry *entries;
+    size_t count;
+    size_t next; /**< index of the next entry to read */
     bool can_seek;
     bool can_seek_fast;
     bool can_pause;
     bool can_control_pace;
     uint64_t size;
     int64_t caching;
+
+    unsigned lookahead;
+    vlc_thread_t thread;
+    vlc_interrupt_t *interrupt;
+    vlc_mutex_t lock;
+    vlc_cond_t wait_work;
+    vlc_cond_t wait_open;
+    bool stop;
 } access_sys_t;
 
+/* Opens the next entries in advance, so that no time is lost at the
+ * boundaries between the inputs */
+static void *Thread(void *data)
+{
+    stream_t *access = data;
+    access_sys_t *sys = access->p_sys;
+
+    vlc_interrupt_set(sys->interrupt);
+
+    vlc_mutex_lock(&sys->lock);
+    while (!sys->stop)
+    {
+        size_t end = sys->next + sys->lookahead;
+        size_t i;
+
+        if (end > sys->count)
+            end = sys->count;
+        for (i = sys->next; i < end; i++)
+        {
+            const struct access_entry *e = &sys->entries[i];
+            if (e->stream == NULL && !e->opening && !e->failed)
+                break;
+        }
+
+        if (i >= end)
+        {
+            vlc_cond_wait(&sys->wait_work, &sys->lock);
+            continue;
+        }
+
+        struct access_entry *e = &sys->entries[i];
+
+        e->opening = true;
+        vlc_mutex_unlock(&sys->lock);
+
+        stream_t *a = vlc_access_NewMRL(VLC_OBJECT(access), e->mrl);
+
+        vlc_mutex_lock(&sys->lock);
+        e->opening = false;
+        vlc_cond_broadcast(&sys->wait_open);
+
+        if (a == NULL)
+            e->failed = true;
+        else if (i < sys->next || i >= sys->next + sys->lookahead)
+        {   /* Seeked away in the meantime */
+            vlc_mutex_unlock(&sys->lock);
+            vlc_stream_Delete(a);
+            vlc_mutex_lock(&sys->lock);
+        }
+        else
+            e->stream = a;
+    }
+    vlc_mutex_unlock(&sys->lock);
+    return NULL;
+}
+
+/* Moves the read position to the given entry */
+static void SetNext(stream_t *access, size_t next)
+{
+    access_sys_t *sys = access->p_sys;
+    stream_t *drop[LOOKAHEAD_MAX + 1];
+    size_t dropped = 0;
+
+    vlc_mutex_lock(&sys->lock);
+    for (size_t i = sys->next;
+         i < sys->count && i < sys->next + sys->lookahead + 1; i++)
+    {
+        struct access_entry *e = &sys->entries[i];
+
+        if (e->stream != NULL
+         && (i < next || i >= next + __MAX(sys->lookahead, 1)))
+        {
+            drop[dropped++] = e->stream;
+            e->stream = NULL;
+        }
+    }
+    for (size_t i = next; i < sys->count && i < next + sys->lookahead; i++)
+        sys->entries[i].failed = false;
+    sys->next = next;
+    vlc_cond_signal(&sys->wait_work);
+    vlc_mutex_unlock(&sys->lock);
+
+    while (dropped > 0)
+        vlc_stream_Delete(drop[--dropped]);
+}
+
 static stream_t *GetAccess(stream_t *access)
 {
     access_sys_t *sys = access->p_sys;
@@ -62,43 +164,102 @@ static stream_t *GetAccess(stream_t *access)
         sys->access = NULL;
     }
 
-    if (sys->next == NULL)
+    if (sys->next >= sys->count)
         return NULL;
 
-    a = vlc_access_NewMRL(VLC_OBJECT(access), sys->next->mrl);
+    struct access_entry *e = &sys->entries[sys->next];
+
+    vlc_mutex_lock(&sys->lock);
+    while (e->opening)
+        vlc_cond_wait(&sys->wait_open, &sys->lock);
+    a = e->stream;
+    e->stream = NULL;
+    e->failed = false;
+    vlc_mutex_unlock(&sys->lock);
+
     if (a == NULL)
-        return NULL;
+    {
+        a = vlc_access_NewMRL(VLC_OBJECT(access), e->mrl);
+        if (a == NULL)
+            return NULL;
+    }
 
     sys->access = a;
-    sys->next = sys->next->next;
+    SetNext(access, sys->next + 1);
     return a;
 }
 
 static ssize_t Read(stream_t *access, void *buf, size_t len)
 {
-    stream_t *a = GetAccess(access);
-    if (a == NULL)
-        return 0;
+    for (;;)
+    {
+        stream_t *a = GetAccess(access);
+        if (a == NULL)
+            return 0;
+
+        /* NOTE: Since we recreate the underlying access, the access method
+         * can change. We need to check it. For instance, a path could point
+         * to a regular file during Open() yet point to a directory here and
+         * now. */
+        if (unlikely(a->pf_read == NULL))
+            return 0;
+
+        ssize_t val = vlc_stream_ReadPartial(a, buf, len);
+        /* Continue with the next input at the end of this one */
+        if (val != 0 || len == 0 || !vlc_stream_Eof(a))
+            return val;
+    }
+}
 
-    /* NOTE: Since we recreate the underlying access, the access method can
-     * change. We need to check it. For instance, a path could point to a
-     * regular file during Open() yet point to a directory here and now. */
-    if (unlikely(a->pf_read == NULL))
-        return 0;
+static block_t *Block(stream_t *access, bool *restrict eof)
+{
+    for (;;)
+    {
+        stream_t *a = GetAccess(access);
+        if (a == NULL)
+        {
+            *eof = true;
+            return NULL;
+        }
 
-    return vlc_stream_ReadPartial(a, buf, len);
+        block_t *block = vlc_stream_ReadBlock(a);
+        if (block != NULL || !vlc_stream_Eof(a))
+            return block;
+    }
 }
 
-static block_t *Block(stream_t *access, bool *restrict eof)
+/* Finds the last entry starting at or before the position */
+static size_t FindEntry(const access_sys_t *sys, uint64_t position)
 {
-    stream_t *a = GetAccess(access);
-    if (a == NULL)
+    size_t lo = 0, hi = sys->count;
+
+    while (hi - lo > 1)
     {
-        *eof = true;
-        return NULL;
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (sys->entries[mid].offset <= position)
+            lo = mid;
+        else
+            hi = mid;
     }
+    return lo;
+}
 
-    return vlc_stream_ReadBlock(a);
+static int SeekEntry(stream_t *access, size_t index, uint64_t offset)
+{
+    SetNext(access, index);
+
+    stream_t *a = GetAccess(access);
+    if (a == NULL)
+        return VLC_EGENERIC;
+
+    bool can_seek;
+    vlc_stream_Control(a, STREAM_CAN_SEEK, &can_seek);
+    if (!can_seek)
+        return VLC_EGENERIC;
+    if (offset == 0)
+        return VLC_SUCCESS;
+    return vlc_stream_Seek(a, offset) ? VLC_EGENERIC : VLC_SUCCESS;
 }
 
 static int Seek(stream_t *access, uint64_t position)
@@ -111,7 +272,18 @@ static int Seek(stream_t *access, uint64_t position)
         sys->access = NULL;
     }
 
-    sys->next = sys->first;
+    if (sys->count == 0)
+        return VLC_EGENERIC;
+
+    if (sys->size != UINT64_MAX)
+    {   /* The offsets of all the entries are known */
+        size_t index = FindEntry(sys, position);
+
+        return SeekEntry(access, index,
+                         position - sys->entries[index].offset);
+    }
+
+    SetNext(access, 0);
 
     for (uint64_t offset = 0;;)
     {
@@ -180,6 +352,19 @@ static int Control(stream_t *access, int query, va_list args)
     return VLC_SUCCESS;
 }
 
+static void ReleaseEntries(access_sys_t *sys)
+{
+    for (size_t i = 0; i < sys->count; i++)
+    {
+        struct access_entry *e = &sys->entries[i];
+
+        if (e->stream != NULL)
+            vlc_stream_Delete(e->stream);
+        free(e->mrl);
+    }
+    free(sys->entries);
+}
+
 static int Open(vlc_object_t *obj)
 {
     stream_t *access = (stream_t *)obj;
@@ -200,29 +385,46 @@ static int Open(vlc_object_t *obj)
     bool read_cb = true;
 
     sys->access = NULL;
+    sys->entries = NULL;
+    sys->count = 0;
+    sys->next = 0;
     sys->can_seek = true;
     sys->can_seek_fast = true;
     sys->can_pause = true;
     sys->can_control_pace = true;
     sys->size = 0;
     sys->caching = 0;
+    sys->lookahead = var_InheritInteger(access, "concat-lookahead");
+    if (sys->lookahead > LOOKAHEAD_MAX)
+        sys->lookahead = LOOKAHEAD_MAX;
+    sys->stop = false;
 
-    struct access_entry **pp = &sys->first;
+    size_t allocated = 0;
 
     for (char *buf, *mrl = strtok_r(list, ",", &buf);
          mrl != NULL;
          mrl = strtok_r(NULL, ",", &buf))
     {
-        size_t mlen = strlen(mrl);
-        struct access_entry *e = malloc(sizeof (*e) + mlen);
-        if (unlikely(e == NULL))
+        if (sys->count == allocated)
+        {
+            size_t n = allocated ? 2 * allocated : 16;
+            struct access_entry *tab = realloc(sys->entries,
+                                               n * sizeof (*tab));
+            if (unlikely(tab == NULL))
+                break;
+            sys->entries = tab;
+            allocated = n;
+        }
+
+        char *dup = strdup(mrl);
+        if (unlikely(dup == NULL))
             break;
 
         stream_t *a = vlc_access_NewMRL(obj, mrl);
         if (a == NULL)
         {
             msg_Err(access, "cannot concatenate location %s", mrl);
-            free(e);
+            free(dup);
             continue;
         }
 
@@ -232,15 +434,19 @@ static int Open(vlc_object_t *obj)
             {
                 msg_Err(access, "cannot concatenate directory %s", mrl);
                 vlc_stream_Delete(a);
-                free(e);
+                free(dup);
                 continue;
             }
             read_cb = false;
         }
 
-        *pp = e;
-        e->next = NULL;
-        memcpy(e->mrl, mrl, mlen + 1);
+        struct access_entry *e = &sys->entries[sys->count];
+
+        e->mrl = dup;
+        e->stream = NULL;
+        e->offset = sys->size;
+        e->opening = false;
+        e->failed = false;
 
         if (sys->can_seek)
             vlc_stream_Control(a, STREAM_CAN_SEEK, &sys->can_seek);
@@ -266,19 +472,40 @@ static int Open(vlc_object_t *obj)
         if (caching > sys->caching)
             sys->caching = caching;
 
-        vlc_stream_Delete(a);
-        pp = &e->next;
+        /* Keep the first inputs open, they are read next */
+        if (sys->count < __MAX(sys->lookahead, 1))
+            e->stream = a;
+        else
+            vlc_stream_Delete(a);
+        sys->count++;
     }
 
     free(list);
-    *pp = NULL;
-    sys->next = sys->first;
+
+    vlc_mutex_init(&sys->lock);
+    vlc_cond_init(&sys->wait_work);
+    vlc_cond_init(&sys->wait_open);
+    access->p_sys = sys;
+
+    if (sys->lookahead > 0 && sys->count > 1)
+    {
+        sys->interrupt = vlc_interrupt_create();
+        if (unlikely(sys->interrupt == NULL)
+         || vlc_clone(&sys->thread, Thread, access, VLC_THREAD_PRIORITY_LOW))
+        {
+            if (sys->interrupt != NULL)
+                vlc_interrupt_destroy(sys->interrupt);
+            msg_Warn(access, "cannot open inputs in advance");
+            sys->lookahead = 0;
+        }
+    }
+    else
+        sys->lookahead = 0;
 
     access->pf_read = read_cb ? Read : NULL;
     access->pf_block = read_cb ? NULL : Block;
     access->pf_seek = Seek;
     access->pf_control = Control;
-    access->p_sys = sys;
 
     return VLC_SUCCESS;
 }
@@ -288,14 +515,24 @@ static void Close(vlc_object_t *obj)
     stream_t *access = (stream_t *)obj;
     access_sys_t *sys = access->p_sys;
 
+    if (sys->lookahead > 0)
+    {
+        vlc_mutex_lock(&sys->lock);
+        sys->stop = true;
+        vlc_cond_signal(&sys->wait_work);
+        vlc_mutex_unlock(&sys->lock);
+        vlc_interrupt_kill(sys->interrupt);
+        vlc_join(sys->thread, NULL);
+        vlc_interrupt_destroy(sys->interrupt);
+    }
+
     if (sys->access != NULL)
         vlc_stream_Delete(sys->access);
 
-    for (struct access_entry *e = sys->first, *next; e != NULL; e = next)
-    {
-        next = e->next;
-        free(e);
-    }
+    ReleaseEntries(sys);
+    vlc_cond_destroy(&sys->wait_open);
+    vlc_cond_destroy(&sys->wait_work);
+    vlc_mutex_destroy(&sys->lock);
 
     var_Destroy(access, "concat-list");
 }
@@ -303,6 +540,10 @@ static void Close(vlc_object_t *obj)
 #define INPUT_LIST_TEXT N_("Inputs list")
 #define INPUT_LIST_LONGTEXT N_( \
     "Comma-separated list of input URLs to concatenate.")
+#define LOOKAHEAD_TEXT N_("Inputs opened in advance")
+#define LOOKAHEAD_LONGTEXT N_( \
+    "Number of the next inputs to open in the background while reading, " \
+    "to avoid stalls at the boundaries between the inputs.")
 
 vlc_module_begin()
     set_shortname(N_("Concatenation"))
@@ -310,6 +551,8 @@ vlc_module_begin()
     set_category(CAT_INPUT)
     set_subcategory(SUBCAT_INPUT_ACCESS)
     add_string("concat-list", NULL, INPUT_LIST_TEXT, INPUT_LIST_LONGTEXT, true)
+    add_integer_with_range("concat-lookahead", 2, 0, LOOKAHEAD_MAX,
+                           LOOKAHEAD_TEXT, LOOKAHEAD_LONGTEXT, true)
     set_capability("access", 0)
     set_callbacks(Open, Close)
     add_shortcut("concast", "list")
@@ -51,12 +51,16 @@
 #else
 #   include <unistd.h>
 #endif
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 #include <dirent.h>
 
 #include <vlc_common.h>
 #include "fs.h"
 #include <vlc_input.h>
 #include <vlc_access.h>
+#include <vlc_block.h>
 #ifdef _WIN32
 # include <vlc_charset.h>
 #endif
@@ -69,8 +73,15 @@ typedef struct
     int fd;
 
     bool b_pace_control;
+
+    /* memory-mapped reading */
+    uint64_t i_pos;
+    uint64_t i_size;
 } access_sys_t;
 
+/* Size of the file windows mapped by the block reading mode */
+#define MMAP_WINDOW (8 << 20)
+
 #if !defined (_WIN32) && !defined (__OS2__)
 static bool IsRemote (int fd)
 {
@@ -126,8 +137,15 @@ static bool IsRemote (const char *path)
 #ifndef HAVE_POSIX_FADVISE
 # define posix_fadvise(fd, off, len, adv)
 #endif
+#ifndef HAVE_POSIX_MADVISE
+# define posix_madvise(addr, len, adv)
+#endif
 
 static ssize_t Read (stream_t *, void *, size_t);
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (stream_t *, bool *);
+static int MmapSeek (stream_t *, uint64_t);
+#endif
 static int FileSeek (stream_t *, uint64_t);
 static int NoSeek (stream_t *, uint64_t);
 static int FileControl (stream_t *, int, va_list);
@@ -231,6 +249,20 @@ int FileOpen( vlc_object_t *p_this )
             fcntl (fd, F_RDAHEAD, 0);
         else
             fcntl (fd, F_RDAHEAD, 1);
+#endif
+#ifdef HAVE_MMAP
+        /* Hand windows of the mapped file as blocks, so that the demuxers
+         * can take their data without copying it. A file truncated or
+         * failing while mapped would kill the process: local files only. */
+        if (S_ISREG (st.st_mode) && var_InheritBool (p_access, "file-mmap")
+         && !IsRemote(fd, p_access->psz_filepath))
+        {
+            p_access->pf_read = NULL;
+            p_access->pf_block = MmapBlock;
+            p_access->pf_seek = MmapSeek;
+            p_sys->i_pos = 0;
+            p_sys->i_size = st.st_size;
+        }
 #endif
     }
     else
@@ -253,7 +285,7 @@ void FileClose (vlc_object_t * p_this)
 {
     stream_t     *p_access = (stream_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_read == NULL && p_access->pf_block == NULL)
     {
         DirClose (p_this);
         return;
@@ -287,6 +319,63 @@ static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
     return val;
 }
 
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if (p_sys->i_pos >= p_sys->i_size)
+    {   /* The file may have grown */
+        struct stat st;
+
+        if (fstat (p_sys->fd, &st) == 0)
+            p_sys->i_size = st.st_size;
+        if (p_sys->i_pos >= p_sys->i_size)
+        {
+            *eof = true;
+            return NULL;
+        }
+    }
+
+    uint64_t i_offset = p_sys->i_pos & ~(uint64_t)(sysconf (_SC_PAGESIZE) - 1);
+    size_t i_skip = p_sys->i_pos - i_offset;
+    size_t i_length = __MIN(p_sys->i_size - i_offset, MMAP_WINDOW);
+
+    /* Private writable mapping: the demuxers and decoders may modify the
+     * data in place, without affecting the file. */
+    void *p_addr = mmap (NULL, i_length, PROT_READ|PROT_WRITE, MAP_PRIVATE,
+                         p_sys->fd, i_offset);
+    if (p_addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "cannot map file: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    posix_madvise (p_addr, i_length, POSIX_MADV_SEQUENTIAL);
+    /* Start reading the next window while this one is consumed */
+    posix_fadvise (p_sys->fd, i_offset + i_length, MMAP_WINDOW,
+                   POSIX_FADV_WILLNEED);
+
+    block_t *p_block = block_mmap_Alloc (p_addr, i_length);
+    if (unlikely(p_block == NULL))
+        return NULL;
+
+    p_block->p_buffer += i_skip;
+    p_block->i_buffer -= i_skip;
+    p_sys->i_pos += p_block->i_buffer;
+    return p_block;
+}
+
+static int MmapSeek (stream_t *p_access, uint64_t i_pos)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    p_sys->i_pos = i_pos;
+    return VLC_SUCCESS;
+}
+#endif
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
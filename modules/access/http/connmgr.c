@@ -98,6 +98,10 @@ struct vlc_http_mgr
     vlc_tls_creds_t *creds;
     struct vlc_http_cookie_jar_t *jar;
     struct vlc_http_conn *conn;
+    bool multiplexed; /* conn is an HTTP/2 connection */
+    /* Protects creds, conn and multiplexed. It is not held while connecting or waiting for
+     * a response, so that requests from several threads can overlap. */
+    vlc_mutex_t lock;
 };
 
 static struct vlc_http_conn *vlc_http_mgr_find(struct vlc_http_mgr *mgr,
@@ -107,13 +111,14 @@ static struct vlc_http_conn *vlc_http_mgr_find(struct vlc_http_mgr *mgr,
     return mgr->conn;
 }
 
-static void vlc_http_mgr_release(struct vlc_http_mgr *mgr,
-                                 struct vlc_http_conn *conn)
+/** Detaches the connection from the locked manager, to be released
+ * without the lock. */
+static struct vlc_http_conn *vlc_http_mgr_detach(struct vlc_http_mgr *mgr)
 {
-    assert(mgr->conn == conn);
-    mgr->conn = NULL;
+    struct vlc_http_conn *conn = mgr->conn;
 
-    vlc_http_conn_release(conn);
+    mgr->conn = NULL;
+    return conn;
 }
 
 static
@@ -121,43 +126,79 @@ struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
                                         const char *host, unsigned port,
                                         const struct vlc_http_msg *req)
 {
+    struct vlc_http_stream *stream = NULL;
+    struct vlc_http_conn *old = NULL;
+
+    vlc_mutex_lock(&mgr->lock);
     struct vlc_http_conn *conn = vlc_http_mgr_find(mgr, host, port);
-    if (conn == NULL)
-        return NULL;
+    if (conn != NULL)
+    {
+        stream = vlc_http_stream_open(conn, req);
+        if (stream == NULL) /* Get rid of closing or reset connection */
+            old = vlc_http_mgr_detach(mgr);
+    }
+    vlc_mutex_unlock(&mgr->lock);
 
-    struct vlc_http_stream *stream = vlc_http_stream_open(conn, req);
-    if (stream != NULL)
+    if (stream == NULL)
     {
-        struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
-        if (m != NULL)
-            return m;
-
-        /* NOTE: If the request were not idempotent, we would not know if it
-         * was processed by the other end. Thus POST is not used/supported so
-         * far, and CONNECT is treated as if it were idempotent (which works
-         * fine here). */
+        if (old != NULL)
+            vlc_http_conn_release(old);
+        return NULL;
     }
-    /* Get rid of closing or reset connection */
-    vlc_http_mgr_release(mgr, conn);
+
+    /* The connection is not destroyed before the stream is closed, so the
+     * response is waited for without the lock. */
+    struct vlc_http_msg *m = vlc_http_stream_read_headers(stream);
+    if (m != NULL)
+        return m;
+
+    /* NOTE: If the request were not idempotent, we would not know if it
+     * was processed by the other end. Thus POST is not used/supported so
+     * far, and CONNECT is treated as if it were idempotent (which works
+     * fine here). */
+    vlc_mutex_lock(&mgr->lock);
+    if (mgr->conn == conn)
+        old = vlc_http_mgr_detach(mgr);
+    vlc_mutex_unlock(&mgr->lock);
+
+    vlc_http_stream_close(stream, false);
+    if (old != NULL)
+        vlc_http_conn_release(old);
     return NULL;
 }
 
+/** Makes a new connection the one of the manager. */
+static void vlc_http_mgr_set(struct vlc_http_mgr *mgr,
+                             struct vlc_http_conn *conn, bool multiplexed)
+{
+    vlc_mutex_lock(&mgr->lock);
+    /* Another thread may have connected meanwhile */
+    struct vlc_http_conn *old = vlc_http_mgr_detach(mgr);
+    mgr->conn = conn;
+    mgr->multiplexed = multiplexed;
+    vlc_mutex_unlock(&mgr->lock);
+
+    if (old != NULL)
+        vlc_http_conn_release(old);
+}
+
 static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
                                               const char *host, unsigned port,
                                               const struct vlc_http_msg *req)
 {
     vlc_tls_t *tls;
+    vlc_tls_creds_t *creds;
     bool http2 = true;
 
-    if (mgr->creds == NULL && mgr->conn != NULL)
-        return NULL; /* switch from HTTP to HTTPS not implemented */
-
-    if (mgr->creds == NULL)
-    {   /* First TLS connection: load x509 credentials */
+    vlc_mutex_lock(&mgr->lock);
+    if (mgr->creds == NULL && mgr->conn == NULL)
+        /* First TLS connection: load x509 credentials */
         mgr->creds = vlc_tls_ClientCreate(mgr->obj);
-        if (mgr->creds == NULL)
-            return NULL;
-    }
+    creds = mgr->creds;
+    vlc_mutex_unlock(&mgr->lock);
+
+    if (creds == NULL)
+        return NULL; /* or switch from HTTP to HTTPS, not implemented */
 
     /* TODO? non-idempotent request support */
     struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
@@ -167,12 +208,12 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
     char *proxy = vlc_http_proxy_find(host, port, true);
     if (proxy != NULL)
     {
-        tls = vlc_https_connect_proxy(mgr->creds, mgr->creds,
-                                      host, port, &http2, proxy);
+        tls = vlc_https_connect_proxy(creds, creds, host, port, &http2,
+                                      proxy);
         free(proxy);
     }
     else
-        tls = vlc_https_connect(mgr->creds, host, port, &http2);
+        tls = vlc_https_connect(creds, host, port, &http2);
 
     if (tls == NULL)
         return NULL;
@@ -197,7 +238,7 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    mgr->conn = conn;
+    vlc_http_mgr_set(mgr, conn, http2);
 
     return vlc_http_mgr_reuse(mgr, host, port, req);
 }
@@ -206,7 +247,10 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
                                              const char *host, unsigned port,
                                              const struct vlc_http_msg *req)
 {
-    if (mgr->creds != NULL && mgr->conn != NULL)
+    vlc_mutex_lock(&mgr->lock);
+    bool secure = mgr->creds != NULL && mgr->conn != NULL;
+    vlc_mutex_unlock(&mgr->lock);
+    if (secure)
         return NULL; /* switch from HTTPS to HTTP not implemented */
 
     struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
@@ -247,7 +291,7 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    mgr->conn = conn;
+    vlc_http_mgr_set(mgr, conn, false);
     return resp;
 }
 
@@ -263,6 +307,14 @@ struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *mgr)
     return mgr->jar;
 }
 
+bool vlc_http_mgr_is_multiplexed(struct vlc_http_mgr *mgr)
+{
+    vlc_mutex_lock(&mgr->lock);
+    bool multiplexed = mgr->conn != NULL && mgr->multiplexed;
+    vlc_mutex_unlock(&mgr->lock);
+    return multiplexed;
+}
+
 struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
                                          struct vlc_http_cookie_jar_t *jar)
 {
@@ -274,14 +326,17 @@ struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
     mgr->creds = NULL;
     mgr->jar = jar;
     mgr->conn = NULL;
+    mgr->multiplexed = false;
+    vlc_mutex_init(&mgr->lock);
     return mgr;
 }
 
 void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
 {
     if (mgr->conn != NULL)
-        vlc_http_mgr_release(mgr, mgr->conn);
+        vlc_http_conn_release(mgr->conn);
     if (mgr->creds != NULL)
         vlc_tls_Delete(mgr->creds);
+    vlc_mutex_destroy(&mgr->lock);
     free(mgr);
 }
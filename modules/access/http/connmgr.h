@@ -54,6 +54,14 @@ struct vlc_http_msg *vlc_http_mgr_request(struct vlc_http_mgr *mgr, bool https,
 
 struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *);
 
+/**
+ * Checks whether requests are multiplexed
+ *
+ * @return true if the current connection of the manager is HTTP/2, i.e.
+ *         concurrent requests share it, false otherwise
+ */
+bool vlc_http_mgr_is_multiplexed(struct vlc_http_mgr *mgr);
+
 /**
  * Creates an HTTP connection manager
  *
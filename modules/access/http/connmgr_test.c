@@ -0,0 +1,317 @@
+/*****************************************************************************
+ * connmgr_test.c: HTTP connection manager tests
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_network.h>
+#include <vlc_tls.h>
+
+/* The "TLS" sessions are local socket pairs. The ALPN is chosen by the test,
+ * and each connection is served by a thread. */
+static vlc_tls_t *test_tls_open(const char *name, unsigned port,
+                                const char *const *alpn, char **alp);
+
+#define vlc_tls_ClientCreate(obj) ((void)(obj), (vlc_tls_creds_t *)&test_creds)
+#define vlc_tls_Delete(crd) assert((crd) == (vlc_tls_creds_t *)&test_creds)
+#define vlc_tls_SocketOpenTLS(crd, name, port, service, alpn, alp) \
+    ((void)(crd), test_tls_open(name, port, alpn, alp))
+#define vlc_getProxyUrl(url) ((void)(url), (char *)NULL)
+
+static char test_creds;
+
+#include "connmgr.c"
+#include "h2frame.h"
+
+#undef NDEBUG /* config.h was included again */
+#include <assert.h>
+
+static vlc_mutex_t lock = VLC_STATIC_MUTEX;
+static const char *server_alpn;
+static unsigned connections;
+static unsigned h2_streams; /* HTTP/2 streams answered all at once */
+
+#define MAX_CONNECTIONS 8
+static vlc_thread_t server_threads[MAX_CONNECTIONS];
+
+static void server_send(vlc_tls_t *tls, const void *buf, size_t len)
+{
+    ssize_t val = vlc_tls_Write(tls, buf, len);
+    assert((size_t)val == len);
+}
+
+static void server_send_frame(vlc_tls_t *tls, struct vlc_h2_frame *f)
+{
+    assert(f != NULL);
+    server_send(tls, f->data, vlc_h2_frame_size(f));
+    free(f);
+}
+
+static void server_h2(vlc_tls_t *tls)
+{
+    uint_fast32_t ids[4];
+    unsigned count = 0;
+    char hello[24];
+
+    if (vlc_tls_Read(tls, hello, 24, true) != 24)
+        return;
+    assert(!memcmp(hello, "PRI * HTTP/2.0\r\n", 16));
+    server_send_frame(tls, vlc_h2_frame_settings());
+
+    for (;;)
+    {
+        uint8_t hdr[9];
+
+        if (vlc_tls_Read(tls, hdr, 9, true) != 9)
+            break;
+
+        size_t len = (hdr[0] << 16) | (hdr[1] << 8) | hdr[2];
+        if (len > 0)
+        {
+            char buf[len];
+
+            if (vlc_tls_Read(tls, buf, len, true) != (ssize_t)len)
+                break;
+        }
+
+        if (hdr[3] != 1 /* HEADERS */)
+            continue;
+
+        /* Answer only once the expected streams are all open, in reverse
+         * order: the requests must be in flight at the same time. */
+        ids[count++] = ((hdr[5] & 0x7f) << 24) | (hdr[6] << 16)
+                     | (hdr[7] << 8) | hdr[8];
+
+        vlc_mutex_lock(&lock);
+        unsigned expected = h2_streams;
+        vlc_mutex_unlock(&lock);
+        assert(count <= expected && expected <= ARRAY_SIZE(ids));
+
+        if (count < expected)
+            continue;
+
+        while (count > 0)
+        {
+            uint_fast32_t id = ids[--count];
+            struct vlc_http_msg *m = vlc_http_resp_create(200);
+
+            assert(m != NULL);
+            server_send_frame(tls, vlc_http_msg_h2_frame(m, id, false));
+            vlc_http_msg_destroy(m);
+            server_send_frame(tls, vlc_h2_frame_data(id, "Hello", 5, true));
+        }
+    }
+}
+
+static void server_h1(vlc_tls_t *tls)
+{
+    static const char resp[] =
+        "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nHello";
+
+    for (;;)
+    {
+        char buf[4] = "";
+
+        /* Read the request header up to the empty line */
+        while (memcmp(buf, "\r\n\r\n", 4))
+        {
+            memmove(buf, buf + 1, 3);
+            if (vlc_tls_Read(tls, buf + 3, 1, true) != 1)
+                return;
+        }
+        server_send(tls, resp, strlen(resp));
+    }
+}
+
+static void *server_thread(void *data)
+{
+    vlc_tls_t *tls = data;
+
+    if (!strcmp(server_alpn, "h2"))
+        server_h2(tls);
+    else
+        server_h1(tls);
+    vlc_tls_Close(tls);
+    return NULL;
+}
+
+static vlc_tls_t *test_tls_open(const char *name, unsigned port,
+                                const char *const *alpn, char **alp)
+{
+    vlc_tls_t *tlsv[2];
+
+    assert(!strcmp(name, "www.example.com"));
+    assert(port == 443);
+    assert(!strcmp(alpn[0], "h2"));
+
+    if (vlc_tls_SocketPair(PF_LOCAL, 0, tlsv))
+        assert(!"vlc_tls_SocketPair");
+
+    vlc_mutex_lock(&lock);
+    assert(connections < MAX_CONNECTIONS);
+    if (vlc_clone(&server_threads[connections], server_thread, tlsv[0],
+                  VLC_THREAD_PRIORITY_LOW))
+        assert(!"vlc_clone");
+    connections++;
+    vlc_mutex_unlock(&lock);
+
+    *alp = strdup(server_alpn);
+    assert(*alp != NULL);
+    return tlsv[1];
+}
+
+static struct vlc_http_msg *request(struct vlc_http_mgr *mgr)
+{
+    struct vlc_http_msg *req = vlc_http_req_create("GET", "https",
+                                                   "www.example.com", "/");
+    assert(req != NULL);
+
+    struct vlc_http_msg *resp = vlc_http_mgr_request(mgr, true,
+                                                     "www.example.com", 0,
+                                                     req);
+    vlc_http_msg_destroy(req);
+    assert(resp != NULL);
+    assert(vlc_http_msg_get_status(resp) == 200);
+    return resp;
+}
+
+static void response_check(struct vlc_http_msg *resp)
+{
+    char buf[16];
+    size_t len = 0;
+    block_t *b;
+
+    while ((b = vlc_http_msg_read(resp)) != NULL)
+    {
+        assert(b != vlc_http_error);
+        assert(len + b->i_buffer <= sizeof (buf));
+        memcpy(buf + len, b->p_buffer, b->i_buffer);
+        len += b->i_buffer;
+        block_Release(b);
+    }
+    assert(len == 5 && !memcmp(buf, "Hello", 5));
+    vlc_http_msg_destroy(resp);
+}
+
+static void *request_thread(void *data)
+{
+    response_check(request(data));
+    return NULL;
+}
+
+static void *close_thread(void *data)
+{
+    response_check(data);
+    return NULL;
+}
+
+static void test_start(const char *alpn)
+{
+    server_alpn = alpn;
+    connections = 0;
+}
+
+static void test_end(struct vlc_http_mgr *mgr)
+{
+    vlc_http_mgr_destroy(mgr);
+    for (unsigned i = 0; i < connections; i++)
+        vlc_join(server_threads[i], NULL);
+}
+
+static void test_h2(void)
+{
+    struct vlc_http_mgr *mgr = vlc_http_mgr_create(NULL, NULL);
+    vlc_thread_t th[2];
+
+    test_start("h2");
+    assert(mgr != NULL);
+    assert(!vlc_http_mgr_is_multiplexed(mgr));
+
+    h2_streams = 1;
+    response_check(request(mgr));
+    assert(vlc_http_mgr_is_multiplexed(mgr));
+
+    /* Concurrent requests are multiplexed on the same connection: the
+     * server does not answer before both streams are open */
+    vlc_mutex_lock(&lock);
+    h2_streams = 2;
+    vlc_mutex_unlock(&lock);
+    for (unsigned i = 0; i < 2; i++)
+        assert(!vlc_clone(&th[i], request_thread, mgr,
+                          VLC_THREAD_PRIORITY_LOW));
+    for (unsigned i = 0; i < 2; i++)
+        vlc_join(th[i], NULL);
+    assert(connections == 1);
+
+    test_end(mgr);
+}
+
+static void test_h1(void)
+{
+    struct vlc_http_mgr *mgr = vlc_http_mgr_create(NULL, NULL);
+    struct vlc_http_msg *m;
+    vlc_thread_t th;
+
+    test_start("http/1.1");
+    assert(mgr != NULL);
+
+    /* Sequential requests reuse the connection */
+    response_check(request(mgr));
+    response_check(request(mgr));
+    assert(connections == 1);
+    assert(!vlc_http_mgr_is_multiplexed(mgr));
+
+    /* The connection is busy with an unread response: the manager opens a
+     * new one and releases the busy one, which lives until its stream is
+     * closed. */
+    m = request(mgr);
+    response_check(request(mgr));
+    assert(connections == 2);
+    response_check(m);
+
+    /* The stream is closed by another thread than the one requesting */
+    m = request(mgr);
+    assert(!vlc_clone(&th, close_thread, m, VLC_THREAD_PRIORITY_LOW));
+    response_check(request(mgr));
+    vlc_join(th, NULL);
+
+    test_end(mgr);
+}
+
+int main(void)
+{
+    test_h2();
+    test_h1();
+    return 0;
+}
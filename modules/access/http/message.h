@@ -400,7 +400,7 @@ static inline void vlc_http_stream_close(struct vlc_http_stream *s, bool abort)
  * @return A heap-allocated nul-terminated string or *lenp bytes,
  *         or NULL on error
  */
-char *vlc_http_msg_format(const struct vlc_http_msg *m, size_t *restrict lenp,
+char *vlc_http_msg_format(const struct vlc_http_msg *m, size_t *lenp,
                           bool proxied) VLC_USED;
 
 /**
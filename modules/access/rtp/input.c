@@ -100,6 +100,206 @@ static int rtp_timeout (mtime_t deadline)
     return t;
 }
 
+#ifdef HAVE_RECVMMSG
+#define RTP_BATCH_MAX 64
+
+struct rtp_batch
+{
+    unsigned size;
+    size_t mru;
+    block_t *blocks[RTP_BATCH_MAX];
+};
+
+static void rtp_batch_cleanup (void *data)
+{
+    struct rtp_batch *batch = data;
+
+    for (unsigned i = 0; i < batch->size; i++)
+        if (batch->blocks[i] != NULL)
+            block_Release (batch->blocks[i]);
+}
+
+/**
+ * Converts the kernel reception time stamp of a datagram, if any,
+ * to the mdate() time line.
+ */
+static mtime_t rtp_rx_time (struct msghdr *msg, mtime_t now,
+                            const struct timespec *wall)
+{
+#ifdef SO_TIMESTAMPNS
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR (msg);
+         cmsg != NULL;
+         cmsg = CMSG_NXTHDR (msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET
+         || cmsg->cmsg_type != SCM_TIMESTAMPNS)
+            continue;
+
+        struct timespec ts;
+        memcpy (&ts, CMSG_DATA (cmsg), sizeof (ts));
+
+        /* The stamp is on the wall clock: only its age is meaningful */
+        mtime_t age = (wall->tv_sec - ts.tv_sec) * CLOCK_FREQ
+                    + (wall->tv_nsec - ts.tv_nsec) / (1000000000 / CLOCK_FREQ);
+        if (age > 0 && age < CLOCK_FREQ) /* ignore wall clock steps */
+            now -= age;
+        break;
+    }
+#else
+    VLC_UNUSED (msg); VLC_UNUSED (wall);
+#endif
+    return now;
+}
+
+/**
+ * RTP/RTCP session thread for datagram sockets
+ *
+ * Receives up to sys->batch datagrams per system call into a ring of
+ * pre-allocated blocks. Each packet is stamped with its kernel reception
+ * time, so that the jitter estimate is not skewed by the batching.
+ */
+void *rtp_dgram_thread (void *opaque)
+{
+    demux_t *demux = opaque;
+    demux_sys_t *sys = demux->p_sys;
+    mtime_t deadline = VLC_TS_INVALID;
+    int rtp_fd = sys->fd;
+    struct rtp_batch batch =
+    {
+        .size = __MIN(sys->batch, RTP_BATCH_MAX),
+        .mru = DEFAULT_MRU,
+    };
+    struct mmsghdr msgs[RTP_BATCH_MAX];
+    struct iovec iovs[RTP_BATCH_MAX];
+#ifdef SO_TIMESTAMPNS
+    union
+    {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof (struct timespec))];
+    } cmsgs[RTP_BATCH_MAX];
+
+    if (setsockopt (rtp_fd, SOL_SOCKET, SO_TIMESTAMPNS,
+                    &(int){ 1 }, sizeof (int)))
+        msg_Dbg (demux, "kernel time stamps not available: %s",
+                 vlc_strerror_c(errno));
+#endif
+
+    if (batch.size == 0)
+        batch.size = 1;
+
+    for (unsigned i = 0; i < batch.size; i++)
+        batch.blocks[i] = NULL;
+
+    struct pollfd ufd[1];
+    ufd[0].fd = rtp_fd;
+    ufd[0].events = POLLIN;
+
+    vlc_cleanup_push (rtp_batch_cleanup, &batch);
+    for (;;)
+    {
+        int n = poll (ufd, 1, rtp_timeout (deadline));
+        if (n == -1)
+            continue;
+
+        int canc = vlc_savecancel ();
+        if (n == 0)
+            goto dequeue;
+
+        if (ufd[0].revents)
+        {
+            if (unlikely(ufd[0].revents & POLLHUP))
+            {
+                vlc_restorecancel (canc);
+                break; /* RTP socket dead (DCCP only) */
+            }
+
+            /* Refill the slots consumed by the previous batch */
+            unsigned count = 0;
+            while (count < batch.size)
+            {
+                block_t *block = batch.blocks[count];
+
+                if (block == NULL || block->i_buffer < batch.mru)
+                {
+                    if (block != NULL)
+                        block_Release (block); /* MRU grew */
+
+                    block = block_Alloc (batch.mru);
+                    batch.blocks[count] = block;
+                    if (unlikely(block == NULL))
+                        break;
+                }
+
+                iovs[count].iov_base = block->p_buffer;
+                iovs[count].iov_len = block->i_buffer;
+                memset (&msgs[count], 0, sizeof (msgs[count]));
+                msgs[count].msg_hdr.msg_iov = &iovs[count];
+                msgs[count].msg_hdr.msg_iovlen = 1;
+#ifdef SO_TIMESTAMPNS
+                msgs[count].msg_hdr.msg_control = cmsgs[count].buf;
+                msgs[count].msg_hdr.msg_controllen = sizeof (cmsgs[count]);
+#endif
+                count++;
+            }
+
+            if (unlikely(count == 0))
+            {
+                if (batch.mru == DEFAULT_MRU)
+                {
+                    vlc_restorecancel (canc);
+                    break; /* we are totallly screwed */
+                }
+                batch.mru = DEFAULT_MRU; /* retry with shrunk MRU */
+                goto dequeue;
+            }
+
+            /* MSG_TRUNC makes msg_len the actual datagram length */
+            n = recvmmsg (rtp_fd, msgs, count, MSG_DONTWAIT | MSG_TRUNC,
+                          NULL);
+            if (n == -1)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    msg_Warn (demux, "RTP network error: %s",
+                              vlc_strerror_c(errno));
+                goto dequeue;
+            }
+
+            struct timespec wall = { 0, 0 };
+            mtime_t now = mdate ();
+#ifdef SO_TIMESTAMPNS
+            clock_gettime (CLOCK_REALTIME, &wall);
+#endif
+            for (int i = 0; i < n; i++)
+            {
+                block_t *block = batch.blocks[i];
+                size_t len = msgs[i].msg_len;
+
+                batch.blocks[i] = NULL;
+                if (len > block->i_buffer)
+                {
+                    msg_Err(demux, "%zu bytes packet truncated (MRU was %zu)",
+                            len, block->i_buffer);
+                    block->i_flags |= BLOCK_FLAG_CORRUPTED;
+                    batch.mru = len;
+                }
+                else
+                    block->i_buffer = len;
+
+                block->i_pts = rtp_rx_time (&msgs[i].msg_hdr, now, &wall);
+                rtp_process (demux, block);
+            }
+        }
+
+    dequeue:
+        if (!rtp_dequeue (demux, sys->session, &deadline))
+            deadline = VLC_TS_INVALID;
+        vlc_restorecancel (canc);
+    }
+    vlc_cleanup_pop ();
+    rtp_batch_cleanup (&batch);
+    return NULL;
+}
+#else
 /**
  * RTP/RTCP session thread for datagram sockets
  */
@@ -187,6 +387,7 @@ void *rtp_dgram_thread (void *opaque)
     }
     return NULL;
 }
+#endif
 
 /**
  * RTP/RTCP session thread for stream sockets (framed RTP)
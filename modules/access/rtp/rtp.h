@@ -77,6 +77,9 @@ typedef struct
     uint16_t      max_dropout; /**< Max packet forward misordering */
     uint16_t      max_misorder; /**< Max packet backward misordering */
     uint8_t       max_src; /**< Max simultaneous RTP sources */
+#ifdef HAVE_RECVMMSG
+    uint8_t       batch; /**< Max datagrams per receive system call */
+#endif
     bool          thread_ready;
     bool          autodetect; /**< Payload type autodetection pending */
 } demux_sys_t;
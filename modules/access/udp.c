@@ -59,6 +59,9 @@ static void Close( vlc_object_t * );
 #define BUFFER_TEXT N_("Receive buffer")
 #define BUFFER_LONGTEXT N_("UDP receive buffer size (bytes)" )
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
+#define BATCH_TEXT N_("Receive batch size")
+#define BATCH_LONGTEXT N_("Maximum number of datagrams received per " \
+    "system call. Larger batches reduce the CPU load at high bit rates.")
 
 vlc_module_begin ()
     set_shortname( N_("UDP" ) )
@@ -69,6 +72,10 @@ vlc_module_begin ()
     add_obsolete_integer( "server-port" ) /* since 2.0.0 */
     add_obsolete_integer( "udp-buffer" ) /* since 3.0.0 */
     add_integer( "udp-timeout", -1, TIMEOUT_TEXT, NULL, true )
+#ifdef HAVE_RECVMMSG
+    add_integer_with_range( "udp-batch", 16, 1, 256, BATCH_TEXT,
+                            BATCH_LONGTEXT, true )
+#endif
 
     set_capability( "access", 0 )
     add_shortcut( "udp", "udpstream", "udp4", "udp6" )
@@ -81,12 +88,24 @@ typedef struct
     int fd;
     int timeout;
     size_t mtu;
+#ifdef HAVE_RECVMMSG
+    /* Ring of pre-allocated datagram buffers filled by recvmmsg() */
+    unsigned batch;
+    unsigned head; /**< next received datagram to return */
+    unsigned count; /**< number of received datagrams */
+    block_t **blocks;
+    struct mmsghdr *msgs;
+    struct iovec *iovs;
+#endif
 } access_sys_t;
 
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
 static block_t *BlockUDP( stream_t *, bool * );
+#ifdef HAVE_RECVMMSG
+static block_t *BlockUDPBatch( stream_t *, bool * );
+#endif
 static int Control( stream_t *, int, va_list );
 
 /*****************************************************************************
@@ -174,6 +193,34 @@ static int Open( vlc_object_t *p_this )
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+#ifdef HAVE_RECVMMSG
+    sys->batch = var_InheritInteger( p_access, "udp-batch" );
+    sys->head = sys->count = 0;
+    sys->blocks = NULL;
+    if( sys->batch > 1 )
+    {
+        sys->blocks = vlc_obj_calloc( p_this, sys->batch,
+                                      sizeof( *sys->blocks ) );
+        sys->msgs = vlc_obj_calloc( p_this, sys->batch,
+                                    sizeof( *sys->msgs ) );
+        sys->iovs = vlc_obj_calloc( p_this, sys->batch,
+                                    sizeof( *sys->iovs ) );
+        if( unlikely(sys->blocks == NULL || sys->msgs == NULL
+                  || sys->iovs == NULL) )
+        {
+            net_Close( sys->fd );
+            return VLC_ENOMEM;
+        }
+
+        for( unsigned i = 0; i < sys->batch; i++ )
+        {
+            sys->msgs[i].msg_hdr.msg_iov = &sys->iovs[i];
+            sys->msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        p_access->pf_block = BlockUDPBatch;
+    }
+#endif
+
     return VLC_SUCCESS;
 }
 
@@ -185,6 +232,12 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t*)p_this;
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef HAVE_RECVMMSG
+    if( sys->blocks != NULL )
+        for( unsigned i = 0; i < sys->batch; i++ )
+            if( sys->blocks[i] != NULL )
+                block_Release( sys->blocks[i] );
+#endif
     net_Close( sys->fd );
 }
 
@@ -282,3 +335,88 @@ skip:
 
     return pkt;
 }
+
+#ifdef HAVE_RECVMMSG
+/*****************************************************************************
+ * BlockUDPBatch: receives up to sys->batch datagrams per system call
+ *****************************************************************************/
+static block_t *BlockUDPBatch(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (sys->head < sys->count)
+        goto dequeue;
+
+    /* Refill the slots consumed by the previous batch */
+    unsigned n = 0;
+    while (n < sys->batch)
+    {
+        block_t *pkt = sys->blocks[n];
+
+        if (pkt == NULL || pkt->i_buffer < sys->mtu)
+        {
+            if (pkt != NULL)
+                block_Release(pkt); /* MTU grew */
+
+            pkt = block_Alloc(sys->mtu);
+            sys->blocks[n] = pkt;
+            if (unlikely(pkt == NULL))
+                break;
+            sys->iovs[n].iov_base = pkt->p_buffer;
+            sys->iovs[n].iov_len = sys->mtu;
+        }
+        n++;
+    }
+
+    if (unlikely(n == 0))
+    {   /* OOM - dequeue and discard one packet */
+        char dummy;
+        recv(sys->fd, &dummy, 1, 0);
+        return NULL;
+    }
+
+    struct pollfd ufd[1];
+
+    ufd[0].fd = sys->fd;
+    ufd[0].events = POLLIN;
+
+    switch (vlc_poll_i11e(ufd, 1, sys->timeout))
+    {
+        case 0:
+            msg_Err(access, "receive time-out");
+            *eof = true;
+            /* fall through */
+        case -1:
+            return NULL;
+    }
+
+    /* MSG_TRUNC makes msg_len the actual datagram length */
+    int ret = recvmmsg(sys->fd, sys->msgs, n, MSG_DONTWAIT | MSG_TRUNC, NULL);
+    if (ret <= 0)
+        return NULL;
+
+    for (int i = 0; i < ret; i++)
+    {
+        block_t *pkt = sys->blocks[i];
+        size_t len = sys->msgs[i].msg_len;
+
+        if (len > pkt->i_buffer)
+        {
+            msg_Err(access, "%zu bytes packet truncated (MTU was %zu)",
+                    len, pkt->i_buffer);
+            pkt->i_flags |= BLOCK_FLAG_CORRUPTED;
+            sys->mtu = len;
+        }
+        else
+            pkt->i_buffer = len;
+    }
+    sys->head = 0;
+    sys->count = ret;
+
+dequeue:;
+    block_t *pkt = sys->blocks[sys->head];
+
+    sys->blocks[sys->head++] = NULL;
+    return pkt;
+}
+#endif
@@ -0,0 +1,671 @@
+/*****************************************************************************
+ * uring.c: asynchronous file input using Linux io_uring
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_EVENTFD_H
+# include <sys/eventfd.h>
+#endif
+#include <linux/io_uring.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_access.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_interrupt.h>
+
+/*
+ * Several reads of the file ahead of the current position are kept in
+ * flight in a ring. Each read fills one slot of a registered buffer arena,
+ * and the slot is handed up as a data block as is. The slot returns to the
+ * pool when the block is released, which can happen after the access is
+ * closed: the shared state is then reference counted.
+ */
+
+enum
+{
+    SLOT_FREE,
+    SLOT_PENDING,   /* read in flight */
+    SLOT_DONE,      /* read completed, not yet consumed */
+    SLOT_HELD,      /* block in use downstream */
+};
+
+typedef struct uring_sys_t uring_sys_t;
+
+struct uring_slot
+{
+    block_t      self;
+    uring_sys_t *sys;
+    struct iovec iov;
+    uint64_t     offset;
+    int          result;
+    int          state;
+    bool         stale;     /* read result is not wanted anymore */
+};
+
+struct uring_sys_t
+{
+    int          fd;
+    int          ring_fd;
+    int          event_fd;
+    bool         fixed;     /* buffers are registered */
+
+    /* submission and completion queues, shared with the kernel */
+    unsigned    *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned    *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void        *sq_ring;
+    size_t       sq_ring_size;
+    void        *cq_ring;
+    size_t       cq_ring_size;
+    size_t       sqes_size;
+    unsigned     sq_queued;     /* not yet in the submission queue */
+    unsigned     sq_unsubmitted;  /* not yet consumed by the kernel */
+
+    uint64_t     pos;       /* consumer position */
+    uint64_t     next;      /* offset of the next read to submit */
+    uint64_t     size;
+
+    vlc_mutex_t  lock;      /* slot states */
+    atomic_uint  refs;
+    unsigned     depth;
+    size_t       slot_size;
+    uint8_t     *arena;
+    struct uring_slot slots[];
+};
+
+static int uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                       unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                   NULL, 0);
+}
+
+static int uring_register(int fd, unsigned opcode, const void *arg,
+                          unsigned nr_args)
+{
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static unsigned load_acquire(const unsigned *p)
+{
+    return atomic_load_explicit((_Atomic unsigned *)p, memory_order_acquire);
+}
+
+static void store_release(unsigned *p, unsigned v)
+{
+    atomic_store_explicit((_Atomic unsigned *)p, v, memory_order_release);
+}
+
+static int RingInit(uring_sys_t *sys, unsigned entries)
+{
+    struct io_uring_params p;
+
+    memset(&p, 0, sizeof (p));
+    sys->ring_fd = uring_setup(entries, &p);
+    if (sys->ring_fd == -1)
+        return -1;
+
+    sys->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+    sys->cq_ring_size = p.cq_off.cqes
+                      + p.cq_entries * sizeof (struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        sys->sq_ring_size = sys->cq_ring_size
+                          = __MAX(sys->sq_ring_size, sys->cq_ring_size);
+
+    sys->sq_ring = mmap(NULL, sys->sq_ring_size, PROT_READ|PROT_WRITE,
+                        MAP_SHARED|MAP_POPULATE, sys->ring_fd,
+                        IORING_OFF_SQ_RING);
+    if (sys->sq_ring == MAP_FAILED)
+        goto error;
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        sys->cq_ring = sys->sq_ring;
+    else
+    {
+        sys->cq_ring = mmap(NULL, sys->cq_ring_size, PROT_READ|PROT_WRITE,
+                            MAP_SHARED|MAP_POPULATE, sys->ring_fd,
+                            IORING_OFF_CQ_RING);
+        if (sys->cq_ring == MAP_FAILED)
+            goto error_sq;
+    }
+
+    sys->sqes_size = p.sq_entries * sizeof (struct io_uring_sqe);
+    sys->sqes = mmap(NULL, sys->sqes_size, PROT_READ|PROT_WRITE,
+                     MAP_SHARED|MAP_POPULATE, sys->ring_fd, IORING_OFF_SQES);
+    if (sys->sqes == MAP_FAILED)
+        goto error_cq;
+
+    uint8_t *sq = sys->sq_ring, *cq = sys->cq_ring;
+
+    sys->sq_head = (unsigned *)(sq + p.sq_off.head);
+    sys->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    sys->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    sys->sq_array = (unsigned *)(sq + p.sq_off.array);
+    sys->cq_head = (unsigned *)(cq + p.cq_off.head);
+    sys->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    sys->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    sys->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    sys->sq_queued = 0;
+    sys->sq_unsubmitted = 0;
+    return 0;
+
+error_cq:
+    if (sys->cq_ring != sys->sq_ring)
+        munmap(sys->cq_ring, sys->cq_ring_size);
+error_sq:
+    munmap(sys->sq_ring, sys->sq_ring_size);
+error:
+    close(sys->ring_fd);
+    return -1;
+}
+
+static void RingClean(uring_sys_t *sys)
+{
+    munmap(sys->sqes, sys->sqes_size);
+    if (sys->cq_ring != sys->sq_ring)
+        munmap(sys->cq_ring, sys->cq_ring_size);
+    munmap(sys->sq_ring, sys->sq_ring_size);
+    close(sys->ring_fd);
+}
+
+static void Release(uring_sys_t *sys)
+{
+    if (atomic_fetch_sub(&sys->refs, 1) != 1)
+        return;
+
+    RingClean(sys);
+    if (sys->event_fd != -1)
+        close(sys->event_fd);
+    vlc_mutex_destroy(&sys->lock);
+    free(sys->arena);
+    free(sys);
+}
+
+static void SlotRelease(block_t *block)
+{
+    struct uring_slot *slot = container_of(block, struct uring_slot, self);
+    uring_sys_t *sys = slot->sys;
+
+    vlc_mutex_lock(&sys->lock);
+    assert(slot->state == SLOT_HELD);
+    slot->state = SLOT_FREE;
+    vlc_mutex_unlock(&sys->lock);
+    Release(sys);
+}
+
+/** Queues a read of the given slot at the given offset (lock held) */
+static void Prepare(uring_sys_t *sys, struct uring_slot *slot,
+                    uint64_t offset)
+{
+    unsigned tail = *sys->sq_tail + sys->sq_queued;
+    unsigned index = tail & *sys->sq_mask;
+    struct io_uring_sqe *sqe = &sys->sqes[index];
+
+    memset(sqe, 0, sizeof (*sqe));
+    sqe->fd = sys->fd;
+    sqe->off = offset;
+    if (sys->fixed)
+    {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = (uintptr_t)slot->iov.iov_base;
+        sqe->len = slot->iov.iov_len;
+        sqe->buf_index = 0; /* the whole arena */
+    }
+    else
+    {
+        sqe->opcode = IORING_OP_READV;
+        sqe->addr = (uintptr_t)&slot->iov;
+        sqe->len = 1;
+    }
+    sqe->user_data = (uintptr_t)slot;
+    sys->sq_array[index] = index;
+    sys->sq_queued++;
+
+    slot->offset = offset;
+    slot->state = SLOT_PENDING;
+    slot->stale = false;
+}
+
+/** Fills the free slots with reads ahead of the consumer (lock held) */
+static void Submit(uring_sys_t *sys)
+{
+    for (unsigned i = 0; i < sys->depth; i++)
+    {
+        struct uring_slot *slot = &sys->slots[i];
+
+        if (slot->state != SLOT_FREE)
+            continue;
+
+        if (sys->next >= sys->size && sys->next > sys->pos)
+        {   /* Do not read past the end, unless the file grew */
+            struct stat st;
+
+            if (fstat(sys->fd, &st) == 0)
+                sys->size = st.st_size;
+            if (sys->next >= sys->size)
+                break;
+        }
+
+        Prepare(sys, slot, sys->next);
+        sys->next += sys->slot_size;
+    }
+
+    store_release(sys->sq_tail, *sys->sq_tail + sys->sq_queued);
+    sys->sq_unsubmitted += sys->sq_queued;
+    sys->sq_queued = 0;
+
+    if (sys->sq_unsubmitted == 0)
+        return;
+
+    int val = uring_enter(sys->ring_fd, sys->sq_unsubmitted, 0, 0);
+    if (val > 0)
+        sys->sq_unsubmitted -= val;
+}
+
+/** Collects the completed reads (lock held) */
+static unsigned Reap(uring_sys_t *sys)
+{
+    unsigned head = *sys->cq_head, tail = load_acquire(sys->cq_tail);
+    unsigned count = 0;
+
+    while (head != tail)
+    {
+        const struct io_uring_cqe *cqe = &sys->cqes[head & *sys->cq_mask];
+        struct uring_slot *slot = (struct uring_slot *)(uintptr_t)cqe->user_data;
+
+        assert(slot->state == SLOT_PENDING);
+        if (slot->stale)
+            slot->state = SLOT_FREE;
+        else
+        {
+            slot->result = cqe->res;
+            slot->state = SLOT_DONE;
+        }
+        head++;
+        count++;
+    }
+    store_release(sys->cq_head, head);
+    return count;
+}
+
+/** Waits for at least one completion (lock held) */
+static int Wait(uring_sys_t *sys, bool interruptible)
+{
+    if (Reap(sys) > 0)
+        return 0;
+
+    if (sys->sq_unsubmitted > 0)
+    {   /* The kernel could not take the reads earlier */
+        int val = uring_enter(sys->ring_fd, sys->sq_unsubmitted, 0, 0);
+        if (val < 0)
+            return -1;
+        sys->sq_unsubmitted -= val;
+    }
+
+    if (interruptible && sys->event_fd != -1)
+    {
+        struct pollfd ufd = { .fd = sys->event_fd, .events = POLLIN };
+        uint64_t counter;
+
+        vlc_mutex_unlock(&sys->lock);
+        int val = vlc_poll_i11e(&ufd, 1, -1);
+        vlc_mutex_lock(&sys->lock);
+        if (val < 0)
+            return -1;
+        if (read(sys->event_fd, &counter, sizeof (counter)) < 0)
+            (void) counter;
+    }
+    else
+    {
+        int val = uring_enter(sys->ring_fd, 0, 1, IORING_ENTER_GETEVENTS);
+        if (val < 0 && errno != EINTR)
+            return -1;
+    }
+    Reap(sys);
+    return 0;
+}
+
+static struct uring_slot *Find(uring_sys_t *sys, uint64_t offset)
+{
+    for (unsigned i = 0; i < sys->depth; i++)
+    {
+        struct uring_slot *slot = &sys->slots[i];
+
+        if ((slot->state == SLOT_PENDING || slot->state == SLOT_DONE)
+         && !slot->stale && slot->offset == offset)
+            return slot;
+    }
+    return NULL;
+}
+
+/** Reads synchronously when all the slots are held downstream */
+static block_t *ReadCopy(stream_t *access, uring_sys_t *sys, bool *restrict eof)
+{
+    block_t *block = block_Alloc(sys->slot_size);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    ssize_t val = pread(sys->fd, block->p_buffer, sys->slot_size, sys->pos);
+    if (val <= 0)
+    {
+        if (val < 0)
+            msg_Err(access, "read error: %s", vlc_strerror_c(errno));
+        block_Release(block);
+        *eof = true;
+        return NULL;
+    }
+    block->i_buffer = val;
+    sys->pos += val;
+    return block;
+}
+
+static block_t *Block(stream_t *access, bool *restrict eof)
+{
+    uring_sys_t *sys = access->p_sys;
+    struct uring_slot *slot;
+
+    vlc_mutex_lock(&sys->lock);
+    slot = Find(sys, sys->pos);
+    if (slot == NULL)
+    {   /* Seek or short read: restart the reads from the position */
+        for (unsigned i = 0; i < sys->depth; i++)
+        {
+            struct uring_slot *s = &sys->slots[i];
+
+            if (s->state == SLOT_PENDING)
+                s->stale = true;
+            else if (s->state == SLOT_DONE)
+                s->state = SLOT_FREE;
+        }
+        sys->next = sys->pos;
+    }
+
+    Submit(sys);
+
+    while (slot == NULL && (slot = Find(sys, sys->pos)) == NULL)
+    {
+        bool pending = false;
+
+        for (unsigned i = 0; i < sys->depth; i++)
+            if (sys->slots[i].state == SLOT_PENDING)
+                pending = true;
+
+        if (!pending)
+        {   /* All the buffers are held downstream */
+            vlc_mutex_unlock(&sys->lock);
+            return ReadCopy(access, sys, eof);
+        }
+
+        /* Wait for a stale read to free its slot */
+        if (Wait(sys, true))
+        {
+            vlc_mutex_unlock(&sys->lock);
+            return NULL;
+        }
+        Submit(sys);
+    }
+
+    while (slot->state == SLOT_PENDING)
+        if (Wait(sys, true))
+        {   /* Interrupted, the read stays in flight */
+            vlc_mutex_unlock(&sys->lock);
+            return NULL;
+        }
+
+    assert(slot->state == SLOT_DONE);
+
+    if (slot->result <= 0)
+    {
+        slot->state = SLOT_FREE;
+        vlc_mutex_unlock(&sys->lock);
+
+        if (slot->result == -EINTR || slot->result == -EAGAIN)
+            return NULL; /* read again at the same position */
+        if (slot->result < 0)
+            msg_Err(access, "read error: %s", vlc_strerror_c(-slot->result));
+        *eof = true;
+        return NULL;
+    }
+
+    block_t *block = &slot->self;
+
+    block_Init(block, slot->iov.iov_base, slot->iov.iov_len);
+    block->i_buffer = slot->result;
+    block->pf_release = SlotRelease;
+    slot->state = SLOT_HELD;
+    sys->pos += slot->result;
+    atomic_fetch_add(&sys->refs, 1);
+
+    /* Keep the freed slots busy */
+    Submit(sys);
+    vlc_mutex_unlock(&sys->lock);
+    return block;
+}
+
+static int Seek(stream_t *access, uint64_t offset)
+{
+    uring_sys_t *sys = access->p_sys;
+
+    sys->pos = offset;
+    return VLC_SUCCESS;
+}
+
+static int Control(stream_t *access, int query, va_list args)
+{
+    uring_sys_t *sys = access->p_sys;
+
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_FASTSEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg(args, bool *) = true;
+            break;
+
+        case STREAM_GET_SIZE:
+        {
+            struct stat st;
+
+            if (fstat(sys->fd, &st))
+                return VLC_EGENERIC;
+            *va_arg(args, uint64_t *) = st.st_size;
+            break;
+        }
+
+        case STREAM_GET_PTS_DELAY:
+            *va_arg(args, int64_t *) =
+                INT64_C(1000) * var_InheritInteger(access, "file-caching");
+            break;
+
+        case STREAM_SET_PAUSE_STATE:
+            /* Nothing to do */
+            break;
+
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int Open(vlc_object_t *obj)
+{
+    stream_t *access = (stream_t *)obj;
+
+    if (!var_InheritBool(obj, "file-uring")
+     || access->psz_filepath == NULL)
+        return VLC_EGENERIC;
+
+    int fd = vlc_open(access->psz_filepath, O_RDONLY);
+    if (fd == -1)
+        return VLC_EGENERIC;
+
+    /* Directories, pipes and devices are left to the file input */
+    struct stat st;
+    if (fstat(fd, &st) || !S_ISREG(st.st_mode))
+        goto error;
+
+    unsigned depth = var_InheritInteger(obj, "file-uring-depth");
+    size_t slot_size = var_InheritInteger(obj, "file-uring-block") << 10u;
+    uring_sys_t *sys = malloc(sizeof (*sys) + depth * sizeof (sys->slots[0]));
+    if (unlikely(sys == NULL))
+        goto error;
+
+    long pagesize = sysconf(_SC_PAGESIZE);
+    if (posix_memalign((void **)&sys->arena, pagesize, depth * slot_size))
+    {
+        free(sys);
+        goto error;
+    }
+
+    if (RingInit(sys, depth))
+    {
+        msg_Dbg(access, "io_uring not available: %s", vlc_strerror_c(errno));
+        free(sys->arena);
+        free(sys);
+        goto error;
+    }
+
+    sys->fd = fd;
+    sys->pos = 0;
+    sys->next = 0;
+    sys->size = st.st_size;
+    sys->depth = depth;
+    sys->slot_size = slot_size;
+    vlc_mutex_init(&sys->lock);
+    atomic_init(&sys->refs, 1);
+
+    for (unsigned i = 0; i < depth; i++)
+    {
+        struct uring_slot *slot = &sys->slots[i];
+
+        slot->sys = sys;
+        slot->iov.iov_base = sys->arena + i * slot_size;
+        slot->iov.iov_len = slot_size;
+        slot->state = SLOT_FREE;
+        slot->stale = false;
+    }
+
+    /* Registered buffers save mapping the pages on every read, but count
+     * against the locked memory limit. */
+    struct iovec arena = { sys->arena, depth * slot_size };
+
+    sys->fixed = uring_register(sys->ring_fd, IORING_REGISTER_BUFFERS,
+                                &arena, 1) == 0;
+    if (!sys->fixed)
+        msg_Dbg(access, "cannot register buffers: %s", vlc_strerror_c(errno));
+
+    sys->event_fd = -1;
+#ifdef HAVE_SYS_EVENTFD_H
+    sys->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (sys->event_fd != -1
+     && uring_register(sys->ring_fd, IORING_REGISTER_EVENTFD,
+                       &sys->event_fd, 1))
+    {
+        close(sys->event_fd);
+        sys->event_fd = -1;
+    }
+#endif
+
+    /* Demuxers will need the beginning of the file for probing. */
+    vlc_mutex_lock(&sys->lock);
+    Submit(sys);
+    vlc_mutex_unlock(&sys->lock);
+
+    msg_Dbg(access, "%u reads of %zu bytes in flight%s", depth, slot_size,
+            sys->fixed ? " (registered buffers)" : "");
+    access->pf_read = NULL;
+    access->pf_block = Block;
+    access->pf_seek = Seek;
+    access->pf_control = Control;
+    access->p_sys = sys;
+    return VLC_SUCCESS;
+
+error:
+    vlc_close(fd);
+    return VLC_EGENERIC;
+}
+
+static void Close(vlc_object_t *obj)
+{
+    stream_t *access = (stream_t *)obj;
+    uring_sys_t *sys = access->p_sys;
+    bool pending;
+
+    /* The kernel may still write to the buffers */
+    vlc_mutex_lock(&sys->lock);
+    do
+    {
+        pending = false;
+        for (unsigned i = 0; i < sys->depth; i++)
+            if (sys->slots[i].state == SLOT_PENDING)
+            {
+                sys->slots[i].stale = true;
+                pending = true;
+            }
+    }
+    while (pending && Wait(sys, false) == 0);
+    vlc_mutex_unlock(&sys->lock);
+
+    vlc_close(sys->fd);
+    Release(sys);
+}
+
+vlc_module_begin()
+    set_description(N_("Asynchronous file input"))
+    set_shortname(N_("File (io_uring)"))
+    set_category(CAT_INPUT)
+    set_subcategory(SUBCAT_INPUT_ACCESS)
+    set_capability("access", 60)
+    add_shortcut("file")
+    set_callbacks(Open, Close)
+
+    add_bool("file-uring", false, N_("Asynchronous file reading"),
+             N_("Read regular files with several reads in flight "
+                "through io_uring."), true)
+    add_integer("file-uring-depth", 8, N_("Reads in flight"),
+                N_("Number of file reads kept in flight."), true)
+        change_integer_range(2, 64)
+    add_integer("file-uring-block", 256, N_("Read size"),
+                N_("Size of each file read (KiB)."), true)
+        change_integer_range(4, 4096)
+vlc_module_end()
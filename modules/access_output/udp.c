@@ -48,8 +48,12 @@
 #endif
 
 #include <vlc_network.h>
+#ifdef HAVE_SENDMMSG
+#   include <netinet/udp.h>
+#endif
 
 #define MAX_EMPTY_BLOCKS 200
+#define MAX_BATCH 64
 
 /*****************************************************************************
  * Module descriptor
@@ -71,6 +75,14 @@ static void Close( vlc_object_t * );
                           "helps reducing the scheduling load on " \
                           "heavily-loaded systems." )
 
+#define BATCH_TEXT N_("Send batch size")
+#define BATCH_LONGTEXT N_("Packets that are due at the same time are sent " \
+                          "with a single system call, up to this many " \
+                          "at a time." )
+#define GSO_TEXT N_("UDP segmentation offload")
+#define GSO_LONGTEXT N_("Let the kernel split batches of equally sized " \
+                        "packets (UDP GSO), if supported." )
+
 vlc_module_begin ()
     set_description( N_("UDP stream output") )
     set_shortname( "UDP" )
@@ -79,6 +91,11 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000, CACHING_TEXT, CACHING_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "group", 1, GROUP_TEXT, GROUP_LONGTEXT,
                                  true )
+#ifdef HAVE_SENDMMSG
+    add_integer_with_range( SOUT_CFG_PREFIX "batch", 16, 1, MAX_BATCH,
+                            BATCH_TEXT, BATCH_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "gso", true, GSO_TEXT, GSO_LONGTEXT, true )
+#endif
 
     set_capability( "sout access", 0 )
     add_shortcut( "udp" )
@@ -92,6 +109,10 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "caching",
     "group",
+#ifdef HAVE_SENDMMSG
+    "batch",
+    "gso",
+#endif
     NULL
 };
 
@@ -120,6 +141,14 @@ typedef struct
     block_fifo_t *p_empty_blocks;
     block_t      *p_buffer;
 
+#ifdef HAVE_SENDMMSG
+    /* Due packets not sent yet (owned by the sending thread) */
+    unsigned      i_batch;
+    unsigned      i_batch_count;
+    bool          b_gso;
+    block_t      *pp_batch[MAX_BATCH];
+#endif
+
     vlc_thread_t  thread;
 } sout_access_out_sys_t;
 
@@ -212,6 +241,11 @@ static int Open( vlc_object_t *p_this )
     p_sys->p_fifo = block_FifoNew();
     p_sys->p_empty_blocks = block_FifoNew();
     p_sys->p_buffer = NULL;
+#ifdef HAVE_SENDMMSG
+    p_sys->i_batch = var_GetInteger( p_access, SOUT_CFG_PREFIX "batch" );
+    p_sys->i_batch_count = 0;
+    p_sys->b_gso = var_GetBool( p_access, SOUT_CFG_PREFIX "gso" );
+#endif
 
     if( vlc_clone( &p_sys->thread, ThreadWrite, p_access,
                            VLC_THREAD_PRIORITY_HIGHEST ) )
@@ -240,6 +274,10 @@ static void Close( vlc_object_t * p_this )
 
     vlc_cancel( p_sys->thread );
     vlc_join( p_sys->thread, NULL );
+#ifdef HAVE_SENDMMSG
+    for( unsigned i = 0; i < p_sys->i_batch_count; i++ )
+        block_Release( p_sys->pp_batch[i] );
+#endif
     block_FifoRelease( p_sys->p_fifo );
     block_FifoRelease( p_sys->p_empty_blocks );
 
@@ -380,6 +418,136 @@ static block_t *NewUDPPacket( sout_access_out_t *p_access, mtime_t i_dts)
     return p_buffer;
 }
 
+#ifdef HAVE_SENDMMSG
+# ifdef UDP_SEGMENT
+/*****************************************************************************
+ * SendSegmented: send equally sized packets as one UDP GSO super-datagram
+ *****************************************************************************
+ * Returns the number of packets consumed, or 0 if none could be segmented.
+ *****************************************************************************/
+static unsigned SendSegmented( sout_access_out_t *p_access,
+                               block_t *const *pp_pk, unsigned i_count )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    const size_t i_seg = pp_pk[0]->i_buffer;
+    struct iovec iov[MAX_BATCH];
+    size_t i_total = 0;
+    unsigned n = 0;
+
+    if( i_seg == 0 )
+        return 0;
+
+    /* All segments but the last must have the same size */
+    while( n < i_count && pp_pk[n]->i_buffer <= i_seg
+        && i_total + pp_pk[n]->i_buffer <= 65507 )
+    {
+        iov[n].iov_base = pp_pk[n]->p_buffer;
+        iov[n].iov_len = pp_pk[n]->i_buffer;
+        i_total += pp_pk[n++]->i_buffer;
+        if( iov[n - 1].iov_len < i_seg )
+            break;
+    }
+    if( n < 2 )
+        return 0;
+
+    union
+    {
+        char buf[CMSG_SPACE(sizeof (uint16_t))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg = {
+        .msg_iov = iov,
+        .msg_iovlen = n,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof (control.buf),
+    };
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR( &msg );
+    uint16_t i_gso = i_seg;
+
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof (i_gso));
+    memcpy( CMSG_DATA(cmsg), &i_gso, sizeof (i_gso) );
+
+    if( sendmsg( p_sys->i_handle, &msg, 0 ) == -1 )
+    {
+        switch( errno )
+        {
+            case EIO: /* no checksum offload on the egress device */
+            case EINVAL:
+            case ENOPROTOOPT:
+            case EOPNOTSUPP:
+                msg_Dbg( p_access, "UDP segmentation offload disabled: %s",
+                         vlc_strerror_c(errno) );
+                p_sys->b_gso = false;
+                return 0;
+        }
+        msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+    }
+    return n;
+}
+# endif
+
+/*****************************************************************************
+ * SendBatch: send all the batched packets, then recycle them
+ *****************************************************************************/
+static void SendBatch( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    block_t **pp_pk = p_sys->pp_batch;
+    const unsigned i_count = p_sys->i_batch_count;
+    unsigned i_sent = 0;
+
+    if( i_count == 0 )
+        return;
+
+# ifdef UDP_SEGMENT
+    while( p_sys->b_gso && i_sent < i_count )
+    {
+        unsigned n = SendSegmented( p_access, pp_pk + i_sent,
+                                    i_count - i_sent );
+        if( n == 0 )
+            break;
+        i_sent += n;
+    }
+# endif
+
+    struct mmsghdr msgs[MAX_BATCH];
+    struct iovec iov[MAX_BATCH];
+
+    for( unsigned i = i_sent; i < i_count; i++ )
+    {
+        iov[i].iov_base = pp_pk[i]->p_buffer;
+        iov[i].iov_len = pp_pk[i]->i_buffer;
+        memset( &msgs[i], 0, sizeof (msgs[i]) );
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while( i_sent < i_count )
+    {
+        int val = sendmmsg( p_sys->i_handle, msgs + i_sent,
+                            i_count - i_sent, 0 );
+        if( val == -1 )
+        {
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+            val = 1; /* skip the offending packet */
+        }
+        i_sent += val;
+    }
+
+    /* The first packet has the earliest deadline */
+    mtime_t i_late = mdate() - (pp_pk[0]->i_dts + p_sys->i_caching);
+    if( i_late > 20000 )
+        msg_Dbg( p_access, "packet has been sent too late (%"PRId64 ")",
+                 i_late );
+
+    for( unsigned i = 0; i < i_count; i++ )
+        block_FifoPut( p_sys->p_empty_blocks, pp_pk[i] );
+    p_sys->i_batch_count = 0;
+}
+#endif
+
 /*****************************************************************************
  * ThreadWrite: Write a packet on the network at the good time.
  *****************************************************************************/
@@ -392,9 +560,23 @@ static void* ThreadWrite( void *data )
                                              SOUT_CFG_PREFIX "group" );
     int i_to_send = i_group;
     unsigned i_dropped_packets = 0;
+    bool b_batch = false;
+#ifdef HAVE_SENDMMSG
+    b_batch = p_sys->i_batch > 1;
+#endif
 
     for (;;)
     {
+#ifdef HAVE_SENDMMSG
+        if( p_sys->i_batch_count > 0 )
+        {   /* Send as soon as the next packet is not readily available */
+            vlc_fifo_Lock( p_sys->p_fifo );
+            bool b_empty = vlc_fifo_IsEmpty( p_sys->p_fifo );
+            vlc_fifo_Unlock( p_sys->p_fifo );
+            if( b_empty )
+                SendBatch( p_access );
+        }
+#endif
         block_t *p_pk = block_FifoGet( p_sys->p_fifo );
         mtime_t       i_date, i_sent;
 
@@ -425,10 +607,16 @@ static void* ThreadWrite( void *data )
         i_to_send--;
         if( !i_to_send || (p_pk->i_flags & BLOCK_FLAG_CLOCK) )
         {
+#ifdef HAVE_SENDMMSG
+            /* Do not hold back packets that are already due */
+            if( i_date > mdate() )
+                SendBatch( p_access );
+#endif
             mwait( i_date );
             i_to_send = i_group;
         }
-        if ( send( p_sys->i_handle, p_pk->p_buffer, p_pk->i_buffer, 0 ) == -1 )
+        if ( !b_batch
+          && send( p_sys->i_handle, p_pk->p_buffer, p_pk->i_buffer, 0 ) == -1 )
             msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
         vlc_cleanup_pop();
 
@@ -438,6 +626,17 @@ static void* ThreadWrite( void *data )
             i_dropped_packets = 0;
         }
 
+        i_date_last = i_date;
+#ifdef HAVE_SENDMMSG
+        if( b_batch )
+        {   /* Sent and recycled later on by SendBatch() */
+            p_sys->pp_batch[p_sys->i_batch_count++] = p_pk;
+            if( p_sys->i_batch_count >= p_sys->i_batch )
+                SendBatch( p_access );
+            continue;
+        }
+#endif
+
 #if 1
         i_sent = mdate();
         if ( i_sent > i_date + 20000 )
@@ -448,8 +647,6 @@ static void* ThreadWrite( void *data )
 #endif
 
         block_FifoPut( p_sys->p_empty_blocks, p_pk );
-
-        i_date_last = i_date;
     }
     return NULL;
 }
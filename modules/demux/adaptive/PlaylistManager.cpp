@@ -765,6 +765,8 @@ AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::L
     {
         logic->setMaxDeviceResolution( var_InheritInteger(p_demux, "adaptive-maxwidth"),
                                        var_InheritInteger(p_demux, "adaptive-maxheight") );
+        logic->setBandwidthEstimator( (BandwidthEstimator::EstimatorType)
+                                      var_InheritInteger(p_demux, "adaptive-bw-estimator") );
     }
 
     return logic;
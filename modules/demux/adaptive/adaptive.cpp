@@ -73,9 +73,22 @@ static void Close   (vlc_object_t *);
 
 #define ADAPT_LOGIC_TEXT N_("Adaptive Logic")
 
+#define ADAPT_ESTIMATOR_TEXT N_("Bandwidth estimator")
+#define ADAPT_ESTIMATOR_LONGTEXT N_("How the adaptive logics estimate the " \
+                                    "bandwidth from the downloaded segments")
+
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
+#define ADAPT_THREADS_TEXT N_("Download threads")
+#define ADAPT_THREADS_LONGTEXT N_("Number of segments downloaded in parallel. " \
+                                  "The streams are served in turn.")
+
+#define ADAPT_CACHE_TEXT N_("Segments cache size (MiB)")
+#define ADAPT_CACHE_LONGTEXT N_("Memory used to keep the downloaded segments " \
+                                "of non-live streams, shared by all the adaptive " \
+                                "streams. 0 disables the cache.")
+
 static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::Default,
                                 AbstractAdaptationLogic::Predictive,
@@ -108,6 +121,20 @@ static_assert( ARRAY_SIZE( pi_logics ) == ARRAY_SIZE( ppsz_logics ),
 static_assert( ARRAY_SIZE( pi_logics ) == ARRAY_SIZE( ppsz_logics_values ),
     "pi_logics and ppsz_logics_values shall have the same number of elements" );
 
+static const int pi_estimators[] = {
+                                BandwidthEstimator::Default,
+                                BandwidthEstimator::Ewma,
+                                BandwidthEstimator::HarmonicMean,
+                                BandwidthEstimator::Percentile};
+
+static const char *const ppsz_estimators[] = { N_("Moving average"),
+                                               N_("Exponentially weighted average"),
+                                               N_("Harmonic mean"),
+                                               N_("Sliding percentile")};
+
+static_assert( ARRAY_SIZE( pi_estimators ) == ARRAY_SIZE( ppsz_estimators ),
+    "pi_estimators and ppsz_estimators shall have the same number of elements" );
+
 vlc_module_begin ()
         set_shortname( N_("Adaptive"))
         set_description( N_("Unified adaptive streaming for DASH/HLS") )
@@ -116,12 +143,19 @@ vlc_module_begin ()
         set_subcategory( SUBCAT_INPUT_DEMUX )
         add_string( "adaptive-logic",  "", ADAPT_LOGIC_TEXT, NULL, false )
             change_string_list( ppsz_logics_values, ppsz_logics )
+        add_integer( "adaptive-bw-estimator", BandwidthEstimator::Default,
+                     ADAPT_ESTIMATOR_TEXT, ADAPT_ESTIMATOR_LONGTEXT, true )
+            change_integer_list( pi_estimators, ppsz_estimators )
         add_integer( "adaptive-maxwidth",  0,
                      ADAPT_WIDTH_TEXT,  ADAPT_WIDTH_TEXT,  false )
         add_integer( "adaptive-maxheight", 0,
                      ADAPT_HEIGHT_TEXT, ADAPT_HEIGHT_TEXT, false )
         add_integer( "adaptive-bw",     250, ADAPT_BW_TEXT,     ADAPT_BW_LONGTEXT,     false )
         add_bool   ( "adaptive-use-access", false, ADAPT_ACCESS_TEXT, ADAPT_ACCESS_LONGTEXT, true );
+        add_integer_with_range( "adaptive-download-threads", 3, 1, 16,
+                                ADAPT_THREADS_TEXT, ADAPT_THREADS_LONGTEXT, true )
+        add_integer_with_range( "adaptive-cache-size", 16, 0, 1024,
+                                ADAPT_CACHE_TEXT, ADAPT_CACHE_LONGTEXT, true )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
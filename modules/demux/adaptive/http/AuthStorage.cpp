@@ -24,19 +24,75 @@
 #include "AuthStorage.hpp"
 #include "ConnectionParams.hpp"
 
+#include <sstream>
+
+extern "C"
+{
+#include "../../../access/http/connmgr.h"
+}
+
 using namespace adaptive::http;
 
 AuthStorage::AuthStorage( vlc_object_t *p_obj )
 {
+    p_object = p_obj;
     if ( var_InheritBool( p_obj, "http-forward-cookies" ) )
         p_cookies_jar = static_cast<vlc_http_cookie_jar_t *>
                 (var_InheritAddress( p_obj, "http-cookies" ));
     else
         p_cookies_jar = NULL;
+    vlc_mutex_init( &lock );
 }
 
 AuthStorage::~AuthStorage()
 {
+    std::map<std::string, struct vlc_http_mgr *>::const_iterator it;
+    for( it = httpManagers.begin(); it != httpManagers.end(); ++it )
+        vlc_http_mgr_destroy( (*it).second );
+    vlc_mutex_destroy( &lock );
+}
+
+std::string AuthStorage::getHostKey( const ConnectionParams &params )
+{
+    std::ostringstream key;
+    key.imbue( std::locale("C") );
+    key << params.getHostname() << ":" << params.getPort();
+    return key.str();
+}
+
+struct vlc_http_mgr * AuthStorage::getHTTPManager( const ConnectionParams &params )
+{
+    const std::string key = getHostKey( params );
+    struct vlc_http_mgr *mgr = NULL;
+
+    vlc_mutex_lock( &lock );
+    if( http1Hosts.find( key ) == http1Hosts.end() )
+    {
+        std::map<std::string, struct vlc_http_mgr *>::const_iterator it =
+                httpManagers.find( key );
+        if( it != httpManagers.end() )
+        {
+            mgr = (*it).second;
+        }
+        else
+        {
+            /* The manager keeps a single connection: one per server */
+            mgr = vlc_http_mgr_create( p_object, p_cookies_jar );
+            if( mgr )
+                httpManagers[key] = mgr;
+        }
+    }
+    vlc_mutex_unlock( &lock );
+
+    return mgr;
+}
+
+void AuthStorage::setNotMultiplexed( const ConnectionParams &params )
+{
+    vlc_mutex_lock( &lock );
+    /* The manager is kept for the requests still using it */
+    http1Hosts.insert( getHostKey( params ) );
+    vlc_mutex_unlock( &lock );
 }
 
 void AuthStorage::addCookie( const std::string &cookie, const ConnectionParams &params )
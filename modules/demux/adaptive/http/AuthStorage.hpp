@@ -24,6 +24,10 @@
 #include <vlc_http.h>
 
 #include <string>
+#include <map>
+#include <set>
+
+struct vlc_http_mgr;
 
 namespace adaptive
 {
@@ -38,9 +42,18 @@ namespace adaptive
                 ~AuthStorage();
                 void addCookie( const std::string &cookie, const ConnectionParams & );
                 std::string getCookie( const ConnectionParams &, bool secure );
+                /* HTTP/2 capable connection to the server, shared by the whole
+                 * session. NULL once the server negotiated HTTP/1.1 */
+                struct vlc_http_mgr * getHTTPManager( const ConnectionParams & );
+                void setNotMultiplexed( const ConnectionParams & );
 
             private:
+                static std::string getHostKey( const ConnectionParams & );
+                vlc_object_t *p_object;
                 vlc_http_cookie_jar_t *p_cookies_jar;
+                vlc_mutex_t lock; /* protects the HTTP managers */
+                std::map<std::string, struct vlc_http_mgr *> httpManagers;
+                std::set<std::string> http1Hosts;
         };
     }
 }
@@ -29,6 +29,7 @@
 #include "HTTPConnection.hpp"
 #include "HTTPConnectionManager.h"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 
 #include <vlc_common.h>
 #include <vlc_block.h>
@@ -192,9 +193,9 @@ block_t * HTTPChunkSource::read(size_t readsize)
         return NULL;
     }
 
-    mtime_t time = mdate();
+    const mtime_t start = mdate();
     ssize_t ret = connection->read(p_block->p_buffer, readsize);
-    time = mdate() - time;
+    const mtime_t end = mdate();
     if(ret < 0)
     {
         block_Release(p_block);
@@ -207,8 +208,8 @@ block_t * HTTPChunkSource::read(size_t readsize)
         consumed += p_block->i_buffer;
         if((size_t)ret < readsize)
             eof = true;
-        if(ret && time)
-            connManager->updateDownloadRate(sourceid, p_block->i_buffer, time);
+        if(ret && end > start)
+            connManager->updateDownloadRate(sourceid, p_block->i_buffer, end - start, end);
     }
 
     return p_block;
@@ -244,12 +245,10 @@ bool HTTPChunkSource::prepare()
         {
             if(i_ret == VLC_ETIMEOUT) /* redirection */
             {
-                HTTPConnection *httpconn = dynamic_cast<HTTPConnection *>(connection);
-                if(httpconn)
-                    connparams = httpconn->getRedirection();
+                connparams = connection->getRedirection();
                 connection->setUsed(false);
                 connection = NULL;
-                if(httpconn)
+                if(!connparams.getUrl().empty())
                     continue;
             }
             break;
@@ -276,7 +275,13 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     HTTPChunkSource(url, manager, sourceid),
     p_head     (NULL),
     pp_tail    (&p_head),
-    buffered     (0)
+    buffered     (0),
+    cachekey     (url),
+    cache        (NULL),
+    p_cachehead  (NULL),
+    pp_cachetail (&p_cachehead),
+    cachesize    (0),
+    cachemax     (0)
 {
     vlc_mutex_init(&lock);
     vlc_cond_init(&avail);
@@ -303,6 +308,8 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
         pp_tail = &p_head;
     }
     buffered = 0;
+    if(p_cachehead)
+        block_ChainRelease(p_cachehead);
     vlc_mutex_unlock(&lock);
 
     vlc_cond_destroy(&avail);
@@ -328,6 +335,57 @@ void HTTPChunkBufferedSource::release()
     vlc_cond_signal(&avail);
 }
 
+void HTTPChunkBufferedSource::setCacheKey(const std::string &key)
+{
+    cachekey = key;
+}
+
+bool HTTPChunkBufferedSource::attachCache(SegmentCache *cache_)
+{
+    if(!cache_ || cachekey.empty() || eof)
+        return false;
+
+    std::string type;
+    block_t *p_block = cache_->get(cachekey, bytesRange, &type);
+    if(p_block)
+    {
+        vlc_mutex_locker locker( &lock );
+        contentLength = p_block->i_buffer;
+        cachedContentType = type;
+        buffered = p_block->i_buffer;
+        block_ChainLastAppend(&pp_tail, p_block);
+        prepared = true;
+        done = true;
+        vlc_cond_signal(&avail);
+        return true;
+    }
+
+    cache = cache_;
+    cachemax = cache->getMaxEntrySize();
+    return false;
+}
+
+void HTTPChunkBufferedSource::storeInCache()
+{
+    /* Only keep the segments which were completely received, up to their
+     * length or, when it is unknown, up to the end of the data */
+    if(p_cachehead && (!contentLength || cachesize == contentLength))
+    {
+        block_t *p_block = block_ChainGather(p_cachehead);
+        if(p_block)
+            cache->put(cachekey, bytesRange,
+                       connection->getContentType(), p_block);
+    }
+    else if(p_cachehead)
+    {
+        block_ChainRelease(p_cachehead);
+    }
+    p_cachehead = NULL;
+    pp_cachetail = &p_cachehead;
+    cachesize = 0;
+    cache = NULL;
+}
+
 void HTTPChunkBufferedSource::bufferize(size_t readsize)
 {
     vlc_mutex_lock(&lock);
@@ -359,17 +417,41 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     {
         size_t size;
         mtime_t time;
-    } rate = {0,0};
+        mtime_t end;
+    } rate = {0,0,0};
+    bool eofreached = false; /* cleanly, not on error nor cancellation */
 
     ssize_t ret = connection->read(p_block->p_buffer, readsize);
+    if(cache)
+    {
+        /* Keep a copy for the segment cache */
+        block_t *p_copy = NULL;
+        if(ret > 0 && cachesize + ret <= cachemax &&
+           (p_copy = block_Alloc(ret)) != NULL)
+        {
+            memcpy(p_copy->p_buffer, p_block->p_buffer, ret);
+            cachesize += ret;
+            block_ChainLastAppend(&pp_cachetail, p_copy);
+        }
+        else if(ret != 0) /* error, or too large to be cached */
+        {
+            block_ChainRelease(p_cachehead);
+            p_cachehead = NULL;
+            pp_cachetail = &p_cachehead;
+            cache = NULL;
+        }
+    }
+
     if(ret <= 0)
     {
         block_Release(p_block);
         p_block = NULL;
         vlc_mutex_locker locker( &lock );
         done = true;
+        eofreached = (ret == 0);
         rate.size = buffered + consumed;
-        rate.time = mdate() - downloadstart;
+        rate.end = mdate();
+        rate.time = rate.end - downloadstart;
         downloadstart = 0;
     }
     else
@@ -381,17 +463,22 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         if((size_t) ret < readsize)
         {
             done = true;
+            eofreached = true;
             rate.size = buffered + consumed;
-            rate.time = mdate() - downloadstart;
+            rate.end = mdate();
+            rate.time = rate.end - downloadstart;
             downloadstart = 0;
         }
     }
 
     if(rate.size && rate.time)
     {
-        connManager->updateDownloadRate(sourceid, rate.size, rate.time);
+        connManager->updateDownloadRate(sourceid, rate.size, rate.time, rate.end);
     }
 
+    if(cache && eofreached)
+        storeInCache();
+
     vlc_cond_signal(&avail);
 }
 
@@ -405,6 +492,16 @@ bool HTTPChunkBufferedSource::prepare()
     return true;
 }
 
+std::string HTTPChunkBufferedSource::getContentType() const
+{
+    {
+        vlc_mutex_locker locker( &lock );
+        if(!connection)
+            return cachedContentType;
+    }
+    return HTTPChunkSource::getContentType();
+}
+
 bool HTTPChunkBufferedSource::hasMoreData() const
 {
     vlc_mutex_locker locker( &lock );
@@ -41,6 +41,7 @@ namespace adaptive
         class AbstractConnection;
         class AbstractConnectionManager;
         class AbstractChunk;
+        class SegmentCache;
 
         class AbstractChunkSource
         {
@@ -104,10 +105,10 @@ namespace adaptive
                 bool                prepared;
                 bool                eof;
                 ID                  sourceid;
+                ConnectionParams    params;
 
             private:
                 bool init(const std::string &);
-                ConnectionParams    params;
         };
 
         class HTTPChunkBufferedSource : public HTTPChunkSource
@@ -121,13 +122,17 @@ namespace adaptive
                 virtual block_t *  readBlock       (); /* reimpl */
                 virtual block_t *  read            (size_t); /* reimpl */
                 virtual bool       hasMoreData     () const; /* impl */
+                virtual std::string getContentType () const; /* reimpl */
                 void               hold();
                 void               release();
+                bool               attachCache(SegmentCache *);
+                void               setCacheKey(const std::string &);
 
             protected:
                 virtual bool       prepare(); /* reimpl */
                 void               bufferize(size_t);
                 bool               isDone() const;
+                void               storeInCache();
 
             private:
                 block_t            *p_head; /* read cache buffer */
@@ -139,6 +144,13 @@ namespace adaptive
                 mutable vlc_mutex_t lock;
                 vlc_cond_t          avail;
                 bool                held;
+                std::string         cachekey; /* names the content, empty if not cacheable */
+                SegmentCache       *cache;
+                block_t            *p_cachehead; /* copy of the whole segment */
+                block_t           **pp_cachetail;
+                size_t              cachesize;
+                size_t              cachemax;
+                std::string         cachedContentType;
         };
 
         class HTTPChunk : public AbstractChunk
@@ -25,47 +25,65 @@
 
 #include <vlc_threads.h>
 
-#include <atomic>
 
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::StreamQueue::StreamQueue(const ID &id_)
+    : id(id_)
+{
+    busy = false;
+}
+
+Downloader::Downloader(unsigned workers_)
 {
     vlc_mutex_init(&lock);
     vlc_cond_init(&waitcond);
+    vlc_cond_init(&updatedcond);
     killed = false;
-    thread_handle_valid = false;
+    workers = workers_ ? workers_ : 1;
 }
 
 bool Downloader::start()
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread,
-                 static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+    while(threads.size() < workers)
     {
-        return false;
+        vlc_thread_t thread_handle;
+        if(vlc_clone(&thread_handle, downloaderThread,
+                     static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+            break;
+        threads.push_back(thread_handle);
     }
-    thread_handle_valid = true;
-    return true;
+    return !threads.empty();
 }
 
 Downloader::~Downloader()
 {
     vlc_mutex_lock( &lock );
     killed = true;
-    vlc_cond_signal(&waitcond);
+    vlc_cond_broadcast(&waitcond);
     vlc_mutex_unlock( &lock );
 
-    if(thread_handle_valid)
-        vlc_join(thread_handle, NULL);
+    std::vector<vlc_thread_t>::const_iterator it;
+    for(it = threads.begin(); it != threads.end(); ++it)
+        vlc_join(*it, NULL);
     vlc_mutex_destroy(&lock);
     vlc_cond_destroy(&waitcond);
+    vlc_cond_destroy(&updatedcond);
 }
+
 void Downloader::schedule(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
     source->hold();
-    chunks.push_back(source);
+
+    StreamQueues::iterator it;
+    for(it = queues.begin(); it != queues.end(); ++it)
+        if((*it).id == source->sourceid)
+            break;
+    if(it == queues.end())
+        it = queues.insert(queues.end(), StreamQueue(source->sourceid));
+    (*it).sources.push_back(source);
+
     vlc_cond_signal(&waitcond);
     vlc_mutex_unlock(&lock);
 }
@@ -73,8 +91,27 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
+    StreamQueues::iterator it;
+    for(;;)
+    {
+        for(it = queues.begin(); it != queues.end(); ++it)
+            if((*it).id == source->sourceid)
+                break;
+
+        /* Wait for the worker to finish its current step */
+        if(it == queues.end() ||
+           !(*it).busy || (*it).sources.front() != source)
+            break;
+        vlc_cond_wait(&updatedcond, &lock);
+    }
+
+    if(it != queues.end())
+    {
+        (*it).sources.remove(source);
+        if((*it).sources.empty() && !(*it).busy)
+            queues.erase(it);
+    }
     source->release();
-    chunks.remove(source);
     vlc_mutex_unlock(&lock);
 }
 
@@ -93,27 +130,53 @@ void Downloader::DownloadSource(HTTPChunkBufferedSource *source)
         source->bufferize(HTTPChunkSource::CHUNK_SIZE);
 }
 
+Downloader::StreamQueues::iterator Downloader::getNextQueue()
+{
+    for(StreamQueues::iterator it = queues.begin(); it != queues.end(); ++it)
+    {
+        if((*it).busy || (*it).sources.empty())
+            continue;
+        /* Move to the back, so that other streams are served first next time */
+        queues.splice(queues.end(), queues, it);
+        return it;
+    }
+    return queues.end();
+}
+
 void Downloader::Run()
 {
     vlc_mutex_lock(&lock);
     while(1)
     {
-        while(chunks.empty() && !killed)
+        StreamQueues::iterator it = queues.end();
+
+        while(!killed && (it = getNextQueue()) == queues.end())
             vlc_cond_wait(&waitcond, &lock);
 
         if(killed)
             break;
 
-        if(!chunks.empty())
+        StreamQueue &queue = *it;
+        HTTPChunkBufferedSource *source = queue.sources.front();
+
+        /* Download a piece of the segment without holding the lock, so that
+         * the other workers can serve the other streams meanwhile */
+        queue.busy = true;
+        vlc_mutex_unlock(&lock);
+        DownloadSource(source);
+        vlc_mutex_lock(&lock);
+        queue.busy = false;
+
+        if(source->isDone())
         {
-            HTTPChunkBufferedSource *source = chunks.front();
-            DownloadSource(source);
-            if(source->isDone())
-            {
-                chunks.pop_front();
-                source->release();
-            }
+            queue.sources.pop_front();
+            source->release();
+            if(queue.sources.empty())
+                queues.erase(it);
         }
+
+        vlc_cond_broadcast(&updatedcond);
+        vlc_cond_signal(&waitcond);
     }
     vlc_mutex_unlock(&lock);
 }
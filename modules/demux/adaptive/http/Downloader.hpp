@@ -21,9 +21,11 @@
 #define DOWNLOADER_HPP
 
 #include "Chunk.h"
+#include "../ID.hpp"
 
 #include <vlc_common.h>
 #include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -34,22 +36,35 @@ namespace adaptive
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(unsigned = 1);
                 ~Downloader();
                 bool start();
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
 
             private:
+                /* Sources of a same stream, downloaded in order */
+                class StreamQueue
+                {
+                    public:
+                        StreamQueue(const ID &);
+                        ID id;
+                        std::list<HTTPChunkBufferedSource *> sources;
+                        bool busy; /* head is being downloaded by a worker */
+                };
+                typedef std::list<StreamQueue> StreamQueues;
+
                 static void * downloaderThread(void *);
                 void Run();
                 void DownloadSource(HTTPChunkBufferedSource *);
-                vlc_thread_t thread_handle;
+                StreamQueues::iterator getNextQueue();
+                std::vector<vlc_thread_t> threads;
+                unsigned     workers;
                 vlc_mutex_t  lock;
                 vlc_cond_t   waitcond;
-                bool         thread_handle_valid;
+                vlc_cond_t   updatedcond;
                 bool         killed;
-                std::list<HTTPChunkBufferedSource *> chunks;
+                StreamQueues queues; /* served round robin */
         };
 
     }
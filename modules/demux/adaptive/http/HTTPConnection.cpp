@@ -27,9 +27,18 @@
 #include "Transport.hpp"
 #include "../tools/Helper.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <sstream>
 #include <vlc_stream.h>
+#include <vlc_block.h>
+
+extern "C"
+{
+#include "../../../access/http/connmgr.h"
+#include "../../../access/http/message.h"
+#include "../../../access/http/resource.h"
+}
 
 using namespace adaptive::http;
 
@@ -65,6 +74,11 @@ const std::string & AbstractConnection::getContentType() const
     return contentType;
 }
 
+const ConnectionParams & AbstractConnection::getRedirection() const
+{
+    return locationparams;
+}
+
 HTTPConnection::HTTPConnection(vlc_object_t *p_object_, AuthStorage *auth,
                                Transport *socket_, const ConnectionParams &proxy, bool persistent)
     : AbstractConnection( p_object_ )
@@ -452,11 +466,6 @@ std::string HTTPConnection::extraRequestHeaders() const
     return ss.str();
 }
 
-const ConnectionParams & HTTPConnection::getRedirection() const
-{
-    return locationparams;
-}
-
 StreamUrlConnection::StreamUrlConnection(vlc_object_t *p_object)
     : AbstractConnection(p_object)
 {
@@ -567,6 +576,235 @@ void StreamUrlConnection::setUsed( bool b )
        reset();
 }
 
+/* Byte range request, see vlc_http_file for the layout */
+struct adaptive_http_res
+{
+    struct vlc_http_resource resource;
+    struct
+    {
+        bool valid;
+        size_t start;
+        size_t end; /* 0 if open ended */
+    } range;
+};
+
+static int adaptive_http_req(const struct vlc_http_resource *,
+                             struct vlc_http_msg *req, void *opaque)
+{
+    const struct adaptive_http_res *res =
+            container_of(opaque, struct adaptive_http_res, range);
+    if(!res->range.valid)
+        return 0;
+    if(res->range.end)
+        return vlc_http_msg_add_header(req, "Range", "bytes=%zu-%zu",
+                                       res->range.start, res->range.end);
+    return vlc_http_msg_add_header(req, "Range", "bytes=%zu-",
+                                   res->range.start);
+}
+
+static int adaptive_http_resp(const struct vlc_http_resource *,
+                              const struct vlc_http_msg *resp, void *)
+{
+    const int status = vlc_http_msg_get_status(resp);
+    /* let the redirections through, vlc_http_res_get_redirect() follows */
+    return (status / 100 == 2 || status / 100 == 3) ? 0 : -1;
+}
+
+static const struct vlc_http_resource_cbs adaptive_http_callbacks =
+{
+    adaptive_http_req,
+    adaptive_http_resp,
+};
+
+LibVLCHTTPConnection::LibVLCHTTPConnection(vlc_object_t *p_object_, AuthStorage *auth,
+                                           struct vlc_http_mgr *mgr)
+    : AbstractConnection( p_object_ )
+{
+    authStorage = auth;
+    manager = mgr;
+    resource = NULL;
+    p_pending = NULL;
+    psz_useragent = var_InheritString(p_object_, "http-user-agent");
+}
+
+LibVLCHTTPConnection::~LibVLCHTTPConnection()
+{
+    reset();
+    free(psz_useragent);
+}
+
+void LibVLCHTTPConnection::close()
+{
+    if(p_pending)
+        block_Release(p_pending);
+    p_pending = NULL;
+    if(resource)
+        vlc_http_res_destroy(resource);
+    resource = NULL;
+}
+
+void LibVLCHTTPConnection::reset()
+{
+    close();
+    bytesRead = 0;
+    contentLength = 0;
+    contentType = std::string();
+    bytesRange = BytesRange();
+    locationparams = ConnectionParams();
+}
+
+bool LibVLCHTTPConnection::canReuse(const ConnectionParams &params_) const
+{
+    return available &&
+           params.getHostname() == params_.getHostname() &&
+           params.getScheme() == params_.getScheme() &&
+           params.getPort() == params_.getPort() &&
+           authStorage->getHTTPManager(params_) == manager;
+}
+
+int LibVLCHTTPConnection::open(const std::string &url, const BytesRange &range)
+{
+    struct adaptive_http_res *res =
+            (struct adaptive_http_res *) malloc(sizeof(*res));
+    if(unlikely(res == NULL))
+        return VLC_ENOMEM;
+
+    if(vlc_http_res_init(&res->resource, &adaptive_http_callbacks,
+                         manager, url.c_str(),
+                         psz_useragent, NULL))
+    {
+        free(res);
+        return VLC_EGENERIC;
+    }
+
+    res->range.valid = range.isValid();
+    res->range.start = range.getStartByte();
+    res->range.end = range.getEndByte();
+    resource = &res->resource;
+
+    /* Sends the request. The manager only locks its own state, so the
+     * requests of the different streams are not serialized. */
+    const int status = vlc_http_res_get_status(resource);
+    if(status < 0)
+        return VLC_EGENERIC;
+    if(status / 100 == 3)
+        return VLC_ETIMEOUT;
+    return VLC_SUCCESS;
+}
+
+int LibVLCHTTPConnection::request(const std::string &path, const BytesRange &range)
+{
+    reset();
+
+    /* Set new path for this query */
+    params.setPath(path);
+
+    msg_Dbg(p_object, "Retrieving %s @%zu", params.getUrl().c_str(),
+                      range.isValid() ? range.getStartByte() : 0);
+
+    int i_ret = open(params.getUrl(), range);
+    if(i_ret == VLC_ETIMEOUT)
+    {
+        /* The target may be another server: let the caller pick the
+         * connection, as for HTTPConnection */
+        char *psz_redirect = vlc_http_res_get_redirect(resource);
+        reset();
+        if(!psz_redirect)
+            return VLC_EGENERIC;
+        locationparams = ConnectionParams(psz_redirect);
+        free(psz_redirect);
+        msg_Info(p_object, "redirection to %s", locationparams.getUrl().c_str());
+        return VLC_ETIMEOUT;
+    }
+
+    if(i_ret != VLC_SUCCESS)
+    {
+        msg_Err(p_object, "Failed reading %s", params.getUrl().c_str());
+        reset();
+        return i_ret;
+    }
+
+    /* TLS-ALPN did not pick h2: the next requests to this server go
+     * through the HTTP/1.1 connections pool instead */
+    if(!vlc_http_mgr_is_multiplexed(manager))
+        authStorage->setNotMultiplexed(params);
+
+    char *psz_type = vlc_http_res_get_type(resource);
+    if(psz_type)
+    {
+        contentType = std::string(psz_type);
+        free(psz_type);
+    }
+
+    bytesRange = range;
+    const uintmax_t i_size = vlc_http_msg_get_size(resource->response);
+    if(i_size != (uintmax_t) -1)
+        contentLength = i_size;
+    else if(range.isValid() && range.getEndByte() > 0)
+        contentLength = range.getEndByte() - range.getStartByte() + 1;
+
+    return VLC_SUCCESS;
+}
+
+ssize_t LibVLCHTTPConnection::read(void *p_buffer, size_t len)
+{
+    if(!resource)
+        return VLC_EGENERIC;
+
+    if(len == 0)
+        return VLC_SUCCESS;
+
+    const size_t toRead = (contentLength) ? contentLength - bytesRead : len;
+    if (toRead == 0)
+        return VLC_SUCCESS;
+
+    if(len > toRead)
+        len = toRead;
+
+    /* Fill the buffer, as a short read means end of data */
+    size_t copied = 0;
+    while(copied < len)
+    {
+        if(p_pending == NULL)
+        {
+            p_pending = vlc_http_res_read(resource);
+            if(p_pending == NULL)
+                break;
+            if(p_pending == vlc_http_error)
+            {
+                /* Not to be mistaken for the end of the data */
+                p_pending = NULL;
+                close();
+                return -1;
+            }
+        }
+
+        const size_t copy = std::min(len - copied, p_pending->i_buffer);
+        memcpy((uint8_t *) p_buffer + copied, p_pending->p_buffer, copy);
+        copied += copy;
+        p_pending->p_buffer += copy;
+        p_pending->i_buffer -= copy;
+        if(p_pending->i_buffer == 0)
+        {
+            block_Release(p_pending);
+            p_pending = NULL;
+        }
+    }
+
+    bytesRead += copied;
+    if(copied < len || contentLength == bytesRead)
+        close(); /* EOF: give the stream back */
+
+    return copied;
+}
+
+void LibVLCHTTPConnection::setUsed( bool b )
+{
+    available = !b;
+    if(available)
+        reset();
+}
+
 ConnectionFactory::ConnectionFactory( AuthStorage *auth )
 {
     authStorage = auth;
@@ -582,6 +820,15 @@ AbstractConnection * ConnectionFactory::createConnection(vlc_object_t *p_object,
     if((params.getScheme() != "http" && params.getScheme() != "https") || params.getHostname().empty())
         return NULL;
 
+    /* HTTPS goes through the HTTP/2 capable stack, which handles the proxies,
+     * unless the server is known to only speak HTTP/1.1 */
+    if(params.getScheme() == "https" && authStorage)
+    {
+        struct vlc_http_mgr *mgr = authStorage->getHTTPManager(params);
+        if(mgr)
+            return new (std::nothrow) LibVLCHTTPConnection(p_object, authStorage, mgr);
+    }
+
     ConnectionParams proxy;
 
     std::string scheme;
@@ -30,6 +30,9 @@
 #include <vlc_common.h>
 #include <string>
 
+struct vlc_http_mgr;
+struct vlc_http_resource;
+
 namespace adaptive
 {
     namespace http
@@ -52,10 +55,12 @@ namespace adaptive
                 virtual size_t  getContentLength() const;
                 virtual const std::string & getContentType() const;
                 virtual void    setUsed( bool ) = 0;
+                const ConnectionParams &getRedirection() const;
 
             protected:
                 vlc_object_t      *p_object;
                 ConnectionParams   params;
+                ConnectionParams   locationparams;
                 bool               available;
                 size_t             contentLength;
                 std::string        contentType;
@@ -75,7 +80,6 @@ namespace adaptive
                 virtual ssize_t read        (void *p_buffer, size_t len);
 
                 void setUsed( bool );
-                const ConnectionParams &getRedirection() const;
                 static const unsigned MAX_REDIRECTS = 3;
 
             protected:
@@ -96,7 +100,6 @@ namespace adaptive
                 char * psz_useragent;
 
                 AuthStorage        *authStorage;
-                ConnectionParams    locationparams;
                 ConnectionParams    proxyparams;
                 bool                connectionClose;
                 bool                chunked;
@@ -128,6 +131,34 @@ namespace adaptive
                 stream_t *p_streamurl;
        };
 
+       /* Uses the HTTP/2 capable stack of the http access. Requests to the
+        * same server are multiplexed on the connection of the session. The
+        * servers negotiating HTTP/1.1 are left to HTTPConnection */
+       class LibVLCHTTPConnection : public AbstractConnection
+       {
+            public:
+                LibVLCHTTPConnection(vlc_object_t *, AuthStorage *,
+                                     struct vlc_http_mgr *);
+                virtual ~LibVLCHTTPConnection();
+
+                virtual bool    canReuse     (const ConnectionParams &) const;
+
+                virtual int     request     (const std::string& path, const BytesRange & = BytesRange());
+                virtual ssize_t read        (void *p_buffer, size_t len);
+
+                virtual void    setUsed( bool );
+
+            protected:
+                void reset();
+                void close();
+                int  open(const std::string &, const BytesRange &);
+                AuthStorage *authStorage;
+                struct vlc_http_mgr *manager;
+                struct vlc_http_resource *resource;
+                block_t *p_pending; /* received, not yet read */
+                char *psz_useragent;
+       };
+
        class ConnectionFactory
        {
            public:
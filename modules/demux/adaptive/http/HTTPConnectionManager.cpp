@@ -30,6 +30,7 @@
 #include "ConnectionParams.hpp"
 #include "Transport.hpp"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 #include <vlc_url.h>
 #include <vlc_http.h>
 
@@ -47,10 +48,11 @@ AbstractConnectionManager::~AbstractConnectionManager()
 
 }
 
-void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid, size_t size, mtime_t time)
+void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid, size_t size,
+                                                   mtime_t time, mtime_t end)
 {
     if(rateObserver)
-        rateObserver->updateDownloadRate(sourceid, size, time);
+        rateObserver->updateDownloadRate(sourceid, size, time, end);
 }
 
 void AbstractConnectionManager::setDownloadRateObserver(IDownloadRateObserver *obs)
@@ -62,8 +64,12 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, Connec
     : AbstractConnectionManager( p_object_ )
 {
     vlc_mutex_init(&lock);
-    downloader = new (std::nothrow) Downloader();
-    downloader->start();
+    downloader = new (std::nothrow) Downloader(
+                        var_InheritInteger(p_object, "adaptive-download-threads"));
+    if(downloader)
+        downloader->start();
+    cache = SegmentCache::acquire(
+                var_InheritInteger(p_object, "adaptive-cache-size") << 20);
     factory = factory_;
 }
 
@@ -71,8 +77,12 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, AuthSt
     : AbstractConnectionManager( p_object_ )
 {
     vlc_mutex_init(&lock);
-    downloader = new (std::nothrow) Downloader();
-    downloader->start();
+    downloader = new (std::nothrow) Downloader(
+                        var_InheritInteger(p_object, "adaptive-download-threads"));
+    if(downloader)
+        downloader->start();
+    cache = SegmentCache::acquire(
+                var_InheritInteger(p_object, "adaptive-cache-size") << 20);
     if(var_InheritBool(p_object, "adaptive-use-access"))
         factory = new (std::nothrow) StreamUrlConnectionFactory();
     else
@@ -82,6 +92,7 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, AuthSt
 HTTPConnectionManager::~HTTPConnectionManager   ()
 {
     delete downloader;
+    SegmentCache::release(cache);
     delete factory;
     this->closeAllConnections();
     vlc_mutex_destroy(&lock);
@@ -147,7 +158,7 @@ AbstractConnection * HTTPConnectionManager::getConnection(ConnectionParams &para
 void HTTPConnectionManager::start(AbstractChunkSource *source)
 {
     HTTPChunkBufferedSource *src = dynamic_cast<HTTPChunkBufferedSource *>(source);
-    if(src)
+    if(src && !src->attachCache(cache))
         downloader->schedule(src);
 }
 
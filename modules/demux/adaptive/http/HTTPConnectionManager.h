@@ -42,6 +42,7 @@ namespace adaptive
         class AuthStorage;
         class Downloader;
         class AbstractChunkSource;
+        class SegmentCache;
 
         class AbstractConnectionManager : public IDownloadRateObserver
         {
@@ -53,7 +54,7 @@ namespace adaptive
                 virtual void start(AbstractChunkSource *) = 0;
                 virtual void cancel(AbstractChunkSource *) = 0;
 
-                virtual void updateDownloadRate(const ID &, size_t, mtime_t); /* impl */
+                virtual void updateDownloadRate(const ID &, size_t, mtime_t, mtime_t); /* impl */
                 void setDownloadRateObserver(IDownloadRateObserver *);
 
             protected:
@@ -79,6 +80,7 @@ namespace adaptive
             private:
                 void    releaseAllConnections ();
                 Downloader                                         *downloader;
+                SegmentCache                                       *cache;
                 vlc_mutex_t                                         lock;
                 std::vector<AbstractConnection *>                   connectionPool;
                 ConnectionFactory                                  *factory;
@@ -0,0 +1,160 @@
+/*
+ * SegmentCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SegmentCache.hpp"
+
+#include <vlc_block.h>
+
+#include <cassert>
+#include <sstream>
+
+using namespace adaptive::http;
+
+static vlc_mutex_t instance_lock = VLC_STATIC_MUTEX;
+SegmentCache * SegmentCache::instance = NULL;
+
+SegmentCache::SegmentCache(size_t budget_)
+{
+    size = 0;
+    budget = budget_;
+    refs = 0;
+    vlc_mutex_init(&lock);
+}
+
+SegmentCache::~SegmentCache()
+{
+    Entries::iterator it;
+    for(it = entries.begin(); it != entries.end(); ++it)
+        block_Release((*it).data);
+    vlc_mutex_destroy(&lock);
+}
+
+SegmentCache * SegmentCache::acquire(size_t budget)
+{
+    if(budget == 0)
+        return NULL;
+
+    vlc_mutex_lock(&instance_lock);
+    if(instance == NULL)
+        instance = new (std::nothrow) SegmentCache(budget);
+    if(instance)
+    {
+        instance->refs++;
+        vlc_mutex_lock(&instance->lock);
+        /* Use the largest budget requested by the sessions */
+        if(budget > instance->budget)
+            instance->budget = budget;
+        vlc_mutex_unlock(&instance->lock);
+    }
+    SegmentCache *cache = instance;
+    vlc_mutex_unlock(&instance_lock);
+    return cache;
+}
+
+void SegmentCache::release(SegmentCache *cache)
+{
+    if(cache == NULL)
+        return;
+
+    vlc_mutex_lock(&instance_lock);
+    assert(cache == instance);
+    if(--cache->refs == 0)
+    {
+        delete cache;
+        instance = NULL;
+    }
+    vlc_mutex_unlock(&instance_lock);
+}
+
+std::string SegmentCache::makeKey(const std::string &url, const BytesRange &range)
+{
+    if(!range.isValid())
+        return url;
+
+    std::stringstream ss;
+    ss << url << "#" << range.getStartByte() << "-" << range.getEndByte();
+    return ss.str();
+}
+
+size_t SegmentCache::getMaxEntrySize() const
+{
+    vlc_mutex_locker locker(&lock);
+    /* Do not let a single segment flush the whole cache */
+    return budget / 4;
+}
+
+block_t * SegmentCache::get(const std::string &url, const BytesRange &range,
+                            std::string *contentType)
+{
+    const std::string key = makeKey(url, range);
+
+    vlc_mutex_locker locker(&lock);
+    std::map<std::string, Entries::iterator>::iterator it = index.find(key);
+    if(it == index.end())
+        return NULL;
+
+    Entries::iterator entry = (*it).second;
+    block_t *p_block = block_Alloc(entry->data->i_buffer);
+    if(p_block)
+    {
+        memcpy(p_block->p_buffer, entry->data->p_buffer, entry->data->i_buffer);
+        *contentType = entry->contentType;
+        entries.splice(entries.begin(), entries, entry);
+    }
+    return p_block;
+}
+
+void SegmentCache::put(const std::string &url, const BytesRange &range,
+                       const std::string &contentType, block_t *p_block)
+{
+    const std::string key = makeKey(url, range);
+
+    vlc_mutex_locker locker(&lock);
+    if(p_block->i_buffer > budget / 4 || index.find(key) != index.end())
+    {
+        block_Release(p_block);
+        return;
+    }
+
+    evict(p_block->i_buffer);
+
+    Entry entry;
+    entry.key = key;
+    entry.contentType = contentType;
+    entry.data = p_block;
+    entries.push_front(entry);
+    index[key] = entries.begin();
+    size += p_block->i_buffer;
+}
+
+void SegmentCache::evict(size_t needed)
+{
+    while(!entries.empty() && size + needed > budget)
+    {
+        Entry &entry = entries.back();
+        size -= entry.data->i_buffer;
+        block_Release(entry.data);
+        index.erase(entry.key);
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * SegmentCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SEGMENTCACHE_HPP
+#define SEGMENTCACHE_HPP
+
+#include "BytesRange.hpp"
+
+#include <vlc_common.h>
+#include <list>
+#include <map>
+#include <string>
+
+namespace adaptive
+{
+
+    namespace http
+    {
+
+        /* Downloaded segments, keyed by URL, with the sequence number for
+         * the URLs live playlists reuse, and byte range, and shared by all
+         * the adaptive demuxers of the process. Least recently used
+         * segments are evicted once the byte budget is exceeded. */
+        class SegmentCache
+        {
+            public:
+                static SegmentCache * acquire(size_t);
+                static void release(SegmentCache *);
+
+                block_t * get(const std::string &, const BytesRange &,
+                              std::string *);
+                void      put(const std::string &, const BytesRange &,
+                              const std::string &, block_t *);
+                size_t    getMaxEntrySize() const;
+
+            private:
+                SegmentCache(size_t);
+                ~SegmentCache();
+                static std::string makeKey(const std::string &, const BytesRange &);
+                void evict(size_t);
+
+                class Entry
+                {
+                    public:
+                        std::string key;
+                        std::string contentType;
+                        block_t *data;
+                };
+                typedef std::list<Entry> Entries;
+
+                Entries entries; /* most recently used first */
+                std::map<std::string, Entries::iterator> index;
+                size_t size;
+                size_t budget;
+                unsigned refs;
+                mutable vlc_mutex_t lock;
+
+                static SegmentCache *instance;
+        };
+
+    }
+
+}
+
+#endif // SEGMENTCACHE_HPP
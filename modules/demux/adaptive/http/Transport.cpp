@@ -86,7 +86,20 @@ void Transport::disconnect()
 
 ssize_t Transport::read(void *p_buffer, size_t len)
 {
-    return vlc_tls_Read(tls, p_buffer, len, true);
+    /* Wait for all the data here rather than in vlc_tls_Read(), which
+     * returns what it got before a failure: a short read is then always the
+     * end of the stream */
+    size_t total = 0;
+    while(total < len)
+    {
+        ssize_t ret = vlc_tls_Read(tls, (uint8_t *) p_buffer + total, len - total, false);
+        if(ret < 0)
+            return -1;
+        if(ret == 0)
+            break;
+        total += ret;
+    }
+    return total;
 }
 
 std::string Transport::readline()
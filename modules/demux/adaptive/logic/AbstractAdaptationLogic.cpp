@@ -35,13 +35,14 @@ AbstractAdaptationLogic::AbstractAdaptationLogic    ()
 {
     maxwidth = std::numeric_limits<int>::max();
     maxheight = std::numeric_limits<int>::max();
+    estimatorType = BandwidthEstimator::Default;
 }
 
 AbstractAdaptationLogic::~AbstractAdaptationLogic   ()
 {
 }
 
-void AbstractAdaptationLogic::updateDownloadRate    (const adaptive::ID &, size_t, mtime_t)
+void AbstractAdaptationLogic::updateDownloadRate    (const adaptive::ID &, size_t, mtime_t, mtime_t)
 {
 }
 
@@ -50,3 +51,8 @@ void AbstractAdaptationLogic::setMaxDeviceResolution (int w, int h)
     maxwidth = (w > 0) ? w : std::numeric_limits<int>::max();
     maxheight = (h > 0) ? h : std::numeric_limits<int>::max();
 }
+
+void AbstractAdaptationLogic::setBandwidthEstimator(BandwidthEstimator::EstimatorType type)
+{
+    estimatorType = type;
+}
@@ -26,6 +26,7 @@
 #define ABSTRACTADAPTATIONLOGIC_H_
 
 #include "IDownloadRateObserver.h"
+#include "BandwidthEstimator.hpp"
 #include "../SegmentTracker.hpp"
 
 namespace adaptive
@@ -48,9 +49,10 @@ namespace adaptive
                 virtual ~AbstractAdaptationLogic    ();
 
                 virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *) = 0;
-                virtual void                updateDownloadRate     (const ID &, size_t, mtime_t);
+                virtual void                updateDownloadRate     (const ID &, size_t, mtime_t, mtime_t);
                 virtual void                trackerEvent           (const SegmentTrackerEvent &) {}
                 void                        setMaxDeviceResolution (int, int);
+                virtual void                setBandwidthEstimator  (BandwidthEstimator::EstimatorType);
 
                 enum LogicType
                 {
@@ -66,6 +68,7 @@ namespace adaptive
             protected:
                 int maxwidth;
                 int maxheight;
+                BandwidthEstimator::EstimatorType estimatorType;
         };
     }
 }
@@ -0,0 +1,114 @@
+/*
+ * BandwidthEstimator.cpp
+ *****************************************************************************
+ * Copyright (C) 2016 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "BandwidthEstimator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace adaptive::logic;
+
+#define WINDOW_SIZE         10
+#define PERCENTILE          25  /* conservative: 3 samples of 4 are above */
+#define EWMA_FAST_HALFLIFE  3.0 /* seconds */
+#define EWMA_SLOW_HALFLIFE  8.0
+
+BandwidthEstimator::BandwidthEstimator(EstimatorType type_)
+    : type( type_ )
+    , estimate( 0 )
+    , ewmaFast( 0.0 )
+    , ewmaSlow( 0.0 )
+    , ewmaWeight( 0 )
+{
+}
+
+size_t BandwidthEstimator::get() const
+{
+    return estimate;
+}
+
+size_t BandwidthEstimator::push(size_t size, mtime_t time)
+{
+    if(unlikely(time <= 0 || size == 0))
+        return estimate;
+
+    const size_t bps = CLOCK_FREQ * size * 8 / time;
+
+    switch(type)
+    {
+        case Ewma:
+            estimate = pushEwma(bps, time);
+            break;
+        case HarmonicMean:
+        case Percentile:
+            estimate = pushWindow(bps);
+            break;
+        case Default:
+        default:
+            estimate = average.push(bps);
+            break;
+    }
+
+    return estimate;
+}
+
+size_t BandwidthEstimator::pushWindow(size_t bps)
+{
+    if(window.size() >= WINDOW_SIZE)
+        window.pop_front();
+    window.push_back(bps);
+
+    if(type == HarmonicMean)
+    {
+        /* Penalizes the outliers on the high side */
+        double invsum = 0.0;
+        std::list<size_t>::const_iterator it;
+        for(it = window.begin(); it != window.end(); ++it)
+            invsum += 1.0 / (*it);
+        return window.size() / invsum;
+    }
+
+    std::vector<size_t> sorted(window.begin(), window.end());
+    std::vector<size_t>::iterator nth = sorted.begin() + sorted.size() * PERCENTILE / 100;
+    std::nth_element(sorted.begin(), nth, sorted.end());
+    return *nth;
+}
+
+size_t BandwidthEstimator::pushEwma(size_t bps, mtime_t time)
+{
+    /* Samples are weighted by their duration. The fast average reacts to
+     * drops, the slow one to the short peaks: the lowest one wins. */
+    const double seconds = (double) time / CLOCK_FREQ;
+    const double alphaFast = pow(0.5, seconds / EWMA_FAST_HALFLIFE);
+    const double alphaSlow = pow(0.5, seconds / EWMA_SLOW_HALFLIFE);
+    ewmaFast = alphaFast * ewmaFast + (1.0 - alphaFast) * bps;
+    ewmaSlow = alphaSlow * ewmaSlow + (1.0 - alphaSlow) * bps;
+    ewmaWeight += time;
+
+    /* Remove the bias toward the zero initial value */
+    const double weight = (double) ewmaWeight / CLOCK_FREQ;
+    const double fast = ewmaFast / (1.0 - pow(0.5, weight / EWMA_FAST_HALFLIFE));
+    const double slow = ewmaSlow / (1.0 - pow(0.5, weight / EWMA_SLOW_HALFLIFE));
+    return std::min(fast, slow);
+}
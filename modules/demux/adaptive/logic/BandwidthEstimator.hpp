@@ -0,0 +1,64 @@
+/*
+ * BandwidthEstimator.hpp
+ *****************************************************************************
+ * Copyright (C) 2016 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef BANDWIDTHESTIMATOR_HPP
+#define BANDWIDTHESTIMATOR_HPP
+
+#include "../tools/MovingAverage.hpp"
+
+#include <vlc_common.h>
+#include <list>
+
+namespace adaptive
+{
+    namespace logic
+    {
+        /* Estimates the available bandwidth from the download samples
+         * reported to the logics through updateDownloadRate() */
+        class BandwidthEstimator
+        {
+            public:
+                enum EstimatorType
+                {
+                    Default = 0, /* moving average */
+                    Ewma,
+                    HarmonicMean,
+                    Percentile,
+                };
+
+                BandwidthEstimator(EstimatorType = Default);
+                size_t push(size_t, mtime_t); /* bytes, duration; returns bps */
+                size_t get() const;
+
+            private:
+                size_t pushWindow(size_t);
+                size_t pushEwma(size_t, mtime_t);
+
+                EstimatorType type;
+                size_t estimate;
+                MovingAverage<size_t> average;
+                std::list<size_t> window;
+                double ewmaFast;
+                double ewmaSlow;
+                mtime_t ewmaWeight;
+        };
+    }
+}
+
+#endif // BANDWIDTHESTIMATOR_HPP
@@ -34,7 +34,8 @@ namespace adaptive
     class IDownloadRateObserver
     {
         public:
-            virtual void updateDownloadRate(const ID &, size_t, mtime_t) = 0;
+            /* size bytes were received in time, until the end date */
+            virtual void updateDownloadRate(const ID &, size_t, mtime_t, mtime_t) = 0;
             virtual ~IDownloadRateObserver(){}
     };
 }
@@ -43,11 +43,12 @@ using namespace adaptive;
 #define minimumBufferS (CLOCK_FREQ * 6)  /* Qmin */
 #define bufferTargetS  (CLOCK_FREQ * 30) /* Qmax */
 
-NearOptimalContext::NearOptimalContext()
+NearOptimalContext::NearOptimalContext(BandwidthEstimator::EstimatorType type)
     : buffering_min( minimumBufferS )
     , buffering_level( 0 )
     , buffering_target( bufferTargetS )
     , last_download_rate( 0 )
+    , estimator( type )
 { }
 
 NearOptimalAdaptationLogic::NearOptimalAdaptationLogic()
@@ -177,14 +178,14 @@ unsigned NearOptimalAdaptationLogic::getMaxCurrentBw() const
     return i_max_bitrate;
 }
 
-void NearOptimalAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize, mtime_t time)
+void NearOptimalAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize, mtime_t time, mtime_t)
 {
     vlc_mutex_lock(&lock);
     std::map<ID, NearOptimalContext>::iterator it = streams.find(id);
     if(it != streams.end())
     {
         NearOptimalContext &ctx = (*it).second;
-        ctx.last_download_rate = ctx.average.push(CLOCK_FREQ * dlsize * 8 / time);
+        ctx.last_download_rate = ctx.estimator.push(dlsize, time);
     }
     currentBps = getMaxCurrentBw();
     vlc_mutex_unlock(&lock);
@@ -214,7 +215,7 @@ void NearOptimalAdaptationLogic::trackerEvent(const SegmentTrackerEvent &event)
             {
                 if(streams.find(id) == streams.end())
                 {
-                    NearOptimalContext ctx;
+                    NearOptimalContext ctx(estimatorType);
                     streams.insert(std::pair<ID, NearOptimalContext>(id, ctx));
                 }
             }
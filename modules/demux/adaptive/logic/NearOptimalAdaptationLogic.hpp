@@ -22,7 +22,6 @@
 
 #include "AbstractAdaptationLogic.h"
 #include "Representationselectors.hpp"
-#include "../tools/MovingAverage.hpp"
 #include <map>
 
 namespace adaptive
@@ -34,14 +33,14 @@ namespace adaptive
             friend class NearOptimalAdaptationLogic;
 
             public:
-                NearOptimalContext();
+                NearOptimalContext(BandwidthEstimator::EstimatorType = BandwidthEstimator::Default);
 
             private:
                 mtime_t buffering_min;
                 mtime_t buffering_level;
                 mtime_t buffering_target;
                 unsigned last_download_rate;
-                MovingAverage<unsigned> average;
+                BandwidthEstimator estimator;
         };
 
         class NearOptimalAdaptationLogic : public AbstractAdaptationLogic
@@ -51,7 +50,7 @@ namespace adaptive
                 virtual ~NearOptimalAdaptationLogic();
 
                 virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *);
-                virtual void                updateDownloadRate     (const ID &, size_t, mtime_t); /* reimpl */
+                virtual void                updateDownloadRate     (const ID &, size_t, mtime_t, mtime_t); /* reimpl */
                 virtual void                trackerEvent           (const SegmentTrackerEvent &); /* reimpl */
 
             private:
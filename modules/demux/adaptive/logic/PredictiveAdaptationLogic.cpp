@@ -40,7 +40,8 @@ using namespace adaptive;
  * https://www.cs.princeton.edu/~jrex/papers/hotmobile15.pdf
  */
 
-PredictiveStats::PredictiveStats()
+PredictiveStats::PredictiveStats(BandwidthEstimator::EstimatorType type)
+    : estimator( type )
 {
     segments_count = 0;
     buffering_level = 0;
@@ -153,14 +154,14 @@ BaseRepresentation *PredictiveAdaptationLogic::getNextRepresentation(BaseAdaptat
     return rep;
 }
 
-void PredictiveAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize, mtime_t time)
+void PredictiveAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize, mtime_t time, mtime_t)
 {
     vlc_mutex_lock(&lock);
     std::map<ID, PredictiveStats>::iterator it = streams.find(id);
     if(it != streams.end())
     {
         PredictiveStats &stats = (*it).second;
-        stats.last_download_rate = stats.average.push(CLOCK_FREQ * dlsize * 8 / time);
+        stats.last_download_rate = stats.estimator.push(dlsize, time);
     }
     vlc_mutex_unlock(&lock);
 }
@@ -202,7 +203,7 @@ void PredictiveAdaptationLogic::trackerEvent(const SegmentTrackerEvent &event)
             {
                 if(streams.find(id) == streams.end())
                 {
-                    PredictiveStats stats;
+                    PredictiveStats stats(estimatorType);
                     streams.insert(std::pair<ID, PredictiveStats>(id, stats));
                 }
             }
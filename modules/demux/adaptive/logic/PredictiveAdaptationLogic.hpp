@@ -21,7 +21,6 @@
 #define PREDICTIVEADAPTATIONLOGIC_HPP
 
 #include "AbstractAdaptationLogic.h"
-#include "../tools/MovingAverage.hpp"
 #include <map>
 
 namespace adaptive
@@ -33,7 +32,7 @@ namespace adaptive
             friend class PredictiveAdaptationLogic;
 
             public:
-                PredictiveStats();
+                PredictiveStats(BandwidthEstimator::EstimatorType = BandwidthEstimator::Default);
                 bool starting() const;
 
             private:
@@ -42,7 +41,7 @@ namespace adaptive
                 mtime_t buffering_target;
                 unsigned last_download_rate;
                 mtime_t last_duration;
-                MovingAverage<unsigned> average;
+                BandwidthEstimator estimator;
         };
 
         class PredictiveAdaptationLogic : public AbstractAdaptationLogic
@@ -52,7 +51,7 @@ namespace adaptive
                 virtual ~PredictiveAdaptationLogic();
 
                 virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *);
-                virtual void                updateDownloadRate     (const ID &, size_t, mtime_t); /* reimpl */
+                virtual void                updateDownloadRate     (const ID &, size_t, mtime_t, mtime_t); /* reimpl */
                 virtual void                trackerEvent           (const SegmentTrackerEvent &); /* reimpl */
 
             private:
@@ -33,6 +33,8 @@
 #include "../http/Chunk.h"
 #include "../tools/Debug.hpp"
 
+#include <algorithm>
+
 using namespace adaptive::logic;
 using namespace adaptive;
 
@@ -45,6 +47,7 @@ RateBasedAdaptationLogic::RateBasedAdaptationLogic  (vlc_object_t *p_obj_) :
     dllength = 0;
     p_obj = p_obj_;
     dlsize = 0;
+    busystart = busyend = countedend = 0;
     vlc_mutex_init(&lock);
 }
 
@@ -78,35 +81,66 @@ BaseRepresentation *RateBasedAdaptationLogic::getNextRepresentation(BaseAdaptati
     return rep;
 }
 
-void RateBasedAdaptationLogic::updateDownloadRate(const ID &, size_t size, mtime_t time)
+void RateBasedAdaptationLogic::updateDownloadRate(const ID &, size_t size,
+                                                  mtime_t time, mtime_t end)
 {
     if(unlikely(time == 0))
         return;
-    /* Accumulate up to observation window */
-    dllength += time;
+
+    /* Segments can be downloaded by several threads: the throughput is the
+     * size over the wall clock time during which any download was active,
+     * so overlapping samples are merged instead of having their time summed */
+    vlc_mutex_lock(&lock);
+
+    const mtime_t start = end - time;
+    if(start > busyend)
+    {
+        /* Idle since the previous downloads */
+        dllength += busyend - busystart;
+        countedend = busyend;
+        busystart = start;
+    }
+    else if(start < busystart)
+    {
+        busystart = std::max(start, countedend);
+    }
+    busyend = std::max(busyend, end);
     dlsize += size;
 
-    if(dllength < CLOCK_FREQ / 4)
+    /* Accumulate up to observation window */
+    const mtime_t length = dllength + busyend - busystart;
+    if(length < CLOCK_FREQ / 4)
+    {
+        vlc_mutex_unlock(&lock);
         return;
+    }
 
-    const size_t bps = CLOCK_FREQ * dlsize * 8 / dllength;
-
-    vlc_mutex_lock(&lock);
-    bpsAvg = average.push(bps);
+    dllength = length;
+    bpsAvg = estimator.push(dlsize, dllength);
 
 //    BwDebug(msg_Dbg(p_obj, "alpha1 %lf alpha0 %lf dmax %ld ds %ld", alpha,
 //                    (double)deltamax / diffsum, deltamax, diffsum));
     BwDebug(msg_Dbg(p_obj, "bw estimation bps %zu -> avg %zu",
-                            bps / 8000, bpsAvg / 8000));
+                            (size_t)(CLOCK_FREQ * dlsize * 8 / dllength) / 8000,
+                            bpsAvg / 8000));
 
     currentBps = bpsAvg * 3/4;
     dlsize = dllength = 0;
+    busystart = countedend = busyend;
 
     BwDebug(msg_Info(p_obj, "Current bandwidth %zu KiB/s using %u%%",
                     (bpsAvg / 8000), (bpsAvg) ? (unsigned)(usedBps * 100.0 / bpsAvg) : 0));
     vlc_mutex_unlock(&lock);
 }
 
+void RateBasedAdaptationLogic::setBandwidthEstimator(BandwidthEstimator::EstimatorType type)
+{
+    vlc_mutex_lock(&lock);
+    AbstractAdaptationLogic::setBandwidthEstimator(type);
+    estimator = BandwidthEstimator(type);
+    vlc_mutex_unlock(&lock);
+}
+
 void RateBasedAdaptationLogic::trackerEvent(const SegmentTrackerEvent &event)
 {
     if(event.type == SegmentTrackerEvent::SWITCHING)
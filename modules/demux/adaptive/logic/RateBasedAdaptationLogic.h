@@ -26,7 +26,6 @@
 #define RATEBASEDADAPTATIONLOGIC_H_
 
 #include "AbstractAdaptationLogic.h"
-#include "../tools/MovingAverage.hpp"
 
 namespace adaptive
 {
@@ -40,8 +39,9 @@ namespace adaptive
                 virtual ~RateBasedAdaptationLogic   ();
 
                 BaseRepresentation *getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *);
-                virtual void updateDownloadRate(const ID &, size_t, mtime_t); /* reimpl */
+                virtual void updateDownloadRate(const ID &, size_t, mtime_t, mtime_t); /* reimpl */
                 virtual void trackerEvent(const SegmentTrackerEvent &); /* reimpl */
+                virtual void setBandwidthEstimator(BandwidthEstimator::EstimatorType); /* reimpl */
 
             private:
                 size_t                  bpsAvg;
@@ -49,10 +49,13 @@ namespace adaptive
                 size_t                  usedBps;
                 vlc_object_t *          p_obj;
 
-                MovingAverage<size_t>   average;
+                BandwidthEstimator      estimator;
 
                 size_t                  dlsize;
                 mtime_t                 dllength;
+                mtime_t                 busystart;  /* downloads active since */
+                mtime_t                 busyend;    /* and until */
+                mtime_t                 countedend; /* end of the time in dllength */
 
                 vlc_mutex_t             lock;
         };
@@ -77,6 +77,23 @@ SegmentChunk* ISegment::toChunk(size_t index, BaseRepresentation *rep, AbstractC
         if(startByte != endByte)
             source->setBytesRange(BytesRange(startByte, endByte));
 
+        /* Live playlists can reuse a media URL for new content. Templates
+         * put the segment number or time in the URL, and the init segments
+         * do not change, but other segments need their sequence number in
+         * the cache key, and are not cached without one. */
+        if(rep->getPlaylist()->isLive() && !templated &&
+           classId != InitSegment::CLASSID_INITSEGMENT)
+        {
+            if(sequence != SEQUENCE_INVALID)
+            {
+                std::stringstream ss;
+                ss.imbue(std::locale("C"));
+                ss << url << " #" << sequence;
+                source->setCacheKey(ss.str());
+            }
+            else source->setCacheKey(std::string());
+        }
+
         SegmentChunk *chunk = new (std::nothrow) SegmentChunk(this, source, rep);
         if( chunk )
         {
@@ -0,0 +1,343 @@
+/*
+ * replay.cpp: replays download traces through the adaptation logics
+ *****************************************************************************
+ * Copyright (C) 2016 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Usage: adaptive_logic_replay [trace [logic [estimator]]]
+ *
+ * A trace is a text file of download samples, one per line:
+ *     <size in bytes> <duration in us> [<buffer level in us>]
+ * Each sample gives the network throughput during its duration. The
+ * recorded buffer level is ignored, as the simulated one depends on the
+ * representations the logic picks. Lines starting with '#' are comments.
+ *
+ * Segments of SEGMENT_DURATION are downloaded at the throughput of the
+ * trace, and the rebuffering events, the average bitrate and the number
+ * of switches are reported. Without a trace, a synthetic one is replayed
+ * through every logic and the results are sanity checked.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../logic/AbstractAdaptationLogic.h"
+#include "../logic/AlwaysBestAdaptationLogic.h"
+#include "../logic/AlwaysLowestAdaptationLogic.hpp"
+#include "../logic/NearOptimalAdaptationLogic.hpp"
+#include "../logic/PredictiveAdaptationLogic.hpp"
+#include "../logic/RateBasedAdaptationLogic.h"
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BaseRepresentation.h"
+#include "../SegmentTracker.hpp"
+#include "../ID.hpp"
+
+#include <vlc_common.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace adaptive;
+using namespace adaptive::logic;
+using namespace adaptive::playlist;
+
+#define SEGMENT_DURATION (CLOCK_FREQ * 2)
+#define BUFFER_MINIMUM   (CLOCK_FREQ * 6)
+#define BUFFER_TARGET    (CLOCK_FREQ * 30)
+
+static const uint64_t bandwidths[] = { 250000, 500000, 1000000,
+                                       2000000, 4000000, 8000000 };
+
+struct TraceSample
+{
+    size_t size;
+    mtime_t duration;
+};
+
+struct ReplayStats
+{
+    unsigned segments;
+    unsigned rebuffers;
+    mtime_t stalled;
+    unsigned switches;
+    uint64_t bitrate; /* average */
+};
+
+static const struct
+{
+    const char *name;
+    AbstractAdaptationLogic::LogicType type;
+} logics[] = {
+    { "nearoptimal", AbstractAdaptationLogic::NearOptimal },
+    { "predictive",  AbstractAdaptationLogic::Predictive },
+    { "rate",        AbstractAdaptationLogic::RateBased },
+    { "lowest",      AbstractAdaptationLogic::AlwaysLowest },
+    { "highest",     AbstractAdaptationLogic::AlwaysBest },
+};
+
+static const char *const estimators[] = {
+    "average", "ewma", "harmonic", "percentile",
+};
+
+static AbstractAdaptationLogic *CreateLogic(AbstractAdaptationLogic::LogicType type)
+{
+    switch(type)
+    {
+        case AbstractAdaptationLogic::AlwaysLowest:
+            return new AlwaysLowestAdaptationLogic();
+        case AbstractAdaptationLogic::AlwaysBest:
+            return new AlwaysBestAdaptationLogic();
+        case AbstractAdaptationLogic::RateBased:
+            return new RateBasedAdaptationLogic(NULL);
+        case AbstractAdaptationLogic::Predictive:
+            return new PredictiveAdaptationLogic(NULL);
+        default:
+            return new NearOptimalAdaptationLogic();
+    }
+}
+
+static bool LoadTrace(const char *psz_path, std::vector<TraceSample> &trace)
+{
+    FILE *f = fopen(psz_path, "r");
+    if(!f)
+    {
+        perror(psz_path);
+        return false;
+    }
+
+    char line[256];
+    while(fgets(line, sizeof(line), f))
+    {
+        unsigned long long size;
+        long long duration;
+        if(line[0] == '#' || sscanf(line, "%llu %lld", &size, &duration) != 2)
+            continue;
+        if(duration <= 0)
+            continue;
+        TraceSample sample = { (size_t) size, (mtime_t) duration };
+        trace.push_back(sample);
+    }
+    fclose(f);
+    return !trace.empty();
+}
+
+static void SyntheticTrace(std::vector<TraceSample> &trace)
+{
+    /* 6 Mbps, a drop to 600 kbps, then a slow recovery */
+    static const struct { unsigned bps; unsigned seconds; } steps[] = {
+        { 6000000, 60 }, { 600000, 30 }, { 1500000, 30 }, { 3000000, 60 },
+    };
+    for(size_t i = 0; i < ARRAY_SIZE(steps); i++)
+    {
+        for(unsigned j = 0; j < steps[i].seconds; j++)
+        {
+            TraceSample sample = { steps[i].bps / 8, CLOCK_FREQ };
+            trace.push_back(sample);
+        }
+    }
+}
+
+/* Returns the time needed to download size bytes from the trace position,
+ * or -1 if the trace ends first */
+static mtime_t Download(const std::vector<TraceSample> &trace,
+                        size_t *pi_sample, mtime_t *pi_offset, size_t size)
+{
+    mtime_t elapsed = 0;
+    while(size)
+    {
+        if(*pi_sample >= trace.size())
+            return -1;
+
+        const TraceSample &sample = trace[*pi_sample];
+        const mtime_t remain = sample.duration - *pi_offset;
+        const size_t avail = (uint64_t) sample.size * remain / sample.duration;
+        if(avail > size)
+        {
+            const mtime_t spent = (uint64_t) size * sample.duration / sample.size;
+            *pi_offset += spent;
+            elapsed += spent;
+            size = 0;
+        }
+        else
+        {
+            size -= avail;
+            elapsed += remain;
+            *pi_offset = 0;
+            (*pi_sample)++;
+        }
+    }
+    return elapsed;
+}
+
+/* Advances the trace position by time */
+static void Idle(const std::vector<TraceSample> &trace,
+                 size_t *pi_sample, mtime_t *pi_offset, mtime_t time)
+{
+    while(time > 0 && *pi_sample < trace.size())
+    {
+        const mtime_t remain = trace[*pi_sample].duration - *pi_offset;
+        if(time < remain)
+        {
+            *pi_offset += time;
+            return;
+        }
+        time -= remain;
+        *pi_offset = 0;
+        (*pi_sample)++;
+    }
+}
+
+static ReplayStats Replay(AbstractAdaptationLogic *logic,
+                          const std::vector<TraceSample> &trace)
+{
+    ReplayStats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    BaseAdaptationSet *set = new BaseAdaptationSet(NULL);
+    set->setID(ID("replay"));
+    for(size_t i = 0; i < ARRAY_SIZE(bandwidths); i++)
+    {
+        BaseRepresentation *rep = new BaseRepresentation(set);
+        rep->setBandwidth(bandwidths[i]);
+        set->addRepresentation(rep);
+    }
+    const ID &id = set->getID();
+
+    logic->trackerEvent(SegmentTrackerEvent(id, true));
+
+    BaseRepresentation *prev = NULL;
+    size_t sample = 0;
+    mtime_t offset = 0;
+    mtime_t buffer = 0;
+    mtime_t now = 0;
+    bool playing = false;
+    uint64_t bitratesum = 0;
+
+    for(;;)
+    {
+        BaseRepresentation *rep = logic->getNextRepresentation(set, prev);
+        if(rep == NULL)
+            break;
+        if(rep != prev)
+        {
+            if(prev)
+                stats.switches++;
+            logic->trackerEvent(SegmentTrackerEvent(prev, rep));
+            prev = rep;
+        }
+        logic->trackerEvent(SegmentTrackerEvent(id, SEGMENT_DURATION));
+
+        const size_t size = rep->getBandwidth() * SEGMENT_DURATION / 8 / CLOCK_FREQ;
+        const mtime_t time = Download(trace, &sample, &offset, size);
+        if(time < 0)
+            break;
+        now += time;
+
+        /* Playback drains the buffer during the download */
+        buffer -= time;
+        if(buffer < 0)
+        {
+            if(playing)
+            {
+                stats.rebuffers++;
+                stats.stalled -= buffer;
+            }
+            buffer = 0;
+        }
+        buffer += SEGMENT_DURATION;
+        playing = true;
+
+        stats.segments++;
+        bitratesum += rep->getBandwidth();
+
+        logic->updateDownloadRate(id, size, time, now);
+        logic->trackerEvent(SegmentTrackerEvent(id, BUFFER_MINIMUM, buffer, BUFFER_TARGET));
+
+        if(buffer > BUFFER_TARGET)
+        {
+            Idle(trace, &sample, &offset, buffer - BUFFER_TARGET);
+            now += buffer - BUFFER_TARGET;
+            buffer = BUFFER_TARGET;
+        }
+    }
+
+    if(stats.segments)
+        stats.bitrate = bitratesum / stats.segments;
+
+    logic->trackerEvent(SegmentTrackerEvent(id, false));
+    delete set;
+    return stats;
+}
+
+static void Report(const char *psz_logic, const char *psz_estimator,
+                   const ReplayStats &stats)
+{
+    printf("%-12s %-11s segments %4u rebuffers %3u (%6.1fs) "
+           "bitrate %5" PRIu64 " kbps switches %3u\n",
+           psz_logic, psz_estimator, stats.segments, stats.rebuffers,
+           (double) stats.stalled / CLOCK_FREQ, stats.bitrate / 1000,
+           stats.switches);
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<TraceSample> trace;
+    const bool synthetic = argc < 2;
+
+    if(synthetic)
+        SyntheticTrace(trace);
+    else if(!LoadTrace(argv[1], trace))
+        return 1;
+
+    int ret = 0;
+    for(size_t i = 0; i < ARRAY_SIZE(logics); i++)
+    {
+        if(argc > 2 && strcmp(argv[2], logics[i].name))
+            continue;
+
+        for(size_t j = 0; j < ARRAY_SIZE(estimators); j++)
+        {
+            if(argc > 3 && strcmp(argv[3], estimators[j]))
+                continue;
+
+            AbstractAdaptationLogic *logic = CreateLogic(logics[i].type);
+            logic->setBandwidthEstimator((BandwidthEstimator::EstimatorType) j);
+            ReplayStats stats = Replay(logic, trace);
+            delete logic;
+
+            Report(logics[i].name, estimators[j], stats);
+
+            if(!synthetic)
+                continue;
+            /* The whole trace must have been used, and the fixed logics
+             * can not switch */
+            if(stats.segments == 0 ||
+               (stats.switches && (logics[i].type == AbstractAdaptationLogic::AlwaysLowest ||
+                                   logics[i].type == AbstractAdaptationLogic::AlwaysBest)))
+                ret = 1;
+            /* The lowest representation always fits in that trace */
+            if(logics[i].type == AbstractAdaptationLogic::AlwaysLowest && stats.rebuffers)
+                ret = 1;
+        }
+    }
+
+    return ret;
+}
@@ -36,6 +36,9 @@
 #include "pes.h"
 #include "ps.h"
 
+/* Longest PES header, up to the payload */
+#define PS_PES_HEADER_MAX (9 + 255)
+
 /* TODO:
  *  - re-add pre-scanning.
  *  - ...
@@ -121,6 +124,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args );
 
 static int      ps_pkt_resynch( stream_t *, int, bool );
 static block_t *ps_pkt_read   ( stream_t * );
+static bool     ps_pkt_is_splittable( const ps_track_t *, const block_t * );
 
 /*****************************************************************************
  * Open
@@ -331,7 +335,7 @@ static int Probe( demux_t *p_demux, bool b_end )
         p_sys->b_have_pack = true;
     }
 
-    block_Release( p_pkt );
+    block_ChainRelease( p_pkt );
     return VLC_DEMUXER_SUCCESS;
 }
 
@@ -650,11 +654,23 @@ static int Demux( demux_t *p_demux )
                     p_pkt->i_buffer -= 14;
                 }
 #endif
-                es_out_Send( p_demux->out, tk->es, p_pkt );
+                if( p_pkt->p_next != NULL && !ps_pkt_is_splittable( tk, p_pkt ) )
+                    p_pkt = block_ChainGather( p_pkt );
+
+                /* Send the pieces of the PES in turn: only the first one has
+                 * timestamps, the packetizer joins them */
+                while( p_pkt != NULL )
+                {
+                    block_t *p_next = p_pkt->p_next;
+
+                    p_pkt->p_next = NULL;
+                    es_out_Send( p_demux->out, tk->es, p_pkt );
+                    p_pkt = p_next;
+                }
             }
             else
             {
-                block_Release( p_pkt );
+                block_ChainRelease( p_pkt );
             }
 
             p_sys->i_pack_scr = -1;
@@ -884,6 +900,19 @@ static int ps_pkt_resynch( stream_t *s, int format, bool b_pack )
     return vlc_stream_Read( s, NULL, i_skip ) == i_skip ? 0 : -1;
 }
 
+/* Reads a video PES as a chain of blocks referencing the stream data,
+ * instead of copying these large packets. The PES header is kept in the
+ * first block, so that it can be parsed in place. */
+static block_t *ps_pkt_read_chain( stream_t *s, int i_size )
+{
+    block_t *p_chain = vlc_stream_ReadChain( s, i_size );
+
+    if( p_chain != NULL && p_chain->p_next != NULL &&
+        p_chain->i_buffer < __MIN( (size_t)i_size, PS_PES_HEADER_MAX ) )
+        p_chain = block_ChainGather( p_chain );
+    return p_chain;
+}
+
 static block_t *ps_pkt_read( stream_t *s )
 {
     const uint8_t *p_peek;
@@ -917,8 +946,36 @@ static block_t *ps_pkt_read( stream_t *s )
     else
     {
         /* Normal case */
+        if( p_peek[3] >= 0xe0 && p_peek[3] <= 0xef )
+            return ps_pkt_read_chain( s, i_size );
         return vlc_stream_Block( s, i_size );
     }
 
     return NULL;
 }
+
+/* Tells whether the pieces of a PES can be sent separately. The packetizers
+ * of these codecs join them, and give the timestamps to the unit whose start
+ * code is in the first piece, as they would with the whole PES. */
+static bool ps_pkt_is_splittable( const ps_track_t *tk, const block_t *p_pkt )
+{
+    switch( tk->fmt.i_codec )
+    {
+        case VLC_CODEC_MPGV:
+        case VLC_CODEC_MP4V:
+        case VLC_CODEC_H264:
+        case VLC_CODEC_HEVC:
+        case VLC_CODEC_VC1:
+            break;
+        default:
+            return false;
+    }
+
+    for( size_t i = 2; i < p_pkt->i_buffer; i++ )
+    {
+        if( p_pkt->p_buffer[i] == 0x01 && p_pkt->p_buffer[i-1] == 0x00 &&
+            p_pkt->p_buffer[i-2] == 0x00 )
+            return true;
+    }
+    return false;
+}
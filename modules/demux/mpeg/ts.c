@@ -35,6 +35,7 @@
 #include <vlc_access.h>    /* DVB-specific things */
 #include <vlc_demux.h>
 #include <vlc_input.h>
+#include <vlc_atomic.h>
 
 #include "ts_pid.h"
 #include "ts_streams.h"
@@ -115,6 +116,11 @@ static void Close ( vlc_object_t * );
 #define CC_CHECK_LONGTEXT   "Detect discontinuities and drop packet duplicates. " \
                             "(bluRay sources are known broken and have false positives). "
 
+#define BATCH_TEXT N_("Packets per read")
+#define BATCH_LONGTEXT N_( \
+    "Number of TS packets to read from the input at once. Packets are then " \
+    "dispatched from that buffer without copy. 0 reads one packet at a time." )
+
 #define PCR_TEXT N_("Trust in-stream PCR")
 #define PCR_LONGTEXT N_("Use the stream PCR as a reference.")
 
@@ -153,6 +159,7 @@ vlc_module_begin ()
     add_bool( "ts-split-es", true, SPLIT_ES_TEXT, SPLIT_ES_LONGTEXT, false )
     add_bool( "ts-seek-percent", false, SEEK_PERCENT_TEXT, SEEK_PERCENT_LONGTEXT, true )
     add_bool( "ts-cc-check", true, CC_CHECK_TEXT, CC_CHECK_LONGTEXT, true )
+    add_integer_with_range( "ts-read-batch", 0, 0, 1024, BATCH_TEXT, BATCH_LONGTEXT, true )
 
     add_obsolete_bool( "ts-silent" );
 
@@ -186,6 +193,10 @@ static bool GatherSectionsData( demux_t *p_demux, ts_pid_t *, block_t *, size_t
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, stime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static uint64_t TsStreamTell( demux_sys_t *p_sys );
+static int TsStreamSeek( demux_sys_t *p_sys, uint64_t i_pos );
+static void TsStreamDropBatch( demux_sys_t *p_sys );
+static void TsBatchRelease( ts_batch_t *p_batch );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, stime_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, stime_t );
@@ -394,6 +405,12 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
+    p_sys->batch.i_packets = var_InheritInteger( p_demux, "ts-read-batch" );
+    if( p_sys->batch.i_packets > 0 && p_sys->batch.i_packets < 4 )
+        p_sys->batch.i_packets = 4; /* room for resync and carried over data */
+    p_sys->batch.p_current = NULL;
+    p_sys->batch.i_offset = 0;
+    p_sys->batch.i_decrypted = 0;
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
 
@@ -580,6 +597,10 @@ static void Close( vlc_object_t *p_this )
     /* Clear up attachments */
     vlc_dictionary_clear( &p_sys->attachments, FreeDictAttachment, NULL );
 
+    /* Packet views still owned by decoders keep their batch alive */
+    if( p_sys->batch.p_current )
+        TsBatchRelease( p_sys->batch.p_current );
+
     free( p_sys );
 }
 
@@ -943,7 +964,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TsStreamTell( p_sys );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -990,7 +1011,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         i64 = stream_Size( p_sys->stream );
         if( i64 > 0 &&
-            vlc_stream_Seek( p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
+            TsStreamSeek( p_sys, (int64_t)(i64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1124,11 +1145,16 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     }
 
     case DEMUX_SET_TITLE:
-        return vlc_stream_vaControl( p_sys->stream, STREAM_SET_TITLE, args );
+        if( vlc_stream_vaControl( p_sys->stream, STREAM_SET_TITLE, args ) )
+            return VLC_EGENERIC;
+        TsStreamDropBatch( p_sys );
+        return VLC_SUCCESS;
 
     case DEMUX_SET_SEEKPOINT:
-        return vlc_stream_vaControl( p_sys->stream, STREAM_SET_SEEKPOINT,
-                                     args );
+        if( vlc_stream_vaControl( p_sys->stream, STREAM_SET_SEEKPOINT, args ) )
+            return VLC_EGENERIC;
+        TsStreamDropBatch( p_sys );
+        return VLC_SUCCESS;
 
     case DEMUX_TEST_AND_CLEAR_FLAGS:
     {
@@ -1718,20 +1744,277 @@ static bool PushPESBlock( demux_t *p_demux, ts_pid_t *pid, block_t *p_pkt, bool
     return b_ret;
 }
 
+/*****************************************************************************
+ * Batched reads:
+ *  A batch is one buffer filled with a single stream read. Packets are handed
+ *  out as block views into it, and the storage is only freed once the reader
+ *  and every view have released it.
+ *****************************************************************************/
+typedef struct
+{
+    block_t     self;
+    ts_batch_t *p_batch;
+} ts_packet_view_t;
+
+struct ts_batch_t
+{
+    atomic_uint       refs;     /* one for the reader, one per live view */
+    size_t            i_size;   /* valid bytes in p_data */
+    size_t            i_max;    /* allocated bytes in p_data */
+    unsigned          i_views;  /* views used in p_views */
+    ts_packet_view_t *p_views;  /* views never overlap: at most i_max / packet size */
+    uint8_t          *p_data;
+};
+
+static ts_batch_t *TsBatchNew( size_t i_max, size_t i_packet_size )
+{
+    const size_t i_views = i_max / i_packet_size;
+    ts_batch_t *p_batch = malloc( sizeof(*p_batch) +
+                                  i_views * sizeof(ts_packet_view_t) + i_max );
+    if( unlikely(p_batch == NULL) )
+        return NULL;
+
+    atomic_init( &p_batch->refs, 1 );
+    p_batch->i_size = 0;
+    p_batch->i_max = i_max;
+    p_batch->i_views = 0;
+    p_batch->p_views = (ts_packet_view_t *) &p_batch[1];
+    p_batch->p_data = (uint8_t *) &p_batch->p_views[i_views];
+    return p_batch;
+}
+
+static void TsBatchRelease( ts_batch_t *p_batch )
+{
+    if( atomic_fetch_sub_explicit( &p_batch->refs, 1, memory_order_acq_rel ) == 1 )
+        free( p_batch );
+}
+
+static void TsPacketViewRelease( block_t *p_block )
+{
+    ts_packet_view_t *p_view = container_of( p_block, ts_packet_view_t, self );
+    TsBatchRelease( p_view->p_batch );
+}
+
+/* Starts a new batch with the unread bytes of the current one, then reads
+ * until at least i_min bytes are available. Live inputs are not waited for
+ * beyond that, whatever the batch size. */
+static bool TsBatchFill( demux_t *p_demux, size_t i_min )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    ts_batch_t *p_old = p_sys->batch.p_current;
+    ts_batch_t *p_batch;
+    size_t i_carry = 0;
+
+    if( p_old )
+        i_carry = p_old->i_size - p_sys->batch.i_offset;
+
+    if( p_old && atomic_load_explicit( &p_old->refs, memory_order_acquire ) == 1 )
+    {
+        /* No view alive anymore, recycle the storage */
+        memmove( p_old->p_data, &p_old->p_data[p_sys->batch.i_offset], i_carry );
+        p_batch = p_old;
+        p_batch->i_views = 0;
+    }
+    else
+    {
+        p_batch = TsBatchNew( (size_t) p_sys->batch.i_packets * p_sys->i_packet_size,
+                              p_sys->i_packet_size );
+        if( unlikely(p_batch == NULL) )
+            return false;
+        if( p_old )
+        {
+            memcpy( p_batch->p_data, &p_old->p_data[p_sys->batch.i_offset], i_carry );
+            TsBatchRelease( p_old );
+        }
+    }
+
+    assert( i_min <= p_batch->i_max );
+    p_batch->i_size = i_carry;
+    p_sys->batch.p_current = p_batch;
+    p_sys->batch.i_offset = 0;
+    p_sys->batch.i_decrypted = 0; /* carried bytes are still scrambled */
+
+    while( p_batch->i_size < i_min )
+    {
+        ssize_t i_read = vlc_stream_ReadPartial( p_sys->stream,
+                                                 &p_batch->p_data[p_batch->i_size],
+                                                 p_batch->i_max - p_batch->i_size );
+        if( i_read <= 0 )
+            return false;
+        p_batch->i_size += i_read;
+    }
+    return true;
+}
+
+/* Descrambles at once the packets in sync from the next unread one to the end
+ * of the batch, skipping the ones ProcessTSPacket() would not descramble. It
+ * then finds them clear. */
+static void TsBatchDecrypt( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    ts_batch_t *p_batch = p_sys->batch.p_current;
+    const size_t i_packet_size = p_sys->i_packet_size;
+    uint8_t *pp_pkt[CSA_BATCH_MAX];
+    unsigned i_pkt = 0;
+    size_t i_pos;
+
+    vlc_mutex_lock( &p_sys->csa_lock );
+    for( i_pos = p_sys->batch.i_offset;
+         i_pos + i_packet_size <= p_batch->i_size; i_pos += i_packet_size )
+    {
+        uint8_t *p = &p_batch->p_data[i_pos + p_sys->i_packet_header_size];
+
+        if( p[0] != 0x47 )
+            break; /* resync ahead */
+        if( (p[1]&0x80) || ((p[1]&0x1f) << 8 | p[2]) == 0x1FFF || !(p[3]&0xc0) )
+            continue;
+
+        pp_pkt[i_pkt++] = p;
+        if( i_pkt == CSA_BATCH_MAX )
+        {
+            csa_DecryptBatch( p_sys->csa, pp_pkt, i_pkt, p_sys->i_csa_pkt_size );
+            i_pkt = 0;
+        }
+    }
+    if( i_pkt > 0 )
+        csa_DecryptBatch( p_sys->csa, pp_pkt, i_pkt, p_sys->i_csa_pkt_size );
+    vlc_mutex_unlock( &p_sys->csa_lock );
+
+    p_sys->batch.i_decrypted = i_pos;
+}
+
+static block_t* ReadTSPacketBatched( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const size_t i_packet_size = p_sys->i_packet_size;
+    const size_t i_header_size = p_sys->i_packet_header_size;
+    ts_batch_t *p_batch = p_sys->batch.p_current;
+
+    if( !p_batch || p_batch->i_size - p_sys->batch.i_offset < i_packet_size )
+    {
+        if( !TsBatchFill( p_demux, i_packet_size ) )
+        {
+            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, TsStreamTell( p_sys ) );
+            return NULL;
+        }
+        p_batch = p_sys->batch.p_current;
+    }
+
+    /* Check sync byte and re-sync if needed, over the whole batch */
+    if( p_batch->p_data[p_sys->batch.i_offset + i_header_size] != 0x47 )
+    {
+        size_t i_skipped = 0;
+
+        msg_Warn( p_demux, "lost synchro" );
+        for( ;; )
+        {
+            const uint8_t *p_data = &p_batch->p_data[p_sys->batch.i_offset];
+            const size_t i_data = p_batch->i_size - p_sys->batch.i_offset;
+            size_t i_skip = 0;
+
+            while( i_skip + i_header_size + i_packet_size < i_data )
+            {
+                if( p_data[i_skip + i_header_size] == 0x47 &&
+                    p_data[i_skip + i_header_size + i_packet_size] == 0x47 )
+                    break;
+                i_skip++;
+            }
+            p_sys->batch.i_offset += i_skip;
+            i_skipped += i_skip;
+
+            if( i_skip + i_header_size + i_packet_size < i_data )
+                break;
+
+            /* Keep the unchecked tail and get more data */
+            if( !TsBatchFill( p_demux, i_header_size + i_packet_size + 1 ) )
+            {
+                msg_Dbg( p_demux, "eof ?" );
+                return NULL;
+            }
+            p_batch = p_sys->batch.p_current;
+        }
+        msg_Dbg( p_demux, "skipping %zu bytes of garbage", i_skipped );
+    }
+
+    if( p_sys->csa && p_sys->batch.i_offset >= p_sys->batch.i_decrypted )
+        TsBatchDecrypt( p_demux );
+
+    assert( p_batch->i_views < p_batch->i_max / i_packet_size );
+    ts_packet_view_t *p_view = &p_batch->p_views[p_batch->i_views++];
+    block_Init( &p_view->self, &p_batch->p_data[p_sys->batch.i_offset], i_packet_size );
+    p_view->self.pf_release = TsPacketViewRelease;
+    p_view->p_batch = p_batch;
+    atomic_fetch_add_explicit( &p_batch->refs, 1, memory_order_relaxed );
+    p_sys->batch.i_offset += i_packet_size;
+
+    /* Skip header (BluRay streams), see ReadTSPacket */
+    p_view->self.p_buffer += i_header_size;
+    p_view->self.i_buffer -= i_header_size;
+
+    return &p_view->self;
+}
+
+/* Stream position as seen by the demuxer, excluding batched unread bytes */
+static uint64_t TsStreamTell( demux_sys_t *p_sys )
+{
+    uint64_t i_pos = vlc_stream_Tell( p_sys->stream );
+    const ts_batch_t *p_batch = p_sys->batch.p_current;
+
+    if( p_batch )
+        i_pos -= p_batch->i_size - p_sys->batch.i_offset;
+    return i_pos;
+}
+
+/* Drops the unread batched data, once the stream position changed */
+static void TsStreamDropBatch( demux_sys_t *p_sys )
+{
+    if( p_sys->batch.p_current )
+        p_sys->batch.i_offset = p_sys->batch.p_current->i_size;
+}
+
+static int TsStreamSeek( demux_sys_t *p_sys, uint64_t i_pos )
+{
+    int i_ret = vlc_stream_Seek( p_sys->stream, i_pos );
+
+    /* Batched data is no longer contiguous with the stream */
+    if( i_ret == VLC_SUCCESS )
+        TsStreamDropBatch( p_sys );
+    return i_ret;
+}
+
+void TsStreamFlushBatch( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    ts_batch_t *p_batch = p_sys->batch.p_current;
+
+    if( !p_batch || p_batch->i_size == p_sys->batch.i_offset )
+        return;
+
+    /* The unread bytes were read through the current stream: rewind it so
+     * that they are read again through the new one */
+    const size_t i_pending = p_batch->i_size - p_sys->batch.i_offset;
+    if( vlc_stream_Seek( p_sys->stream, TsStreamTell( p_sys ) ) != VLC_SUCCESS )
+        msg_Warn( p_demux, "dropping %zu batched bytes", i_pending );
+    p_sys->batch.i_offset = p_batch->i_size;
+}
+
 static block_t* ReadTSPacket( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
     block_t     *p_pkt;
 
+    if( p_sys->batch.i_packets > 0 )
+        return ReadTSPacketBatched( p_demux );
+
     /* Get a new TS packet */
     if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
     {
         int64_t size = stream_Size( p_sys->stream );
-        if( size >= 0 && (uint64_t)size == vlc_stream_Tell( p_sys->stream ) )
-            msg_Dbg( p_demux, "EOF at %"PRIu64, vlc_stream_Tell( p_sys->stream ) );
+        if( size >= 0 && (uint64_t)size == TsStreamTell( p_sys ) )
+            msg_Dbg( p_demux, "EOF at %"PRIu64, TsStreamTell( p_sys ) );
         else
-            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, vlc_stream_Tell(p_sys->stream) );
+            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, TsStreamTell( p_sys ) );
         return NULL;
     }
 
@@ -1900,13 +2183,13 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return TsStreamSeek( p_sys, 0 );
 
     const int64_t i_stream_size = stream_Size( p_sys->stream );
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TsStreamTell( p_sys );
 
     /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
@@ -1922,7 +2205,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( TsStreamSeek( p_sys, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -1936,7 +2219,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
                 break;
             }
             else
-                i_pos = vlc_stream_Tell( p_sys->stream );
+                i_pos = TsStreamTell( p_sys );
 
             int i_pid = PIDGet( p_pkt );
             ts_pid_t *p_pid = GetPID(p_sys, i_pid);
@@ -1993,7 +2276,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        vlc_stream_Seek( p_sys->stream, i_initial_pos );
+        TsStreamSeek( p_sys, i_initial_pos );
         return VLC_EGENERIC;
     }
     return VLC_SUCCESS;
@@ -2074,7 +2357,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, stime_t *pi_
                         if( b_end )
                         {
                             p_pmt->i_last_dts = *pi_pcr;
-                            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                            p_pmt->i_last_dts_byte = TsStreamTell( p_sys );
                         }
                         /* Start, only keep first */
                         else if( b_pcrresult && p_pmt->pcr.i_first == -1 )
@@ -2102,7 +2385,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, stime_t *pi_
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TsStreamTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = 0;
@@ -2115,7 +2398,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_pos = p_sys->i_packet_size * i_probe_count;
         i_pos = __MIN( i_pos, i_stream_size );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TsStreamSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, false, &i_pcr, &b_found );
@@ -2125,7 +2408,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
     } while( i_pos < i_stream_size && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TsStreamSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2134,7 +2417,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TsStreamTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = PROBE_CHUNK_COUNT;
@@ -2147,7 +2430,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         i_pos = i_stream_size - (p_sys->i_packet_size * i_probe_count);
         i_pos = __MAX( i_pos, 0 );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TsStreamSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, true, &i_pcr, &b_found );
@@ -2157,7 +2440,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TsStreamSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2208,14 +2491,14 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr )
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TsStreamTell( p_sys ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = TsStreamTell( p_sys );
             }
         }
     }
@@ -44,6 +44,8 @@ typedef struct
     int i_service;
 } vdr_info_t;
 
+typedef struct ts_batch_t ts_batch_t;
+
 struct demux_sys_t
 {
     stream_t   *stream;
@@ -63,6 +65,15 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* Batched reads: packets are views into a shared multi-packet buffer */
+    struct
+    {
+        unsigned    i_packets; /* packets per stream read, 0 if disabled */
+        ts_batch_t *p_current;
+        size_t      i_offset;  /* next unread byte in p_current */
+        size_t      i_decrypted; /* end of the descrambled packets in p_current */
+    } batch;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
@@ -145,6 +156,10 @@ void UpdatePESFilters( demux_t *p_demux, bool b_all );
 int ProbeStart( demux_t *p_demux, int i_program );
 int ProbeEnd( demux_t *p_demux, int i_program );
 
+/* Gives the batched but unread bytes back to the source stream, before
+ * another stream is stacked on top of it */
+void TsStreamFlushBatch( demux_t *p_demux );
+
 void AddAndCreateES( demux_t *p_demux, ts_pid_t *pid, bool b_create_delayed );
 int FindPCRCandidate( ts_pmt_t *p_pmt );
 
@@ -215,6 +215,8 @@ static int vlclua_input_item_stats( lua_State *L )
         STATS_INT( lost_pictures )
         STATS_INT( played_abuffers )
         STATS_INT( lost_abuffers )
+        STATS_INT( block_pool_hits )
+        STATS_INT( block_pool_misses )
 #undef STATS_INT
 #undef STATS_FLOAT
     }
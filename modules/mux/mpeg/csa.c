@@ -27,9 +27,17 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_cpu.h>
 
 #include "csa.h"
 
+#if defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#endif
+
 struct csa_t
 {
     /* odd and even keys */
@@ -47,8 +55,15 @@ struct csa_t
     int     p, q, r;
 
     bool    use_odd;
+
+    /* key stream of batched packets */
+    uint8_t ks[CSA_BATCH_MAX][184];
 };
 
+/* Below that many packets, the bitsliced stream cypher is slower than the
+ * byte-wise one, whose state setup is much cheaper */
+#define CSA_BATCH_MIN 16
+
 static void csa_ComputeKey( uint8_t kk[57], uint8_t ck[8] );
 
 static void csa_StreamCypher( csa_t *c, int b_init, uint8_t *ck, uint8_t *sb, uint8_t *cb );
@@ -56,6 +71,10 @@ static void csa_StreamCypher( csa_t *c, int b_init, uint8_t *ck, uint8_t *sb, ui
 static void csa_BlockDecypher( uint8_t kk[57], uint8_t ib[8], uint8_t bd[8] );
 static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] );
 
+static void csa_StreamBatch( unsigned i_lanes, const uint8_t *const *pp_ck,
+                             const uint8_t *const *pp_sb,
+                             uint8_t *const *pp_out, size_t i_out );
+
 /*****************************************************************************
  * csa_New:
  *****************************************************************************/
@@ -131,6 +150,8 @@ int csa_UseKey( vlc_object_t *p_caller, csa_t *c, bool use_odd )
 #ifndef TS_NO_CSA_CK_MSG
         msg_Dbg( p_caller, "using the %s key for scrambling",
                  use_odd ? "odd" : "even" );
+#else
+    VLC_UNUSED( p_caller );
 #endif
     return VLC_SUCCESS;
 }
@@ -307,6 +328,186 @@ void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
     }
 }
 
+static void csa_DecryptPayload( uint8_t kk[57], uint8_t *p, int i_len,
+                                const uint8_t *ks )
+{
+    uint8_t ib[8], block[8];
+    const int n = i_len / 8;
+
+    /* remove the stream layer, which covers all but the first block */
+    for( int i = 8; i < i_len; i++ )
+        p[i] ^= ks[i - 8];
+
+    memcpy( ib, p, 8 );
+    for( int i = 1; i < n + 1; i++ )
+    {
+        csa_BlockDecypher( kk, ib, block );
+        if( i != n )
+            memcpy( ib, &p[8*i], 8 );
+        else
+            memset( ib, 0, 8 ); /* last block */
+        for( int j = 0; j < 8; j++ )
+            p[8*(i-1)+j] = ib[j] ^ block[j];
+    }
+}
+
+/*****************************************************************************
+ * csa_DecryptBatch:
+ *****************************************************************************/
+void csa_DecryptBatch( csa_t *c, uint8_t *const *pkts, unsigned i_pkts,
+                       int i_pkt_size )
+{
+    while( i_pkts > 0 )
+    {
+        const unsigned i_batch = __MIN( i_pkts, CSA_BATCH_MAX );
+        const uint8_t *ck[CSA_BATCH_MAX], *sb[CSA_BATCH_MAX];
+        uint8_t *kk[CSA_BATCH_MAX], *ks[CSA_BATCH_MAX];
+        int i_len[CSA_BATCH_MAX];
+        unsigned i_lanes = 0;
+        int i_ks = 0;
+
+        if( i_batch < CSA_BATCH_MIN )
+        {
+            for( unsigned i = 0; i < i_batch; i++ )
+                csa_Decrypt( c, pkts[i], i_pkt_size );
+            break;
+        }
+
+        for( unsigned i = 0; i < i_batch; i++ )
+        {
+            uint8_t *pkt = pkts[i];
+            int i_hdr;
+
+            /* transport scrambling control */
+            if( (pkt[3]&0x80) == 0 )
+                continue;
+
+            i_hdr = 4;
+            if( pkt[3]&0x20 )
+                i_hdr += pkt[4] + 1;
+
+            if( 188 - i_hdr < 8 || i_pkt_size - i_hdr < 8 )
+            {
+                /* no block to chain, use the single packet path */
+                csa_Decrypt( c, pkt, i_pkt_size );
+                continue;
+            }
+
+            if( pkt[3]&0x40 )
+            {
+                ck[i_lanes] = c->o_ck;
+                kk[i_lanes] = c->o_kk;
+            }
+            else
+            {
+                ck[i_lanes] = c->e_ck;
+                kk[i_lanes] = c->e_kk;
+            }
+            pkt[3] &= 0x3f;
+
+            sb[i_lanes] = &pkt[i_hdr];
+            ks[i_lanes] = c->ks[i_lanes];
+            i_len[i_lanes] = i_pkt_size - i_hdr;
+            i_ks = __MAX( i_ks, i_len[i_lanes] - 8 );
+            i_lanes++;
+        }
+
+        if( i_lanes > 0 )
+        {
+            csa_StreamBatch( i_lanes, ck, sb, ks, i_ks );
+            for( unsigned i = 0; i < i_lanes; i++ )
+                csa_DecryptPayload( kk[i], (uint8_t *)sb[i], i_len[i], ks[i] );
+        }
+
+        pkts += i_batch;
+        i_pkts -= i_batch;
+    }
+}
+
+static void csa_EncryptPayload( uint8_t kk[57], uint8_t *p, int i_len )
+{
+    uint8_t ib[8] = { 0 }, block[8];
+
+    /* block layer, chained backwards from the last full block */
+    for( int i = i_len / 8; i > 0; i-- )
+    {
+        for( int j = 0; j < 8; j++ )
+            block[j] = p[8*(i-1)+j] ^ ib[j];
+        csa_BlockCypher( kk, block, ib );
+        memcpy( &p[8*(i-1)], ib, 8 );
+    }
+}
+
+/*****************************************************************************
+ * csa_EncryptBatch:
+ *****************************************************************************/
+void csa_EncryptBatch( csa_t *c, uint8_t *const *pkts, unsigned i_pkts,
+                       int i_pkt_size )
+{
+    const uint8_t *ck_used = c->use_odd ? c->o_ck : c->e_ck;
+    uint8_t *kk_used = c->use_odd ? c->o_kk : c->e_kk;
+
+    while( i_pkts > 0 )
+    {
+        const unsigned i_batch = __MIN( i_pkts, CSA_BATCH_MAX );
+        const uint8_t *ck[CSA_BATCH_MAX], *sb[CSA_BATCH_MAX];
+        uint8_t *ks[CSA_BATCH_MAX];
+        int i_len[CSA_BATCH_MAX];
+        unsigned i_lanes = 0;
+        int i_ks = 0;
+
+        if( i_batch < CSA_BATCH_MIN )
+        {
+            for( unsigned i = 0; i < i_batch; i++ )
+                csa_Encrypt( c, pkts[i], i_pkt_size );
+            break;
+        }
+
+        for( unsigned i = 0; i < i_batch; i++ )
+        {
+            uint8_t *pkt = pkts[i];
+            int i_hdr = 4;
+
+            if( pkt[3]&0x20 )
+                i_hdr += pkt[4] + 1;
+
+            if( i_pkt_size - i_hdr < 8 )
+            {
+                /* nothing to scramble, use the single packet path */
+                csa_Encrypt( c, pkt, i_pkt_size );
+                continue;
+            }
+
+            /* set transport scrambling control */
+            pkt[3] |= c->use_odd ? 0xc0 : 0x80;
+
+            csa_EncryptPayload( kk_used, &pkt[i_hdr], i_pkt_size - i_hdr );
+
+            ck[i_lanes] = ck_used;
+            sb[i_lanes] = &pkt[i_hdr];
+            ks[i_lanes] = c->ks[i_lanes];
+            i_len[i_lanes] = i_pkt_size - i_hdr;
+            i_ks = __MAX( i_ks, i_len[i_lanes] - 8 );
+            i_lanes++;
+        }
+
+        if( i_lanes > 0 )
+        {
+            /* stream layer, initialised with the first cyphered block */
+            csa_StreamBatch( i_lanes, ck, sb, ks, i_ks );
+            for( unsigned i = 0; i < i_lanes; i++ )
+            {
+                uint8_t *p = (uint8_t *)sb[i];
+                for( int j = 8; j < i_len[i]; j++ )
+                    p[j] ^= ks[i][j - 8];
+            }
+        }
+
+        pkts += i_batch;
+        i_pkts -= i_batch;
+    }
+}
+
 /*****************************************************************************
  * Divers
  *****************************************************************************/
@@ -610,3 +811,166 @@ static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] )
     }
 }
 
+/*****************************************************************************
+ * Bitsliced stream cypher
+ *****************************************************************************/
+static const uint32_t csa_bs_sbox[7][2] =
+{
+    /* truth tables of bit 0 and bit 1 of sbox1..sbox7 */
+    { 0x78C6B16C, 0x4B368771 },
+    { 0xE41B4B63, 0x58B98679 },
+    { 0xE41B1BE4, 0x69D25879 },
+    { 0x92AD994B, 0x66B492AD },
+    { 0x35E29E58, 0x9C274CF1 },
+    { 0x66D2E61A, 0x691BB46C },
+    { 0x266D9D92, 0xB38C691E },
+};
+
+/* Transposes an 8x8 bit matrix, one row per byte */
+static inline uint64_t csa_bs_Transpose8( uint64_t x )
+{
+    uint64_t t;
+
+    t = ( x ^ (x >> 7) ) & 0x00AA00AA00AA00AAULL;
+    x ^= t ^ (t << 7);
+    t = ( x ^ (x >> 14) ) & 0x0000CCCC0000CCCCULL;
+    x ^= t ^ (t << 14);
+    t = ( x ^ (x >> 28) ) & 0x00000000F0F0F0F0ULL;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+/* Gathers bit b of byte i of up to 64 lanes into plane[b * i_stride] */
+static void csa_bs_Slice( uint64_t *plane, size_t i_stride,
+                          const uint8_t *const *pp, unsigned i_count, size_t i )
+{
+    for( int b = 0; b < 8; b++ )
+        plane[b * i_stride] = 0;
+
+    for( unsigned g = 0; g < i_count; g += 8 )
+    {
+        uint64_t x = 0;
+
+        for( unsigned k = 0; k < 8 && g + k < i_count; k++ )
+            x |= (uint64_t)pp[g + k][i] << (8 * k);
+        x = csa_bs_Transpose8( x );
+        for( int b = 0; b < 8; b++ )
+            plane[b * i_stride] |= ( (x >> (8 * b)) & 0xff ) << g;
+    }
+}
+
+/* Scatters plane[b * i_stride] back to bit b of byte i of up to 64 lanes */
+static void csa_bs_Unslice( const uint64_t *plane, size_t i_stride,
+                            uint8_t *const *pp, unsigned i_count, size_t i )
+{
+    for( unsigned g = 0; g < i_count; g += 8 )
+    {
+        uint64_t x = 0;
+
+        for( int b = 0; b < 8; b++ )
+            x |= ( (plane[b * i_stride] >> g) & 0xff ) << (8 * b);
+        x = csa_bs_Transpose8( x );
+        for( unsigned k = 0; k < 8 && g + k < i_count; k++ )
+            pp[g + k][i] = x >> (8 * k);
+    }
+}
+
+/* Portable version, 64 packets per word */
+#define BS_SUFFIX       C
+#define BS_TARGET
+#define BS_W            uint64_t
+#define BS_U64          1
+#define BS_LOAD(p)      (*(p))
+#define BS_STORE(p,w)   (*(p) = (w))
+#define BS_AND(a,b)     ((a) & (b))
+#define BS_OR(a,b)      ((a) | (b))
+#define BS_XOR(a,b)     ((a) ^ (b))
+#define BS_ZERO         UINT64_C(0)
+#define BS_ONES         (~UINT64_C(0))
+#include "csa_bs_template.h"
+#undef BS_SUFFIX
+#undef BS_TARGET
+#undef BS_W
+#undef BS_U64
+#undef BS_LOAD
+#undef BS_STORE
+#undef BS_AND
+#undef BS_OR
+#undef BS_XOR
+#undef BS_ZERO
+#undef BS_ONES
+
+#ifdef HAVE_SSE2_INTRINSICS
+/* SSE2 version, 128 packets per word */
+#define BS_SUFFIX       SSE2
+#define BS_TARGET       __attribute__ ((__target__ ("sse2")))
+#define BS_W            __m128i
+#define BS_U64          2
+#define BS_LOAD(p)      _mm_loadu_si128( (const __m128i *)(p) )
+#define BS_STORE(p,w)   _mm_storeu_si128( (__m128i *)(p), (w) )
+#define BS_AND(a,b)     _mm_and_si128( (a), (b) )
+#define BS_OR(a,b)      _mm_or_si128( (a), (b) )
+#define BS_XOR(a,b)     _mm_xor_si128( (a), (b) )
+#define BS_ZERO         _mm_setzero_si128()
+#define BS_ONES         _mm_set1_epi32( -1 )
+#include "csa_bs_template.h"
+#undef BS_SUFFIX
+#undef BS_TARGET
+#undef BS_W
+#undef BS_U64
+#undef BS_LOAD
+#undef BS_STORE
+#undef BS_AND
+#undef BS_OR
+#undef BS_XOR
+#undef BS_ZERO
+#undef BS_ONES
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+/* AVX2 version, 256 packets per word */
+#define BS_SUFFIX       AVX2
+#define BS_TARGET       __attribute__ ((__target__ ("avx2")))
+#define BS_W            __m256i
+#define BS_U64          4
+#define BS_LOAD(p)      _mm256_loadu_si256( (const __m256i *)(p) )
+#define BS_STORE(p,w)   _mm256_storeu_si256( (__m256i *)(p), (w) )
+#define BS_AND(a,b)     _mm256_and_si256( (a), (b) )
+#define BS_OR(a,b)      _mm256_or_si256( (a), (b) )
+#define BS_XOR(a,b)     _mm256_xor_si256( (a), (b) )
+#define BS_ZERO         _mm256_setzero_si256()
+#define BS_ONES         _mm256_set1_epi32( -1 )
+#include "csa_bs_template.h"
+#undef BS_SUFFIX
+#undef BS_TARGET
+#undef BS_W
+#undef BS_U64
+#undef BS_LOAD
+#undef BS_STORE
+#undef BS_AND
+#undef BS_OR
+#undef BS_XOR
+#undef BS_ZERO
+#undef BS_ONES
+#endif
+
+static void csa_StreamBatch( unsigned i_lanes, const uint8_t *const *pp_ck,
+                             const uint8_t *const *pp_sb,
+                             uint8_t *const *pp_out, size_t i_out )
+{
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() && i_lanes > 128 )
+    {
+        csa_StreamBatchAVX2( i_lanes, pp_ck, pp_sb, pp_out, i_out );
+        return;
+    }
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() && i_lanes > 64 )
+    {
+        csa_StreamBatchSSE2( i_lanes, pp_ck, pp_sb, pp_out, i_out );
+        return;
+    }
+#endif
+    csa_StreamBatchC( i_lanes, pp_ck, pp_sb, pp_out, i_out );
+}
@@ -0,0 +1,272 @@
+/*****************************************************************************
+ * csa_bs_template.h: bitsliced CSA stream cypher
+ *****************************************************************************
+ * Copyright (C) 2004-2005 Laurent Aimar
+ * Copyright (C) the deCSA authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included once per word type by csa.c, which defines:
+ *  BS_SUFFIX   suffix appended to every function name
+ *  BS_TARGET   function attributes (target CPU)
+ *  BS_W        word type, BS_U64 64-bit units per word
+ *  BS_LOAD, BS_STORE, BS_AND, BS_XOR, BS_OR, BS_ZERO, BS_ONES
+ * Each bit of a word holds the cypher state of one packet, so that a word
+ * operation steps 64 * BS_U64 packets at once. */
+
+#define BS_CAT_(a,b) a##b
+#define BS_CAT(a,b) BS_CAT_(a,b)
+#define BS_FN(name) BS_CAT(name, BS_SUFFIX)
+#define BS_STATE BS_FN(csa_bs_state_)
+#define BS_LANES (64 * BS_U64)
+
+typedef struct
+{
+    BS_W A[11][4];
+    BS_W B[11][4];
+    BS_W X[4], Y[4], Z[4];
+    BS_W D[4], E[4], F[4];
+    BS_W p, q, r;
+} BS_STATE;
+
+/* Selects b where s is set, a elsewhere */
+BS_TARGET
+static inline BS_W BS_FN(csa_bs_Mux)( BS_W a, BS_W b, BS_W s )
+{
+    return BS_XOR( a, BS_AND( BS_XOR( a, b ), s ) );
+}
+
+/* Evaluates a 5 inputs boolean function given its truth table,
+ * in[0] being the least significant bit of the table index */
+BS_TARGET
+static inline BS_W BS_FN(csa_bs_Lut5)( uint32_t truth, const BS_W in[5] )
+{
+    BS_W l[16];
+
+    for( int i = 0; i < 16; i++ )
+    {
+        const unsigned t = ( truth >> (2 * i) ) & 3;
+        l[i] = BS_XOR( (t & 1) ? BS_ONES : BS_ZERO,
+                       ((t ^ (t >> 1)) & 1) ? in[0] : BS_ZERO );
+    }
+    for( int w = 8, k = 1; w > 0; w /= 2, k++ )
+        for( int i = 0; i < w; i++ )
+            l[i] = BS_FN(csa_bs_Mux)( l[2*i], l[2*i+1], in[k] );
+    return l[0];
+}
+
+BS_TARGET
+static void BS_FN(csa_bs_LoadByte)( BS_W w[8], const uint8_t *const *pp,
+                                    unsigned i_count, size_t i )
+{
+    uint64_t plane[8][BS_U64];
+
+    for( unsigned u = 0; u < BS_U64; u++ )
+    {
+        if( i_count > 64 * u )
+            csa_bs_Slice( &plane[0][u], BS_U64, &pp[64 * u],
+                          __MIN( i_count - 64 * u, 64 ), i );
+        else
+            for( int b = 0; b < 8; b++ )
+                plane[b][u] = 0;
+    }
+    for( int b = 0; b < 8; b++ )
+        w[b] = BS_LOAD( plane[b] );
+}
+
+BS_TARGET
+static void BS_FN(csa_bs_StoreByte)( const BS_W w[8], uint8_t *const *pp,
+                                     unsigned i_count, size_t i )
+{
+    uint64_t plane[8][BS_U64];
+
+    for( int b = 0; b < 8; b++ )
+        BS_STORE( plane[b], w[b] );
+    for( unsigned u = 0; u < BS_U64 && i_count > 64 * u; u++ )
+        csa_bs_Unslice( &plane[0][u], BS_U64, &pp[64 * u],
+                        __MIN( i_count - 64 * u, 64 ), i );
+}
+
+/* One iteration of csa_StreamCypher(), producing 2 bits of output.
+ * in_a and in_b are the nibbles fed during initialisation, NULL otherwise */
+BS_TARGET
+static inline void BS_FN(csa_bs_Step)( BS_STATE *s, const BS_W *in_a,
+                                       const BS_W *in_b, BS_W out[2] )
+{
+    BS_W (*A)[4] = s->A, (*B)[4] = s->B;
+    BS_W s1[2], s2[2], s3[2], s4[2], s5[2], s6[2], s7[2];
+    BS_W next_A1[4], next_B1[4], next_F[4], extra_B[4];
+    BS_W carry;
+
+    /* from A[1]..A[10], 35 bits are selected as inputs to 7 s-boxes */
+    const BS_W i1[5] = { A[9][0], A[7][3], A[6][1], A[1][2], A[4][0] };
+    const BS_W i2[5] = { A[9][1], A[7][0], A[6][3], A[3][2], A[2][1] };
+    const BS_W i3[5] = { A[6][2], A[5][3], A[5][1], A[2][0], A[1][3] };
+    const BS_W i4[5] = { A[8][0], A[4][2], A[2][3], A[1][1], A[3][3] };
+    const BS_W i5[5] = { A[9][2], A[8][1], A[6][0], A[4][3], A[5][2] };
+    const BS_W i6[5] = { A[9][3], A[7][2], A[5][0], A[4][1], A[3][1] };
+    const BS_W i7[5] = { A[8][3], A[8][2], A[7][1], A[3][0], A[2][2] };
+
+    for( int k = 0; k < 2; k++ )
+    {
+        s1[k] = BS_FN(csa_bs_Lut5)( csa_bs_sbox[0][k], i1 );
+        s2[k] = BS_FN(csa_bs_Lut5)( csa_bs_sbox[1][k], i2 );
+        s3[k] = BS_FN(csa_bs_Lut5)( csa_bs_sbox[2][k], i3 );
+        s4[k] = BS_FN(csa_bs_Lut5)( csa_bs_sbox[3][k], i4 );
+        s5[k] = BS_FN(csa_bs_Lut5)( csa_bs_sbox[4][k], i5 );
+        s6[k] = BS_FN(csa_bs_Lut5)( csa_bs_sbox[5][k], i6 );
+        s7[k] = BS_FN(csa_bs_Lut5)( csa_bs_sbox[6][k], i7 );
+    }
+
+    /* use 4x4 xor to produce extra nibble for T3 */
+    extra_B[3] = BS_XOR( BS_XOR( B[3][0], B[6][1] ), BS_XOR( B[7][2], B[9][3] ) );
+    extra_B[2] = BS_XOR( BS_XOR( B[6][0], B[8][1] ), BS_XOR( B[3][3], B[4][2] ) );
+    extra_B[1] = BS_XOR( BS_XOR( B[5][3], B[8][2] ), BS_XOR( B[4][0], B[5][1] ) );
+    extra_B[0] = BS_XOR( BS_XOR( B[9][2], B[6][3] ), BS_XOR( B[3][1], B[8][0] ) );
+
+    for( int n = 0; n < 4; n++ )
+    {
+        /* T1, T2: in_a, in_b and D are only used during initialisation */
+        next_A1[n] = BS_XOR( A[10][n], s->X[n] );
+        next_B1[n] = BS_XOR( BS_XOR( B[7][n], B[10][n] ), s->Y[n] );
+        if( in_a )
+        {
+            next_A1[n] = BS_XOR( next_A1[n], BS_XOR( s->D[n], in_a[n] ) );
+            next_B1[n] = BS_XOR( next_B1[n], in_b[n] );
+        }
+    }
+
+    /* if p=1, rotate next_B1 left */
+    const BS_W rotated[4] = { next_B1[3], next_B1[0], next_B1[1], next_B1[2] };
+    for( int n = 0; n < 4; n++ )
+        next_B1[n] = BS_FN(csa_bs_Mux)( next_B1[n], rotated[n], s->p );
+
+    /* T4 = sum, carry of Z + E + r, only if q=1 */
+    carry = s->r;
+    for( int n = 0; n < 4; n++ )
+    {
+        const BS_W ze = BS_XOR( s->Z[n], s->E[n] );
+        const BS_W sum = BS_XOR( ze, carry );
+
+        carry = BS_OR( BS_AND( s->Z[n], s->E[n] ), BS_AND( carry, ze ) );
+        next_F[n] = BS_FN(csa_bs_Mux)( s->E[n], sum, s->q );
+    }
+    s->r = BS_FN(csa_bs_Mux)( s->r, carry, s->q );
+
+    for( int n = 0; n < 4; n++ )
+    {
+        /* T3 = xor all inputs */
+        s->D[n] = BS_XOR( BS_XOR( s->E[n], s->Z[n] ), extra_B[n] );
+        s->E[n] = s->F[n];
+        s->F[n] = next_F[n];
+    }
+
+    for( int k = 10; k > 1; k-- )
+        for( int n = 0; n < 4; n++ )
+        {
+            A[k][n] = A[k-1][n];
+            B[k][n] = B[k-1][n];
+        }
+    for( int n = 0; n < 4; n++ )
+    {
+        A[1][n] = next_A1[n];
+        B[1][n] = next_B1[n];
+    }
+
+    s->X[3] = s4[0]; s->X[2] = s3[0]; s->X[1] = s2[1]; s->X[0] = s1[1];
+    s->Y[3] = s6[0]; s->Y[2] = s5[0]; s->Y[1] = s4[1]; s->Y[0] = s3[1];
+    s->Z[3] = s2[0]; s->Z[2] = s1[0]; s->Z[1] = s6[1]; s->Z[0] = s5[1];
+    s->p = s7[1];
+    s->q = s7[0];
+
+    if( out )
+    {
+        /* 2 output bits are a function of the 4 bits of D */
+        out[1] = BS_XOR( s->D[2], s->D[3] );
+        out[0] = BS_XOR( s->D[0], s->D[1] );
+    }
+}
+
+/* Generates i_out bytes of key stream for each of i_lanes packets, lane n
+ * being initialised with control word pp_ck[n] and first block pp_sb[n] */
+BS_TARGET
+static void BS_FN(csa_StreamBatch)( unsigned i_lanes,
+                                    const uint8_t *const *pp_ck,
+                                    const uint8_t *const *pp_sb,
+                                    uint8_t *const *pp_out, size_t i_out )
+{
+    for( unsigned i_base = 0; i_base < i_lanes; i_base += BS_LANES )
+    {
+        const unsigned i_count = __MIN( i_lanes - i_base, BS_LANES );
+        BS_STATE s;
+        BS_W w[8];
+
+        /* load first 32 bits of CK into A[1]..A[8]
+         * load last  32 bits of CK into B[1]..B[8]
+         * all other regs = 0 */
+        for( int i = 0; i < 4; i++ )
+        {
+            BS_FN(csa_bs_LoadByte)( w, &pp_ck[i_base], i_count, i );
+            for( int n = 0; n < 4; n++ )
+            {
+                s.A[1+2*i][n] = w[4+n];
+                s.A[2+2*i][n] = w[n];
+            }
+            BS_FN(csa_bs_LoadByte)( w, &pp_ck[i_base], i_count, 4 + i );
+            for( int n = 0; n < 4; n++ )
+            {
+                s.B[1+2*i][n] = w[4+n];
+                s.B[2+2*i][n] = w[n];
+            }
+        }
+        for( int n = 0; n < 4; n++ )
+        {
+            s.A[9][n] = s.A[10][n] = BS_ZERO;
+            s.B[9][n] = s.B[10][n] = BS_ZERO;
+            s.X[n] = s.Y[n] = s.Z[n] = BS_ZERO;
+            s.D[n] = s.E[n] = s.F[n] = BS_ZERO;
+        }
+        s.p = s.q = s.r = BS_ZERO;
+
+        /* initialisation with the first 8 bytes of data */
+        for( int i = 0; i < 8; i++ )
+        {
+            BS_FN(csa_bs_LoadByte)( w, &pp_sb[i_base], i_count, i );
+            for( int j = 0; j < 4; j++ )
+            {
+                const BS_W *in1 = &w[4], *in2 = &w[0];
+                if( j % 2 )
+                    BS_FN(csa_bs_Step)( &s, in2, in1, NULL );
+                else
+                    BS_FN(csa_bs_Step)( &s, in1, in2, NULL );
+            }
+        }
+
+        /* generation, 4 iterations per output byte */
+        for( size_t i = 0; i < i_out; i++ )
+        {
+            for( int j = 0; j < 4; j++ )
+                BS_FN(csa_bs_Step)( &s, NULL, NULL, &w[6 - 2 * j] );
+            BS_FN(csa_bs_StoreByte)( w, &pp_out[i_base], i_count, i );
+        }
+    }
+}
+
+#undef BS_LANES
+#undef BS_STATE
+#undef BS_FN
+#undef BS_CAT
+#undef BS_CAT_
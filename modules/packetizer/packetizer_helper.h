@@ -180,15 +180,39 @@ static inline block_t *packetizer_Packetize( packetizer_t *p_pack, block_t **pp_
 
             /* Get the new fragment and set the pts/dts */
             block_t *p_block_bytestream = p_pack->bytestream.p_block;
+            const mtime_t i_pts = p_block_bytestream->i_pts;
+            const mtime_t i_dts = p_block_bytestream->i_dts;
 
-            p_pic = block_Alloc( p_pack->i_offset + p_pack->i_au_prepend );
-            p_pic->i_pts = p_block_bytestream->i_pts;
-            p_pic->i_dts = p_block_bytestream->i_dts;
+            if( p_pack->i_au_prepend == 0 )
+            {
+                /* Reference the fragment instead of copying it, unless it
+                 * spans several blocks */
+                p_pic = block_GetChain( &p_pack->bytestream, p_pack->i_offset );
+                if( p_pic != NULL )
+                    p_pic = block_ChainGather( p_pic );
+                /* The first block may have been replaced by an equivalent */
+                p_block_bytestream = p_pack->bytestream.p_chain;
+            }
+            else
+            {
+                p_pic = block_Alloc( p_pack->i_offset + p_pack->i_au_prepend );
+                if( p_pic != NULL )
+                {
+                    block_GetBytes( &p_pack->bytestream, &p_pic->p_buffer[p_pack->i_au_prepend],
+                                    p_pic->i_buffer - p_pack->i_au_prepend );
+                    memcpy( p_pic->p_buffer, p_pack->p_au_prepend, p_pack->i_au_prepend );
+                }
+            }
 
-            block_GetBytes( &p_pack->bytestream, &p_pic->p_buffer[p_pack->i_au_prepend],
-                            p_pic->i_buffer - p_pack->i_au_prepend );
-            if( p_pack->i_au_prepend > 0 )
-                memcpy( p_pic->p_buffer, p_pack->p_au_prepend, p_pack->i_au_prepend );
+            if( unlikely(p_pic == NULL) )
+            {
+                block_SkipBytes( &p_pack->bytestream, p_pack->i_offset );
+                p_pack->i_offset = 0;
+                p_pack->i_state = STATE_NOSYNC;
+                break;
+            }
+            p_pic->i_pts = i_pts;
+            p_pic->i_dts = i_dts;
 
             p_pack->i_offset = 0;
 
@@ -283,6 +283,14 @@ static int Open(vlc_object_t *obj)
     if (s->s->pf_block == NULL)
         return VLC_EGENERIC;
 
+    /* Local sources seek fast enough without a cache. Their blocks, such as
+     * the mapped windows of a file, are then taken by vlc_stream_Block()
+     * without copying them into the cache. */
+    bool fast_seek;
+    if (vlc_stream_Control(s->s, STREAM_CAN_FASTSEEK, &fast_seek) == VLC_SUCCESS
+     && fast_seek)
+        return VLC_EGENERIC;
+
     stream_sys_t *sys = malloc(sizeof (*sys));
     if (unlikely(sys == NULL))
         return VLC_ENOMEM;
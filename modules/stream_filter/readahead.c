@@ -0,0 +1,753 @@
+/*****************************************************************************
+ * readahead.c: adaptive read-ahead stream filter for VLC
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_stream.h>
+#include <vlc_interrupt.h>
+
+/*
+ * Unlike the prefetch filter, which keeps a single circular buffer, this
+ * filter caches several non-contiguous ranges of the source, so that
+ * demuxers jumping between an index (MP4 moov, MKV cues) and the data do
+ * not discard and refetch either of them.
+ *
+ * The read-ahead window of the range being read starts small, doubles as
+ * long as the access is sequential, and is capped by the time it covers at
+ * the measured consumer rate, which is longer if the source is slow.
+ */
+
+#define READ_MAX        (1 << 20) /* largest single read from the source */
+#define RATE_PERIOD     (CLOCK_FREQ) /* consumer rate measurement period */
+#define HORIZON_FAST    (2 * CLOCK_FREQ)
+#define HORIZON_SLOW    (8 * CLOCK_FREQ)
+
+struct stream_ctrl
+{
+    struct stream_ctrl *next;
+    int query;
+    union
+    {
+        struct
+        {
+            int id;
+            bool state;
+        } id_state;
+    };
+};
+
+/* Cached contiguous range of the source */
+struct readahead_range
+{
+    uint64_t     offset;
+    size_t       length;
+    size_t       size;      /* allocated */
+    char        *buffer;
+    uint64_t     used;      /* last use, for eviction */
+    bool         eof;       /* the source ends after this range */
+};
+
+typedef struct
+{
+    vlc_mutex_t  lock;
+    vlc_cond_t   wait_data;
+    vlc_cond_t   wait_space;
+    vlc_thread_t thread;
+    vlc_interrupt_t *interrupt;
+
+    bool         error;
+    bool         paused;
+
+    bool         can_pace;
+    bool         can_pause;
+    uint64_t     size;
+    int64_t      pts_delay;
+    char        *content_type;
+
+    uint64_t     stream_offset;   /* downstream position */
+    uint64_t     source_offset;   /* upstream position */
+
+    struct readahead_range *ranges;
+    unsigned     range_count;
+    unsigned     range_max;
+    size_t       cached;          /* total length of the ranges */
+    size_t       budget;
+    uint64_t     clock;
+
+    /* read-ahead window */
+    size_t       window;
+    size_t       window_min;
+    size_t       window_max;
+    uint64_t     run;             /* bytes read sequentially */
+    uint64_t     run_end;
+    uint64_t     consumer_rate;   /* bytes per second, 0 if unknown */
+    uint64_t     rate_bytes;
+    mtime_t      rate_date;
+    uint64_t     source_rate;     /* bytes per second, 0 if unknown */
+
+    struct stream_ctrl *controls;
+} stream_sys_t;
+
+static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
+{
+    stream_sys_t *sys = stream->p_sys;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_unlock(&sys->lock);
+    assert(length > 0);
+
+    ssize_t val = vlc_stream_ReadPartial(stream->s, buf, length);
+
+    vlc_mutex_lock(&sys->lock);
+    vlc_restorecancel(canc);
+    return val;
+}
+
+static int ThreadSeek(stream_t *stream, uint64_t seek_offset)
+{
+    stream_sys_t *sys = stream->p_sys;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_unlock(&sys->lock);
+
+    int val = vlc_stream_Seek(stream->s, seek_offset);
+    if (val != VLC_SUCCESS)
+        msg_Err(stream, "cannot seek (to offset %"PRIu64")", seek_offset);
+
+    vlc_mutex_lock(&sys->lock);
+    vlc_restorecancel(canc);
+
+    return (val == VLC_SUCCESS) ? 0 : -1;
+}
+
+static int ThreadControl(stream_t *stream, int query, ...)
+{
+    stream_sys_t *sys = stream->p_sys;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_unlock(&sys->lock);
+
+    va_list ap;
+    int ret;
+
+    va_start(ap, query);
+    ret = vlc_stream_vaControl(stream->s, query, ap);
+    va_end(ap);
+
+    vlc_mutex_lock(&sys->lock);
+    vlc_restorecancel(canc);
+    return ret;
+}
+
+/** Finds the range holding data at the given offset */
+static struct readahead_range *FindRange(stream_sys_t *sys, uint64_t offset)
+{
+    for (unsigned i = 0; i < sys->range_count; i++)
+    {
+        struct readahead_range *r = &sys->ranges[i];
+
+        if (offset >= r->offset && offset - r->offset < r->length)
+            return r;
+    }
+    return NULL;
+}
+
+/** Finds the range that would be extended to reach the given offset */
+static struct readahead_range *FindRangeEnd(stream_sys_t *sys,
+                                            uint64_t offset)
+{
+    for (unsigned i = 0; i < sys->range_count; i++)
+    {
+        struct readahead_range *r = &sys->ranges[i];
+
+        if (r->offset + r->length == offset)
+            return r;
+    }
+    return NULL;
+}
+
+static void DeleteRange(stream_sys_t *sys, struct readahead_range *r)
+{
+    assert(sys->cached >= r->length);
+    sys->cached -= r->length;
+    free(r->buffer);
+    *r = sys->ranges[--sys->range_count];
+}
+
+/** Evicts the least recently used range outside [first, last] */
+static bool EvictRange(stream_sys_t *sys, uint64_t first, uint64_t last)
+{
+    struct readahead_range *victim = NULL;
+
+    for (unsigned i = 0; i < sys->range_count; i++)
+    {
+        struct readahead_range *r = &sys->ranges[i];
+
+        if (r->offset >= first && r->offset <= last)
+            continue; /* data ahead of the reader */
+        if (victim == NULL || r->used < victim->used)
+            victim = r;
+    }
+
+    if (victim == NULL)
+        return false;
+    DeleteRange(sys, victim);
+    return true;
+}
+
+static struct readahead_range *NewRange(stream_sys_t *sys, uint64_t offset)
+{
+    if (sys->range_count == sys->range_max)
+        EvictRange(sys, offset, offset);
+    assert(sys->range_count < sys->range_max);
+
+    struct readahead_range *r = &sys->ranges[sys->range_count++];
+
+    r->offset = offset;
+    r->length = 0;
+    r->size = 0;
+    r->buffer = NULL;
+    r->used = sys->clock++;
+    r->eof = sys->size != (uint64_t)-1 && offset >= sys->size;
+    return r;
+}
+
+/**
+ * Makes room for length more bytes in the cache, first by evicting the
+ * ranges not ahead of the reader, then by dropping the data already read
+ * from the range holding the reader position.
+ * @return the number of bytes that fit
+ */
+static size_t MakeRoom(stream_sys_t *sys, uint64_t first, uint64_t last,
+                       size_t length)
+{
+    while (sys->cached + length > sys->budget
+        && EvictRange(sys, first, last))
+        ;
+
+    /* Deleting a range moved the last one of the table */
+    struct readahead_range *r = FindRange(sys, sys->stream_offset);
+    if (r == NULL)
+        r = FindRangeEnd(sys, sys->stream_offset);
+
+    if (sys->cached + length > sys->budget && r != NULL)
+    {
+        size_t history = sys->stream_offset - r->offset;
+        size_t excess = sys->cached + length - sys->budget;
+
+        /* Drop more than needed to not move the data on every read */
+        if (history > excess)
+            history = __MAX(excess, history / 2);
+        if (history > 0)
+        {
+            memmove(r->buffer, r->buffer + history, r->length - history);
+            r->offset += history;
+            r->length -= history;
+            sys->cached -= history;
+        }
+    }
+
+    if (sys->cached >= sys->budget)
+        return 0;
+    return __MIN(length, sys->budget - sys->cached);
+}
+
+/** Adapts the read-ahead window to the access pattern and rates */
+static void UpdateWindow(stream_sys_t *sys)
+{
+    size_t limit = sys->window_max;
+
+    if (sys->consumer_rate > 0)
+    {   /* Cover more time if the source is not much faster than needed */
+        mtime_t horizon = (sys->source_rate > 2 * sys->consumer_rate)
+                          ? HORIZON_FAST : HORIZON_SLOW;
+        uint64_t bytes = sys->consumer_rate * horizon / CLOCK_FREQ;
+
+        if (bytes < limit)
+            limit = __MAX(bytes, sys->window_min);
+    }
+
+    if (sys->run < sys->window_min)
+        sys->window = sys->window_min; /* random access */
+    else if (sys->run >= sys->window / 2 && sys->window < limit)
+        sys->window = __MIN(2 * sys->window, limit); /* sequential access */
+
+    if (sys->window > limit)
+        sys->window = limit;
+}
+
+static void *Thread(void *data)
+{
+    stream_t *stream = data;
+    stream_sys_t *sys = stream->p_sys;
+    bool paused = false;
+
+    vlc_interrupt_set(sys->interrupt);
+
+    vlc_mutex_lock(&sys->lock);
+    mutex_cleanup_push(&sys->lock);
+    for (;;)
+    {
+        struct stream_ctrl *ctrl = sys->controls;
+
+        if (unlikely(ctrl != NULL))
+        {
+            sys->controls = ctrl->next;
+            ThreadControl(stream, ctrl->query, ctrl->id_state.id,
+                          ctrl->id_state.state);
+            free(ctrl);
+            continue;
+        }
+
+        if (sys->paused != paused)
+        {   /* Update pause state */
+            msg_Dbg(stream, paused ? "resuming" : "pausing");
+            paused = sys->paused;
+            ThreadControl(stream, STREAM_SET_PAUSE_STATE, paused);
+            continue;
+        }
+
+        if (paused || sys->error)
+        {   /* Wait for not paused and not failed */
+            vlc_cond_wait(&sys->wait_space, &sys->lock);
+            continue;
+        }
+
+        uint64_t stream_offset = sys->stream_offset;
+        struct readahead_range *first = FindRange(sys, stream_offset);
+
+        if (first == NULL)
+            first = FindRangeEnd(sys, stream_offset);
+        if (first == NULL)
+        {   /* Random access outside of the cached ranges */
+            for (unsigned i = 0; i < sys->range_count; i++)
+                if (sys->ranges[i].length == 0) /* abandoned by the reader */
+                    DeleteRange(sys, &sys->ranges[i--]);
+
+            first = NewRange(sys, stream_offset);
+            vlc_cond_signal(&sys->wait_data); /* may be at EOF */
+        }
+
+        /* Follow the cached data contiguous to the reader position */
+        struct readahead_range *last = first, *next;
+
+        while (!last->eof
+            && (next = FindRange(sys, last->offset + last->length)) != NULL)
+            last = next;
+
+        uint64_t end = last->offset + last->length;
+
+        UpdateWindow(sys);
+
+        if (last->eof || end - stream_offset >= sys->window)
+        {   /* Wait for data to be read or for a seek */
+            vlc_cond_wait(&sys->wait_space, &sys->lock);
+            continue;
+        }
+
+        if (sys->source_offset != end)
+        {
+            if (ThreadSeek(stream, end) == 0)
+                sys->source_offset = end;
+            else
+            {
+                sys->error = true;
+                vlc_cond_signal(&sys->wait_data);
+            }
+            continue;
+        }
+
+        size_t len = sys->window - (end - stream_offset);
+        if (len > READ_MAX)
+            len = READ_MAX;
+
+        /* Do not overlap the next cached range */
+        for (unsigned i = 0; i < sys->range_count; i++)
+        {
+            const struct readahead_range *r = &sys->ranges[i];
+
+            if (r->offset > end && r->offset - end < len)
+                len = r->offset - end;
+        }
+
+        len = MakeRoom(sys, first->offset, last->offset, len);
+        last = FindRangeEnd(sys, end);
+        if (len == 0 || last == NULL)
+        {   /* Cache is full of unread data */
+            vlc_cond_wait(&sys->wait_space, &sys->lock);
+            continue;
+        }
+
+        if (last->length + len > last->size)
+        {
+            size_t size = __MAX(last->length + len, 2 * last->size);
+            char *buf = realloc(last->buffer, size);
+
+            if (unlikely(buf == NULL))
+            {
+                sys->error = true;
+                vlc_cond_signal(&sys->wait_data);
+                continue;
+            }
+            last->buffer = buf;
+            last->size = size;
+        }
+
+        mtime_t start = mdate();
+        ssize_t val = ThreadRead(stream, last->buffer + last->length, len);
+        mtime_t time = mdate() - start;
+
+        /* Only this thread deletes ranges, the last one is still valid */
+        if (val < 0)
+            continue;
+        if (val == 0)
+        {
+            msg_Dbg(stream, "end of stream");
+            last->eof = true;
+        }
+
+        assert((size_t)val <= len);
+        last->length += val;
+        sys->cached += val;
+        sys->source_offset += val;
+
+        if (time > 0 && (size_t)val >= len / 2)
+        {   /* Full reads measure the source throughput */
+            uint64_t rate = (uint64_t)val * CLOCK_FREQ / time;
+
+            sys->source_rate = sys->source_rate
+                             ? (3 * sys->source_rate + rate) / 4 : rate;
+        }
+
+        vlc_cond_signal(&sys->wait_data);
+    }
+    vlc_assert_unreachable();
+    vlc_cleanup_pop();
+    return NULL;
+}
+
+static int Seek(stream_t *stream, uint64_t offset)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    vlc_mutex_lock(&sys->lock);
+    sys->stream_offset = offset;
+    sys->error = false;
+    vlc_cond_signal(&sys->wait_space);
+    vlc_mutex_unlock(&sys->lock);
+    return 0;
+}
+
+static bool AtEOF(stream_sys_t *sys)
+{
+    if (sys->size != (uint64_t)-1 && sys->stream_offset >= sys->size)
+        return true;
+
+    const struct readahead_range *r = FindRangeEnd(sys, sys->stream_offset);
+    return r != NULL && r->eof;
+}
+
+static void UpdateRate(stream_sys_t *sys, size_t length)
+{
+    mtime_t now = mdate();
+
+    if (sys->stream_offset != sys->run_end)
+        sys->run = 0;
+    sys->run += length;
+    sys->run_end = sys->stream_offset + length;
+
+    sys->rate_bytes += length;
+    if (now - sys->rate_date >= RATE_PERIOD)
+    {
+        uint64_t rate = sys->rate_bytes * CLOCK_FREQ / (now - sys->rate_date);
+
+        sys->consumer_rate = sys->consumer_rate
+                           ? (3 * sys->consumer_rate + rate) / 4 : rate;
+        sys->rate_bytes = 0;
+        sys->rate_date = now;
+    }
+}
+
+static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
+{
+    stream_sys_t *sys = stream->p_sys;
+    struct readahead_range *r;
+
+    if (buflen == 0)
+        return buflen;
+
+    vlc_mutex_lock(&sys->lock);
+    if (sys->paused)
+    {
+        msg_Err(stream, "reading while paused (buggy demux?)");
+        sys->paused = false;
+        vlc_cond_signal(&sys->wait_space);
+    }
+
+    while ((r = FindRange(sys, sys->stream_offset)) == NULL)
+    {
+        void *data[2];
+
+        if (sys->error || AtEOF(sys))
+        {
+            vlc_mutex_unlock(&sys->lock);
+            return 0;
+        }
+
+        vlc_interrupt_forward_start(sys->interrupt, data);
+        vlc_cond_wait(&sys->wait_data, &sys->lock);
+        vlc_interrupt_forward_stop(data);
+    }
+
+    size_t offset = sys->stream_offset - r->offset;
+    size_t copy = __MIN(buflen, r->length - offset);
+
+    memcpy(buf, r->buffer + offset, copy);
+    r->used = sys->clock++;
+    UpdateRate(sys, copy);
+    sys->stream_offset += copy;
+    vlc_cond_signal(&sys->wait_space);
+    vlc_mutex_unlock(&sys->lock);
+    return copy;
+}
+
+static int Control(stream_t *stream, int query, va_list args)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+            *va_arg(args, bool *) = true;
+            break;
+        case STREAM_CAN_FASTSEEK:
+            *va_arg(args, bool *) = false;
+            break;
+        case STREAM_CAN_PAUSE:
+             *va_arg(args, bool *) = sys->can_pause;
+            break;
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg (args, bool *) = sys->can_pace;
+            break;
+        case STREAM_GET_SIZE:
+            if (sys->size == (uint64_t)-1)
+                return VLC_EGENERIC;
+            *va_arg(args, uint64_t *) = sys->size;
+            break;
+        case STREAM_GET_PTS_DELAY:
+            *va_arg(args, int64_t *) = sys->pts_delay;
+            break;
+        case STREAM_GET_TITLE_INFO:
+        case STREAM_GET_TITLE:
+        case STREAM_GET_SEEKPOINT:
+        case STREAM_GET_META:
+            return VLC_EGENERIC;
+        case STREAM_GET_CONTENT_TYPE:
+            if (sys->content_type == NULL)
+                return VLC_EGENERIC;
+            *va_arg(args, char **) = strdup(sys->content_type);
+            return VLC_SUCCESS;
+        case STREAM_GET_SIGNAL:
+            return VLC_EGENERIC;
+        case STREAM_SET_PAUSE_STATE:
+        {
+            bool paused = va_arg(args, unsigned);
+
+            vlc_mutex_lock(&sys->lock);
+            sys->paused = paused;
+            vlc_cond_signal(&sys->wait_space);
+            vlc_mutex_unlock (&sys->lock);
+            break;
+        }
+        case STREAM_SET_TITLE:
+        case STREAM_SET_SEEKPOINT:
+            return VLC_EGENERIC;
+        case STREAM_SET_PRIVATE_ID_STATE:
+        {
+            struct stream_ctrl *ctrl = malloc(sizeof (*ctrl)), **pp;
+            if (unlikely(ctrl == NULL))
+                return VLC_ENOMEM;
+
+            ctrl->next = NULL;
+            ctrl->query = query;
+            ctrl->id_state.id = va_arg(args, int);
+            ctrl->id_state.state = va_arg(args, int);
+            vlc_mutex_lock(&sys->lock);
+            for (pp = &sys->controls; *pp != NULL; pp = &((*pp)->next));
+            *pp = ctrl;
+            vlc_cond_signal(&sys->wait_space);
+            vlc_mutex_unlock(&sys->lock);
+            break;
+        }
+        case STREAM_SET_PRIVATE_ID_CA:
+        case STREAM_GET_PRIVATE_ID_STATE:
+            return VLC_EGENERIC;
+        default:
+            msg_Err(stream, "unimplemented query (%d) in control", query);
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int Open(vlc_object_t *obj)
+{
+    stream_t *stream = (stream_t *)obj;
+
+    /* Ranges are only useful if the source can seek. The prefetch filter
+     * handles the other sources. */
+    bool can_seek;
+    if (vlc_stream_Control(stream->s, STREAM_CAN_SEEK, &can_seek)
+     || !can_seek)
+        return VLC_EGENERIC;
+
+    /* PID-filtered streams are not suitable for prefetching, as they would
+     * suffer excessive latency to enable a PID. */
+    if (vlc_stream_Control(stream->s, STREAM_GET_PRIVATE_ID_STATE, 0,
+                           &(bool){ false }) == VLC_SUCCESS)
+        return VLC_EGENERIC;
+
+    stream_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    vlc_stream_Control(stream->s, STREAM_CAN_PAUSE, &sys->can_pause);
+    vlc_stream_Control(stream->s, STREAM_CAN_CONTROL_PACE, &sys->can_pace);
+    if (vlc_stream_Control(stream->s, STREAM_GET_SIZE, &sys->size))
+        sys->size = -1;
+    vlc_stream_Control(stream->s, STREAM_GET_PTS_DELAY, &sys->pts_delay);
+    if (vlc_stream_Control(stream->s, STREAM_GET_CONTENT_TYPE,
+                           &sys->content_type))
+        sys->content_type = NULL;
+
+    sys->error = false;
+    sys->paused = false;
+    sys->stream_offset = 0;
+    sys->source_offset = vlc_stream_Tell(stream->s);
+    sys->range_count = 0;
+    sys->range_max = var_InheritInteger(obj, "readahead-ranges");
+    sys->cached = 0;
+    sys->budget = var_InheritInteger(obj, "readahead-size") << 10u;
+    sys->clock = 0;
+    sys->window_min = var_InheritInteger(obj, "readahead-min-window") << 10u;
+    sys->window_max = sys->budget / 2;
+    if (sys->window_min > sys->window_max)
+        sys->window_min = sys->window_max;
+    sys->window = sys->window_min;
+    sys->run = 0;
+    sys->run_end = 0;
+    sys->consumer_rate = 0;
+    sys->rate_bytes = 0;
+    sys->rate_date = mdate();
+    sys->source_rate = 0;
+    sys->controls = NULL;
+
+    sys->ranges = vlc_alloc(sys->range_max, sizeof (*sys->ranges));
+    if (unlikely(sys->ranges == NULL))
+        goto error;
+
+    sys->interrupt = vlc_interrupt_create();
+    if (unlikely(sys->interrupt == NULL))
+        goto error;
+
+    vlc_mutex_init(&sys->lock);
+    vlc_cond_init(&sys->wait_data);
+    vlc_cond_init(&sys->wait_space);
+
+    stream->p_sys = sys;
+
+    if (vlc_clone(&sys->thread, Thread, stream, VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_cond_destroy(&sys->wait_space);
+        vlc_cond_destroy(&sys->wait_data);
+        vlc_mutex_destroy(&sys->lock);
+        vlc_interrupt_destroy(sys->interrupt);
+        goto error;
+    }
+
+    msg_Dbg(stream, "using %zu bytes in up to %u ranges", sys->budget,
+            sys->range_max);
+    stream->pf_read = Read;
+    stream->pf_seek = Seek;
+    stream->pf_control = Control;
+    return VLC_SUCCESS;
+
+error:
+    free(sys->ranges);
+    free(sys->content_type);
+    free(sys);
+    return VLC_ENOMEM;
+}
+
+
+/**
+ * Releases allocate resources.
+ */
+static void Close (vlc_object_t *obj)
+{
+    stream_t *stream = (stream_t *)obj;
+    stream_sys_t *sys = stream->p_sys;
+
+    vlc_cancel(sys->thread);
+    vlc_interrupt_kill(sys->interrupt);
+    vlc_join(sys->thread, NULL);
+    vlc_interrupt_destroy(sys->interrupt);
+    vlc_cond_destroy(&sys->wait_space);
+    vlc_cond_destroy(&sys->wait_data);
+    vlc_mutex_destroy(&sys->lock);
+
+    while(sys->controls)
+    {
+        struct stream_ctrl *ctrl = sys->controls;
+        sys->controls = ctrl->next;
+        free(ctrl);
+    }
+    for (unsigned i = 0; i < sys->range_count; i++)
+        free(sys->ranges[i].buffer);
+    free(sys->ranges);
+    free(sys->content_type);
+    free(sys);
+}
+
+vlc_module_begin()
+    set_category(CAT_INPUT)
+    set_subcategory(SUBCAT_INPUT_STREAM_FILTER)
+    set_capability("stream_filter", 0)
+
+    set_description(N_("Stream read-ahead filter"))
+    set_callbacks(Open, Close)
+
+    add_integer("readahead-size", 1 << 15, N_("Cache size"),
+                N_("Read-ahead cache size for all the ranges (KiB)"), false)
+        change_integer_range(64, 1 << 20)
+    add_integer("readahead-min-window", 64, N_("Minimum window"),
+                N_("Read-ahead window after a random access (KiB)"), true)
+        change_integer_range(4, 1 << 16)
+    add_integer("readahead-ranges", 8, N_("Cached ranges"),
+                N_("Maximum number of non-contiguous cached ranges"), true)
+        change_integer_range(1, 64)
+vlc_module_end()
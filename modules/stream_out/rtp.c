@@ -69,6 +69,8 @@
 #include <errno.h>
 #include <assert.h>
 
+#define RTP_BATCH_MAX 64
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -137,6 +139,11 @@
     "Default caching value for outbound RTP streams. This " \
     "value should be set in milliseconds." )
 
+#define BATCH_TEXT N_("Send batch size")
+#define BATCH_LONGTEXT N_( \
+    "RTP packets that are due at the same time are sent with a single " \
+    "system call, up to this many at a time." )
+
 #define PROTO_TEXT N_("Transport protocol")
 #define PROTO_LONGTEXT N_( \
     "This selects which transport protocol to use for RTP." )
@@ -227,6 +234,11 @@ vlc_module_begin ()
               RTCP_MUX_TEXT, RTCP_MUX_LONGTEXT, false )
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000,
                  CACHING_TEXT, CACHING_LONGTEXT, true )
+#ifdef HAVE_SENDMMSG
+    add_integer( SOUT_CFG_PREFIX "batch", 16, BATCH_TEXT,
+                 BATCH_LONGTEXT, true )
+        change_integer_range( 1, RTP_BATCH_MAX )
+#endif
 
 #ifdef HAVE_SRTP
     add_string( SOUT_CFG_PREFIX "key", "",
@@ -263,6 +275,9 @@ static const char *const ppsz_sout_options[] = {
     "dst", "name", "cat", "port", "port-audio", "port-video", "*sdp", "ttl",
     "mux", "sap", "description", "url", "email",
     "proto", "rtcp-mux", "caching",
+#ifdef HAVE_SENDMMSG
+    "batch",
+#endif
 #ifdef HAVE_SRTP
     "key", "salt",
 #endif
@@ -383,6 +398,7 @@ struct sout_stream_id_sys_t
 
     block_fifo_t     *p_fifo;
     mtime_t           i_caching;
+    unsigned          i_batch;
 };
 
 /*****************************************************************************
@@ -979,6 +995,12 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
     id->b_first_packet = true;
     id->i_caching =
         (int64_t)1000 * var_GetInteger( p_stream, SOUT_CFG_PREFIX "caching");
+    id->i_batch = 1;
+#ifdef HAVE_SENDMMSG
+    id->i_batch = var_GetInteger( p_stream, SOUT_CFG_PREFIX "batch" );
+    if( id->i_batch < 1 || id->i_batch > RTP_BATCH_MAX )
+        id->i_batch = 1;
+#endif
 
     vlc_rand_bytes (&id->i_sequence, sizeof (id->i_sequence));
     vlc_rand_bytes (id->ssrc, sizeof (id->ssrc));
@@ -1389,6 +1411,57 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
+#ifdef HAVE_SRTP
+static block_t *rtp_protect( sout_stream_id_sys_t *id, block_t *out )
+{   /* FIXME: this is awfully inefficient */
+    size_t len = out->i_buffer;
+    out = block_Realloc( out, 0, len + 10 );
+    out->i_buffer = len;
+
+    int canc = vlc_savecancel ();
+    int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
+    vlc_restorecancel (canc);
+    if( val )
+    {
+        msg_Dbg( id->p_stream, "SRTP sending error: %s",
+                 vlc_strerror_c(val) );
+        block_Release( out );
+        return NULL;
+    }
+    out->i_buffer = len;
+    return out;
+}
+#endif
+
+/**
+ * Sends a batch of RTP packets to one sink.
+ * @return the number of packets sent, or -1 on error on the first one.
+ */
+static int rtp_send_batch( int fd, block_t *const *batch, unsigned count )
+{
+#ifdef HAVE_SENDMMSG
+    if( count > 1 )
+    {
+        struct mmsghdr msgs[count];
+        struct iovec iov[count];
+
+        for( unsigned i = 0; i < count; i++ )
+        {
+            iov[i].iov_base = batch[i]->p_buffer;
+            iov[i].iov_len = batch[i]->i_buffer;
+            memset( &msgs[i], 0, sizeof (msgs[i]) );
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        return sendmmsg( fd, msgs, count, 0 );
+    }
+#else
+    (void) count;
+#endif
+    return (send( fd, batch[0]->p_buffer, batch[0]->i_buffer, 0 ) == -1)
+           ? -1 : 1;
+}
+
 static void* ThreadSend( void *data )
 {
 #ifdef _WIN32
@@ -1406,24 +1479,7 @@ static void* ThreadSend( void *data )
 
 #ifdef HAVE_SRTP
         if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int canc = vlc_savecancel ();
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            vlc_restorecancel (canc);
-            if( val )
-            {
-                msg_Dbg( id->p_stream, "SRTP sending error: %s",
-                         vlc_strerror_c(val) );
-                block_Release( out );
-                out = NULL;
-            }
-            else
-                out->i_buffer = len;
-        }
+            out = rtp_protect( id, out );
         if (out)
             mwait (out->i_dts + i_caching);
         vlc_cleanup_pop ();
@@ -1434,38 +1490,78 @@ static void* ThreadSend( void *data )
         vlc_cleanup_pop ();
 #endif
 
-        ssize_t len = out->i_buffer;
+        block_t *batch[RTP_BATCH_MAX];
+        unsigned count = 0;
         int canc = vlc_savecancel ();
 
+        /* Gather the following packets if they are due too */
+        batch[count++] = out;
+        while( count < id->i_batch )
+        {
+            vlc_fifo_Lock( id->p_fifo );
+            bool empty = vlc_fifo_IsEmpty( id->p_fifo );
+            vlc_fifo_Unlock( id->p_fifo );
+            if( empty
+             || block_FifoShow( id->p_fifo )->i_dts + i_caching > mdate() )
+                break;
+
+            out = block_FifoGet( id->p_fifo );
+#ifdef HAVE_SRTP
+            if( id->srtp )
+                out = rtp_protect( id, out );
+            if( out == NULL )
+                continue;
+#endif
+            batch[count++] = out;
+        }
+
         vlc_mutex_lock( &id->lock_sink );
         unsigned deadc = 0; /* How many dead sockets? */
         int deadv[id->sinkc ? id->sinkc : 1]; /* Dead sockets list */
 
         for( int i = 0; i < id->sinkc; i++ )
         {
+            int fd = id->sinkv[i].rtp_fd;
+
 #ifdef HAVE_SRTP
             if( !id->srtp ) /* FIXME: SRTCP support */
 #endif
-                SendRTCP( id->sinkv[i].rtcp, out );
+                for( unsigned j = 0; j < count; j++ )
+                    SendRTCP( id->sinkv[i].rtcp, batch[j] );
 
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
+            for( unsigned sent = 0; sent < count; )
             {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
-                    /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                else
-                    /* Broken connection */
-                    deadv[deadc++] = id->sinkv[i].rtp_fd;
+                int val = rtp_send_batch( fd, batch + sent, count - sent );
+                if( val > 0 )
+                {
+                    sent += val;
+                    continue;
+                }
+
+                if( net_errno != EAGAIN && net_errno != EWOULDBLOCK
+                 && net_errno != ENOBUFS && net_errno != ENOMEM )
+                {
+                    int type;
+                    getsockopt( fd, SOL_SOCKET, SO_TYPE,
+                                &type, &(socklen_t){ sizeof(type) });
+                    if( type == SOCK_DGRAM )
+                        /* ICMP soft error: ignore and retry */
+                        send( fd, batch[sent]->p_buffer,
+                              batch[sent]->i_buffer, 0 );
+                    else
+                    {   /* Broken connection */
+                        deadv[deadc++] = fd;
+                        break;
+                    }
+                }
+                sent++;
             }
         }
+        out = batch[count - 1];
         id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
         vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
+        for( unsigned j = 0; j < count; j++ )
+            block_Release( batch[j] );
 
         for( unsigned i = 0; i < deadc; i++ )
         {
@@ -111,6 +111,10 @@ static void Destroy( vlc_object_t * );
 #define TEXT_DIRECTION_LONGTEXT N_("Paragraph base direction for the Unicode bi-directional algorithm.")
 
 
+#define CACHE_SIZE_TEXT N_("Glyph cache size (KiB)")
+#define CACHE_SIZE_LONGTEXT N_("Memory used to keep the rendered glyphs and " \
+  "the shaped text between subtitles. 0 disables the cache." )
+
 #define YUVP_TEXT N_("Use YUVP renderer")
 #define YUVP_LONGTEXT N_("This renders the font using \"paletized YUV\". " \
   "This option is only needed if you want to encode into DVB subtitles" )
@@ -211,6 +215,8 @@ vlc_module_begin ()
 
     add_bool( "freetype-yuvp", false, YUVP_TEXT,
               YUVP_LONGTEXT, true )
+    add_integer_with_range( "freetype-cache-size", 4096, 0, 65536,
+                            CACHE_SIZE_TEXT, CACHE_SIZE_LONGTEXT, true )
 
 #ifdef HAVE_FRIBIDI
     add_integer_with_range( "freetype-text-direction", 0, 0, 2, TEXT_DIRECTION_TEXT,
@@ -1200,6 +1206,10 @@ static int Render( filter_t *p_filter, subpicture_region_t *p_region_out,
 
     UpdateDefaultLiveStyles( p_filter );
 
+    /* Cached glyphs are only referenced during a rendering */
+    if( p_sys->cache.i_size > p_sys->cache.i_max_size )
+        ClearLayoutCache( p_filter, true );
+
     /*
      * Update the default face to reflect changes in video size or text scaling
      */
@@ -1427,6 +1437,11 @@ static int Create( vlc_object_t *p_this )
     vlc_dictionary_init( &p_sys->family_map, 50 );
     vlc_dictionary_init( &p_sys->fallback_map, 20 );
 
+    vlc_dictionary_init( &p_sys->cache.glyph_map, 1024 );
+    vlc_dictionary_init( &p_sys->cache.run_map, 256 );
+    p_sys->cache.i_max_size =
+        (size_t)var_InheritInteger( p_filter, "freetype-cache-size" ) * 1024;
+
     p_sys->i_scale = 100;
 
     /* default style to apply to uncomplete segmeents styles */
@@ -1547,6 +1562,12 @@ static void Destroy( vlc_object_t *p_this )
     DumpDictionary( p_filter, &p_sys->fallback_map, true, -1 );
 #endif
 
+    /* Glyph cache */
+    if( p_sys->cache.i_max_size > 0 )
+        msg_Dbg( p_filter, "glyph cache: %u hits, %u misses",
+                 p_sys->cache.i_hits, p_sys->cache.i_misses );
+    ClearLayoutCache( p_filter, false );
+
     /* Text styles */
     text_style_Delete( p_sys->p_default_style );
     text_style_Delete( p_sys->p_forced_style );
@@ -111,6 +111,21 @@ typedef struct
     /** Font face cache */
     vlc_dictionary_t  face_map;
 
+    /**
+     * Glyphs and shaped runs kept across renderings, see text_layout.c.
+     * The dictionaries are emptied between two renderings once they hold
+     * more than i_max_size bytes. A zero i_max_size disables the caches.
+     */
+    struct
+    {
+        vlc_dictionary_t glyph_map;
+        vlc_dictionary_t run_map;
+        size_t           i_size;
+        size_t           i_max_size;
+        unsigned         i_hits;
+        unsigned         i_misses;
+    } cache;
+
     int               i_fallback_counter;
 
     /* Current scaling of the text, default is 100 (%) */
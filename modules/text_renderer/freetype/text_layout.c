@@ -41,6 +41,7 @@
 
 #include <vlc_common.h>
 #include <vlc_filter.h>
+#include <vlc_memstream.h>
 #include <vlc_text_style.h>
 
 /* Freetype */
@@ -115,6 +116,40 @@ typedef struct run_desc_t
 
 } run_desc_t;
 
+/**
+ * Bitmap of a cached glyph, rendered at a sub-pixel origin
+ */
+typedef struct cached_bitmap_t
+{
+    struct cached_bitmap_t *p_next;
+    FT_Glyph                p_glyph;
+    bool                    b_outline;
+    FT_Vector               origin;      /**< 26.6 values within [0, 64) */
+} cached_bitmap_t;
+
+/**
+ * Cached glyph of a face, with its synthesized style and outline
+ */
+typedef struct cached_glyph_t
+{
+    FT_Glyph         p_glyph;
+    FT_Glyph         p_outline;
+    FT_Vector        advance;
+    cached_bitmap_t *p_bitmaps;
+} cached_glyph_t;
+
+#ifdef HAVE_HARFBUZZ
+/**
+ * Cached result of shaping a run
+ */
+typedef struct cached_run_t
+{
+    unsigned int         i_glyph_count;
+    hb_glyph_info_t     *p_infos;
+    hb_glyph_position_t *p_positions;
+} cached_run_t;
+#endif
+
 /**
  * Glyph bitmaps. Advance and offset are 26.6 values
  */
@@ -123,6 +158,7 @@ typedef struct glyph_bitmaps_t
     FT_Glyph p_glyph;
     FT_Glyph p_outline;
     FT_Glyph p_shadow;
+    cached_glyph_t *p_cached;
     FT_BBox  glyph_bbox;
     FT_BBox  outline_bbox;
     FT_BBox  shadow_bbox;
@@ -297,6 +333,171 @@ static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox,
     }
 }
 
+/*
+ * Glyph and shaped run caches
+ *
+ * Loading, hinting and stroking a glyph, and shaping a run, only depend on
+ * the face (which has a fixed size), the glyph or the text and the style.
+ * Rasterizing a glyph also depends on the sub-pixel part of the pen position,
+ * the integer part only moves the bitmap. Entries are owned by the
+ * dictionaries of filter_sys_t and stay valid until the next rendering.
+ */
+static size_t GlyphSize( FT_Glyph glyph )
+{
+    if( glyph->format == FT_GLYPH_FORMAT_BITMAP )
+    {
+        const FT_Bitmap *p_bitmap = &((FT_BitmapGlyph)glyph)->bitmap;
+        return sizeof( FT_BitmapGlyphRec )
+             + p_bitmap->rows * (size_t)abs( p_bitmap->pitch );
+    }
+    if( glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+    {
+        const FT_Outline *p_outline = &((FT_OutlineGlyph)glyph)->outline;
+        return sizeof( FT_OutlineGlyphRec )
+             + p_outline->n_points * ( sizeof( FT_Vector ) + 1 )
+             + p_outline->n_contours * sizeof( short );
+    }
+    return sizeof( FT_GlyphRec );
+}
+
+static void FreeCachedGlyph( void *p_item, void *p_obj )
+{
+    VLC_UNUSED( p_obj );
+    cached_glyph_t *p_cached = p_item;
+
+    for( cached_bitmap_t *p_bmp = p_cached->p_bitmaps; p_bmp; )
+    {
+        cached_bitmap_t *p_next = p_bmp->p_next;
+        FT_Done_Glyph( p_bmp->p_glyph );
+        free( p_bmp );
+        p_bmp = p_next;
+    }
+    FT_Done_Glyph( p_cached->p_glyph );
+    if( p_cached->p_outline )
+        FT_Done_Glyph( p_cached->p_outline );
+    free( p_cached );
+}
+
+#ifdef HAVE_HARFBUZZ
+static void FreeCachedRun( void *p_item, void *p_obj )
+{
+    VLC_UNUSED( p_obj );
+    cached_run_t *p_cached = p_item;
+
+    free( p_cached->p_infos );
+    free( p_cached->p_positions );
+    free( p_cached );
+}
+#endif
+
+void ClearLayoutCache( filter_t *p_filter, bool b_reuse )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    vlc_dictionary_clear( &p_sys->cache.glyph_map, FreeCachedGlyph, NULL );
+#ifdef HAVE_HARFBUZZ
+    vlc_dictionary_clear( &p_sys->cache.run_map, FreeCachedRun, NULL );
+#else
+    vlc_dictionary_clear( &p_sys->cache.run_map, NULL, NULL );
+#endif
+    p_sys->cache.i_size = 0;
+
+    if( b_reuse )
+    {
+        vlc_dictionary_init( &p_sys->cache.glyph_map, 1024 );
+        vlc_dictionary_init( &p_sys->cache.run_map, 256 );
+    }
+}
+
+static cached_glyph_t *CacheGlyph( filter_t *p_filter, const char *psz_key,
+                                   FT_Glyph p_glyph, FT_Glyph p_outline,
+                                   const FT_Vector *p_advance )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    cached_glyph_t *p_cached = calloc( 1, sizeof( *p_cached ) );
+    if( !p_cached )
+        return NULL;
+
+    if( FT_Glyph_Copy( p_glyph, &p_cached->p_glyph ) )
+    {
+        free( p_cached );
+        return NULL;
+    }
+    if( p_outline && FT_Glyph_Copy( p_outline, &p_cached->p_outline ) )
+    {
+        FT_Done_Glyph( p_cached->p_glyph );
+        free( p_cached );
+        return NULL;
+    }
+    p_cached->advance = *p_advance;
+
+    p_sys->cache.i_size += sizeof( *p_cached ) + GlyphSize( p_glyph );
+    if( p_outline )
+        p_sys->cache.i_size += GlyphSize( p_outline );
+
+    vlc_dictionary_insert( &p_sys->cache.glyph_map, psz_key, p_cached );
+    return p_cached;
+}
+
+/**
+ * Replaces an outline glyph with its bitmap rendered at \p p_origin,
+ * like FT_Glyph_To_Bitmap(), using the bitmaps of the cached glyph if any.
+ */
+static int GlyphToBitmap( filter_t *p_filter, cached_glyph_t *p_cached,
+                          FT_Glyph *pp_glyph, bool b_outline,
+                          const FT_Vector *p_origin, bool b_destroy )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( !p_cached )
+        return FT_Glyph_To_Bitmap( pp_glyph, FT_RENDER_MODE_NORMAL,
+                                   (FT_Vector *) p_origin, b_destroy );
+
+    FT_Vector origin = { .x = p_origin->x & 63, .y = p_origin->y & 63 };
+
+    cached_bitmap_t *p_bmp = p_cached->p_bitmaps;
+    while( p_bmp && ( p_bmp->b_outline != b_outline
+                   || p_bmp->origin.x != origin.x
+                   || p_bmp->origin.y != origin.y ) )
+        p_bmp = p_bmp->p_next;
+
+    if( !p_bmp )
+    {
+        p_bmp = malloc( sizeof( *p_bmp ) );
+        if( !p_bmp )
+            return FT_Err_Out_Of_Memory;
+
+        p_bmp->p_glyph = b_outline ? p_cached->p_outline : p_cached->p_glyph;
+        int i_error = FT_Glyph_To_Bitmap( &p_bmp->p_glyph, FT_RENDER_MODE_NORMAL,
+                                          &origin, 0 );
+        if( i_error )
+        {
+            free( p_bmp );
+            return i_error;
+        }
+        p_bmp->b_outline = b_outline;
+        p_bmp->origin = origin;
+        p_bmp->p_next = p_cached->p_bitmaps;
+        p_cached->p_bitmaps = p_bmp;
+        p_sys->cache.i_size += sizeof( *p_bmp ) + GlyphSize( p_bmp->p_glyph );
+    }
+
+    FT_Glyph glyph;
+    int i_error = FT_Glyph_Copy( p_bmp->p_glyph, &glyph );
+    if( i_error )
+        return i_error;
+
+    FT_BitmapGlyph glyph_bmp = (FT_BitmapGlyph) glyph;
+    glyph_bmp->left += ( p_origin->x - origin.x ) / 64;
+    glyph_bmp->top  += ( p_origin->y - origin.y ) / 64;
+
+    if( b_destroy )
+        FT_Done_Glyph( *pp_glyph );
+    *pp_glyph = glyph;
+    return 0;
+}
+
 static paragraph_t *NewParagraph( filter_t *p_filter,
                                   int i_size,
                                   const uni_char_t *p_code_points,
@@ -728,6 +929,56 @@ static int ItemizeParagraph( filter_t *p_filter, paragraph_t *p_paragraph )
 }
 
 #ifdef HAVE_HARFBUZZ
+/**
+ * Builds the key of a run to shape: its face, script, direction and text.
+ */
+static char *RunKey( const paragraph_t *p_paragraph, const run_desc_t *p_run )
+{
+    struct vlc_memstream stream;
+
+    if( vlc_memstream_open( &stream ) )
+        return NULL;
+
+    vlc_memstream_printf( &stream, "%p %x %x", (void *) p_run->p_face,
+                          (unsigned) p_run->script, (unsigned) p_run->direction );
+    for( int i = p_run->i_start_offset; i < p_run->i_end_offset; ++i )
+        vlc_memstream_printf( &stream, " %x",
+                              (unsigned) p_paragraph->p_code_points[ i ] );
+
+    if( vlc_memstream_close( &stream ) )
+        return NULL;
+    return stream.ptr;
+}
+
+static void CacheRun( filter_t *p_filter, const char *psz_key,
+                      const run_desc_t *p_run )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned int i_count = p_run->i_glyph_count;
+
+    cached_run_t *p_cached = malloc( sizeof( *p_cached ) );
+    if( !p_cached )
+        return;
+
+    p_cached->i_glyph_count = i_count;
+    p_cached->p_infos = vlc_alloc( i_count, sizeof( *p_cached->p_infos ) );
+    p_cached->p_positions = vlc_alloc( i_count, sizeof( *p_cached->p_positions ) );
+    if( !p_cached->p_infos || !p_cached->p_positions )
+    {
+        FreeCachedRun( p_cached, NULL );
+        return;
+    }
+    memcpy( p_cached->p_infos, p_run->p_glyph_infos,
+            i_count * sizeof( *p_cached->p_infos ) );
+    memcpy( p_cached->p_positions, p_run->p_glyph_positions,
+            i_count * sizeof( *p_cached->p_positions ) );
+
+    p_sys->cache.i_size += sizeof( *p_cached ) + strlen( psz_key )
+                         + i_count * ( sizeof( *p_cached->p_infos )
+                                     + sizeof( *p_cached->p_positions ) );
+    vlc_dictionary_insert( &p_sys->cache.run_map, psz_key, p_cached );
+}
+
 /**
  * Shape an itemized paragraph using HarfBuzz.
  * This is where the glyphs of complex scripts get their positions
@@ -752,6 +1003,8 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         return VLC_EGENERIC;
     }
 
+    char *psz_run_key = NULL;
+
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
         run_desc_t *p_run = p_paragraph->p_runs + i;
@@ -781,6 +1034,25 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         else
             p_face = p_run->p_face;
 
+        if( p_sys->cache.i_max_size > 0 )
+        {
+            psz_run_key = RunKey( p_paragraph, p_run );
+            const cached_run_t *p_cached = psz_run_key ?
+                vlc_dictionary_value_for_key( &p_sys->cache.run_map, psz_run_key ) : NULL;
+            if( p_cached )
+            {
+                p_sys->cache.i_hits++;
+                free( psz_run_key );
+                psz_run_key = NULL;
+
+                p_run->p_glyph_infos = p_cached->p_infos;
+                p_run->p_glyph_positions = p_cached->p_positions;
+                p_run->i_glyph_count = p_cached->i_glyph_count;
+                i_total_glyphs += p_run->i_glyph_count;
+                continue;
+            }
+        }
+
         p_run->p_hb_font = hb_ft_font_create( p_face, 0 );
         if( !p_run->p_hb_font )
         {
@@ -823,6 +1095,14 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
             goto error;
         }
 
+        if( psz_run_key )
+        {
+            p_sys->cache.i_misses++;
+            CacheRun( p_filter, psz_run_key, p_run );
+            free( psz_run_key );
+            psz_run_key = NULL;
+        }
+
         i_total_glyphs += p_run->i_glyph_count;
     }
 
@@ -896,8 +1176,11 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
 
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
-        hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
-        hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        /* Runs found in the cache were not shaped */
+        if( p_paragraph->p_runs[ i ].p_hb_font )
+            hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
+        if( p_paragraph->p_runs[ i ].p_buffer )
+            hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
     }
     FreeParagraph( *p_old_paragraph );
     *p_old_paragraph = p_new_paragraph;
@@ -905,6 +1188,7 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
     return VLC_SUCCESS;
 
 error:
+    free( psz_run_key );
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
         if( p_paragraph->p_runs[ i ].p_hb_font )
@@ -1052,18 +1336,24 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
+        int i_radius = -1;
         if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
         {
             double f_outline_thickness =
                 var_InheritInteger( p_filter, "freetype-outline-thickness" ) / 100.0;
             f_outline_thickness = VLC_CLIP( f_outline_thickness, 0.0, 0.5 );
-            int i_radius = ( i_live_size << 6 ) * f_outline_thickness;
+            i_radius = ( i_live_size << 6 ) * f_outline_thickness;
             FT_Stroker_Set( p_sys->p_stroker,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
                             FT_STROKER_LINEJOIN_ROUND, 0 );
         }
 
+        const bool b_embolden = ( p_style->i_style_flags & STYLE_BOLD )
+                             && !( p_face->style_flags & FT_STYLE_FLAG_BOLD );
+        const bool b_oblique = ( p_style->i_style_flags & STYLE_ITALIC )
+                            && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC );
+
         for( int j = p_run->i_start_offset; j < p_run->i_end_offset; ++j )
         {
             int i_glyph_index;
@@ -1114,39 +1404,76 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
-            if( FT_Load_Glyph( p_face, i_glyph_index,
-                               FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
-             && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
-                SKIP_GLYPH( p_bitmaps )
+            char psz_key[64];
+            cached_glyph_t *p_cached = NULL;
+            if( p_sys->cache.i_max_size > 0 )
+            {
+                snprintf( psz_key, sizeof( psz_key ), "%p %x %d%d %d",
+                          (void *) p_face, i_glyph_index,
+                          b_embolden, b_oblique, i_radius );
+                p_cached = vlc_dictionary_value_for_key( &p_sys->cache.glyph_map,
+                                                         psz_key );
+            }
 
-            if( ( p_style->i_style_flags & STYLE_BOLD )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
-                FT_GlyphSlot_Embolden( p_face->glyph );
-            if( ( p_style->i_style_flags & STYLE_ITALIC )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
-                FT_GlyphSlot_Oblique( p_face->glyph );
+            FT_Vector advance;
+            if( p_cached )
+            {
+                p_sys->cache.i_hits++;
 
-            if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
-                SKIP_GLYPH( p_bitmaps )
+                if( FT_Glyph_Copy( p_cached->p_glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
+                if( p_cached->p_outline
+                 && FT_Glyph_Copy( p_cached->p_outline, &p_bitmaps->p_outline ) )
+                    p_bitmaps->p_outline = 0;
+                advance = p_cached->advance;
+            }
+            else
+            {
+                if( FT_Load_Glyph( p_face, i_glyph_index,
+                                   FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
+                 && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-#undef SKIP_GLYPH
+                if( b_embolden )
+                    FT_GlyphSlot_Embolden( p_face->glyph );
+                if( b_oblique )
+                    FT_GlyphSlot_Oblique( p_face->glyph );
 
-            if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
-            {
-                p_bitmaps->p_outline = p_bitmaps->p_glyph;
-                if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
-                                           p_sys->p_stroker, 0, 0 ) )
-                    p_bitmaps->p_outline = 0;
+                if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
+
+                if( i_radius >= 0 )
+                {
+                    p_bitmaps->p_outline = p_bitmaps->p_glyph;
+                    if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
+                                               p_sys->p_stroker, 0, 0 ) )
+                        p_bitmaps->p_outline = 0;
+                }
+                advance = p_face->glyph->advance;
+
+                if( p_sys->cache.i_max_size > 0 )
+                {
+                    p_sys->cache.i_misses++;
+                    p_cached = CacheGlyph( p_filter, psz_key, p_bitmaps->p_glyph,
+                                           p_bitmaps->p_outline, &advance );
+                }
             }
 
+#undef SKIP_GLYPH
+
+            /* Only render from the cache a glyph with the same outline */
+            if( p_cached && !p_cached->p_outline != !p_bitmaps->p_outline )
+                p_cached = NULL;
+            p_bitmaps->p_cached = p_cached;
+
             if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
                                       p_bitmaps->p_outline : p_bitmaps->p_glyph;
 
             if( b_overwrite_advance )
             {
-                p_bitmaps->i_x_advance = p_face->glyph->advance.x;
-                p_bitmaps->i_y_advance = p_face->glyph->advance.y;
+                p_bitmaps->i_x_advance = advance.x;
+                p_bitmaps->i_y_advance = advance.y;
             }
         }
 
@@ -1253,8 +1580,9 @@ static int LayoutLine( filter_t *p_filter,
 
         if( p_bitmaps->p_shadow )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                    &pen_shadow, 0 ) )
+            const bool b_outline = p_bitmaps->p_shadow == p_bitmaps->p_outline;
+            if( GlyphToBitmap( p_filter, p_bitmaps->p_cached,
+                               &p_bitmaps->p_shadow, b_outline, &pen_shadow, false ) )
                 p_bitmaps->p_shadow = 0;
             else
                 FT_Glyph_Get_CBox( p_bitmaps->p_shadow, ft_glyph_bbox_pixels,
@@ -1262,8 +1590,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_glyph )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_glyph, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( GlyphToBitmap( p_filter, p_bitmaps->p_cached,
+                               &p_bitmaps->p_glyph, false, &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_glyph );
                 if( p_bitmaps->p_outline )
@@ -1278,8 +1606,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_outline )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_outline, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( GlyphToBitmap( p_filter, p_bitmaps->p_cached,
+                               &p_bitmaps->p_outline, true, &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_outline );
                 p_bitmaps->p_outline = 0;
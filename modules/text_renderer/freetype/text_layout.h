@@ -65,6 +65,14 @@ struct line_desc_t
 void FreeLines( line_desc_t *p_lines );
 line_desc_t *NewLine( int i_count );
 
+/**
+ * Empties the glyph and shaped run caches of the module.
+ *
+ * \param p_filter the FreeType module object [IN]
+ * \param b_reuse whether the caches will be used again [IN]
+ */
+void ClearLayoutCache( filter_t *p_filter, bool b_reuse );
+
 /**
  * \struct layout_ruby_t
  * \brief LayoutText parameters
@@ -296,17 +296,90 @@ static void Deactivate( vlc_object_t *p_this )
     free( p_sys );
 }
 
+/*****************************************************************************
+ * Convert: convert a picture, in bands when possible
+ *****************************************************************************
+ * Without scaling, each line is converted on its own, so the bands of the
+ * picture are converted in parallel. The conversion functions only read the
+ * formats and the tables of the filter: each band gets a copy of the filter
+ * whose formats describe the lines of the band.
+ *****************************************************************************/
+typedef void (*convert_cb)( filter_t *, picture_t *, picture_t * );
+
+struct convert_slice
+{
+    convert_cb pf_convert;
+    picture_t *p_src;
+    picture_t *p_dst;
+};
+
+static void ConvertSlice( filter_t *p_filter, void *opaque,
+                          unsigned i_first, unsigned i_last )
+{
+    const struct convert_slice *p_slice = opaque;
+    const unsigned i_lines = p_filter->fmt_in.video.i_visible_height;
+    filter_t band = *p_filter;
+    picture_t src, dst;
+
+    band.fmt_in.video.i_visible_height =
+    band.fmt_out.video.i_visible_height = i_last - i_first;
+    filter_SlicePicture( &src, p_slice->p_src, i_first, i_last, i_lines );
+    filter_SlicePicture( &dst, p_slice->p_dst, i_first, i_last, i_lines );
+    p_slice->pf_convert( &band, &src, &dst );
+}
+
+static void Convert( filter_t *p_filter, picture_t *p_src, picture_t *p_dst,
+                     convert_cb pf_convert )
+{
+    const video_format_t *p_in = &p_filter->fmt_in.video;
+    const video_format_t *p_out = &p_filter->fmt_out.video;
+
+    /* Scaling carries state from a line to the next one */
+    if( p_in->i_x_offset != p_out->i_x_offset
+     || p_in->i_visible_width != p_out->i_visible_width
+     || p_in->i_y_offset != 0 || p_out->i_y_offset != 0
+     || p_in->i_visible_height != p_out->i_visible_height
+     || (p_in->i_visible_height & 1)
+     || (unsigned)p_src->p[Y_PLANE].i_visible_lines != p_in->i_visible_height
+     || (unsigned)p_dst->p[0].i_visible_lines != p_out->i_visible_height )
+    {
+        pf_convert( p_filter, p_src, p_dst );
+        return;
+    }
+
+    struct convert_slice slice = {
+        .pf_convert = pf_convert,
+        .p_src = p_src,
+        .p_dst = p_dst,
+    };
+    filter_RunSlices( p_filter, p_in->i_visible_height, ConvertSlice, &slice );
+}
+
+#define CONVERT_WRAPPER( name )                                         \
+    static picture_t *name ## _Filter ( filter_t *p_filter,             \
+                                        picture_t *p_pic )              \
+    {                                                                   \
+        picture_t *p_outpic = filter_NewPicture( p_filter );            \
+        if( p_outpic )                                                  \
+        {                                                               \
+            Convert( p_filter, p_pic, p_outpic, name );                 \
+            picture_CopyProperties( p_outpic, p_pic );                  \
+        }                                                               \
+        picture_Release( p_pic );                                       \
+        return p_outpic;                                                \
+    }
+
 #ifndef PLAIN
-VIDEO_FILTER_WRAPPER( I420_R5G5B5 )
-VIDEO_FILTER_WRAPPER( I420_R5G6B5 )
-VIDEO_FILTER_WRAPPER( I420_A8R8G8B8 )
-VIDEO_FILTER_WRAPPER( I420_R8G8B8A8 )
-VIDEO_FILTER_WRAPPER( I420_B8G8R8A8 )
-VIDEO_FILTER_WRAPPER( I420_A8B8G8R8 )
+CONVERT_WRAPPER( I420_R5G5B5 )
+CONVERT_WRAPPER( I420_R5G6B5 )
+CONVERT_WRAPPER( I420_A8R8G8B8 )
+CONVERT_WRAPPER( I420_R8G8B8A8 )
+CONVERT_WRAPPER( I420_B8G8R8A8 )
+CONVERT_WRAPPER( I420_A8B8G8R8 )
 #else
-VIDEO_FILTER_WRAPPER( I420_RGB8 )
-VIDEO_FILTER_WRAPPER( I420_RGB16 )
-VIDEO_FILTER_WRAPPER( I420_RGB32 )
+CONVERT_WRAPPER( I420_RGB8 )
+CONVERT_WRAPPER( I420_RGB16 )
+CONVERT_WRAPPER( I420_RGB32 )
 
 /*****************************************************************************
  * SetGammaTable: return intensity table transformed by gamma curve.
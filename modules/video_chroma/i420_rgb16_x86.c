@@ -671,8 +671,8 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
                     SSE2_UNPACK_32_ARGB_UNALIGNED
                 );
                 p_y += 16;
-                p_u += 4;
-                p_v += 4;
+                p_u += 8;
+                p_v += 8;
             }
             SCALE_WIDTH;
             SCALE_HEIGHT( 420, 4 );
@@ -903,8 +903,8 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     SSE2_UNPACK_32_RGBA_UNALIGNED
                 );
                 p_y += 16;
-                p_u += 4;
-                p_v += 4;
+                p_u += 8;
+                p_v += 8;
             }
             SCALE_WIDTH;
             SCALE_HEIGHT( 420, 4 );
@@ -1135,8 +1135,8 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     SSE2_UNPACK_32_BGRA_UNALIGNED
                 );
                 p_y += 16;
-                p_u += 4;
-                p_v += 4;
+                p_u += 8;
+                p_v += 8;
             }
             SCALE_WIDTH;
             SCALE_HEIGHT( 420, 4 );
@@ -1364,8 +1364,8 @@ void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     SSE2_UNPACK_32_ABGR_UNALIGNED
                 );
                 p_y += 16;
-                p_u += 4;
-                p_v += 4;
+                p_u += 8;
+                p_v += 8;
             }
             SCALE_WIDTH;
             SCALE_HEIGHT( 420, 4 );
@@ -32,18 +32,34 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#if defined(HAVE_SSE2_INTRINSICS) && defined(CAN_COMPILE_SSE4_1)
+# include <smmintrin.h>
+# define BLEND_SSE4_1
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
 static int  Open (vlc_object_t *);
+static int  OpenC(vlc_object_t *);
 static void Close(vlc_object_t *);
 
 vlc_module_begin()
     set_description(N_("Video pictures blending"))
     set_capability("video blending", 100)
     set_callbacks(Open, Close)
+
+    /* Generic code only, to check the vectorised code against */
+    add_submodule()
+    set_capability("video blending", 0)
+    add_shortcut("blend_c")
+    set_callbacks(OpenC, Close)
 vlc_module_end()
 
 static inline unsigned div255(unsigned v)
@@ -548,14 +564,339 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
     }
 }
 
+#if defined(BLEND_SSE4_1) || defined(HAVE_AVX2_INTRINSICS)
+/* Vectorised blending: the source is handled by chunks of planar YUVA lines,
+ * which the kernels blend onto whole destination lines at once */
+#define BLEND_CHUNK 256
+
+class CLinesYUVA : public CPicture {
+public:
+    CLinesYUVA(const CPicture &cfg) : CPicture(cfg)
+    {
+        for (unsigned i = 0; i < 4; i++)
+            data[i] = CPicture::getLine<1>(i);
+    }
+    template <class K>
+    void get(const uint8_t *line[4], uint8_t (*)[BLEND_CHUNK],
+             unsigned dx, unsigned)
+    {
+        for (unsigned i = 0; i < 4; i++)
+            line[i] = &data[i][x + dx];
+    }
+    void nextLine()
+    {
+        y++;
+        for (unsigned i = 0; i < 4; i++)
+            data[i] += picture->p[i].i_pitch;
+    }
+private:
+    uint8_t *data[4];
+};
+
+class CLinesRGBA : public CPicture {
+public:
+    CLinesRGBA(const CPicture &cfg) : CPicture(cfg)
+    {
+        data = CPicture::getLine<1>(0);
+    }
+    template <class K>
+    void get(const uint8_t *line[4], uint8_t (*buffer)[BLEND_CHUNK],
+             unsigned dx, unsigned count)
+    {
+        uint8_t *const yuva[4] = { buffer[0], buffer[1], buffer[2], buffer[3] };
+
+        K::ConvertRGBA(yuva, &data[(x + dx) * 4], count);
+        for (unsigned i = 0; i < 4; i++)
+            line[i] = buffer[i];
+    }
+    void nextLine()
+    {
+        y++;
+        data += picture->p[0].i_pitch;
+    }
+private:
+    uint8_t *data;
+};
+
+class CLinesYUVP : public CPicture {
+public:
+    CLinesYUVP(const CPicture &cfg) : CPicture(cfg)
+    {
+        data = CPicture::getLine<1>(0);
+    }
+    template <class K>
+    void get(const uint8_t *line[4], uint8_t (*buffer)[BLEND_CHUNK],
+             unsigned dx, unsigned count)
+    {
+        /* The palette entries are packed YUVA pixels */
+        const video_palette_t *palette = fmt->p_palette;
+        uint8_t *const yuva[4] = { buffer[0], buffer[1], buffer[2], buffer[3] };
+
+        for (unsigned i = 0; i < count; i++)
+            memcpy(&packed[4 * i], palette->palette[data[x + dx + i]], 4);
+        K::SplitYUVA(yuva, packed, count);
+        for (unsigned i = 0; i < 4; i++)
+            line[i] = buffer[i];
+    }
+    void nextLine()
+    {
+        y++;
+        data += picture->p[0].i_pitch;
+    }
+private:
+    uint8_t *data;
+    uint8_t packed[4 * BLEND_CHUNK];
+};
+
+template <bool swap_uv>
+class CLinesI420 : public CPicture {
+public:
+    CLinesI420(const CPicture &cfg) : CPicture(cfg)
+    {
+        data[0] = CPicture::getLine<1>(0);
+        data[1] = CPicture::getLine<2>(swap_uv ? 2 : 1);
+        data[2] = CPicture::getLine<2>(swap_uv ? 1 : 2);
+    }
+    template <class K>
+    void merge(unsigned dx, const uint8_t *const line[4], unsigned alpha,
+               unsigned count)
+    {
+        K::BlendLine(&data[0][x + dx], line[0], line[3], alpha, count);
+
+        /* Chroma is blended from the pixels at even positions only */
+        const unsigned phase = (x + dx) % 2;
+        if ((y % 2) != 0 || count <= phase)
+            return;
+        K::BlendLineUV(&data[1][(x + dx + phase) / 2],
+                       &data[2][(x + dx + phase) / 2],
+                       &line[1][phase], &line[2][phase], &line[3][phase],
+                       alpha, (count - phase + 1) / 2);
+    }
+    void nextLine()
+    {
+        y++;
+        data[0] += picture->p[0].i_pitch;
+        if ((y % 2) == 0) {
+            data[1] += picture->p[swap_uv ? 2 : 1].i_pitch;
+            data[2] += picture->p[swap_uv ? 1 : 2].i_pitch;
+        }
+    }
+private:
+    uint8_t *data[3];
+};
+
+template <bool swap_uv>
+class CLinesNV12 : public CPicture {
+public:
+    CLinesNV12(const CPicture &cfg) : CPicture(cfg)
+    {
+        data[0] = CPicture::getLine<1>(0);
+        data[1] = CPicture::getLine<2>(1);
+    }
+    template <class K>
+    void merge(unsigned dx, const uint8_t *const line[4], unsigned alpha,
+               unsigned count)
+    {
+        K::BlendLine(&data[0][x + dx], line[0], line[3], alpha, count);
+
+        const unsigned phase = (x + dx) % 2;
+        if ((y % 2) != 0 || count <= phase)
+            return;
+        K::BlendLineNV(&data[1][x + dx + phase],
+                       &line[swap_uv ? 2 : 1][phase],
+                       &line[swap_uv ? 1 : 2][phase], &line[3][phase],
+                       alpha, (count - phase + 1) / 2);
+    }
+    void nextLine()
+    {
+        y++;
+        data[0] += picture->p[0].i_pitch;
+        if ((y % 2) == 0)
+            data[1] += picture->p[1].i_pitch;
+    }
+private:
+    uint8_t *data[2];
+};
+
+template <class K, class TDst, class TSrc>
+void BlendLines(const CPicture &dst_data, const CPicture &src_data,
+                unsigned width, unsigned height, int alpha)
+{
+    TSrc src(src_data);
+    TDst dst(dst_data);
+    uint8_t buffer[4][BLEND_CHUNK];
+
+    for (unsigned y = 0; y < height; y++) {
+        for (unsigned x = 0; x < width; x += BLEND_CHUNK) {
+            const unsigned count = __MIN(width - x, BLEND_CHUNK);
+            const uint8_t *line[4];
+
+            src.template get<K>(line, buffer, x, count);
+            dst.template merge<K>(x, line, alpha, count);
+        }
+        src.nextLine();
+        dst.nextLine();
+    }
+}
+
+class CLinesRGB32 : public CPicture {
+public:
+    CLinesRGB32(const CPicture &cfg) : CPicture(cfg)
+    {
+        data = CPicture::getLine<1>(0);
+    }
+    uint8_t *get(unsigned dx) const
+    {
+        return &data[(x + dx) * 4];
+    }
+    void nextLine()
+    {
+        y++;
+        data += picture->p[0].i_pitch;
+    }
+private:
+    uint8_t *data;
+};
+
+template <class K>
+void BlendRGB32(const CPicture &dst_data, const CPicture &src_data,
+                unsigned width, unsigned height, int alpha)
+{
+    const video_format_t *fmt = dst_data.getFormat();
+    const int shift[3] = {
+        fmt->i_lrshift, fmt->i_lgshift, fmt->i_lbshift
+    };
+    unsigned offset[3];
+    unsigned used = 0;
+
+    for (unsigned i = 0; i < 3; i++) {
+        if (shift[i] < 0 || shift[i] >= 32 || (shift[i] % 8) != 0) {
+            used = 0;
+            break;
+        }
+        offset[i] = shift[i] / 8;
+        used |= 1 << offset[i];
+    }
+    if (vlc_popcount(used) != 3) {
+        /* Components are not whole distinct bytes */
+        Blend<CPictureRGB32, CPictureRGBA, compose<convertNone, convertNone> >
+            (dst_data, src_data, width, height, alpha);
+        return;
+    }
+
+    CLinesRGB32 dst(dst_data);
+    CLinesRGB32 src(src_data);
+
+    for (unsigned y = 0; y < height; y++) {
+        K::BlendLineRGB32(dst.get(0), src.get(0), alpha, offset, width);
+        src.nextLine();
+        dst.nextLine();
+    }
+}
+#endif
+
+#ifdef BLEND_SSE4_1
+#define BLEND_ISA           BlendSSE4_1
+#define BLEND_TARGET        __attribute__ ((__target__ ("sse4.1")))
+#define BLEND_V             __m128i
+#define BLEND_BYTES         16
+#define BLEND_LOAD(p)       _mm_loadu_si128((const __m128i *)(p))
+#define BLEND_STORE(p,v)    _mm_storeu_si128((__m128i *)(p), (v))
+#define BLEND_LOADW(p)      _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(p)))
+#define BLEND_PACK(a,b)     _mm_packus_epi16((a), (b))
+#define BLEND_SET1(x)       _mm_set1_epi16(x)
+#define BLEND_ADD(a,b)      _mm_add_epi16((a), (b))
+#define BLEND_SUB(a,b)      _mm_sub_epi16((a), (b))
+#define BLEND_MUL(a,b)      _mm_mullo_epi16((a), (b))
+#define BLEND_SRL(v,n)      _mm_srli_epi16((v), (n))
+#define BLEND_SLL(v,n)      _mm_slli_epi16((v), (n))
+#define BLEND_AND(a,b)      _mm_and_si128((a), (b))
+#define BLEND_OR(a,b)       _mm_or_si128((a), (b))
+#define BLEND_SHUFFLE(v,m)  _mm_shuffle_epi8((v), (m))
+#define BLEND_BROADCAST(p)  _mm_loadu_si128((const __m128i *)(p))
+#define BLEND_UNPACKLO(v)   _mm_unpacklo_epi8((v), _mm_setzero_si128())
+#define BLEND_UNPACKHI(v)   _mm_unpackhi_epi8((v), _mm_setzero_si128())
+#define BLEND_PACKLANE(a,b) _mm_packus_epi16((a), (b))
+#include "blend_simd.h"
+#undef BLEND_ISA
+#undef BLEND_TARGET
+#undef BLEND_V
+#undef BLEND_BYTES
+#undef BLEND_LOAD
+#undef BLEND_STORE
+#undef BLEND_LOADW
+#undef BLEND_PACK
+#undef BLEND_SET1
+#undef BLEND_ADD
+#undef BLEND_SUB
+#undef BLEND_MUL
+#undef BLEND_SRL
+#undef BLEND_SLL
+#undef BLEND_AND
+#undef BLEND_OR
+#undef BLEND_SHUFFLE
+#undef BLEND_BROADCAST
+#undef BLEND_UNPACKLO
+#undef BLEND_UNPACKHI
+#undef BLEND_PACKLANE
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+#define BLEND_ISA           BlendAVX2
+#define BLEND_TARGET        __attribute__ ((__target__ ("avx2")))
+#define BLEND_V             __m256i
+#define BLEND_BYTES         32
+#define BLEND_LOAD(p)       _mm256_loadu_si256((const __m256i *)(p))
+#define BLEND_STORE(p,v)    _mm256_storeu_si256((__m256i *)(p), (v))
+#define BLEND_LOADW(p)      _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+#define BLEND_PACK(a,b)     _mm256_permute4x64_epi64(_mm256_packus_epi16((a), (b)), 0xd8)
+#define BLEND_SET1(x)       _mm256_set1_epi16(x)
+#define BLEND_ADD(a,b)      _mm256_add_epi16((a), (b))
+#define BLEND_SUB(a,b)      _mm256_sub_epi16((a), (b))
+#define BLEND_MUL(a,b)      _mm256_mullo_epi16((a), (b))
+#define BLEND_SRL(v,n)      _mm256_srli_epi16((v), (n))
+#define BLEND_SLL(v,n)      _mm256_slli_epi16((v), (n))
+#define BLEND_AND(a,b)      _mm256_and_si256((a), (b))
+#define BLEND_OR(a,b)       _mm256_or_si256((a), (b))
+#define BLEND_SHUFFLE(v,m)  _mm256_shuffle_epi8((v), (m))
+#define BLEND_BROADCAST(p)  _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(p)))
+#define BLEND_UNPACKLO(v)   _mm256_unpacklo_epi8((v), _mm256_setzero_si256())
+#define BLEND_UNPACKHI(v)   _mm256_unpackhi_epi8((v), _mm256_setzero_si256())
+#define BLEND_PACKLANE(a,b) _mm256_packus_epi16((a), (b))
+#include "blend_simd.h"
+#undef BLEND_ISA
+#undef BLEND_TARGET
+#undef BLEND_V
+#undef BLEND_BYTES
+#undef BLEND_LOAD
+#undef BLEND_STORE
+#undef BLEND_LOADW
+#undef BLEND_PACK
+#undef BLEND_SET1
+#undef BLEND_ADD
+#undef BLEND_SUB
+#undef BLEND_MUL
+#undef BLEND_SRL
+#undef BLEND_SLL
+#undef BLEND_AND
+#undef BLEND_OR
+#undef BLEND_SHUFFLE
+#undef BLEND_BROADCAST
+#undef BLEND_UNPACKLO
+#undef BLEND_UNPACKHI
+#undef BLEND_PACKLANE
+#endif
+
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
-static const struct {
+struct blend_entry {
     vlc_fourcc_t     dst;
     vlc_fourcc_t     src;
     blend_function_t blend;
-} blends[] = {
+};
+
+static const blend_entry blends[] = {
 #undef RGB
 #undef YUV
 #define RGB(csp, picture, cvt) \
@@ -625,6 +966,46 @@ static const struct {
 #undef YUV
 };
 
+#if defined(BLEND_SSE4_1) || defined(HAVE_AVX2_INTRINSICS)
+#define SIMD(csp, lines, isa) \
+    { csp, VLC_CODEC_YUVA, BlendLines<isa, lines, CLinesYUVA> }, \
+    { csp, VLC_CODEC_RGBA, BlendLines<isa, lines, CLinesRGBA> }, \
+    { csp, VLC_CODEC_YUVP, BlendLines<isa, lines, CLinesYUVP> }
+#define SIMD_BLENDS(isa) \
+    SIMD(VLC_CODEC_I420, CLinesI420<false>, isa), \
+    SIMD(VLC_CODEC_J420, CLinesI420<false>, isa), \
+    SIMD(VLC_CODEC_YV12, CLinesI420<true>,  isa), \
+    SIMD(VLC_CODEC_NV12, CLinesNV12<false>, isa), \
+    SIMD(VLC_CODEC_NV21, CLinesNV12<true>,  isa), \
+    { VLC_CODEC_RGB32, VLC_CODEC_RGBA, BlendRGB32<isa> }
+#endif
+
+#ifdef BLEND_SSE4_1
+static const blend_entry blends_sse4_1[] = {
+    SIMD_BLENDS(BlendSSE4_1),
+};
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+static const blend_entry blends_avx2[] = {
+    SIMD_BLENDS(BlendAVX2),
+};
+#endif
+#undef SIMD_BLENDS
+#undef SIMD
+
+template <size_t count>
+static blend_function_t FindBlend(const blend_entry (&table)[count],
+                                  vlc_fourcc_t dst, vlc_fourcc_t src)
+{
+    blend_function_t blend = NULL;
+
+    for (size_t i = 0; i < count; i++) {
+        if (table[i].src == src && table[i].dst == dst)
+            blend = table[i].blend;
+    }
+    return blend;
+}
+
 struct filter_sys_t {
     filter_sys_t() : blend(NULL)
     {
@@ -666,17 +1047,23 @@ static void Blend(filter_t *filter,
                width, height, alpha);
 }
 
-static int Open(vlc_object_t *object)
+static int Open(filter_t *filter, bool simd)
 {
-    filter_t *filter = (filter_t *)object;
     const vlc_fourcc_t src = filter->fmt_in.video.i_chroma;
     const vlc_fourcc_t dst = filter->fmt_out.video.i_chroma;
 
     filter_sys_t *sys = new filter_sys_t();
-    for (size_t i = 0; i < sizeof(blends) / sizeof(*blends); i++) {
-        if (blends[i].src == src && blends[i].dst == dst)
-            sys->blend = blends[i].blend;
-    }
+#ifdef HAVE_AVX2_INTRINSICS
+    if (simd && !sys->blend && vlc_CPU_AVX2())
+        sys->blend = FindBlend(blends_avx2, dst, src);
+#endif
+#ifdef BLEND_SSE4_1
+    if (simd && !sys->blend && vlc_CPU_SSE4_1())
+        sys->blend = FindBlend(blends_sse4_1, dst, src);
+#endif
+    VLC_UNUSED(simd);
+    if (!sys->blend)
+        sys->blend = FindBlend(blends, dst, src);
 
     if (!sys->blend) {
        msg_Err(filter, "no matching alpha blending routine (chroma: %4.4s -> %4.4s)",
@@ -690,6 +1077,16 @@ static int Open(vlc_object_t *object)
     return VLC_SUCCESS;
 }
 
+static int Open(vlc_object_t *object)
+{
+    return Open((filter_t *)object, true);
+}
+
+static int OpenC(vlc_object_t *object)
+{
+    return Open((filter_t *)object, false);
+}
+
 static void Close(vlc_object_t *object)
 {
     filter_t *filter = (filter_t *)object;
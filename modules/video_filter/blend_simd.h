@@ -0,0 +1,307 @@
+/*****************************************************************************
+ * blend_simd.h: vectorised alpha blending of picture lines
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included once per instruction set by blend.cpp, which defines:
+ *  BLEND_ISA       name of the resulting kernel structure
+ *  BLEND_TARGET    function attributes (target CPU)
+ *  BLEND_V         vector type, BLEND_BYTES bytes per vector
+ *  BLEND_LOADW     loads BLEND_BYTES/2 bytes as 16-bits words
+ *  BLEND_PACK      packs two vectors of words into bytes, in order
+ *  BLEND_LOAD, BLEND_STORE, BLEND_SET1 (words), BLEND_ADD, BLEND_SUB,
+ *  BLEND_MUL, BLEND_SRL, BLEND_SLL, BLEND_AND, BLEND_OR (16-bits lanes),
+ *  BLEND_SHUFFLE (bytes within 128-bits lanes), BLEND_BROADCAST (128-bits),
+ *  BLEND_UNPACKLO, BLEND_UNPACKHI (bytes to words within 128-bits lanes)
+ *  and BLEND_PACKLANE (the reverse of the unpacking).
+ * All the arithmetic fits in unsigned 16-bits words, so that the results are
+ * identical to the generic code. */
+
+#define BLEND_CAT_(a,b) a##b
+#define BLEND_CAT(a,b) BLEND_CAT_(a,b)
+#define BLEND_FN(name) BLEND_CAT(name, BLEND_ISA)
+#define BLEND_WORDS (BLEND_BYTES / 2)
+
+BLEND_TARGET
+static inline BLEND_V BLEND_FN(Div255)(BLEND_V v)
+{
+    return BLEND_SRL(BLEND_ADD(BLEND_ADD(v, BLEND_SRL(v, 8)), BLEND_SET1(1)), 8);
+}
+
+/* Computes div255(alpha * a) */
+BLEND_TARGET
+static inline BLEND_V BLEND_FN(Alpha)(BLEND_V a, BLEND_V alpha)
+{
+    return BLEND_FN(Div255)(BLEND_MUL(a, alpha));
+}
+
+/* Computes div255((255 - f) * dst + src * f) */
+BLEND_TARGET
+static inline BLEND_V BLEND_FN(Merge)(BLEND_V dst, BLEND_V src, BLEND_V f)
+{
+    return BLEND_FN(Div255)(BLEND_ADD(BLEND_MUL(dst, BLEND_SUB(BLEND_SET1(255), f)),
+                                      BLEND_MUL(src, f)));
+}
+
+/* Selects the even bytes of a vector as words */
+BLEND_TARGET
+static inline BLEND_V BLEND_FN(LoadEven)(const uint8_t *p)
+{
+    return BLEND_AND(BLEND_LOAD(p), BLEND_SET1(0xff));
+}
+
+/* Blends count pixels of a full resolution plane */
+BLEND_TARGET
+static void BLEND_FN(BlendLine)(uint8_t *dst, const uint8_t *src,
+                                const uint8_t *a, unsigned alpha,
+                                unsigned count)
+{
+    const BLEND_V valpha = BLEND_SET1(alpha);
+    unsigned i = 0;
+
+    for (; i + BLEND_BYTES <= count; i += BLEND_BYTES) {
+        BLEND_V r[2];
+        for (unsigned h = 0; h < 2; h++) {
+            const unsigned o = i + h * BLEND_WORDS;
+            const BLEND_V f = BLEND_FN(Alpha)(BLEND_LOADW(&a[o]), valpha);
+            r[h] = BLEND_FN(Merge)(BLEND_LOADW(&dst[o]), BLEND_LOADW(&src[o]), f);
+        }
+        BLEND_STORE(&dst[i], BLEND_PACK(r[0], r[1]));
+    }
+    for (; i < count; i++)
+        ::merge(&dst[i], src[i], div255(alpha * a[i]));
+}
+
+/* Blends count pixels of two planes subsampled horizontally by 2, using
+ * every other pixel of the source lines */
+BLEND_TARGET
+static void BLEND_FN(BlendLineUV)(uint8_t *dst_u, uint8_t *dst_v,
+                                  const uint8_t *src_u, const uint8_t *src_v,
+                                  const uint8_t *a, unsigned alpha,
+                                  unsigned count)
+{
+    const BLEND_V valpha = BLEND_SET1(alpha);
+    unsigned i = 0;
+
+    /* The last source pixel is 2 * (count - 1) */
+    for (; i + BLEND_BYTES < count; i += BLEND_BYTES) {
+        BLEND_V u[2], v[2];
+        for (unsigned h = 0; h < 2; h++) {
+            const unsigned o = i + h * BLEND_WORDS;
+            const BLEND_V f = BLEND_FN(Alpha)(BLEND_FN(LoadEven)(&a[2 * o]),
+                                              valpha);
+            u[h] = BLEND_FN(Merge)(BLEND_LOADW(&dst_u[o]),
+                                   BLEND_FN(LoadEven)(&src_u[2 * o]), f);
+            v[h] = BLEND_FN(Merge)(BLEND_LOADW(&dst_v[o]),
+                                   BLEND_FN(LoadEven)(&src_v[2 * o]), f);
+        }
+        BLEND_STORE(&dst_u[i], BLEND_PACK(u[0], u[1]));
+        BLEND_STORE(&dst_v[i], BLEND_PACK(v[0], v[1]));
+    }
+    for (; i < count; i++) {
+        const unsigned f = div255(alpha * a[2 * i]);
+        ::merge(&dst_u[i], src_u[2 * i], f);
+        ::merge(&dst_v[i], src_v[2 * i], f);
+    }
+}
+
+/* Same as BlendLineUV() for an interleaved chroma plane */
+BLEND_TARGET
+static void BLEND_FN(BlendLineNV)(uint8_t *dst_uv,
+                                  const uint8_t *src_u, const uint8_t *src_v,
+                                  const uint8_t *a, unsigned alpha,
+                                  unsigned count)
+{
+    const BLEND_V valpha = BLEND_SET1(alpha);
+    const BLEND_V mask = BLEND_SET1(0xff);
+    unsigned i = 0;
+
+    for (; i + BLEND_WORDS < count; i += BLEND_WORDS) {
+        const BLEND_V uv = BLEND_LOAD(&dst_uv[2 * i]);
+        const BLEND_V f = BLEND_FN(Alpha)(BLEND_FN(LoadEven)(&a[2 * i]), valpha);
+        const BLEND_V u = BLEND_FN(Merge)(BLEND_AND(uv, mask),
+                                          BLEND_FN(LoadEven)(&src_u[2 * i]), f);
+        const BLEND_V v = BLEND_FN(Merge)(BLEND_SRL(uv, 8),
+                                          BLEND_FN(LoadEven)(&src_v[2 * i]), f);
+        BLEND_STORE(&dst_uv[2 * i], BLEND_OR(u, BLEND_SLL(v, 8)));
+    }
+    for (; i < count; i++) {
+        const unsigned f = div255(alpha * a[2 * i]);
+        ::merge(&dst_uv[2 * i + 0], src_u[2 * i], f);
+        ::merge(&dst_uv[2 * i + 1], src_v[2 * i], f);
+    }
+}
+
+/* Blends count RGBA pixels onto 32-bits RGB pixels, the offsets giving the
+ * position of the R, G and B bytes of the destination */
+BLEND_TARGET
+static void BLEND_FN(BlendLineRGB32)(uint8_t *dst, const uint8_t *src,
+                                     unsigned alpha, const unsigned offset[3],
+                                     unsigned count)
+{
+    uint8_t color[16], opacity[16];
+
+    memset(color, 0x80, sizeof (color));
+    memset(opacity, 0x80, sizeof (opacity));
+    for (unsigned i = 0; i < 16; i += 4) {
+        for (unsigned c = 0; c < 3; c++) {
+            color[i + offset[c]] = i + c;
+            opacity[i + offset[c]] = i + 3;
+        }
+    }
+    /* The padding byte is merged with a null opacity, i.e. left intact */
+    const BLEND_V vcolor = BLEND_BROADCAST(color);
+    const BLEND_V vopacity = BLEND_BROADCAST(opacity);
+    const BLEND_V valpha = BLEND_SET1(alpha);
+    unsigned i = 0;
+
+    for (; i + BLEND_BYTES / 4 <= count; i += BLEND_BYTES / 4) {
+        const BLEND_V s = BLEND_LOAD(&src[4 * i]);
+        const BLEND_V d = BLEND_LOAD(&dst[4 * i]);
+        const BLEND_V c = BLEND_SHUFFLE(s, vcolor);
+        const BLEND_V a = BLEND_SHUFFLE(s, vopacity);
+        const BLEND_V lo = BLEND_FN(Merge)(BLEND_UNPACKLO(d), BLEND_UNPACKLO(c),
+                                           BLEND_FN(Alpha)(BLEND_UNPACKLO(a), valpha));
+        const BLEND_V hi = BLEND_FN(Merge)(BLEND_UNPACKHI(d), BLEND_UNPACKHI(c),
+                                           BLEND_FN(Alpha)(BLEND_UNPACKHI(a), valpha));
+        BLEND_STORE(&dst[4 * i], BLEND_PACKLANE(lo, hi));
+    }
+    for (; i < count; i++) {
+        const unsigned f = div255(alpha * src[4 * i + 3]);
+        for (unsigned c = 0; c < 3; c++)
+            ::merge(&dst[4 * i + offset[c]], src[4 * i + c], f);
+    }
+}
+
+/* Splits 8 pixels of 4 bytes into 8 bytes of the first and second
+ * components, and 8 bytes of the third and fourth ones */
+BLEND_TARGET
+static inline void BLEND_FN(LoadPlanar)(const uint8_t *src,
+                                        __m128i *c01, __m128i *c23)
+{
+    const __m128i planar = _mm_setr_epi8(0, 4,  8, 12, 1, 5,  9, 13,
+                                         2, 6, 10, 14, 3, 7, 11, 15);
+    const __m128i p0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&src[ 0]), planar);
+    const __m128i p1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&src[16]), planar);
+
+    *c01 = _mm_unpacklo_epi32(p0, p1);
+    *c23 = _mm_unpackhi_epi32(p0, p1);
+}
+
+/* Converts count RGBA pixels to planar YUVA (see rgb_to_yuv()) */
+BLEND_TARGET
+static void BLEND_FN(ConvertRGBA)(uint8_t *const yuva[4], const uint8_t *src,
+                                  unsigned count)
+{
+    unsigned i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i rg, ba;
+        BLEND_FN(LoadPlanar)(&src[4 * i], &rg, &ba);
+
+        const __m128i r = _mm_cvtepu8_epi16(rg);
+        const __m128i g = _mm_cvtepu8_epi16(_mm_srli_si128(rg, 8));
+        const __m128i b = _mm_cvtepu8_epi16(ba);
+        const __m128i round = _mm_set1_epi16(128);
+
+#define DOT(cr, cg, cb) \
+    _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(cr)), \
+                                _mm_mullo_epi16(g, _mm_set1_epi16(cg))), \
+                  _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(cb)), round))
+        /* The luma sum may exceed 32767 but is always positive */
+        const __m128i y = _mm_add_epi16(_mm_srli_epi16(DOT( 66, 129,  25), 8),
+                                        _mm_set1_epi16(16));
+        const __m128i u = _mm_add_epi16(_mm_srai_epi16(DOT(-38, -74, 112), 8),
+                                        round);
+        const __m128i v = _mm_add_epi16(_mm_srai_epi16(DOT(112, -94, -18), 8),
+                                        round);
+#undef DOT
+        const __m128i yu = _mm_packus_epi16(y, u);
+
+        _mm_storel_epi64((__m128i *)&yuva[0][i], yu);
+        _mm_storel_epi64((__m128i *)&yuva[1][i], _mm_srli_si128(yu, 8));
+        _mm_storel_epi64((__m128i *)&yuva[2][i], _mm_packus_epi16(v, v));
+        _mm_storel_epi64((__m128i *)&yuva[3][i], _mm_srli_si128(ba, 8));
+    }
+    for (; i < count; i++) {
+        rgb_to_yuv(&yuva[0][i], &yuva[1][i], &yuva[2][i],
+                   src[4 * i + 0], src[4 * i + 1], src[4 * i + 2]);
+        yuva[3][i] = src[4 * i + 3];
+    }
+}
+
+/* Splits count packed YUVA pixels into planes */
+BLEND_TARGET
+static void BLEND_FN(SplitYUVA)(uint8_t *const yuva[4], const uint8_t *src,
+                                unsigned count)
+{
+    unsigned i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i yu, va;
+        BLEND_FN(LoadPlanar)(&src[4 * i], &yu, &va);
+
+        _mm_storel_epi64((__m128i *)&yuva[0][i], yu);
+        _mm_storel_epi64((__m128i *)&yuva[1][i], _mm_srli_si128(yu, 8));
+        _mm_storel_epi64((__m128i *)&yuva[2][i], va);
+        _mm_storel_epi64((__m128i *)&yuva[3][i], _mm_srli_si128(va, 8));
+    }
+    for (; i < count; i++)
+        for (unsigned c = 0; c < 4; c++)
+            yuva[c][i] = src[4 * i + c];
+}
+
+struct BLEND_ISA {
+    static void BlendLine(uint8_t *dst, const uint8_t *src,
+                          const uint8_t *a, unsigned alpha, unsigned count)
+    {
+        BLEND_FN(BlendLine)(dst, src, a, alpha, count);
+    }
+    static void BlendLineUV(uint8_t *dst_u, uint8_t *dst_v,
+                            const uint8_t *src_u, const uint8_t *src_v,
+                            const uint8_t *a, unsigned alpha, unsigned count)
+    {
+        BLEND_FN(BlendLineUV)(dst_u, dst_v, src_u, src_v, a, alpha, count);
+    }
+    static void BlendLineNV(uint8_t *dst_uv,
+                            const uint8_t *src_u, const uint8_t *src_v,
+                            const uint8_t *a, unsigned alpha, unsigned count)
+    {
+        BLEND_FN(BlendLineNV)(dst_uv, src_u, src_v, a, alpha, count);
+    }
+    static void BlendLineRGB32(uint8_t *dst, const uint8_t *src, unsigned alpha,
+                               const unsigned offset[3], unsigned count)
+    {
+        BLEND_FN(BlendLineRGB32)(dst, src, alpha, offset, count);
+    }
+    static void ConvertRGBA(uint8_t *const yuva[4], const uint8_t *src,
+                            unsigned count)
+    {
+        BLEND_FN(ConvertRGBA)(yuva, src, count);
+    }
+    static void SplitYUVA(uint8_t *const yuva[4], const uint8_t *src,
+                          unsigned count)
+    {
+        BLEND_FN(SplitYUVA)(yuva, src, count);
+    }
+};
+
+#undef BLEND_WORDS
+#undef BLEND_FN
+#undef BLEND_CAT
+#undef BLEND_CAT_
@@ -37,6 +37,7 @@
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 #include <vlc_image.h>
+#include <vlc_rand.h>
 
 /*****************************************************************************
  * Local prototypes
@@ -56,18 +57,31 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define ALPHA_TEXT N_("Alpha of the blended image")
 #define ALPHA_LONGTEXT N_("Alpha with which the blend image is blended")
 
+#define CHECK_TEXT N_("Check the blending")
+#define CHECK_LONGTEXT N_("Compare the result of the blending with the " \
+                          "generic code, and the speed of both")
+
+#define WIDTH_TEXT N_("Width of the images")
+#define WIDTH_LONGTEXT N_("Width of the random images used when no image " \
+                          "file is given")
+
+#define HEIGHT_TEXT N_("Height of the images")
+#define HEIGHT_LONGTEXT N_("Height of the random images used when no image " \
+                           "file is given")
+
 #define BASE_IMAGE_TEXT N_("Image to be blended onto")
 #define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto")
 
 #define BASE_CHROMA_TEXT N_("Chroma for the base image")
-#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded in")
+#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded " \
+                                "in, or comma separated list of chromas")
 
 #define BLEND_IMAGE_TEXT N_("Image which will be blended")
 #define BLEND_IMAGE_LONGTEXT N_("The image blended onto the base image")
 
 #define BLEND_CHROMA_TEXT N_("Chroma for the blend image")
 #define BLEND_CHROMA_LONGTEXT N_("Chroma which the blend image will be loaded" \
-                                 " in")
+                                 " in, or comma separated list of chromas")
 
 #define CFG_PREFIX "blendbench-"
 
@@ -83,6 +97,11 @@ vlc_module_begin ()
               LOOPS_LONGTEXT, false )
     add_integer_with_range( CFG_PREFIX "alpha", 128, 0, 255, ALPHA_TEXT,
               ALPHA_LONGTEXT, false )
+    add_bool( CFG_PREFIX "check", false, CHECK_TEXT, CHECK_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "width", 1920, 2, 8192, WIDTH_TEXT,
+              WIDTH_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "height", 1080, 2, 8192, HEIGHT_TEXT,
+              HEIGHT_LONGTEXT, false )
 
     set_section( N_("Base image"), NULL )
     add_loadfile(CFG_PREFIX "base-image", NULL,
@@ -100,8 +119,8 @@ vlc_module_begin ()
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "loops", "alpha", "base-image", "base-chroma", "blend-image",
-    "blend-chroma", NULL
+    "loops", "alpha", "check", "width", "height", "base-image", "base-chroma",
+    "blend-image", "blend-chroma", NULL
 };
 
 /*****************************************************************************
@@ -110,13 +129,16 @@ static const char *const ppsz_filter_options[] = {
 typedef struct
 {
     bool b_done;
+    bool b_check;
     int i_loops, i_alpha;
+    unsigned i_width, i_height;
 
-    picture_t *p_base_image;
-    picture_t *p_blend_image;
+    char *psz_base_image;
+    char *psz_base_chroma;
+    char *psz_blend_image;
+    char *psz_blend_chroma;
 
-    vlc_fourcc_t i_base_chroma;
-    vlc_fourcc_t i_blend_chroma;
+    video_palette_t palette;
 } filter_sys_t;
 
 static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
@@ -146,6 +168,209 @@ static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
     return VLC_SUCCESS;
 }
 
+/* Creates an image filled with random pixels, when no file is given */
+static int blendbench_GetImage( filter_t *p_filter, picture_t **pp_pic,
+                                vlc_fourcc_t i_chroma, char *psz_file,
+                                const char *psz_name )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( psz_file != NULL && *psz_file != '\0' )
+        return blendbench_LoadImage( VLC_OBJECT(p_filter), pp_pic, i_chroma,
+                                     psz_file, psz_name );
+
+    video_format_t fmt;
+
+    video_format_Init( &fmt, i_chroma );
+    video_format_Setup( &fmt, i_chroma, p_sys->i_width, p_sys->i_height,
+                        p_sys->i_width, p_sys->i_height, 1, 1 );
+    if( i_chroma == VLC_CODEC_YUVP )
+        fmt.p_palette = &p_sys->palette;
+
+    *pp_pic = picture_NewFromFormat( &fmt );
+    if( *pp_pic == NULL )
+    {
+        msg_Err( p_filter, "Unable to create %s image in %4.4s", psz_name,
+                 (const char *)&i_chroma );
+        return VLC_EGENERIC;
+    }
+
+    for( int i = 0; i < (*pp_pic)->i_planes; i++ )
+        vlc_rand_bytes( (*pp_pic)->p[i].p_pixels,
+                        (*pp_pic)->p[i].i_pitch * (*pp_pic)->p[i].i_lines );
+    return VLC_SUCCESS;
+}
+
+static filter_t *blendbench_NewBlender( filter_t *p_filter,
+                                        const picture_t *p_base,
+                                        const picture_t *p_blend,
+                                        const char *psz_name )
+{
+    filter_t *p_blender = vlc_object_create( p_filter, sizeof(filter_t) );
+    if( !p_blender )
+        return NULL;
+
+    p_blender->fmt_out.video = p_base->format;
+    p_blender->fmt_in.video = p_blend->format;
+    p_blender->p_module = module_need( p_blender, "video blending", psz_name,
+                                       psz_name != NULL );
+    if( !p_blender->p_module )
+    {
+        vlc_object_release( p_blender );
+        return NULL;
+    }
+    return p_blender;
+}
+
+static void blendbench_DeleteBlender( filter_t *p_blender )
+{
+    module_unneed( p_blender, p_blender->p_module );
+    vlc_object_release( p_blender );
+}
+
+static mtime_t blendbench_Time( filter_t *p_filter, filter_t *p_blender,
+                                picture_t *p_base, picture_t *p_blend )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    mtime_t time = mdate();
+    for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
+    {
+        p_blender->pf_video_blend( p_blender, p_base, p_blend,
+                                   0, 0, p_sys->i_alpha );
+    }
+    return mdate() - time;
+}
+
+/* Blends onto a copy of the base image, at an even and an odd position */
+static picture_t *blendbench_Blend( filter_t *p_blender, picture_t *p_base,
+                                    picture_t *p_blend, int i_alpha )
+{
+    picture_t *p_pic = picture_NewFromFormat( &p_base->format );
+    if( p_pic == NULL )
+        return NULL;
+
+    picture_CopyPixels( p_pic, p_base );
+    p_blender->pf_video_blend( p_blender, p_pic, p_blend, 0, 0, i_alpha );
+    p_blender->pf_video_blend( p_blender, p_pic, p_blend, 3, 1, i_alpha );
+    return p_pic;
+}
+
+static void blendbench_Check( filter_t *p_filter, filter_t *p_blender,
+                              picture_t *p_base, picture_t *p_blend,
+                              mtime_t time )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const vlc_fourcc_t i_base_chroma = p_base->format.i_chroma;
+    const vlc_fourcc_t i_blend_chroma = p_blend->format.i_chroma;
+
+    filter_t *p_ref = blendbench_NewBlender( p_filter, p_base, p_blend,
+                                             "blend_c" );
+    if( !p_ref )
+    {
+        msg_Warn( p_filter, "No generic blending to check against" );
+        return;
+    }
+
+    picture_t *p_out = blendbench_Blend( p_blender, p_base, p_blend,
+                                         p_sys->i_alpha );
+    picture_t *p_ref_out = blendbench_Blend( p_ref, p_base, p_blend,
+                                             p_sys->i_alpha );
+    if( p_out == NULL || p_ref_out == NULL )
+        goto out;
+
+    for( int i = 0; i < p_out->i_planes; i++ )
+    {
+        const plane_t *p_plane = &p_out->p[i];
+        const plane_t *p_ref_plane = &p_ref_out->p[i];
+
+        for( int y = 0; y < p_plane->i_visible_lines; y++ )
+        {
+            if( memcmp( &p_plane->p_pixels[y * p_plane->i_pitch],
+                        &p_ref_plane->p_pixels[y * p_ref_plane->i_pitch],
+                        p_plane->i_visible_pitch ) )
+            {
+                msg_Err( p_filter, "%4.4s onto %4.4s differs from the "
+                         "generic blending (plane %d, line %d)",
+                         (const char *)&i_blend_chroma,
+                         (const char *)&i_base_chroma, i, y );
+                goto out;
+            }
+        }
+    }
+
+    mtime_t ref_time = blendbench_Time( p_filter, p_ref, p_base, p_blend );
+    msg_Info( p_filter, "%4.4s onto %4.4s matches the generic blending, "
+              "%f times as fast", (const char *)&i_blend_chroma,
+              (const char *)&i_base_chroma,
+              (float) ref_time / __MAX(time, 1) );
+out:
+    if( p_out != NULL )
+        picture_Release( p_out );
+    if( p_ref_out != NULL )
+        picture_Release( p_ref_out );
+    blendbench_DeleteBlender( p_ref );
+}
+
+static void blendbench_Run( filter_t *p_filter, vlc_fourcc_t i_base_chroma,
+                            vlc_fourcc_t i_blend_chroma )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    picture_t *p_base_image, *p_blend_image;
+
+    if( blendbench_GetImage( p_filter, &p_base_image, i_base_chroma,
+                             p_sys->psz_base_image, "Base" ) )
+        return;
+    if( blendbench_GetImage( p_filter, &p_blend_image, i_blend_chroma,
+                             p_sys->psz_blend_image, "Blend" ) )
+    {
+        picture_Release( p_base_image );
+        return;
+    }
+
+    filter_t *p_blender = blendbench_NewBlender( p_filter, p_base_image,
+                                                 p_blend_image, NULL );
+    if( !p_blender )
+    {
+        msg_Warn( p_filter, "No blending of %4.4s onto %4.4s",
+                  (const char *)&i_blend_chroma,
+                  (const char *)&i_base_chroma );
+        goto out;
+    }
+
+    mtime_t time = blendbench_Time( p_filter, p_blender,
+                                    p_base_image, p_blend_image );
+
+    msg_Info( p_filter, "Blended %d images (%4.4s onto %4.4s) in %f sec",
+              p_sys->i_loops, (const char *)&i_blend_chroma,
+              (const char *)&i_base_chroma, time / (float)CLOCK_FREQ );
+    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
+              (float) p_sys->i_loops / time * CLOCK_FREQ,
+              (float) p_sys->i_loops / time * CLOCK_FREQ *
+                  p_blend_image->p[Y_PLANE].i_visible_pitch *
+                  p_blend_image->p[Y_PLANE].i_visible_lines );
+
+    if( p_sys->b_check )
+        blendbench_Check( p_filter, p_blender, p_base_image, p_blend_image,
+                          time );
+
+    blendbench_DeleteBlender( p_blender );
+out:
+    picture_Release( p_base_image );
+    picture_Release( p_blend_image );
+}
+
+/* Parses the next chroma of a comma separated list */
+static vlc_fourcc_t blendbench_NextChroma( const char **ppsz_list )
+{
+    const char *psz = *ppsz_list;
+    size_t i_len = strcspn( psz, "," );
+
+    *ppsz_list = psz + i_len + (psz[i_len] == ',');
+    return i_len != 4 ? 0 :
+        VLC_FOURCC( psz[0], psz[1], psz[2], psz[3] );
+}
+
 /*****************************************************************************
  * Create: allocates video thread output method
  *****************************************************************************/
@@ -153,8 +378,6 @@ static int Create( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys;
-    char *psz_temp, *psz_cmd;
-    int i_ret;
 
     /* Allocate structure */
     p_filter->p_sys = malloc( sizeof( filter_sys_t ) );
@@ -175,39 +398,24 @@ static int Create( vlc_object_t *p_this )
                                                   CFG_PREFIX "loops" );
     p_sys->i_alpha = var_CreateGetIntegerCommand( p_filter,
                                                   CFG_PREFIX "alpha" );
-
-    psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
-    p_sys->i_base_chroma = !psz_temp || strlen( psz_temp ) != 4 ? 0 :
-        VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
-    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
-    i_ret = blendbench_LoadImage( p_this, &p_sys->p_base_image,
-                                  p_sys->i_base_chroma, psz_cmd, "Base" );
-    free( psz_temp );
-    free( psz_cmd );
-    if( i_ret != VLC_SUCCESS )
-    {
-        free( p_sys );
-        return i_ret;
-    }
-
-    psz_temp = var_CreateGetStringCommand( p_filter,
-                                           CFG_PREFIX "blend-chroma" );
-    p_sys->i_blend_chroma = !psz_temp || strlen( psz_temp ) != 4
-        ? 0 : VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
-    psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
-    i_ret = blendbench_LoadImage( p_this, &p_sys->p_blend_image, p_sys->i_blend_chroma,
-                                  psz_cmd, "Blend" );
-
-    free( psz_temp );
-    free( psz_cmd );
-
-    if( i_ret != VLC_SUCCESS )
-    {
-        picture_Release( p_sys->p_base_image );
-        free( p_sys );
-
-        return VLC_EGENERIC;
-    }
+    p_sys->b_check = var_CreateGetBool( p_filter, CFG_PREFIX "check" );
+    p_sys->i_width = var_CreateGetInteger( p_filter, CFG_PREFIX "width" );
+    p_sys->i_height = var_CreateGetInteger( p_filter, CFG_PREFIX "height" );
+
+    p_sys->psz_base_chroma =
+        var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
+    p_sys->psz_base_image =
+        var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
+    p_sys->psz_blend_chroma =
+        var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-chroma" );
+    p_sys->psz_blend_image =
+        var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
+
+    /* Palette of the random YUVP images, with every level of opacity */
+    p_sys->palette.i_entries = 256;
+    vlc_rand_bytes( p_sys->palette.palette, sizeof (p_sys->palette.palette) );
+    for( int i = 0; i < 256; i++ )
+        p_sys->palette.palette[i][3] = i;
 
     return VLC_SUCCESS;
 }
@@ -220,8 +428,11 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    picture_Release( p_sys->p_base_image );
-    picture_Release( p_sys->p_blend_image );
+    free( p_sys->psz_base_chroma );
+    free( p_sys->psz_base_image );
+    free( p_sys->psz_blend_chroma );
+    free( p_sys->psz_blend_image );
+    free( p_sys );
 }
 
 /*****************************************************************************
@@ -230,47 +441,25 @@ static void Destroy( vlc_object_t *p_this )
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    filter_t *p_blend;
 
     if( p_sys->b_done )
         return p_pic;
 
-    p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
-    if( !p_blend )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-    p_blend->fmt_out.video = p_sys->p_base_image->format;
-    p_blend->fmt_in.video = p_sys->p_blend_image->format;
-    p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
-    if( !p_blend->p_module )
+    /* Every blend chroma onto every base chroma */
+    const char *psz_base = p_sys->psz_base_chroma ? p_sys->psz_base_chroma : "";
+    while( *psz_base != '\0' )
     {
-        picture_Release( p_pic );
-        vlc_object_release( p_blend );
-        return NULL;
-    }
-
-    mtime_t time = mdate();
-    for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
-    {
-        p_blend->pf_video_blend( p_blend,
-                                 p_sys->p_base_image, p_sys->p_blend_image,
-                                 0, 0, p_sys->i_alpha );
-    }
-    time = mdate() - time;
-
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              time / (float)CLOCK_FREQ );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
-              (float) p_sys->i_loops / time * CLOCK_FREQ,
-              (float) p_sys->i_loops / time * CLOCK_FREQ *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+        vlc_fourcc_t i_base_chroma = blendbench_NextChroma( &psz_base );
+        const char *psz_blend = p_sys->psz_blend_chroma ? p_sys->psz_blend_chroma : "";
 
-    module_unneed( p_blend, p_blend->p_module );
+        while( *psz_blend != '\0' )
+        {
+            vlc_fourcc_t i_blend_chroma = blendbench_NextChroma( &psz_blend );
 
-    vlc_object_release( p_blend );
+            if( i_base_chroma != 0 && i_blend_chroma != 0 )
+                blendbench_Run( p_filter, i_base_chroma, i_blend_chroma );
+        }
+    }
 
     p_sys->b_done = true;
     return p_pic;
@@ -39,6 +39,10 @@
 
 #include "algo_yadif.h"
 
+#ifdef CAN_COMPILE_MMX
+#   include "mmx.h"
+#endif
+
 /*****************************************************************************
  * Yadif (Yet Another DeInterlacing Filter).
  *****************************************************************************/
@@ -47,6 +51,91 @@
    Necessary preprocessor macros are defined in common.h. */
 #include "yadif.h"
 
+typedef void (*yadif_filter_line_t)(uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                                    uint8_t *next, int w, int prefs, int mrefs,
+                                    int parity, int mode);
+
+struct yadif_slice
+{
+    picture_t *p_dst;
+    picture_t *p_prev;
+    picture_t *p_cur;
+    picture_t *p_next;
+    yadif_filter_line_t filter;
+    unsigned i_pixel_size;
+    int i_field;
+    int i_parity;
+};
+
+/* Renders the lines of all planes matching the lines [i_first, i_last) of
+ * the first plane */
+static void RenderYadifSlice( filter_t *p_filter, void *opaque,
+                              unsigned i_first, unsigned i_last )
+{
+    const struct yadif_slice *p_slice = opaque;
+    picture_t *p_dst = p_slice->p_dst;
+    const yadif_filter_line_t filter = p_slice->filter;
+    const int i_field = p_slice->i_field;
+    const int yadif_parity = p_slice->i_parity;
+    const unsigned i_lines = p_dst->p[0].i_visible_lines;
+    VLC_UNUSED(p_filter);
+
+    for( int n = 0; n < p_dst->i_planes; n++ )
+    {
+        const plane_t *prevp = &p_slice->p_prev->p[n];
+        const plane_t *curp  = &p_slice->p_cur->p[n];
+        const plane_t *nextp = &p_slice->p_next->p[n];
+        plane_t *dstp        = &p_dst->p[n];
+
+        /* Same mapping of the lines to the planes as filter_SlicePicture() */
+        int y_first = (uint64_t)i_first * dstp->i_visible_lines / i_lines;
+        int y_last  = (uint64_t)i_last  * dstp->i_visible_lines / i_lines;
+
+        for( int y = __MAX(y_first, 1);
+             y < __MIN(y_last, dstp->i_visible_lines - 1); y++ )
+        {
+            if( (y % 2) == i_field  ||  yadif_parity == 2 )
+            {
+                memcpy( &dstp->p_pixels[y * dstp->i_pitch],
+                            &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
+            }
+            else
+            {
+                int mode;
+                /* Spatial checks only when enough data */
+                mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
+
+                assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
+                filter( &dstp->p_pixels[y * dstp->i_pitch],
+                        &prevp->p_pixels[y * prevp->i_pitch],
+                        &curp->p_pixels[y * curp->i_pitch],
+                        &nextp->p_pixels[y * nextp->i_pitch],
+                        dstp->i_visible_pitch / p_slice->i_pixel_size,
+                        y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
+                        y  - 1  ?  -curp->i_pitch : curp->i_pitch,
+                        yadif_parity,
+                        mode );
+            }
+
+            /* We duplicate the first and last lines */
+            if( y == 1 )
+                memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
+                           &dstp->p_pixels[ y    * dstp->i_pitch],
+                           dstp->i_pitch);
+            else if( y == dstp->i_visible_lines - 2 )
+                memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
+                           &dstp->p_pixels[ y    * dstp->i_pitch],
+                           dstp->i_pitch);
+        }
+    }
+
+#if defined(HAVE_YADIF_MMX)
+    /* The bands may run on other threads than the caller */
+    if( filter == yadif_filter_line_mmx )
+        emms();
+#endif
+}
+
 int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src )
 {
     return RenderYadif( p_filter, p_dst, p_src, 0, 0 );
@@ -110,9 +199,23 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
     if( p_prev && p_cur && p_next )
     {
         /* */
-        void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
-                       int w, int prefs, int mrefs, int parity, int mode);
+        yadif_filter_line_t filter;
 
+        if( p_sys->chroma->pixel_size == 2 )
+        {
+#if defined(HAVE_YADIF_AVX2)
+            if( vlc_CPU_AVX2() )
+                filter = yadif_filter_line_avx2_16bit;
+            else
+#endif
+                filter = yadif_filter_line_c_16bit;
+        }
+        else
+#if defined(HAVE_YADIF_AVX2)
+        if( vlc_CPU_AVX2() )
+            filter = yadif_filter_line_avx2;
+        else
+#endif
 #if defined(HAVE_YADIF_SSSE3)
         if( vlc_CPU_SSSE3() )
             filter = yadif_filter_line_ssse3;
@@ -130,52 +233,21 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
 #endif
             filter = yadif_filter_line_c;
 
-        if( p_sys->chroma->pixel_size == 2 )
-            filter = yadif_filter_line_c_16bit;
+        struct yadif_slice slice = {
+            .p_dst = p_dst,
+            .p_prev = p_prev,
+            .p_cur = p_cur,
+            .p_next = p_next,
+            .filter = filter,
+            .i_pixel_size = p_sys->chroma->pixel_size,
+            .i_field = i_field,
+            .i_parity = yadif_parity,
+        };
 
-        for( int n = 0; n < p_dst->i_planes; n++ )
-        {
-            const plane_t *prevp = &p_prev->p[n];
-            const plane_t *curp  = &p_cur->p[n];
-            const plane_t *nextp = &p_next->p[n];
-            plane_t *dstp        = &p_dst->p[n];
-
-            for( int y = 1; y < dstp->i_visible_lines - 1; y++ )
-            {
-                if( (y % 2) == i_field  ||  yadif_parity == 2 )
-                {
-                    memcpy( &dstp->p_pixels[y * dstp->i_pitch],
-                                &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
-                }
-                else
-                {
-                    int mode;
-                    /* Spatial checks only when enough data */
-                    mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
-
-                    assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
-                    filter( &dstp->p_pixels[y * dstp->i_pitch],
-                            &prevp->p_pixels[y * prevp->i_pitch],
-                            &curp->p_pixels[y * curp->i_pitch],
-                            &nextp->p_pixels[y * nextp->i_pitch],
-                            dstp->i_visible_pitch,
-                            y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
-                            y  - 1  ?  -curp->i_pitch : curp->i_pitch,
-                            yadif_parity,
-                            mode );
-                }
-
-                /* We duplicate the first and last lines */
-                if( y == 1 )
-                    memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-                else if( y == dstp->i_visible_lines - 2 )
-                    memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-            }
-        }
+        /* The lines only depend on the input pictures: render them in bands
+         * on the filter threads */
+        filter_RunSlices( p_filter, p_dst->p[0].i_visible_lines,
+                          RenderYadifSlice, &slice );
 
         p_sys->context.i_frame_offset = 1; /* p_cur will be rendered at next frame, too */
 
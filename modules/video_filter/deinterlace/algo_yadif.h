@@ -65,6 +65,9 @@ struct picture_t;
  * Note that the generated "repeated" output picture is unique because
  * of temporal interpolation.
  *
+ * The lines are interpolated in bands on the filter threads, see
+ * filter_RunSlices().
+ *
  * As many output frames should be requested for each input frame as is
  * indicated by p_src->i_nb_fields. This is done by calling this function
  * several times, first with i_order = 0, and then with all other parameters
@@ -151,3 +151,64 @@ static void yadif_filter_line_c_16bit(uint8_t *dst8, uint8_t *prev8, uint8_t *cu
     prefs /= 2;
     FILTER
 }
+
+#ifdef HAVE_AVX2_INTRINSICS
+// ================ AVX2 =================
+#include <immintrin.h>
+#define HAVE_YADIF_AVX2
+#define YADIF_ADD(a,b)      YADIF_LANE(add)((a), (b))
+#define YADIF_SUB(a,b)      YADIF_LANE(sub)((a), (b))
+#define YADIF_ABS(a)        YADIF_LANE(abs)(a)
+#define YADIF_MIN(a,b)      YADIF_LANE(min)((a), (b))
+#define YADIF_MAX(a,b)      YADIF_LANE(max)((a), (b))
+#define YADIF_CMPGT(a,b)    YADIF_LANE(cmpgt)((a), (b))
+#define YADIF_SET1(x)       YADIF_LANE(set1)(x)
+
+/* 8 bits pixels in 16 bits lanes */
+#define YADIF_FN(a)         yadif_ ## a ## _avx2
+#define YADIF_C             yadif_filter_line_c
+#define YADIF_PIXEL         uint8_t
+#define YADIF_STEP          16
+#define YADIF_LANE(op)      _mm256_ ## op ## _epi16
+#define YADIF_SRL1(a)       _mm256_srli_epi16((a), 1)
+#define YADIF_LOAD(p)       _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+#define YADIF_STORE(p,v)    _mm_storeu_si128((__m128i *)(p), _mm256_castsi256_si128( \
+    _mm256_permute4x64_epi64(_mm256_packus_epi16((v), (v)), 0x08)))
+#include "yadif_avx2.h"
+#undef YADIF_FN
+#undef YADIF_C
+#undef YADIF_PIXEL
+#undef YADIF_STEP
+#undef YADIF_LANE
+#undef YADIF_SRL1
+#undef YADIF_LOAD
+#undef YADIF_STORE
+
+/* 16 bits pixels in 32 bits lanes */
+#define YADIF_FN(a)         yadif_ ## a ## _avx2_16bit
+#define YADIF_C             yadif_filter_line_c_16bit
+#define YADIF_PIXEL         uint16_t
+#define YADIF_STEP          8
+#define YADIF_LANE(op)      _mm256_ ## op ## _epi32
+#define YADIF_SRL1(a)       _mm256_srli_epi32((a), 1)
+#define YADIF_LOAD(p)       _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(p)))
+#define YADIF_STORE(p,v)    _mm_storeu_si128((__m128i *)(p), _mm256_castsi256_si128( \
+    _mm256_permute4x64_epi64(_mm256_packus_epi32((v), (v)), 0x08)))
+#include "yadif_avx2.h"
+#undef YADIF_FN
+#undef YADIF_C
+#undef YADIF_PIXEL
+#undef YADIF_STEP
+#undef YADIF_LANE
+#undef YADIF_SRL1
+#undef YADIF_LOAD
+#undef YADIF_STORE
+
+#undef YADIF_ADD
+#undef YADIF_SUB
+#undef YADIF_ABS
+#undef YADIF_MIN
+#undef YADIF_MAX
+#undef YADIF_CMPGT
+#undef YADIF_SET1
+#endif
@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * yadif_avx2.h: AVX2 Yadif line filter
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included once per pixel size by yadif.h, which defines:
+ *  YADIF_FN        name of the resulting line filter
+ *  YADIF_C         generic line filter, used for the last pixels
+ *  YADIF_PIXEL     pixel type, YADIF_STEP pixels per vector
+ *  YADIF_LOAD      loads YADIF_STEP pixels into lanes twice as wide
+ *  YADIF_STORE     stores the lanes back as pixels, with unsigned saturation
+ *  YADIF_SET1, YADIF_ADD, YADIF_SUB, YADIF_ABS, YADIF_MIN, YADIF_MAX,
+ *  YADIF_SRL1 and YADIF_CMPGT: signed operations on the lanes.
+ * The lanes are wide enough for all the intermediate values, so that the
+ * output is identical to the generic FILTER. */
+
+#define YADIF_ALL       _mm256_set1_epi8(-1)
+#define YADIF_BLEND(a,b,m) _mm256_blendv_epi8((a), (b), (m))
+
+/* Vector version of the CHECK() macro of the generic code: mask selects the
+ * lanes where the previous check improved the score. */
+__attribute__ ((__target__ ("avx2")))
+static inline __m256i YADIF_FN(check)(const YADIF_PIXEL *cur, int mrefs,
+                                      int prefs, int j, __m256i mask,
+                                      __m256i *spatial_score,
+                                      __m256i *spatial_pred)
+{
+    __m256i score =
+        YADIF_ADD(YADIF_ADD(
+            YADIF_ABS(YADIF_SUB(YADIF_LOAD(&cur[mrefs-1+j]),
+                                YADIF_LOAD(&cur[prefs-1-j]))),
+            YADIF_ABS(YADIF_SUB(YADIF_LOAD(&cur[mrefs  +j]),
+                                YADIF_LOAD(&cur[prefs  -j])))),
+            YADIF_ABS(YADIF_SUB(YADIF_LOAD(&cur[mrefs+1+j]),
+                                YADIF_LOAD(&cur[prefs+1-j]))));
+
+    mask = _mm256_and_si256(mask, YADIF_CMPGT(*spatial_score, score));
+    *spatial_score = YADIF_BLEND(*spatial_score, score, mask);
+    *spatial_pred = YADIF_BLEND(*spatial_pred,
+                                YADIF_SRL1(YADIF_ADD(YADIF_LOAD(&cur[mrefs+j]),
+                                                     YADIF_LOAD(&cur[prefs-j]))),
+                                mask);
+    return mask;
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void YADIF_FN(filter_line)(uint8_t *dst8, uint8_t *prev8,
+                                  uint8_t *cur8, uint8_t *next8, int w,
+                                  int prefs8, int mrefs8, int parity, int mode)
+{
+    YADIF_PIXEL *dst = (YADIF_PIXEL *)dst8;
+    YADIF_PIXEL *prev = (YADIF_PIXEL *)prev8;
+    YADIF_PIXEL *cur = (YADIF_PIXEL *)cur8;
+    YADIF_PIXEL *next = (YADIF_PIXEL *)next8;
+    YADIF_PIXEL *prev2 = parity ? prev : cur ;
+    YADIF_PIXEL *next2 = parity ? cur  : next;
+    const int mrefs = mrefs8 / (int)sizeof (YADIF_PIXEL);
+    const int prefs = prefs8 / (int)sizeof (YADIF_PIXEL);
+    int x;
+
+    for (x = 0; x + YADIF_STEP <= w; x += YADIF_STEP) {
+        __m256i c = YADIF_LOAD(&cur[x + mrefs]);
+        __m256i e = YADIF_LOAD(&cur[x + prefs]);
+        __m256i p2 = YADIF_LOAD(&prev2[x]);
+        __m256i n2 = YADIF_LOAD(&next2[x]);
+        __m256i d = YADIF_SRL1(YADIF_ADD(p2, n2));
+
+        __m256i temporal_diff0 = YADIF_ABS(YADIF_SUB(p2, n2));
+        __m256i temporal_diff1 = YADIF_SRL1(YADIF_ADD(
+            YADIF_ABS(YADIF_SUB(YADIF_LOAD(&prev[x + mrefs]), c)),
+            YADIF_ABS(YADIF_SUB(YADIF_LOAD(&prev[x + prefs]), e))));
+        __m256i temporal_diff2 = YADIF_SRL1(YADIF_ADD(
+            YADIF_ABS(YADIF_SUB(YADIF_LOAD(&next[x + mrefs]), c)),
+            YADIF_ABS(YADIF_SUB(YADIF_LOAD(&next[x + prefs]), e))));
+        __m256i diff = YADIF_MAX(YADIF_MAX(YADIF_SRL1(temporal_diff0),
+                                           temporal_diff1), temporal_diff2);
+
+        __m256i spatial_pred = YADIF_SRL1(YADIF_ADD(c, e));
+        __m256i spatial_score =
+            YADIF_SUB(YADIF_ADD(YADIF_ADD(
+                YADIF_ABS(YADIF_SUB(YADIF_LOAD(&cur[x + mrefs - 1]),
+                                    YADIF_LOAD(&cur[x + prefs - 1]))),
+                YADIF_ABS(YADIF_SUB(c, e))),
+                YADIF_ABS(YADIF_SUB(YADIF_LOAD(&cur[x + mrefs + 1]),
+                                    YADIF_LOAD(&cur[x + prefs + 1])))),
+                YADIF_SET1(1));
+
+        __m256i mask;
+        mask = YADIF_FN(check)(&cur[x], mrefs, prefs, -1, YADIF_ALL,
+                               &spatial_score, &spatial_pred);
+        YADIF_FN(check)(&cur[x], mrefs, prefs, -2, mask,
+                        &spatial_score, &spatial_pred);
+        mask = YADIF_FN(check)(&cur[x], mrefs, prefs, 1, YADIF_ALL,
+                               &spatial_score, &spatial_pred);
+        YADIF_FN(check)(&cur[x], mrefs, prefs, 2, mask,
+                        &spatial_score, &spatial_pred);
+
+        if (mode < 2) {
+            __m256i b = YADIF_SRL1(YADIF_ADD(YADIF_LOAD(&prev2[x + 2 * mrefs]),
+                                             YADIF_LOAD(&next2[x + 2 * mrefs])));
+            __m256i f = YADIF_SRL1(YADIF_ADD(YADIF_LOAD(&prev2[x + 2 * prefs]),
+                                             YADIF_LOAD(&next2[x + 2 * prefs])));
+            __m256i de = YADIF_SUB(d, e);
+            __m256i dc = YADIF_SUB(d, c);
+            __m256i bc = YADIF_SUB(b, c);
+            __m256i fe = YADIF_SUB(f, e);
+            __m256i max = YADIF_MAX(YADIF_MAX(de, dc), YADIF_MIN(bc, fe));
+            __m256i min = YADIF_MIN(YADIF_MIN(de, dc), YADIF_MAX(bc, fe));
+
+            diff = YADIF_MAX(YADIF_MAX(diff, min),
+                             YADIF_SUB(_mm256_setzero_si256(), max));
+        }
+
+        /* diff is never negative, so this is the clipping of FILTER */
+        spatial_pred = YADIF_MIN(spatial_pred, YADIF_ADD(d, diff));
+        spatial_pred = YADIF_MAX(spatial_pred, YADIF_SUB(d, diff));
+
+        YADIF_STORE(&dst[x], spatial_pred);
+    }
+
+    if (x < w)
+        YADIF_C((uint8_t *)&dst[x], (uint8_t *)&prev[x], (uint8_t *)&cur[x],
+                (uint8_t *)&next[x], w - x, prefs8, mrefs8, parity, mode);
+}
+
+#undef YADIF_ALL
+#undef YADIF_BLEND
@@ -169,11 +169,12 @@ static void Destroy( vlc_object_t *p_this )
         const unsigned data_sz = sizeof(data_t);                        \
         const int i_src_line_len = p_outpic->p[Y_PLANE].i_pitch / data_sz; \
         const int i_out_line_len = p_pic->p[Y_PLANE].i_pitch / data_sz; \
-        const int sigma = atomic_load(&p_sys->sigma);         \
                                                                         \
-        memcpy(p_out, p_src, i_visible_pitch);                          \
+        if( i_first == 0 )                                              \
+            memcpy(p_out, p_src, i_visible_pitch);                      \
                                                                         \
-        for( unsigned i = 1; i < i_visible_lines - 1; i++ )             \
+        for( unsigned i = __MAX(i_first, 1);                            \
+             i < __MIN(i_last, i_visible_lines - 1); i++ )              \
         {                                                               \
             p_out[i * i_out_line_len] = p_src[i * i_src_line_len];      \
                                                                         \
@@ -200,19 +201,49 @@ static void Destroy( vlc_object_t *p_this )
             p_out[i * i_out_line_len + i_visible_pitch / data_sz - 1] = \
                 p_src[i * i_src_line_len + i_visible_pitch / data_sz - 1];  \
         }                                                               \
-        memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],          \
-               &p_src[(i_visible_lines - 1) * i_src_line_len],          \
-               i_visible_pitch);                                        \
+        if( i_last == i_visible_lines )                                 \
+            memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],      \
+                   &p_src[(i_visible_lines - 1) * i_src_line_len],      \
+                   i_visible_pitch);                                    \
     } while (0)
 
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+struct sharpen_slice
 {
+    picture_t *p_pic;
     picture_t *p_outpic;
+    int sigma;
+};
+
+static void FilterSlice( filter_t *p_filter, void *opaque,
+                         unsigned i_first, unsigned i_last )
+{
+    const struct sharpen_slice *p_slice = opaque;
+    picture_t *p_pic = p_slice->p_pic;
+    picture_t *p_outpic = p_slice->p_outpic;
+    const int sigma = p_slice->sigma;
     const int v1 = -1;
     const int v2 = 3; /* 2^3 = 8 */
     const unsigned i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
     const unsigned i_visible_pitch = p_pic->p[Y_PLANE].i_visible_pitch;
 
+    if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
+        SHARPEN_FRAME(255, uint8_t);
+    else
+        SHARPEN_FRAME(1023, uint16_t);
+
+    picture_t in, out;
+
+    filter_SlicePicture( &in, p_pic, i_first, i_last, i_visible_lines );
+    filter_SlicePicture( &out, p_outpic, i_first, i_last, i_visible_lines );
+    plane_CopyPixels( &out.p[U_PLANE], &in.p[U_PLANE] );
+    plane_CopyPixels( &out.p[V_PLANE], &in.p[V_PLANE] );
+    VLC_UNUSED(p_filter);
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+
     p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
     {
@@ -221,14 +252,14 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     }
 
     filter_sys_t *p_sys = p_filter->p_sys;
-
-    if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
-        SHARPEN_FRAME(255, uint8_t);
-    else
-        SHARPEN_FRAME(1023, uint16_t);
-
-    plane_CopyPixels( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE] );
-    plane_CopyPixels( &p_outpic->p[V_PLANE], &p_pic->p[V_PLANE] );
+    struct sharpen_slice slice = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .sigma = atomic_load(&p_sys->sigma),
+    };
+
+    filter_RunSlices( p_filter, p_pic->p[Y_PLANE].i_visible_lines,
+                      FilterSlice, &slice );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
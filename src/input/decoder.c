@@ -95,6 +95,10 @@ struct decoder_owner
 
     /* fifo */
     block_fifo_t *p_fifo;
+    mtime_t      fifo_in_ts;  /* Time stamp of the last queued block */
+    mtime_t      fifo_out_ts; /* Time stamp of the last dequeued block */
+    unsigned     fifo_discontinuities; /* Queued discontinuous blocks */
+    bool         fifo_paced;  /* The producer waits on wait_fifo */
 
     /* Lock for communication with decoder thread */
     vlc_mutex_t lock;
@@ -153,6 +157,17 @@ struct decoder_owner
 
 #define VLC_TS_OLDEST  (VLC_TS_INVALID + 1)
 
+/* The producer is paced while the decoder FIFO holds more than that much data.
+ * The block count is only used if the FIFO duration is unknown. */
+#define DECODER_FIFO_PACE_DURATION  (CLOCK_FREQ/2)
+#define DECODER_FIFO_PACE_BYTES     (16*1024*1024)
+#define DECODER_FIFO_PACE_COUNT     10
+
+/* Without pacing, the FIFO is reset beyond that much data: the data is not
+ * consumed quickly enough. 400 MiB is ~ 50mb/s for 60s. */
+#define DECODER_FIFO_DROP_DURATION  (60*CLOCK_FREQ)
+#define DECODER_FIFO_DROP_BYTES     (400*1024*1024)
+
 static inline struct decoder_owner *dec_get_owner( decoder_t *p_dec )
 {
     return container_of( p_dec, struct decoder_owner, dec );
@@ -1528,6 +1543,51 @@ static void OutputChangeRate( decoder_t *p_dec, float rate )
     }
 }
 
+static void DecoderFifoUpdateTs( mtime_t *ts, const block_t *p_block )
+{
+    mtime_t date = p_block->i_dts != VLC_TS_INVALID ? p_block->i_dts
+                                                     : p_block->i_pts;
+    if( date != VLC_TS_INVALID )
+        *ts = date;
+}
+
+static void DecoderFifoReset( struct decoder_owner *p_owner )
+{
+    block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+    p_owner->fifo_in_ts = p_owner->fifo_out_ts = VLC_TS_INVALID;
+    p_owner->fifo_discontinuities = 0;
+}
+
+/**
+ * Gets the duration of the data in the decoder FIFO, or -1 if unknown.
+ * The FIFO must be locked.
+ */
+static mtime_t DecoderFifoDuration( const struct decoder_owner *p_owner )
+{
+    /* Time stamps cannot be compared across a discontinuity */
+    if( p_owner->fifo_discontinuities > 0
+     || p_owner->fifo_in_ts == VLC_TS_INVALID
+     || p_owner->fifo_out_ts == VLC_TS_INVALID
+     || p_owner->fifo_in_ts < p_owner->fifo_out_ts )
+        return -1;
+    return p_owner->fifo_in_ts - p_owner->fifo_out_ts;
+}
+
+static bool DecoderFifoIsFull( const struct decoder_owner *p_owner )
+{
+    size_t count = vlc_fifo_GetCount( p_owner->p_fifo );
+
+    if( count < 2 )
+        return false;
+    if( vlc_fifo_GetBytes( p_owner->p_fifo ) >= DECODER_FIFO_PACE_BYTES )
+        return true;
+
+    mtime_t duration = DecoderFifoDuration( p_owner );
+    if( duration >= 0 )
+        return duration >= DECODER_FIFO_PACE_DURATION;
+    return count >= DECODER_FIFO_PACE_COUNT;
+}
+
 /**
  * The decoding main loop
  *
@@ -1604,10 +1664,18 @@ static void *DecoderThread( void *p_data )
             continue;
         }
 
-        vlc_cond_signal( &p_owner->wait_fifo );
+        if( p_owner->fifo_paced )
+            vlc_cond_signal( &p_owner->wait_fifo );
         vlc_testcancel(); /* forced expedited cancellation in case of stop */
 
         block_t *p_block = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
+        if( p_block != NULL )
+        {
+            if( (p_block->i_flags & BLOCK_FLAG_DISCONTINUITY)
+             && p_owner->fifo_discontinuities > 0 )
+                p_owner->fifo_discontinuities--;
+            DecoderFifoUpdateTs( &p_owner->fifo_out_ts, p_block );
+        }
         if( p_block == NULL )
         {
             if( likely(!p_owner->b_draining) )
@@ -1742,6 +1810,9 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
         vlc_object_release( p_dec );
         return NULL;
     }
+    p_owner->fifo_in_ts = p_owner->fifo_out_ts = VLC_TS_INVALID;
+    p_owner->fifo_discontinuities = 0;
+    p_owner->fifo_paced = false;
 
     vlc_mutex_init( &p_owner->lock );
     vlc_cond_init( &p_owner->wait_request );
@@ -2083,14 +2154,12 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
     vlc_fifo_Lock( p_owner->p_fifo );
     if( !b_do_pace )
     {
-        /* FIXME: ideally we would check the time amount of data
-         * in the FIFO instead of its size. */
-        /* 400 MiB, i.e. ~ 50mb/s for 60s */
-        if( vlc_fifo_GetBytes( p_owner->p_fifo ) > 400*1024*1024 )
+        if( vlc_fifo_GetBytes( p_owner->p_fifo ) > DECODER_FIFO_DROP_BYTES
+         || DecoderFifoDuration( p_owner ) > DECODER_FIFO_DROP_DURATION )
         {
             msg_Warn( p_dec, "decoder/packetizer fifo full (data not "
                       "consumed quickly enough), resetting fifo!" );
-            block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+            DecoderFifoReset( p_owner );
             p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
         }
     }
@@ -2099,10 +2168,18 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
     {   /* The FIFO is not consumed when waiting, so pacing would deadlock VLC.
          * Locking is not necessary as b_waiting is only read, not written by
          * the decoder thread. */
-        while( vlc_fifo_GetCount( p_owner->p_fifo ) >= 10 )
+        while( DecoderFifoIsFull( p_owner ) )
+        {
+            /* The decoder thread only signals while the producer is paced */
+            p_owner->fifo_paced = true;
             vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->wait_fifo );
+        }
+        p_owner->fifo_paced = false;
     }
 
+    if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
+        p_owner->fifo_discontinuities++;
+    DecoderFifoUpdateTs( &p_owner->fifo_in_ts, p_block );
     vlc_fifo_QueueUnlocked( p_owner->p_fifo, p_block );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
@@ -2169,7 +2246,7 @@ void input_DecoderFlush( decoder_t *p_dec )
     vlc_fifo_Lock( p_owner->p_fifo );
 
     /* Empty the fifo */
-    block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+    DecoderFifoReset( p_owner );
 
     /* Don't need to wait for the DecoderThread to flush. Indeed, if called a
      * second time, this function will clear the FIFO again before anything was
@@ -37,6 +37,9 @@
 #endif
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef HAVE_MMAP
+#  include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -61,6 +64,9 @@
 #   define attribute_packed
 #endif
 
+/* Maximum number of commands indexed by a ring storage */
+#define TS_RING_CMD_MAX (30000 << 5)
+
 enum
 {
     C_ADD,
@@ -84,7 +90,7 @@ typedef struct attribute_packed
 {
     es_out_id_t *p_es;
     block_t *p_block;
-    int     i_offset;  /* We do not use file > INT_MAX */
+    int64_t i_offset;  /* -1 if the block was dropped from the ring */
 } ts_cmd_send_t;
 
 typedef struct attribute_packed
@@ -161,6 +167,17 @@ typedef struct attribute_packed
     } u;
 } ts_cmd_t;
 
+/* Block header stored in the ring, followed by the block data */
+typedef struct
+{
+    mtime_t  i_dts;
+    mtime_t  i_pts;
+    mtime_t  i_length;
+    size_t   i_buffer;
+    uint32_t i_flags;
+    unsigned i_nb_samples;
+} ts_block_header_t;
+
 typedef struct ts_storage_t ts_storage_t;
 struct ts_storage_t
 {
@@ -175,6 +192,16 @@ struct ts_storage_t
     FILE    *p_filew;   /* FILE handle for data writing */
     FILE    *p_filer;   /* FILE handle for data reading */
 
+    /* Ring mode: the data are stored in a single preallocated file of
+     * i_file_max bytes, mapped in memory. When it is full, the oldest unread
+     * blocks are overwritten. The commands are not indexed by date: they are
+     * only ever played in order, seeking is done by the input and flushes
+     * the storages. */
+    uint8_t *p_ring;
+    size_t  i_ring_w;   /* Write offset */
+    size_t  i_ring_used;/* Bytes used by unread blocks */
+    int     i_cmd_drop; /* Commands before this one have no data to drop */
+
     /* */
     int      i_cmd_r;
     int      i_cmd_w;
@@ -188,6 +215,7 @@ typedef struct
     input_thread_t *p_input;
     es_out_t       *p_out;
     int64_t        i_tmp_size_max;
+    int64_t        i_ring_size;
     const char     *psz_tmp_path;
 
     /* Lock for all following fields */
@@ -210,6 +238,7 @@ typedef struct
     /* */
     ts_storage_t   *p_storage_r;
     ts_storage_t   *p_storage_w;
+    ts_storage_t   *p_ring_spare;  /* Drained ring, waiting to be reused */
 
     mtime_t        i_cmd_delay;
 
@@ -218,6 +247,7 @@ typedef struct
 struct es_out_id_t
 {
     es_out_id_t *p_es;
+    bool        b_discontinuity; /* Blocks were dropped from the ring */
 };
 
 typedef struct
@@ -227,6 +257,7 @@ typedef struct
 
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
+    int64_t        i_ring_size;       /* Ring file size in byte, or 0 */
     char           *psz_tmp_path;     /* Path for temporary files */
 
     /* Lock for all following fields */
@@ -265,6 +296,11 @@ static int          TsChangeRate( ts_thread_t *, int i_src_rate, int i_rate );
 static void         *TsRun( void * );
 
 static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
+#ifdef HAVE_MMAP
+static ts_storage_t *TsStorageNewRing( const char *psz_path, int64_t i_size );
+static void         TsRingReset( ts_storage_t * );
+static void         TsRingReserveCmd( ts_storage_t * );
+#endif
 static void         TsStorageDelete( ts_storage_t * );
 static void         TsStoragePack( ts_storage_t *p_storage );
 static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
@@ -331,6 +367,18 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     msg_Dbg( p_input, "using timeshift granularity of %d MiB",
              (int)p_sys->i_tmp_size_max/(1024*1024) );
 
+    p_sys->i_ring_size = 0;
+#ifdef HAVE_MMAP
+    const int64_t i_ring_size = var_InheritInteger( p_input,
+                                                    "input-timeshift-ring" );
+    if( i_ring_size > 0 )
+    {
+        p_sys->i_ring_size = i_ring_size * 1024 * 1024;
+        msg_Dbg( p_input, "using a timeshift ring of %"PRId64" MiB",
+                 i_ring_size );
+    }
+#endif
+
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32) && !VLC_WINSTORE_APP
     if( p_sys->psz_tmp_path == NULL )
@@ -418,6 +466,7 @@ static es_out_id_t *Add( es_out_t *p_out, const es_format_t *p_fmt )
     es_out_id_t *p_es = malloc( sizeof( *p_es ) );
     if( !p_es )
         return NULL;
+    p_es->b_discontinuity = false;
 
     vlc_mutex_lock( &p_sys->lock );
 
@@ -767,6 +816,7 @@ static int TsStart( es_out_t *p_out )
         return VLC_EGENERIC;
 
     p_ts->i_tmp_size_max = p_sys->i_tmp_size_max;
+    p_ts->i_ring_size = p_sys->i_ring_size;
     p_ts->psz_tmp_path = p_sys->psz_tmp_path;
     p_ts->p_input = p_sys->p_input;
     p_ts->p_out = p_sys->p_out;
@@ -782,6 +832,7 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_cmd_delay = 0;
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
+    p_ts->p_ring_spare = NULL;
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts, VLC_THREAD_PRIORITY_INPUT ) )
@@ -826,6 +877,8 @@ static void TsStop( ts_thread_t *p_ts )
     assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
     if( p_ts->p_storage_r )
         TsStorageDelete( p_ts->p_storage_r );
+    if( p_ts->p_ring_spare )
+        TsStorageDelete( p_ts->p_ring_spare );
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
@@ -834,9 +887,37 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_lock( &p_ts->lock );
 
-    if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
+#ifdef HAVE_MMAP
+    if( p_ts->p_storage_w && p_ts->p_storage_w->p_ring != NULL )
+        TsRingReserveCmd( p_ts->p_storage_w );
+#endif
+
+    /* Go back to the ring as soon as it has been drained after a spill */
+    if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd )
+     || p_ts->p_ring_spare )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        ts_storage_t *p_storage = NULL;
+
+#ifdef HAVE_MMAP
+        if( p_ts->p_ring_spare )
+        {
+            p_storage = p_ts->p_ring_spare;
+            p_ts->p_ring_spare = NULL;
+        }
+        else if( p_ts->i_ring_size > 0 && !p_ts->p_storage_w )
+        {
+            p_storage = TsStorageNewRing( p_ts->psz_tmp_path,
+                                          p_ts->i_ring_size );
+            if( !p_storage )
+            {
+                msg_Warn( p_ts->p_input, "cannot create the timeshift ring, "
+                          "using temporary files" );
+                p_ts->i_ring_size = 0;
+            }
+        }
+#endif
+        if( !p_storage )
+            p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
 
         if( !p_storage )
         {
@@ -876,12 +957,21 @@ static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
 
     while( TsStorageIsEmpty( p_ts->p_storage_r ) )
     {
-        ts_storage_t *p_next = p_ts->p_storage_r->p_next;
+        ts_storage_t *p_drained = p_ts->p_storage_r;
+        ts_storage_t *p_next = p_drained->p_next;
         if( !p_next )
             break;
 
-        TsStorageDelete( p_ts->p_storage_r );
         p_ts->p_storage_r = p_next;
+#ifdef HAVE_MMAP
+        if( p_drained->p_ring != NULL && !b_flush )
+        {
+            TsRingReset( p_drained );
+            p_ts->p_ring_spare = p_drained;
+            continue;
+        }
+#endif
+        TsStorageDelete( p_drained );
     }
 
     return VLC_SUCCESS;
@@ -1121,6 +1211,7 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     /* */
     p_storage->i_file_max = i_tmp_size_max;
     p_storage->i_file_size = 0;
+    p_storage->p_ring = NULL;
 
     /* */
     p_storage->i_cmd_w = 0;
@@ -1141,6 +1232,237 @@ error:
     return NULL;
 }
 
+#ifdef HAVE_MMAP
+static ts_storage_t *TsStorageNewRing( const char *psz_tmp_path, int64_t i_size )
+{
+    if( (uint64_t)i_size > SIZE_MAX )
+        return NULL;
+
+    ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
+    if( unlikely(p_storage == NULL) )
+        return NULL;
+
+    char *psz_file;
+    int fd = GetTmpFile( &psz_file, psz_tmp_path );
+    if( fd == -1 )
+    {
+        free( p_storage );
+        return NULL;
+    }
+    vlc_unlink( psz_file );
+    free( psz_file );
+
+    /* The blocks must be allocated on the disk: writing to a hole of a
+     * sparse mapping fails with SIGBUS when the disk is full. */
+    void *p_map = MAP_FAILED;
+#ifdef HAVE_POSIX_FALLOCATE
+    if( posix_fallocate( fd, 0, i_size ) == 0 )
+        p_map = mmap( NULL, i_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0 );
+#endif
+    vlc_close( fd );
+    if( p_map == MAP_FAILED )
+    {
+        free( p_storage );
+        return NULL;
+    }
+
+    p_storage->p_next = NULL;
+    p_storage->p_filew = NULL;
+    p_storage->p_filer = NULL;
+    p_storage->i_file_max = i_size;
+    p_storage->i_file_size = 0;
+
+    p_storage->p_ring = p_map;
+    p_storage->i_ring_w = 0;
+    p_storage->i_ring_used = 0;
+    p_storage->i_cmd_drop = 0;
+
+    p_storage->i_cmd_w = 0;
+    p_storage->i_cmd_r = 0;
+    p_storage->i_cmd_max = 30000;
+    p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
+    if( !p_storage->p_cmd )
+    {
+        TsStorageDelete( p_storage );
+        return NULL;
+    }
+    return p_storage;
+}
+
+static void TsRingWrite( ts_storage_t *p_storage, size_t i_offset,
+                         const void *p_data, size_t i_size )
+{
+    size_t i_copy = __MIN( i_size, p_storage->i_file_max - i_offset );
+
+    memcpy( &p_storage->p_ring[i_offset], p_data, i_copy );
+    memcpy( p_storage->p_ring, (const uint8_t *)p_data + i_copy,
+            i_size - i_copy );
+}
+
+static void TsRingRead( ts_storage_t *p_storage, size_t i_offset,
+                        void *p_data, size_t i_size )
+{
+    size_t i_copy = __MIN( i_size, p_storage->i_file_max - i_offset );
+
+    memcpy( p_data, &p_storage->p_ring[i_offset], i_copy );
+    memcpy( (uint8_t *)p_data + i_copy, p_storage->p_ring, i_size - i_copy );
+}
+
+static void TsRingReset( ts_storage_t *p_storage )
+{
+    assert( p_storage->i_cmd_r >= p_storage->i_cmd_w );
+
+    p_storage->p_next = NULL;
+    p_storage->i_ring_w = 0;
+    p_storage->i_ring_used = 0;
+    p_storage->i_cmd_drop = 0;
+    p_storage->i_cmd_r = 0;
+    p_storage->i_cmd_w = 0;
+}
+
+/* Releases the ring space of the oldest unread block */
+static bool TsRingDropOldest( ts_storage_t *p_storage )
+{
+    int i = __MAX( p_storage->i_cmd_drop, p_storage->i_cmd_r );
+
+    for( ; i < p_storage->i_cmd_w; i++ )
+    {
+        ts_cmd_t *p_cmd = &p_storage->p_cmd[i];
+
+        if( p_cmd->i_type != C_SEND || p_cmd->u.send.i_offset < 0 )
+            continue;
+
+        ts_block_header_t hdr;
+        TsRingRead( p_storage, p_cmd->u.send.i_offset, &hdr, sizeof(hdr) );
+        p_storage->i_ring_used -= sizeof(hdr) + hdr.i_buffer;
+
+        p_cmd->u.send.i_offset = -1;
+        p_cmd->u.send.p_es->b_discontinuity = true;
+        p_storage->i_cmd_drop = i + 1;
+        return true;
+    }
+    p_storage->i_cmd_drop = i;
+    return false;
+}
+
+/* Makes room in the command index of a ring: the commands already read are
+ * reclaimed first, then the index grows up to TS_RING_CMD_MAX commands, and
+ * then the oldest blocks are overwritten and their commands removed. */
+static void TsRingReserveCmd( ts_storage_t *p_storage )
+{
+    if( p_storage->i_cmd_w < p_storage->i_cmd_max )
+        return;
+
+    if( p_storage->i_cmd_r < p_storage->i_cmd_max / 2
+     && p_storage->i_cmd_max < TS_RING_CMD_MAX )
+    {
+        ts_cmd_t *p_new = realloc( p_storage->p_cmd,
+                2 * p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) );
+        if( likely(p_new != NULL) )
+        {
+            p_storage->p_cmd = p_new;
+            p_storage->i_cmd_max *= 2;
+            return;
+        }
+    }
+
+    /* Free at least a quarter of the index */
+    int i_free = p_storage->i_cmd_r;
+    for( int i = p_storage->i_cmd_r; i < p_storage->i_cmd_w; i++ )
+    {
+        const ts_cmd_t *p_cmd = &p_storage->p_cmd[i];
+        if( p_cmd->i_type == C_SEND && p_cmd->u.send.i_offset < 0 )
+            i_free++;
+    }
+    while( i_free < p_storage->i_cmd_max / 4 && TsRingDropOldest( p_storage ) )
+        i_free++;
+
+    int i_cmd_w = 0;
+    for( int i = p_storage->i_cmd_r; i < p_storage->i_cmd_w; i++ )
+    {
+        const ts_cmd_t *p_cmd = &p_storage->p_cmd[i];
+        if( p_cmd->i_type == C_SEND && p_cmd->u.send.i_offset < 0 )
+            continue;
+        p_storage->p_cmd[i_cmd_w++] = *p_cmd;
+    }
+    p_storage->i_cmd_r = 0;
+    p_storage->i_cmd_w = i_cmd_w;
+    p_storage->i_cmd_drop = 0;
+}
+
+static void TsRingPushBlock( ts_storage_t *p_storage, ts_cmd_t *p_cmd )
+{
+    block_t *p_block = p_cmd->u.send.p_block;
+    const ts_block_header_t hdr = {
+        .i_dts = p_block->i_dts,
+        .i_pts = p_block->i_pts,
+        .i_length = p_block->i_length,
+        .i_buffer = p_block->i_buffer,
+        .i_flags = p_block->i_flags,
+        .i_nb_samples = p_block->i_nb_samples,
+    };
+    const size_t i_size = sizeof(hdr) + p_block->i_buffer;
+
+    p_cmd->u.send.p_block = NULL;
+    p_cmd->u.send.i_offset = -1;
+
+    if( i_size <= p_storage->i_file_max )
+    {
+        /* Overwrite the oldest blocks if needed */
+        while( p_storage->i_ring_used + i_size > p_storage->i_file_max
+            && TsRingDropOldest( p_storage ) );
+
+        p_cmd->u.send.i_offset = p_storage->i_ring_w;
+        TsRingWrite( p_storage, p_storage->i_ring_w, &hdr, sizeof(hdr) );
+        TsRingWrite( p_storage,
+                     (p_storage->i_ring_w + sizeof(hdr)) % p_storage->i_file_max,
+                     p_block->p_buffer, p_block->i_buffer );
+        p_storage->i_ring_w = (p_storage->i_ring_w + i_size)
+                            % p_storage->i_file_max;
+        p_storage->i_ring_used += i_size;
+    }
+    else
+        p_cmd->u.send.p_es->b_discontinuity = true;
+
+    block_Release( p_block );
+}
+
+static block_t *TsRingPopBlock( ts_storage_t *p_storage, ts_cmd_t *p_cmd,
+                                bool b_flush )
+{
+    if( p_cmd->u.send.i_offset < 0 )
+        return NULL; /* dropped */
+
+    ts_block_header_t hdr;
+    size_t i_offset = p_cmd->u.send.i_offset;
+
+    TsRingRead( p_storage, i_offset, &hdr, sizeof(hdr) );
+    p_storage->i_ring_used -= sizeof(hdr) + hdr.i_buffer;
+    if( b_flush )
+        return NULL;
+
+    block_t *p_block = block_Alloc( hdr.i_buffer );
+    if( unlikely(p_block == NULL) )
+        return NULL;
+
+    p_block->i_dts        = hdr.i_dts;
+    p_block->i_pts        = hdr.i_pts;
+    p_block->i_length     = hdr.i_length;
+    p_block->i_flags      = hdr.i_flags;
+    p_block->i_nb_samples = hdr.i_nb_samples;
+    TsRingRead( p_storage, (i_offset + sizeof(hdr)) % p_storage->i_file_max,
+                p_block->p_buffer, hdr.i_buffer );
+
+    es_out_id_t *p_es = p_cmd->u.send.p_es;
+    if( p_es->b_discontinuity )
+    {
+        p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+        p_es->b_discontinuity = false;
+    }
+    return p_block;
+}
+#endif
+
 static void TsStorageDelete( ts_storage_t *p_storage )
 {
     while( p_storage->i_cmd_r < p_storage->i_cmd_w )
@@ -1153,6 +1475,14 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     }
     free( p_storage->p_cmd );
 
+#ifdef HAVE_MMAP
+    if( p_storage->p_ring != NULL )
+    {
+        munmap( p_storage->p_ring, p_storage->i_file_max );
+        free( p_storage );
+        return;
+    }
+#endif
     fclose( p_storage->p_filer );
     fclose( p_storage->p_filew );
 #ifdef _WIN32
@@ -1165,7 +1495,7 @@ static void TsStorageDelete( ts_storage_t *p_storage )
 static void TsStoragePack( ts_storage_t *p_storage )
 {
     /* Try to release a bit of memory */
-    if( p_storage->i_cmd_w >= p_storage->i_cmd_max )
+    if( p_storage->p_ring != NULL || p_storage->i_cmd_w >= p_storage->i_cmd_max )
         return;
 
     p_storage->i_cmd_max = __MAX( p_storage->i_cmd_w, 1 );
@@ -1176,6 +1506,13 @@ static void TsStoragePack( ts_storage_t *p_storage )
 }
 static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
+    if( p_storage->p_ring != NULL )
+    {
+        /* Only full if TsRingReserveCmd() found nothing to overwrite (no
+         * blocks, only other commands): spill them to a new storage */
+        return p_storage->i_cmd_w >= p_storage->i_cmd_max;
+    }
+
     if( p_cmd && p_cmd->i_type == C_SEND && p_storage->i_cmd_w > 0 )
     {
         size_t i_size = sizeof(*p_cmd->u.send.p_block) + p_cmd->u.send.p_block->i_buffer;
@@ -1195,6 +1532,16 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
 
     assert( !TsStorageIsFull( p_storage, p_cmd ) );
 
+#ifdef HAVE_MMAP
+    if( p_storage->p_ring != NULL )
+    {
+        if( cmd.i_type == C_SEND )
+            TsRingPushBlock( p_storage, &cmd );
+        p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
+        return;
+    }
+#endif
+
     if( cmd.i_type == C_SEND )
     {
         block_t *p_block = cmd.u.send.p_block;
@@ -1229,6 +1576,14 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
     assert( !TsStorageIsEmpty( p_storage ) );
 
     *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
+#ifdef HAVE_MMAP
+    if( p_storage->p_ring != NULL )
+    {
+        if( p_cmd->i_type == C_SEND )
+            p_cmd->u.send.p_block = TsRingPopBlock( p_storage, p_cmd, b_flush );
+        return;
+    }
+#endif
     if( p_cmd->i_type == C_SEND )
     {
         block_t block;
@@ -30,6 +30,7 @@
 
 #include <vlc_common.h>
 #include "input/input_internal.h"
+#include "../libvlc.h"
 
 /**
  * Create a statistics counter
@@ -111,6 +112,13 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                     memory_order_relaxed);
     st->i_lost_pictures = atomic_load_explicit(&stats->lost_pictures,
                                                memory_order_relaxed);
+
+    /* Block pool */
+    uintmax_t hits, misses;
+
+    vlc_block_pool_Stats(&hits, &misses);
+    st->i_block_pool_hits = hits;
+    st->i_block_pool_misses = misses;
 }
 
 /** Update a counter element with new values
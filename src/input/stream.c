@@ -704,9 +704,46 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
     return s->pf_control(s, cmd, args);
 }
 
+/**
+ * Takes the first bytes of a block without copying them.
+ * The remaining data, if any, is left in *pp.
+ */
+static block_t *vlc_stream_TakeBlock( block_t **restrict pp, size_t len )
+{
+    block_t *block = *pp;
+
+    assert( len > 0 && len <= block->i_buffer );
+
+    if( len == block->i_buffer )
+    {   /* Hand the whole block over, as if it was new */
+        *pp = NULL;
+        block->p_next = NULL;
+        block->i_flags = 0;
+        block->i_nb_samples = 0;
+        block->i_pts = block->i_dts = VLC_TS_INVALID;
+        block->i_length = 0;
+        return block;
+    }
+
+    block_t *head = block_Slice( pp, 0, len );
+    if( unlikely(head == NULL) )
+        return NULL;
+
+    /* Keep the blocks apart, in case their owners write to them */
+    block = *pp;
+    block->p_buffer += len;
+    block->i_buffer -= len;
+    block->i_size -= block->p_buffer - block->p_start;
+    block->p_start = block->p_buffer;
+    return head;
+}
+
 /**
  * Read data into a block.
  *
+ * If the stream back-end provides data blocks, and the requested data is
+ * within the current one, the returned block references it without copy.
+ *
  * @param s stream to read data from
  * @param size number of bytes to read
  * @return a block of data, or NULL on error
@@ -715,9 +752,38 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
  */
 block_t *vlc_stream_Block( stream_t *s, size_t size )
 {
+    stream_priv_t *priv = (stream_priv_t *)s;
+
     if( unlikely(size > SSIZE_MAX) )
         return NULL;
 
+    if( s->pf_read == NULL && s->pf_block != NULL && size > 0 )
+    {
+        if( priv->peek == NULL && priv->block == NULL && !vlc_killed() )
+        {
+            bool eof = false;
+
+            priv->block = s->pf_block( s, &eof );
+            if( priv->block == NULL && eof )
+            {
+                priv->eof = true;
+                return NULL;
+            }
+        }
+
+        block_t **pp = (priv->peek != NULL) ? &priv->peek : &priv->block;
+
+        if( *pp != NULL && (*pp)->i_buffer >= size )
+        {
+            block_t *block = vlc_stream_TakeBlock( pp, size );
+            if( likely(block != NULL) )
+            {
+                priv->offset += size;
+                return block;
+            }
+        }
+    }
+
     block_t *block = block_Alloc( size );
     if( unlikely(block == NULL) )
         return NULL;
@@ -733,6 +799,68 @@ block_t *vlc_stream_Block( stream_t *s, size_t size )
     return block;
 }
 
+block_t *vlc_stream_ReadChain( stream_t *s, size_t size )
+{
+    stream_priv_t *priv = (stream_priv_t *)s;
+    block_t *chain = NULL, **pp_last = &chain;
+
+    if( unlikely(size > SSIZE_MAX) )
+        return NULL;
+
+    while( size > 0 )
+    {
+        block_t **pp;
+
+        if( priv->peek != NULL )
+            pp = &priv->peek;
+        else if( s->pf_read == NULL && s->pf_block != NULL )
+        {
+            if( priv->block == NULL )
+            {
+                bool eof = false;
+
+                if( vlc_killed() )
+                    eof = true;
+                else
+                    priv->block = s->pf_block( s, &eof );
+
+                if( eof )
+                {
+                    priv->eof = true;
+                    break;
+                }
+                if( priv->block == NULL )
+                    continue;
+            }
+            pp = &priv->block;
+        }
+        else
+        {   /* No data blocks to reference: read the rest at once */
+            block_t *block = vlc_stream_Block( s, size );
+            if( block != NULL )
+                block_ChainLastAppend( &pp_last, block );
+            break;
+        }
+
+        if( (*pp)->i_buffer == 0 )
+        {
+            block_Release( *pp );
+            *pp = NULL;
+            continue;
+        }
+
+        block_t *block = vlc_stream_TakeBlock( pp, __MIN(size, (*pp)->i_buffer) );
+        if( unlikely(block == NULL) )
+            break;
+
+        priv->offset += block->i_buffer;
+        size -= block->i_buffer;
+        block_ChainLastAppend( &pp_last, block );
+    }
+
+    return chain;
+}
+
 int vlc_stream_ReadDir( stream_t *s, input_item_node_t *p_node )
 {
     assert(s->pf_readdir != NULL);
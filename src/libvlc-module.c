@@ -388,6 +388,11 @@ static const char *const ppsz_pos_descriptions[] =
     "picture quality, for instance deinterlacing, or distort " \
     "the video.")
 
+#define FILTER_THREADS_TEXT N_("Video filter threads")
+#define FILTER_THREADS_LONGTEXT N_( \
+    "Number of threads processing the bands of the pictures in the video " \
+    "filters supporting it (0 for one per processor, 1 to disable).")
+
 #define SNAP_PATH_TEXT N_("Video snapshot directory (or filename)")
 #define SNAP_PATH_LONGTEXT N_( \
     "Directory where the video snapshots will be stored.")
@@ -688,6 +693,13 @@ static const char *const ppsz_prefres[] = {
     "This is the maximum size in bytes of the temporary files " \
     "that will be used to store the timeshifted streams." )
 
+#define INPUT_TIMESHIFT_RING_TEXT N_("Timeshift ring size (MiB)")
+#define INPUT_TIMESHIFT_RING_LONGTEXT N_( \
+    "If non-zero, the timeshifted streams are stored in a single " \
+    "preallocated memory-mapped file of this size, and the oldest data " \
+    "are overwritten when it is full, instead of using growing temporary " \
+    "files." )
+
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
     "$a: Artist<br>$b: Album<br>$c: Copyright<br>$t: Title<br>$g: Genre<br>"  \
@@ -709,6 +721,12 @@ static const char *const ppsz_prefres[] = {
     "You can use this option to place the subtitles under the movie, " \
     "instead of over the movie. Try several positions.")
 
+#define SUB_CACHE_SIZE_TEXT N_("Subpictures render cache size (MiB)")
+#define SUB_CACHE_SIZE_LONGTEXT N_( \
+    "Rendered and scaled subpictures are kept in memory, up to this size, " \
+    "to be reused when the same subtitles are displayed again or when the " \
+    "video is resized. 0 disables the cache.")
+
 #define SUB_TEXT_SCALE_TEXT N_("Subtitles text scaling factor")
 #define SUB_TEXT_SCALE_LONGTEXT N_("Changes the subtitles size where possible")
 
@@ -830,6 +848,11 @@ static const char *const ppsz_prefres[] = {
     "However allocation of port numbers below 1025 is usually restricted " \
     "by the operating system." )
 
+#define HTTP_THREADS_TEXT N_( "HTTP server threads" )
+#define HTTP_THREADS_LONGTEXT N_( \
+    "Number of threads serving the clients of the HTTP, HTTPS and RTSP " \
+    "servers. 0 uses one thread per CPU." )
+
 #define RTSP_PORT_TEXT N_( "RTSP server port" )
 #define RTSP_PORT_LONGTEXT N_( \
     "The RTSP server will listen on this TCP port. " \
@@ -1097,6 +1120,12 @@ static const char *const ppsz_prefres[] = {
     "all the processor time and render the whole system unresponsive which " \
     "might require a reboot of your machine.")
 
+#define BLOCK_POOL_TEXT N_("Pool data blocks")
+#define BLOCK_POOL_LONGTEXT N_( \
+    "Recycle the data blocks of the most common sizes through per-thread " \
+    "caches instead of allocating each of them from the heap. This reduces " \
+    "allocator contention when processing many streams at once." )
+
 #define PLAYLISTENQUEUE_TEXT N_( \
     "Enqueue items into playlist in one instance mode")
 #define PLAYLISTENQUEUE_LONGTEXT N_( \
@@ -1125,6 +1154,15 @@ static const char *const ppsz_prefres[] = {
 #define PREPARSE_TIMEOUT_LONGTEXT N_( \
     "Maximum time allowed to preparse an item, in milliseconds" )
 
+#define PREPARSE_THREADS_TEXT N_( "Preparsing threads" )
+#define PREPARSE_THREADS_LONGTEXT N_( \
+    "Maximum number of items preparsed in parallel." )
+
+#define FETCH_ART_THREADS_TEXT N_( "Art fetching threads" )
+#define FETCH_ART_THREADS_LONGTEXT N_( \
+    "Maximum number of items whose art is fetched in parallel, " \
+    "for each stage of the fetching (local, network, download)." )
+
 #define METADATA_NETWORK_TEXT N_( "Allow metadata network access" )
 
 static const char *const psz_recursive_list[] = {
@@ -1664,6 +1702,8 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_VIDEO_VFILTER )
     add_module_list("video-filter", "video filter", NULL,
                     VIDEO_FILTER_TEXT, VIDEO_FILTER_LONGTEXT)
+    add_integer_with_range( "filter-threads", 0, 0, 64,
+                            FILTER_THREADS_TEXT, FILTER_THREADS_LONGTEXT, true )
 
     set_subcategory( SUBCAT_VIDEO_SPLITTER )
     add_module_list("video-splitter", "video splitter", NULL,
@@ -1700,6 +1740,8 @@ vlc_module_begin ()
                  SUB_PATH_TEXT, SUB_PATH_LONGTEXT, true )
     add_integer( "sub-margin", 0, SUB_MARGIN_TEXT,
                  SUB_MARGIN_LONGTEXT, true )
+    add_integer_with_range( "sub-cache-size", 32, 0, 1024,
+                 SUB_CACHE_SIZE_TEXT, SUB_CACHE_SIZE_LONGTEXT, true )
     add_integer_with_range( "sub-text-scale", 100, 10, 500,
                SUB_TEXT_SCALE_TEXT, SUB_TEXT_SCALE_LONGTEXT, false )
         change_volatile  ()
@@ -1801,6 +1843,9 @@ vlc_module_begin ()
         change_integer_range( 1, 65535 )
     add_integer( "https-port", 8443, HTTPS_PORT_TEXT, HTTPS_PORT_LONGTEXT, true )
         change_integer_range( 1, 65535 )
+    add_integer( "http-threads", 0, HTTP_THREADS_TEXT, HTTP_THREADS_LONGTEXT,
+                 true )
+        change_integer_range( 0, 64 )
     add_string( "rtsp-host", NULL, RTSP_HOST_TEXT, RTSP_HOST_LONGTEXT, true )
     add_integer( "rtsp-port", 554, RTSP_PORT_TEXT, RTSP_PORT_LONGTEXT, true )
         change_integer_range( 1, 65535 )
@@ -1927,6 +1972,9 @@ vlc_module_begin ()
                   INPUT_TIMESHIFT_PATH_TEXT, INPUT_TIMESHIFT_PATH_LONGTEXT)
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_integer( "input-timeshift-ring", 0, INPUT_TIMESHIFT_RING_TEXT,
+                 INPUT_TIMESHIFT_RING_LONGTEXT, true )
+        change_integer_range( 0, 65536 )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT, false );
 
@@ -2051,6 +2099,9 @@ vlc_module_begin ()
     add_obsolete_bool( "inhibit" ) /* since 3.0.0 */
 #endif
 
+    add_bool( "block-pool", false, BLOCK_POOL_TEXT,
+              BLOCK_POOL_LONGTEXT, true )
+
 #if defined(_WIN32) || defined(__OS2__)
     add_bool( "high-priority", 0, HPRIORITY_TEXT,
               HPRIORITY_LONGTEXT, false )
@@ -2109,6 +2160,12 @@ vlc_module_begin ()
 
     add_integer( "preparse-timeout", 5000, PREPARSE_TIMEOUT_TEXT,
                  PREPARSE_TIMEOUT_LONGTEXT, false )
+    add_integer_with_range( "preparse-threads", 1, 1, 64,
+                            PREPARSE_THREADS_TEXT, PREPARSE_THREADS_LONGTEXT,
+                            true )
+    add_integer_with_range( "fetch-art-threads", 1, 1, 64,
+                            FETCH_ART_THREADS_TEXT,
+                            FETCH_ART_THREADS_LONGTEXT, true )
 
     add_obsolete_integer( "album-art" )
     add_bool( "metadata-network-access", false, METADATA_NETWORK_TEXT,
@@ -93,6 +93,7 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv = libvlc_priv (p_libvlc);
     priv->playlist = NULL;
     priv->p_vlm = NULL;
+    priv->slices = NULL;
 
     vlc_ExitInit( &priv->exit );
 
@@ -309,6 +310,9 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
     free( psz_modules );
     free( psz_control );
 
+    if( var_InheritBool( p_libvlc, "block-pool" ) )
+        vlc_block_pool_Enable();
+
     if( var_InheritBool( p_libvlc, "network-synchronisation") )
         libvlc_InternalAddIntf( p_libvlc, "netsync,none" );
 
@@ -374,6 +378,11 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     }
 #endif
 
+    if( priv->slices != NULL )
+        vlc_slices_Delete( priv->slices );
+
+    vlc_block_pool_Reclaim();
+
 #if !defined( _WIN32 ) && !defined( __OS2__ )
     char *pidfile = var_InheritString( p_libvlc, "pidfile" );
     if( pidfile != NULL )
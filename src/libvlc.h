@@ -71,6 +71,31 @@ int vlc_LogPreinit(libvlc_int_t *);
 int vlc_LogInit(libvlc_int_t *);
 void vlc_LogDeinit(libvlc_int_t *);
 
+/*
+ * Data blocks
+ */
+
+/** Enables the pooled block allocator for the whole process. */
+void vlc_block_pool_Enable(void);
+/** Frees the blocks of the depot and of the cache of the calling thread. */
+void vlc_block_pool_Reclaim(void);
+/** Gets the number of block allocations served by the pool and the heap. */
+void vlc_block_pool_Stats(uintmax_t *hits, uintmax_t *misses);
+
+/*
+ * Slice threading
+ */
+struct vlc_slices;
+
+/** Creates a pool of threads processing the slices of jobs. */
+struct vlc_slices *vlc_slices_New(unsigned threads);
+void vlc_slices_Delete(struct vlc_slices *);
+/** Gets the number of threads processing a job, including the caller. */
+unsigned vlc_slices_Count(const struct vlc_slices *);
+/** Runs run(opaque, i) for i in [0, count), and waits for completion. */
+void vlc_slices_Run(struct vlc_slices *, unsigned count,
+                    void (*run)(void *, unsigned), void *opaque);
+
 /*
  * LibVLC exit event handling
  */
@@ -185,6 +210,7 @@ typedef struct libvlc_priv_t
     struct playlist_t *playlist; ///< Playlist for interfaces
     struct playlist_preparser_t *parser; ///< Input item meta data handler
     vlc_actions_t *actions; ///< Hotkeys handler
+    struct vlc_slices *slices; ///< Video filters threads (or NULL)
 
     /* Exit callback */
     vlc_exit_t       exit;
@@ -34,97 +34,110 @@ struct bg_queued_item {
     int timeout; /**< timeout duration in microseconds */
 };
 
+struct bg_task {
+    void* id; /**< id of the entity being processed */
+    mtime_t deadline; /**< deadline of the task */
+    bool probe_request; /**< true if a probe is requested */
+    bool cancel; /**< true if the task shall be stopped */
+};
+
 struct background_worker {
     void* owner;
     struct background_worker_config conf;
 
     vlc_mutex_t lock; /**< acquire to inspect members that follow */
     struct {
-        bool probe_request; /**< true if a probe is requested */
         vlc_cond_t wait; /**< wait for update in terms of head */
         vlc_cond_t worker_wait; /**< wait for probe request or cancelation */
-        mtime_t deadline; /**< deadline of the current task */
-        void* id; /**< id of the current task */
-        bool active; /**< true if there is an active thread */
+        vlc_array_t tasks; /**< tasks being processed */
+        unsigned threads; /**< number of threads */
+        unsigned idle; /**< number of threads waiting for an entity */
+        bool closing; /**< true if the threads shall terminate */
     } head;
 
     struct {
         vlc_cond_t wait; /**< wait for update in terms of tail */
-        vlc_array_t data; /**< queue of pending entities to process */
+        vlc_array_t data[2]; /**< queues of pending entities, by priority */
     } tail;
 };
 
+static struct bg_queued_item* QueuePop( struct background_worker* worker )
+{
+    for( size_t i = 0; i < ARRAY_SIZE( worker->tail.data ); ++i )
+    {
+        vlc_array_t* queue = &worker->tail.data[i];
+
+        if( vlc_array_count( queue ) )
+        {
+            struct bg_queued_item* item = vlc_array_item_at_index( queue, 0 );
+            vlc_array_remove( queue, 0 );
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static size_t QueueCount( struct background_worker* worker )
+{
+    size_t count = 0;
+
+    for( size_t i = 0; i < ARRAY_SIZE( worker->tail.data ); ++i )
+        count += vlc_array_count( &worker->tail.data[i] );
+    return count;
+}
+
 static void* Thread( void* data )
 {
     struct background_worker* worker = data;
 
+    vlc_mutex_lock( &worker->lock );
     for( ;; )
     {
         struct bg_queued_item* item = NULL;
+        struct bg_task task;
         void* handle;
 
-        vlc_mutex_lock( &worker->lock );
-        for( ;; )
+        while( !worker->head.closing
+            && ( item = QueuePop( worker ) ) == NULL )
         {
-            if( vlc_array_count( &worker->tail.data ) )
-            {
-                item = vlc_array_item_at_index( &worker->tail.data, 0 );
-                handle = NULL;
-
-                vlc_array_remove( &worker->tail.data, 0 );
-            }
-
-            if( worker->head.deadline == VLC_TS_INVALID && item == NULL )
-                worker->head.active = false;
-            worker->head.id = item ? item->id : NULL;
-            vlc_cond_broadcast( &worker->head.wait );
-
-            if( item )
-            {
-                if( item->timeout > 0 )
-                    worker->head.deadline = mdate() + item->timeout * 1000;
-                else
-                    worker->head.deadline = INT64_MAX;
-            }
-            else if( worker->head.deadline != VLC_TS_INVALID )
+            /* Wait 1 seconds for new inputs before terminating */
+            mtime_t deadline = mdate() + 1*CLOCK_FREQ;
+
+            worker->head.idle++;
+            int ret = vlc_cond_timedwait( &worker->tail.wait,
+                                          &worker->lock, deadline );
+            worker->head.idle--;
+            if( ret != 0 )
             {
-                /* Wait 1 seconds for new inputs before terminating */
-                mtime_t deadline = mdate() + 1*CLOCK_FREQ;
-                int ret = vlc_cond_timedwait( &worker->tail.wait,
-                                              &worker->lock, deadline );
-                if( ret != 0 )
-                {
-                    /* Timeout: if there is still no items, the thread will be
-                     * terminated at next loop iteration (active = false). */
-                    worker->head.deadline = VLC_TS_INVALID;
-                }
-                continue;
+                item = QueuePop( worker );
+                break;
             }
-            break;
         }
 
-        if( !worker->head.active )
-        {
-            vlc_mutex_unlock( &worker->lock );
+        if( item == NULL )
             break;
-        }
-        vlc_mutex_unlock( &worker->lock );
 
-        assert( item != NULL );
+        task.id = item->id;
+        task.probe_request = false;
+        task.cancel = false;
+        task.deadline = item->timeout > 0 ? mdate() + item->timeout * 1000
+                                          : INT64_MAX;
+        vlc_array_append_or_abort( &worker->head.tasks, &task );
+        vlc_mutex_unlock( &worker->lock );
 
         if( worker->conf.pf_start( worker->owner, item->entity, &handle ) )
         {
             worker->conf.pf_release( item->entity );
             free( item );
-            continue;
+            goto done;
         }
 
         for( ;; )
         {
             vlc_mutex_lock( &worker->lock );
 
-            bool const b_timeout = worker->head.deadline <= mdate();
-            worker->head.probe_request = false;
+            bool const b_timeout = task.cancel || task.deadline <= mdate();
+            task.probe_request = false;
 
             vlc_mutex_unlock( &worker->lock );
 
@@ -138,46 +151,86 @@ static void* Thread( void* data )
             }
 
             vlc_mutex_lock( &worker->lock );
-            if( worker->head.probe_request == false &&
-                worker->head.deadline > mdate() )
+            if( task.probe_request == false && task.cancel == false &&
+                task.deadline > mdate() )
             {
                 vlc_cond_timedwait( &worker->head.worker_wait, &worker->lock,
-                                     worker->head.deadline );
+                                     task.deadline );
             }
             vlc_mutex_unlock( &worker->lock );
         }
+
+done:
+        vlc_mutex_lock( &worker->lock );
+        vlc_array_remove( &worker->head.tasks,
+                          vlc_array_index_of_item( &worker->head.tasks,
+                                                   &task ) );
+        vlc_cond_broadcast( &worker->head.wait );
     }
 
+    worker->head.threads--;
+    vlc_cond_broadcast( &worker->head.wait );
+    vlc_mutex_unlock( &worker->lock );
+
     return NULL;
 }
 
+static bool HasTask( struct background_worker* worker, void* id )
+{
+    for( size_t i = 0; i < vlc_array_count( &worker->head.tasks ); ++i )
+    {
+        struct bg_task* task = vlc_array_item_at_index( &worker->head.tasks,
+                                                        i );
+        if( id == NULL || task->id == id )
+            return true;
+    }
+    return false;
+}
+
 static void BackgroundWorkerCancel( struct background_worker* worker, void* id)
 {
     vlc_mutex_lock( &worker->lock );
-    for( size_t i = 0; i < vlc_array_count( &worker->tail.data ); )
+    for( size_t q = 0; q < ARRAY_SIZE( worker->tail.data ); ++q )
     {
-        struct bg_queued_item* item =
-            vlc_array_item_at_index( &worker->tail.data, i );
+        vlc_array_t* queue = &worker->tail.data[q];
 
-        if( id == NULL || item->id == id )
+        for( size_t i = 0; i < vlc_array_count( queue ); )
         {
-            vlc_array_remove( &worker->tail.data, i );
-            worker->conf.pf_release( item->entity );
-            free( item );
-            continue;
-        }
+            struct bg_queued_item* item = vlc_array_item_at_index( queue, i );
 
-        ++i;
+            if( id == NULL || item->id == id )
+            {
+                vlc_array_remove( queue, i );
+                worker->conf.pf_release( item->entity );
+                free( item );
+                continue;
+            }
+
+            ++i;
+        }
     }
 
-    while( ( id == NULL && worker->head.active )
-        || ( id != NULL && worker->head.id == id ) )
+    if( id == NULL )
+        worker->head.closing = true;
+
+    while( ( id == NULL && worker->head.threads > 0 )
+        || ( id != NULL && HasTask( worker, id ) ) )
     {
-        worker->head.deadline = VLC_TS_INVALID;
-        vlc_cond_signal( &worker->head.worker_wait );
-        vlc_cond_signal( &worker->tail.wait );
+        for( size_t i = 0; i < vlc_array_count( &worker->head.tasks ); ++i )
+        {
+            struct bg_task* task =
+                vlc_array_item_at_index( &worker->head.tasks, i );
+
+            if( id == NULL || task->id == id )
+                task->cancel = true;
+        }
+        vlc_cond_broadcast( &worker->head.worker_wait );
+        vlc_cond_broadcast( &worker->tail.wait );
         vlc_cond_wait( &worker->head.wait, &worker->lock );
     }
+
+    if( id == NULL )
+        worker->head.closing = false;
     vlc_mutex_unlock( &worker->lock );
 }
 
@@ -190,23 +243,27 @@ struct background_worker* background_worker_New( void* owner,
         return NULL;
 
     worker->conf = *conf;
+    if( worker->conf.max_threads < 1 )
+        worker->conf.max_threads = 1;
     worker->owner = owner;
-    worker->head.id = NULL;
-    worker->head.active = false;
-    worker->head.deadline = VLC_TS_INVALID;
+    worker->head.threads = 0;
+    worker->head.idle = 0;
+    worker->head.closing = false;
 
     vlc_mutex_init( &worker->lock );
     vlc_cond_init( &worker->head.wait );
     vlc_cond_init( &worker->head.worker_wait );
+    vlc_array_init( &worker->head.tasks );
 
-    vlc_array_init( &worker->tail.data );
+    for( size_t i = 0; i < ARRAY_SIZE( worker->tail.data ); ++i )
+        vlc_array_init( &worker->tail.data[i] );
     vlc_cond_init( &worker->tail.wait );
 
     return worker;
 }
 
 int background_worker_Push( struct background_worker* worker, void* entity,
-                        void* id, int timeout )
+                        void* id, int timeout, bool priority )
 {
     struct bg_queued_item* item = malloc( sizeof( *item ) );
 
@@ -218,25 +275,32 @@ int background_worker_Push( struct background_worker* worker, void* entity,
     item->timeout = timeout < 0 ? worker->conf.default_timeout : timeout;
 
     vlc_mutex_lock( &worker->lock );
-    int i_ret = vlc_array_append( &worker->tail.data, item );
+    int i_ret = vlc_array_append( &worker->tail.data[priority ? 0 : 1], item );
     vlc_cond_signal( &worker->tail.wait );
     if( i_ret != 0 )
     {
+        vlc_mutex_unlock( &worker->lock );
         free( item );
         return VLC_EGENERIC;
     }
 
-    if( worker->head.active == false )
-    {
-        worker->head.probe_request = false;
-        worker->head.active =
-            !vlc_clone_detach( NULL, Thread, worker, VLC_THREAD_PRIORITY_LOW );
-    }
+    /* Spawn a new thread unless enough of them are waiting for entities */
+    if( QueueCount( worker ) > worker->head.idle
+     && worker->head.threads < (unsigned)worker->conf.max_threads
+     && !vlc_clone_detach( NULL, Thread, worker, VLC_THREAD_PRIORITY_LOW ) )
+        worker->head.threads++;
 
-    if( worker->head.active )
+    int ret = VLC_SUCCESS;
+    if( worker->head.threads > 0 )
         worker->conf.pf_hold( item->entity );
-
-    int ret = worker->head.active ? VLC_SUCCESS : VLC_EGENERIC;
+    else
+    {
+        vlc_array_remove( &worker->tail.data[priority ? 0 : 1],
+                          vlc_array_index_of_item(
+                              &worker->tail.data[priority ? 0 : 1], item ) );
+        free( item );
+        ret = VLC_EGENERIC;
+    }
     vlc_mutex_unlock( &worker->lock );
 
     return ret;
@@ -250,15 +314,22 @@ void background_worker_Cancel( struct background_worker* worker, void* id )
 void background_worker_RequestProbe( struct background_worker* worker )
 {
     vlc_mutex_lock( &worker->lock );
-    worker->head.probe_request = true;
-    vlc_cond_signal( &worker->head.worker_wait );
+    for( size_t i = 0; i < vlc_array_count( &worker->head.tasks ); ++i )
+    {
+        struct bg_task* task = vlc_array_item_at_index( &worker->head.tasks,
+                                                        i );
+        task->probe_request = true;
+    }
+    vlc_cond_broadcast( &worker->head.worker_wait );
     vlc_mutex_unlock( &worker->lock );
 }
 
 void background_worker_Delete( struct background_worker* worker )
 {
     BackgroundWorkerCancel( worker, NULL );
-    vlc_array_clear( &worker->tail.data );
+    for( size_t i = 0; i < ARRAY_SIZE( worker->tail.data ); ++i )
+        vlc_array_clear( &worker->tail.data[i] );
+    vlc_array_clear( &worker->head.tasks );
     vlc_mutex_destroy( &worker->lock );
     vlc_cond_destroy( &worker->head.wait );
     vlc_cond_destroy( &worker->head.worker_wait );
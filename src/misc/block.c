@@ -34,6 +34,8 @@
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
+#include <vlc_atomic.h>
+#include "libvlc.h"
 
 #ifndef NDEBUG
 static void BlockNoRelease( block_t *b )
@@ -117,6 +119,276 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /** Initial reserved header and footer size. */
 #define BLOCK_PADDING      32
 
+/*** Pooled allocator ***/
+
+/* The pool recycles the blocks of a few common sizes instead of going through
+ * the heap every time. Each thread keeps a small cache of free blocks per size
+ * class, and exchanges them in batches with a central depot. The pool is
+ * disabled by default (see --block-pool). */
+
+#define BLOCK_POOL_OVERHEAD (BLOCK_ALIGN + (2 * BLOCK_PADDING))
+#define BLOCK_POOL_CLASSES  6
+
+/* Consecutive classes are at most 8 times apart, so that a pooled block
+ * wastes at most 7/8 of its payload. */
+static const struct
+{
+    size_t size; /**< Payload size */
+    unsigned cache; /**< Maximum number of free blocks per thread */
+} block_pool_classes[BLOCK_POOL_CLASSES] = {
+    {     256, 64 }, /* single TS packet */
+    {    2048, 64 }, /* UDP datagram */
+    {   16384, 32 },
+    {   65536, 16 },
+    {  262144,  4 },
+    { 1048576,  2 },
+};
+
+/* The depot holds at most that many thread caches worth of blocks */
+#define BLOCK_POOL_DEPOT 8
+
+struct block_pool_cache
+{
+    block_t *free[BLOCK_POOL_CLASSES];
+    unsigned count[BLOCK_POOL_CLASSES];
+    unsigned hits;
+    unsigned misses;
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    block_t *free[BLOCK_POOL_CLASSES];
+    unsigned count[BLOCK_POOL_CLASSES];
+} block_depot = { VLC_STATIC_MUTEX, { NULL }, { 0 } };
+
+static atomic_bool block_pool_enabled = ATOMIC_VAR_INIT(false);
+static vlc_threadvar_t block_pool_key;
+static atomic_uintmax_t block_pool_hits = ATOMIC_VAR_INIT(0);
+static atomic_uintmax_t block_pool_misses = ATOMIC_VAR_INIT(0);
+
+static void block_pool_Account(struct block_pool_cache *cache)
+{
+    atomic_fetch_add_explicit(&block_pool_hits, cache->hits,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&block_pool_misses, cache->misses,
+                              memory_order_relaxed);
+    cache->hits = cache->misses = 0;
+}
+
+static void block_pool_FreeList(block_t *list)
+{
+    while (list != NULL)
+    {
+        block_t *b = list;
+
+        list = b->p_next;
+        free(b);
+    }
+}
+
+/** Moves up to count blocks from a free list to the depot. */
+static void block_depot_Put(unsigned c, block_t **list, unsigned count)
+{
+    const unsigned max = BLOCK_POOL_DEPOT * block_pool_classes[c].cache;
+    block_t *excess = NULL;
+
+    vlc_mutex_lock(&block_depot.lock);
+    while (count-- > 0 && *list != NULL)
+    {
+        block_t *b = *list;
+
+        *list = b->p_next;
+        if (block_depot.count[c] < max)
+        {
+            b->p_next = block_depot.free[c];
+            block_depot.free[c] = b;
+            block_depot.count[c]++;
+        }
+        else
+        {
+            b->p_next = excess;
+            excess = b;
+        }
+    }
+    vlc_mutex_unlock(&block_depot.lock);
+
+    block_pool_FreeList(excess);
+}
+
+/** Moves up to count blocks from the depot to a thread cache. */
+static unsigned block_depot_Get(unsigned c, block_t **list, unsigned count)
+{
+    unsigned n = 0;
+
+    vlc_mutex_lock(&block_depot.lock);
+    while (n < count && block_depot.free[c] != NULL)
+    {
+        block_t *b = block_depot.free[c];
+
+        block_depot.free[c] = b->p_next;
+        b->p_next = *list;
+        *list = b;
+        n++;
+    }
+    block_depot.count[c] -= n;
+    vlc_mutex_unlock(&block_depot.lock);
+    return n;
+}
+
+/* Thread cache destructor: the free blocks of an exiting thread are handed
+ * over to the depot, within its bounds, and the rest is freed. */
+static void block_pool_CacheDestroy(void *data)
+{
+    struct block_pool_cache *cache = data;
+
+    for (unsigned c = 0; c < BLOCK_POOL_CLASSES; c++)
+        block_depot_Put(c, &cache->free[c], cache->count[c]);
+    block_pool_Account(cache);
+    free(cache);
+}
+
+static struct block_pool_cache *block_pool_GetCache(void)
+{
+    struct block_pool_cache *cache = vlc_threadvar_get(block_pool_key);
+
+    if (unlikely(cache == NULL))
+    {
+        cache = calloc(1, sizeof (*cache));
+        if (likely(cache != NULL) && vlc_threadvar_set(block_pool_key, cache))
+        {
+            free(cache);
+            cache = NULL;
+        }
+    }
+    return cache;
+}
+
+static void block_pool_Release(block_t *b)
+{
+    unsigned c = 0;
+
+    while (b->i_size != block_pool_classes[c].size + BLOCK_POOL_OVERHEAD)
+    {
+        c++;
+        assert(c < BLOCK_POOL_CLASSES);
+    }
+
+    block_Invalidate(b);
+
+    struct block_pool_cache *cache = block_pool_GetCache();
+    if (unlikely(cache == NULL))
+    {
+        block_depot_Put(c, &b, 1);
+        return;
+    }
+
+    b->p_next = cache->free[c];
+    cache->free[c] = b;
+
+    /* Hand half of an overflowing cache over to the depot */
+    if (++cache->count[c] > block_pool_classes[c].cache)
+    {
+        unsigned n = cache->count[c] / 2;
+
+        block_depot_Put(c, &cache->free[c], n);
+        cache->count[c] -= n;
+    }
+}
+
+static block_t *block_pool_Alloc(size_t size)
+{
+    unsigned c = 0;
+
+    while (size > block_pool_classes[c].size)
+        if (++c >= BLOCK_POOL_CLASSES)
+            return NULL;
+
+    struct block_pool_cache *cache = block_pool_GetCache();
+    if (unlikely(cache == NULL))
+        return NULL;
+
+    if (cache->free[c] == NULL)
+        cache->count[c] = block_depot_Get(c, &cache->free[c],
+                                          block_pool_classes[c].cache / 2);
+
+    block_t *b = cache->free[c];
+    if (b != NULL)
+    {
+        cache->free[c] = b->p_next;
+        cache->count[c]--;
+        cache->hits++;
+    }
+    else
+    {
+        b = malloc(sizeof (*b) + BLOCK_POOL_OVERHEAD
+                   + block_pool_classes[c].size);
+        if (unlikely(b == NULL))
+            return NULL;
+        cache->misses++;
+    }
+
+    if (cache->hits + cache->misses >= 64)
+        block_pool_Account(cache);
+
+    block_Init(b, b + 1, BLOCK_POOL_OVERHEAD + block_pool_classes[c].size);
+    b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
+    b->p_buffer = (void *)(((uintptr_t)b->p_buffer) & ~(BLOCK_ALIGN - 1));
+    b->i_buffer = size;
+    b->pf_release = block_pool_Release;
+    return b;
+}
+
+void vlc_block_pool_Enable(void)
+{
+    vlc_mutex_lock(&block_depot.lock);
+    if (!atomic_load_explicit(&block_pool_enabled, memory_order_relaxed)
+     && vlc_threadvar_create(&block_pool_key, block_pool_CacheDestroy) == 0)
+        atomic_store_explicit(&block_pool_enabled, true,
+                              memory_order_release);
+    vlc_mutex_unlock(&block_depot.lock);
+}
+
+void vlc_block_pool_Reclaim(void)
+{
+    if (!atomic_load_explicit(&block_pool_enabled, memory_order_acquire))
+        return;
+
+    /* The threads that are not VLC threads, such as the main thread of the
+     * application, may never exit: empty the cache of the calling one. */
+    struct block_pool_cache *cache = vlc_threadvar_get(block_pool_key);
+    if (cache != NULL)
+    {
+        for (unsigned c = 0; c < BLOCK_POOL_CLASSES; c++)
+        {
+            block_pool_FreeList(cache->free[c]);
+            cache->free[c] = NULL;
+            cache->count[c] = 0;
+        }
+        block_pool_Account(cache);
+    }
+
+    block_t *lists[BLOCK_POOL_CLASSES];
+
+    vlc_mutex_lock(&block_depot.lock);
+    for (unsigned c = 0; c < BLOCK_POOL_CLASSES; c++)
+    {
+        lists[c] = block_depot.free[c];
+        block_depot.free[c] = NULL;
+        block_depot.count[c] = 0;
+    }
+    vlc_mutex_unlock(&block_depot.lock);
+
+    for (unsigned c = 0; c < BLOCK_POOL_CLASSES; c++)
+        block_pool_FreeList(lists[c]);
+}
+
+void vlc_block_pool_Stats(uintmax_t *hits, uintmax_t *misses)
+{
+    *hits = atomic_load_explicit(&block_pool_hits, memory_order_relaxed);
+    *misses = atomic_load_explicit(&block_pool_misses, memory_order_relaxed);
+}
+
 block_t *block_Alloc (size_t size)
 {
     if (unlikely(size >> 27))
@@ -125,6 +397,13 @@ block_t *block_Alloc (size_t size)
         return NULL;
     }
 
+    if (atomic_load_explicit(&block_pool_enabled, memory_order_acquire))
+    {
+        block_t *b = block_pool_Alloc(size);
+        if (b != NULL)
+            return b;
+    }
+
     /* 2 * BLOCK_PADDING: pre + post padding */
     const size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
                        + size;
@@ -265,6 +544,80 @@ block_t *block_heap_Alloc (void *addr, size_t length)
     return block;
 }
 
+/* Buffer shared by the blocks created with block_Slice() */
+typedef struct
+{
+    atomic_uint refs;
+    block_t *base;
+} block_shared_t;
+
+typedef struct
+{
+    block_t self;
+    block_shared_t *shared;
+} block_view_t;
+
+static void block_view_Release (block_t *block)
+{
+    block_shared_t *shared = ((block_view_t *)block)->shared;
+
+    if (atomic_fetch_sub (&shared->refs, 1) == 1)
+    {
+        block_Release (shared->base);
+        free (shared);
+    }
+    block_Invalidate (block);
+    free (block);
+}
+
+static block_t *block_view_Alloc (block_shared_t *shared, uint8_t *buf,
+                                  size_t length)
+{
+    block_view_t *view = malloc (sizeof (*view));
+    if (unlikely(view == NULL))
+        return NULL;
+
+    block_Init (&view->self, buf, length);
+    view->self.pf_release = block_view_Release;
+    view->shared = shared;
+    atomic_fetch_add (&shared->refs, 1);
+    return &view->self;
+}
+
+block_t *block_Slice (block_t **pp, size_t offset, size_t length)
+{
+    block_t *block = *pp;
+    block_shared_t *shared;
+
+    block_Check (block);
+    assert (offset <= block->i_buffer && length <= block->i_buffer - offset);
+
+    if (block->pf_release == block_view_Release)
+        shared = ((block_view_t *)block)->shared;
+    else
+    {   /* Replace the block with a view on its buffer */
+        shared = malloc (sizeof (*shared));
+        if (unlikely(shared == NULL))
+            return NULL;
+
+        atomic_init (&shared->refs, 0);
+        shared->base = block;
+
+        block_t *view = block_view_Alloc (shared, block->p_buffer,
+                                          block->i_buffer);
+        if (unlikely(view == NULL))
+        {
+            free (shared);
+            return NULL;
+        }
+        BlockMetaCopy (view, block);
+        block->p_next = NULL;
+        *pp = block = view;
+    }
+
+    return block_view_Alloc (shared, block->p_buffer + offset, length);
+}
+
 #ifdef HAVE_MMAP
 # include <sys/mman.h>
 
@@ -44,6 +44,7 @@ struct block_fifo_t
     block_t             **pp_last;
     size_t              i_depth;
     size_t              i_size;
+    unsigned            i_waiters; /**< Threads waiting for data */
 };
 
 void vlc_fifo_Lock(vlc_fifo_t *fifo)
@@ -61,9 +62,20 @@ void vlc_fifo_Signal(vlc_fifo_t *fifo)
     vlc_cond_signal(&fifo->wait);
 }
 
+static void vlc_fifo_WaitCleanup(void *data)
+{
+    vlc_fifo_t *fifo = data;
+
+    fifo->i_waiters--;
+}
+
 void vlc_fifo_Wait(vlc_fifo_t *fifo)
 {
+    fifo->i_waiters++;
+    vlc_cleanup_push(vlc_fifo_WaitCleanup, fifo);
     vlc_fifo_WaitCond(fifo, &fifo->wait);
+    vlc_cleanup_pop();
+    fifo->i_waiters--;
 }
 
 void vlc_fifo_WaitCond(vlc_fifo_t *fifo, vlc_cond_t *condvar)
@@ -102,7 +114,9 @@ void vlc_fifo_QueueUnlocked(block_fifo_t *fifo, block_t *block)
         block = block->p_next;
     }
 
-    vlc_fifo_Signal(fifo);
+    /* Only wake up the consumer if it is actually sleeping */
+    if (fifo->i_waiters > 0)
+        vlc_fifo_Signal(fifo);
 }
 
 block_t *vlc_fifo_DequeueUnlocked(block_fifo_t *fifo)
@@ -152,6 +166,7 @@ block_fifo_t *block_FifoNew( void )
     p_fifo->p_first = NULL;
     p_fifo->pp_last = &p_fifo->p_first;
     p_fifo->i_depth = p_fifo->i_size = 0;
+    p_fifo->i_waiters = 0;
 
     return p_fifo;
 }
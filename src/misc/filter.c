@@ -102,6 +102,68 @@ void filter_DelProxyCallbacks( vlc_object_t *obj, filter_t *filter,
 
 /* */
 
+#define SLICE_MIN_LINES 32
+
+struct filter_slices
+{
+    filter_t *filter;
+    filter_slice_cb pf_slice;
+    void *opaque;
+    unsigned lines;
+    unsigned band;
+};
+
+static struct vlc_slices *GetSlices(filter_t *filter)
+{
+    static vlc_mutex_t lock = VLC_STATIC_MUTEX;
+    libvlc_priv_t *priv = libvlc_priv(filter->obj.libvlc);
+
+    vlc_mutex_lock(&lock);
+    if (priv->slices == NULL)
+    {
+        unsigned threads = var_InheritInteger(filter, "filter-threads");
+
+        if (threads == 0)
+            threads = vlc_GetCPUCount();
+        priv->slices = vlc_slices_New(threads > 1 ? threads - 1 : 0);
+    }
+    vlc_mutex_unlock(&lock);
+    return priv->slices;
+}
+
+static void RunSlice(void *data, unsigned index)
+{
+    const struct filter_slices *slices = data;
+    unsigned first = index * slices->band;
+    unsigned last = __MIN(first + slices->band, slices->lines);
+
+    slices->pf_slice(slices->filter, slices->opaque, first, last);
+}
+
+void filter_RunSlices(filter_t *filter, unsigned lines,
+                      filter_slice_cb pf_slice, void *opaque)
+{
+    struct vlc_slices *pool = GetSlices(filter);
+    unsigned count = vlc_slices_Count(pool);
+    unsigned band = (lines + count - 1) / count;
+
+    if (band < SLICE_MIN_LINES)
+        band = SLICE_MIN_LINES;
+    band = (band + 15) & ~15u;
+
+    struct filter_slices slices = {
+        .filter = filter,
+        .pf_slice = pf_slice,
+        .opaque = opaque,
+        .lines = lines,
+        .band = band,
+    };
+
+    vlc_slices_Run(pool, (lines + band - 1) / band, RunSlice, &slices);
+}
+
+/* */
+
 filter_t *filter_NewBlend( vlc_object_t *p_this,
                            const video_format_t *p_dst_chroma )
 {
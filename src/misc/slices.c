@@ -0,0 +1,186 @@
+/*****************************************************************************
+ * slices.c: pool of threads processing the slices of a task in parallel
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include "libvlc.h"
+
+struct vlc_slices_job
+{
+    void (*run)(void *, unsigned);
+    void *opaque;
+    unsigned count; /**< number of slices */
+    unsigned next; /**< next slice to start */
+    unsigned done; /**< number of completed slices */
+    struct vlc_slices_job *next_job;
+};
+
+struct vlc_slices
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait_work; /**< signaled when a job is queued */
+    vlc_cond_t wait_done; /**< signaled when a job is completed */
+    struct vlc_slices_job *first; /**< jobs with slices left to start */
+    struct vlc_slices_job **last;
+    bool closing;
+    unsigned threads;
+    vlc_thread_t thread[];
+};
+
+/* Takes the next slice of a queued job, lock must be held */
+static void TakeSlice(struct vlc_slices *pool, struct vlc_slices_job *job,
+                      unsigned *restrict index)
+{
+    assert(job->next < job->count);
+    *index = job->next++;
+    if (job->next < job->count)
+        return;
+
+    /* All the slices are started: dequeue the job */
+    struct vlc_slices_job **pp = &pool->first;
+
+    while (*pp != job)
+        pp = &(*pp)->next_job;
+    *pp = job->next_job;
+    if (pool->last == &job->next_job)
+        pool->last = pp;
+}
+
+static void *Thread(void *data)
+{
+    struct vlc_slices *pool = data;
+
+    vlc_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        while (pool->first == NULL && !pool->closing)
+            vlc_cond_wait(&pool->wait_work, &pool->lock);
+        if (pool->first == NULL)
+            break;
+
+        unsigned index;
+        struct vlc_slices_job *job = pool->first;
+
+        TakeSlice(pool, job, &index);
+        vlc_mutex_unlock(&pool->lock);
+        job->run(job->opaque, index);
+        vlc_mutex_lock(&pool->lock);
+
+        /* The job belongs to the caller, which may return right away */
+        if (++job->done == job->count)
+            vlc_cond_broadcast(&pool->wait_done);
+    }
+    vlc_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+struct vlc_slices *vlc_slices_New(unsigned threads)
+{
+    struct vlc_slices *pool = malloc(sizeof (*pool)
+                                     + threads * sizeof (vlc_thread_t));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    vlc_mutex_init(&pool->lock);
+    vlc_cond_init(&pool->wait_work);
+    vlc_cond_init(&pool->wait_done);
+    pool->first = NULL;
+    pool->last = &pool->first;
+    pool->closing = false;
+    pool->threads = 0;
+
+    while (pool->threads < threads)
+    {
+        if (vlc_clone(&pool->thread[pool->threads], Thread, pool,
+                      VLC_THREAD_PRIORITY_VIDEO))
+            break;
+        pool->threads++;
+    }
+    return pool;
+}
+
+void vlc_slices_Delete(struct vlc_slices *pool)
+{
+    vlc_mutex_lock(&pool->lock);
+    assert(pool->first == NULL);
+    pool->closing = true;
+    vlc_cond_broadcast(&pool->wait_work);
+    vlc_mutex_unlock(&pool->lock);
+
+    for (unsigned i = 0; i < pool->threads; i++)
+        vlc_join(pool->thread[i], NULL);
+
+    vlc_cond_destroy(&pool->wait_done);
+    vlc_cond_destroy(&pool->wait_work);
+    vlc_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+unsigned vlc_slices_Count(const struct vlc_slices *pool)
+{
+    return (pool != NULL) ? pool->threads + 1 : 1;
+}
+
+void vlc_slices_Run(struct vlc_slices *pool, unsigned count,
+                    void (*run)(void *, unsigned), void *opaque)
+{
+    if (pool == NULL || pool->threads == 0 || count <= 1)
+    {
+        for (unsigned i = 0; i < count; i++)
+            run(opaque, i);
+        return;
+    }
+
+    struct vlc_slices_job job = {
+        .run = run,
+        .opaque = opaque,
+        .count = count,
+        .next = 0,
+        .done = 0,
+        .next_job = NULL,
+    };
+
+    vlc_mutex_lock(&pool->lock);
+    *pool->last = &job;
+    pool->last = &job.next_job;
+    vlc_cond_broadcast(&pool->wait_work);
+
+    /* The calling thread processes slices of its own job too */
+    while (job.next < job.count)
+    {
+        unsigned index;
+
+        TakeSlice(pool, &job, &index);
+        vlc_mutex_unlock(&pool->lock);
+        run(opaque, index);
+        vlc_mutex_lock(&pool->lock);
+        job.done++;
+    }
+
+    while (job.done < job.count)
+        vlc_cond_wait(&pool->wait_done, &pool->lock);
+    vlc_mutex_unlock(&pool->lock);
+}
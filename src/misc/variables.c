@@ -28,9 +28,6 @@
 # include "config.h"
 #endif
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 #include <assert.h>
 #include <float.h>
 #include <math.h>
@@ -68,7 +65,9 @@ typedef struct variable_ops_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    char *       psz_name; /**< The variable unique name */
+    uint32_t     i_hash;   /**< Hash of the name */
+    variable_t  *p_next;   /**< Next variable in the same hash bucket */
 
     /** The variable's exported value */
     vlc_value_t  val;
@@ -137,22 +136,95 @@ int_ops    = { CmpInt,     DupDummy,  FreeDummy,  },
 string_ops = { CmpString,  DupString, FreeString, },
 coords_ops = { NULL,       DupDummy,  FreeDummy,  };
 
-static int varcmp( const void *a, const void *b )
+/* Object variables are stored in a per-object hash table with chaining.
+ * The hash of the name is kept in the variable, so that most mismatches are
+ * ruled out without comparing the strings. */
+
+static uint32_t VarHash( const char *psz_name )
 {
-    const variable_t *va = a, *vb = b;
+    uint32_t h = 2166136261u; /* FNV-1a */
+
+    while( *psz_name )
+    {
+        h ^= (unsigned char)*(psz_name++);
+        h *= 16777619u;
+    }
+    return h;
+}
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+static variable_t **VarBucket( vlc_object_internals_t *priv, uint32_t hash )
+{
+    return &priv->var_table[hash & (priv->var_buckets - 1)];
+}
+
+/**
+ * Finds the link to a variable, or NULL if not found.
+ * The variable lock must be held.
+ */
+static variable_t **VarFind( vlc_object_internals_t *priv,
+                             const char *psz_name, uint32_t hash )
+{
+    if( priv->var_buckets == 0 )
+        return NULL;
+
+    for( variable_t **pp = VarBucket( priv, hash ); *pp != NULL;
+         pp = &(*pp)->p_next )
+        if( (*pp)->i_hash == hash && !strcmp( (*pp)->psz_name, psz_name ) )
+            return pp;
+    return NULL;
+}
+
+static int VarInsert( vlc_object_internals_t *priv, variable_t *var )
+{
+    /* Keep the load factor at or below one */
+    if( priv->var_count >= priv->var_buckets )
+    {
+        size_t buckets = priv->var_buckets ? 2 * priv->var_buckets : 16;
+        variable_t **table = calloc( buckets, sizeof (*table) );
+        if( unlikely(table == NULL) )
+            return VLC_ENOMEM;
+
+        for( size_t i = 0; i < priv->var_buckets; i++ )
+            for( variable_t *v = priv->var_table[i], *next; v != NULL;
+                 v = next )
+            {
+                variable_t **bucket = &table[v->i_hash & (buckets - 1)];
+
+                next = v->p_next;
+                v->p_next = *bucket;
+                *bucket = v;
+            }
+
+        free( priv->var_table );
+        priv->var_table = table;
+        priv->var_buckets = buckets;
+    }
+
+    variable_t **bucket = VarBucket( priv, var->i_hash );
+
+    var->p_next = *bucket;
+    *bucket = var;
+    priv->var_count++;
+    return VLC_SUCCESS;
+}
+
+static void VarRemove( vlc_object_internals_t *priv, variable_t *var )
+{
+    variable_t **pp = VarFind( priv, var->psz_name, var->i_hash );
+
+    assert( pp != NULL && *pp == var );
+    *pp = var->p_next;
+    priv->var_count--;
 }
 
 static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
+    uint32_t hash = VarHash( psz_name );
     variable_t **pp_var;
 
     vlc_mutex_lock(&priv->var_lock);
-    pp_var = tfind( &psz_name, &priv->var_root, varcmp );
+    pp_var = VarFind( priv, psz_name, hash );
     return (pp_var != NULL) ? *pp_var : NULL;
 }
 
@@ -296,6 +368,7 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         return VLC_ENOMEM;
 
     p_var->psz_name = strdup( psz_name );
+    p_var->i_hash = VarHash( psz_name );
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
@@ -353,22 +426,26 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         var_Inherit(p_this, psz_name, i_type, &p_var->val);
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
-    variable_t **pp_var, *p_oldvar;
+    variable_t **pp_var;
     int ret = VLC_SUCCESS;
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    pp_var = tsearch( p_var, &p_priv->var_root, varcmp );
-    if( unlikely(pp_var == NULL) )
-        ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var ) /* Variable create */
-        p_var = NULL; /* Variable created */
-    else /* Variable already exists */
+    pp_var = VarFind( p_priv, p_var->psz_name, p_var->i_hash );
+    if( pp_var != NULL ) /* Variable already exists */
     {
+        variable_t *p_oldvar = *pp_var;
+
         assert (((i_type ^ p_oldvar->i_type) & VLC_VAR_CLASS) == 0);
         p_oldvar->i_usage++;
         p_oldvar->i_type |= i_type & VLC_VAR_ISCOMMAND;
     }
+    else
+    {
+        ret = VarInsert( p_priv, p_var );
+        if( likely(ret == VLC_SUCCESS) )
+            p_var = NULL; /* Variable created */
+    }
     vlc_mutex_unlock( &p_priv->var_lock );
 
     /* If we did not need to create a new variable, free everything... */
@@ -392,7 +469,7 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
     else if( --p_var->i_usage == 0 )
     {
         assert(!p_var->b_incallback);
-        tdelete( p_var, &p_priv->var_root, varcmp );
+        VarRemove( p_priv, p_var );
     }
     else
     {
@@ -405,17 +482,22 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
         Destroy( p_var );
 }
 
-static void CleanupVar( void *var )
-{
-    Destroy( var );
-}
-
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    for( size_t i = 0; i < priv->var_buckets; i++ )
+        for( variable_t *var = priv->var_table[i], *next; var != NULL;
+             var = next )
+        {
+            next = var->p_next;
+            Destroy( var );
+        }
+
+    free( priv->var_table );
+    priv->var_table = NULL;
+    priv->var_buckets = 0;
+    priv->var_count = 0;
 }
 
 int (var_Change)(vlc_object_t *p_this, const char *psz_name, int i_action, ...)
@@ -1123,13 +1205,37 @@ error:
     return VLC_EGENERIC;
 }
 
-static void DumpVariable(const void *data, const VISIT which, const int depth)
+static int VarCmpByName(const void *a, const void *b)
 {
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
+    const variable_t *va = *(const variable_t **)a;
+    const variable_t *vb = *(const variable_t **)b;
+
+    return strcmp(va->psz_name, vb->psz_name);
+}
+
+/**
+ * Gets all variables of an object sorted by name.
+ * The variable lock must be held.
+ */
+static variable_t **VarGetSorted(vlc_object_internals_t *priv)
+{
+    variable_t **vars = vlc_alloc(priv->var_count, sizeof (*vars));
+    if (unlikely(vars == NULL))
+        return NULL;
 
-    const variable_t *var = *(const variable_t **)data;
+    size_t n = 0;
+    for (size_t i = 0; i < priv->var_buckets; i++)
+        for (variable_t *var = priv->var_table[i]; var != NULL;
+             var = var->p_next)
+            vars[n++] = var;
+    assert(n == priv->var_count);
+
+    qsort(vars, n, sizeof (*vars), VarCmpByName);
+    return vars;
+}
+
+static void DumpVariable(const variable_t *var)
+{
     const char *typename = "unknown";
 
     switch (var->i_type & VLC_VAR_TYPE)
@@ -1193,27 +1299,22 @@ static void DumpVariable(const void *data, const VISIT which, const int depth)
 
 void DumpVariables(vlc_object_t *obj)
 {
-    vlc_mutex_lock(&vlc_internals(obj)->var_lock);
-    if (vlc_internals(obj)->var_root == NULL)
+    vlc_object_internals_t *priv = vlc_internals(obj);
+
+    vlc_mutex_lock(&priv->var_lock);
+    if (priv->var_count == 0)
         puts(" `-o No variables");
     else
-        twalk(vlc_internals(obj)->var_root, DumpVariable);
-    vlc_mutex_unlock(&vlc_internals(obj)->var_lock);
-}
-
-static thread_local void *twalk_ctx;
-
-static void TwalkGetNames(const void *data, const VISIT which, const int depth)
-{
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
-
-    const variable_t *var = *(const variable_t **)data;
-    DECL_ARRAY(char *) *names = twalk_ctx;
-    char *dup = strdup(var->psz_name);
-    if (dup != NULL)
-        ARRAY_APPEND(*names, dup);
+    {
+        variable_t **vars = VarGetSorted(priv);
+        if (vars != NULL)
+        {
+            for (size_t i = 0; i < priv->var_count; i++)
+                DumpVariable(vars[i]);
+            free(vars);
+        }
+    }
+    vlc_mutex_unlock(&priv->var_lock);
 }
 
 char **var_GetAllNames(vlc_object_t *obj)
@@ -1223,9 +1324,21 @@ char **var_GetAllNames(vlc_object_t *obj)
     DECL_ARRAY(char *) names;
     ARRAY_INIT(names);
 
-    twalk_ctx = &names;
     vlc_mutex_lock(&priv->var_lock);
-    twalk(priv->var_root, TwalkGetNames);
+    if (priv->var_count > 0)
+    {
+        variable_t **vars = VarGetSorted(priv);
+        if (vars != NULL)
+        {
+            for (size_t i = 0; i < priv->var_count; i++)
+            {
+                char *dup = strdup(vars[i]->psz_name);
+                if (dup != NULL)
+                    ARRAY_APPEND(names, dup);
+            }
+            free(vars);
+        }
+    }
     vlc_mutex_unlock(&priv->var_lock);
 
     if (names.i_size == 0)
@@ -40,7 +40,9 @@ struct vlc_object_internals
     char           *psz_name; /* given name */
 
     /* Object variables */
-    void           *var_root;
+    struct variable_t **var_table; /* Hash table buckets */
+    size_t          var_buckets; /* Number of buckets, a power of two */
+    size_t          var_count;
     vlc_mutex_t     var_lock;
     vlc_cond_t      var_wait;
 
@@ -40,6 +40,8 @@
 #include <vlc_url.h>
 #include <vlc_mime.h>
 #include <vlc_block.h>
+#include <vlc_atomic.h>
+#include <vlc_fs.h>
 #include "../libvlc.h"
 
 #include <string.h>
@@ -52,6 +54,12 @@
 #ifdef HAVE_POLL
 # include <poll.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+# include <sys/epoll.h>
+#endif
+#ifdef HAVE_SYS_EVENTFD_H
+# include <sys/eventfd.h>
+#endif
 
 #if defined(_WIN32)
 #   include <winsock2.h>
@@ -66,10 +74,15 @@
 #define HTTPD_CL_BUFSIZE 10000
 #endif
 
+/* stream data a client may be sending at once */
+#define HTTPD_CL_IOV      64
+#define HTTPD_CL_SENDSIZE (256 << 10)
+
 static void httpd_ClientDestroy(httpd_client_t *cl);
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
 
-/* each host run in his own thread */
+typedef struct httpd_worker_t httpd_worker_t;
+
+/* each host run in his own threads, each one serving a share of the clients */
 struct httpd_host_t
 {
     struct vlc_common_members obj;
@@ -82,7 +95,6 @@ struct httpd_host_t
     unsigned     nfd;
     unsigned     port;
 
-    vlc_thread_t thread;
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
@@ -93,13 +105,32 @@ struct httpd_host_t
     int         i_url;
     httpd_url_t **url;
 
-    int            i_client;
-    httpd_client_t **client;
+    /* worker threads, the first one also accepts the connections */
+    unsigned        i_worker;
+    httpd_worker_t *worker;
 
     /* TLS data */
     vlc_tls_creds_t *p_tls;
 };
 
+struct httpd_worker_t
+{
+    httpd_host_t *host;
+
+    vlc_thread_t thread;
+    vlc_mutex_t  lock;
+
+    int            i_client;
+    httpd_client_t **client;
+
+    /* signaled when stream data is available or the clients changed */
+    int          wakeup[2];
+    atomic_bool  b_wakeup;
+#ifdef HAVE_SYS_EPOLL_H
+    int          epfd;
+#endif
+};
+
 
 struct httpd_url_t
 {
@@ -135,6 +166,21 @@ enum
     HTTPD_CLIENT_TLS_HS_OUT
 };
 
+/* stream data, copied once and shared by all the clients sending it */
+typedef struct httpd_chunk_t
+{
+    atomic_uint refs;
+    int64_t     i_pos;  /* absolute position of the first byte */
+    size_t      i_size;
+    uint8_t     p_data[];
+} httpd_chunk_t;
+
+static void httpd_ChunkRelease(httpd_chunk_t *chunk)
+{
+    if (atomic_fetch_sub(&chunk->refs, 1) == 1)
+        free(chunk);
+}
+
 struct httpd_client_t
 {
     httpd_url_t *url;
@@ -160,6 +206,17 @@ struct httpd_client_t
      */
     int64_t i_keyframe_wait_to_pass;
 
+    /* stream being sent, and the shared data being sent from it */
+    httpd_stream_t *stream;
+    unsigned        i_chunk;
+    unsigned        i_chunks;
+    httpd_chunk_t   *chunks[HTTPD_CL_IOV];
+    struct iovec    iov[HTTPD_CL_IOV];
+
+#ifdef HAVE_SYS_EPOLL_H
+    short   i_events; /* registered to the worker epoll */
+#endif
+
     /* */
     httpd_message_t query;  /* client -> httpd */
     httpd_message_t answer; /* httpd -> client */
@@ -606,9 +663,13 @@ struct httpd_stream_t
     bool        b_has_keyframes;
     int64_t     i_last_keyframe_seen_pos;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    /* circular queue of the latest chunks */
+    size_t      i_buffer_size;      /* maximum size of the queued data */
+    size_t      i_buffer;           /* size of the queued data */
+    httpd_chunk_t **pp_chunk;
+    size_t      i_chunk_max;        /* allocated queue entries */
+    size_t      i_chunk_first;
+    size_t      i_chunk;
     int64_t     i_buffer_pos;       /* absolute position from beginning */
     int64_t     i_buffer_last_pos;  /* a new connection will start with that */
 
@@ -627,47 +688,8 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         return VLC_SUCCESS;
 
     if (answer->i_body_offset > 0) {
-        int     i_pos;
-
-        if (answer->i_body_offset >= stream->i_buffer_pos)
-            return VLC_EGENERIC;    /* wait, no data available */
-
-        if (cl->i_keyframe_wait_to_pass >= 0) {
-            if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
-                /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
-
-            /* seek to the new keyframe */
-            answer->i_body_offset = stream->i_last_keyframe_seen_pos;
-            cl->i_keyframe_wait_to_pass = -1;
-        }
-
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
-            answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
-
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
-
-        if (i_write > HTTPD_CL_BUFSIZE)
-            i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
-
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
-
-        /* using HTTPD_MSG_ANSWER -> data available */
-        answer->i_proto  = HTTPD_PROTO_HTTP;
-        answer->i_version= 0;
-        answer->i_type   = HTTPD_MSG_ANSWER;
-
-        answer->i_body = i_write;
-        answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
-
-        answer->i_body_offset += i_write;
-
-        return VLC_SUCCESS;
+        /* the data is sent by the host workers, see httpd_StreamPull() */
+        return VLC_EGENERIC;
     } else {
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
@@ -693,6 +715,7 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
 
         if (query->i_type != HTTPD_MSG_HEAD) {
             cl->b_stream_mode = true;
+            cl->stream = stream;
             vlc_mutex_lock(&stream->lock);
             /* Send the header */
             if (stream->i_header > 0) {
@@ -764,7 +787,11 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->i_header = 0;
     stream->p_header = NULL;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
-    stream->p_buffer = xmalloc(stream->i_buffer_size);
+    stream->i_buffer = 0;
+    stream->pp_chunk = NULL;
+    stream->i_chunk_max = 0;
+    stream->i_chunk_first = 0;
+    stream->i_chunk = 0;
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
     stream->i_buffer_pos = 1;
@@ -800,31 +827,132 @@ int httpd_StreamHeader(httpd_stream_t *stream, uint8_t *p_data, int i_data)
     return VLC_SUCCESS;
 }
 
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data)
+static httpd_chunk_t *httpd_StreamChunk(const httpd_stream_t *stream, size_t i)
+{
+    return stream->pp_chunk[(stream->i_chunk_first + i) % stream->i_chunk_max];
+}
+
+static int httpd_StreamQueue(httpd_stream_t *stream, httpd_chunk_t *chunk)
+{
+    /* Drop the oldest data, the clients still sending it hold a reference */
+    while (stream->i_chunk > 0 &&
+           stream->i_buffer + chunk->i_size > stream->i_buffer_size) {
+        httpd_chunk_t *old = httpd_StreamChunk(stream, 0);
+
+        stream->i_buffer -= old->i_size;
+        stream->i_chunk_first = (stream->i_chunk_first + 1) % stream->i_chunk_max;
+        stream->i_chunk--;
+        httpd_ChunkRelease(old);
+    }
+
+    if (stream->i_chunk == stream->i_chunk_max) {
+        size_t i_max = stream->i_chunk_max ? 2 * stream->i_chunk_max : 64;
+        httpd_chunk_t **pp_chunk = vlc_alloc(i_max, sizeof (*pp_chunk));
+        if (unlikely(pp_chunk == NULL))
+            return VLC_ENOMEM;
+
+        for (size_t i = 0; i < stream->i_chunk; i++)
+            pp_chunk[i] = httpd_StreamChunk(stream, i);
+        free(stream->pp_chunk);
+        stream->pp_chunk = pp_chunk;
+        stream->i_chunk_max = i_max;
+        stream->i_chunk_first = 0;
+    }
+
+    stream->pp_chunk[(stream->i_chunk_first + stream->i_chunk)
+                     % stream->i_chunk_max] = chunk;
+    stream->i_chunk++;
+    stream->i_buffer += chunk->i_size;
+    return VLC_SUCCESS;
+}
+
+/* Takes references to the stream data following the client position,
+ * returns the number of bytes to send */
+static size_t httpd_StreamPull(httpd_stream_t *stream, httpd_client_t *cl)
 {
-    int i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    int i_count = i_data;
-    while (i_count > 0) {
-        int i_copy = __MIN(i_count, stream->i_buffer_size - i_pos);
+    int64_t i_offset = cl->answer.i_body_offset;
+    size_t i_total = 0;
 
-        /* Ok, we can't go past the end of our buffer */
-        memcpy(&stream->p_buffer[i_pos], p_data, i_copy);
+    assert(cl->i_chunks == 0);
 
-        i_pos = (i_pos + i_copy) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
+    vlc_mutex_lock(&stream->lock);
+    if (i_offset >= stream->i_buffer_pos || stream->i_chunk == 0)
+        goto out;   /* wait, no data available */
+
+    if (cl->i_keyframe_wait_to_pass >= 0) {
+        if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
+            /* still waiting for the next keyframe */
+            goto out;
+
+        /* seek to the new keyframe */
+        i_offset = stream->i_last_keyframe_seen_pos;
+        cl->i_keyframe_wait_to_pass = -1;
     }
 
-    stream->i_buffer_pos += i_data;
+    if (i_offset < httpd_StreamChunk(stream, 0)->i_pos)
+        i_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
+
+    /* Find the chunk holding the client position */
+    size_t lo = 0, hi = stream->i_chunk;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+
+        if (httpd_StreamChunk(stream, mid)->i_pos <= i_offset)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    for (size_t i = lo; i < stream->i_chunk; i++) {
+        httpd_chunk_t *chunk = httpd_StreamChunk(stream, i);
+        size_t i_skip = i_offset - chunk->i_pos;
+        size_t i_len = __MIN(chunk->i_size - i_skip,
+                             HTTPD_CL_SENDSIZE - i_total);
+
+        if (i_len == 0 || cl->i_chunks >= HTTPD_CL_IOV)
+            break;
+
+        atomic_fetch_add(&chunk->refs, 1);
+        cl->chunks[cl->i_chunks] = chunk;
+        cl->iov[cl->i_chunks].iov_base = chunk->p_data + i_skip;
+        cl->iov[cl->i_chunks].iov_len = i_len;
+        cl->i_chunks++;
+
+        i_offset += i_len;
+        i_total += i_len;
+    }
+    cl->i_chunk = 0;
+    cl->answer.i_body_offset = i_offset;
+out:
+    vlc_mutex_unlock(&stream->lock);
+    return i_total;
 }
 
+static void httpd_HostWakeup(httpd_host_t *host);
+
 int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
 {
-    if (!p_block || !p_block->p_buffer)
+    if (!p_block || !p_block->p_buffer || p_block->i_buffer == 0)
         return VLC_SUCCESS;
 
+    /* Copy the data once, the clients send it straight from the chunk */
+    httpd_chunk_t *chunk = malloc(sizeof (*chunk) + p_block->i_buffer);
+    if (unlikely(chunk == NULL))
+        return VLC_ENOMEM;
+
+    atomic_init(&chunk->refs, 1);
+    chunk->i_size = p_block->i_buffer;
+    memcpy(chunk->p_data, p_block->p_buffer, p_block->i_buffer);
+
     vlc_mutex_lock(&stream->lock);
 
+    chunk->i_pos = stream->i_buffer_pos;
+    if (httpd_StreamQueue(stream, chunk)) {
+        vlc_mutex_unlock(&stream->lock);
+        free(chunk);
+        return VLC_ENOMEM;
+    }
+
     /* save this pointer (to be used by new connection) */
     stream->i_buffer_last_pos = stream->i_buffer_pos;
 
@@ -833,9 +961,11 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
         stream->i_last_keyframe_seen_pos = stream->i_buffer_pos;
     }
 
-    httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
+    stream->i_buffer_pos += p_block->i_buffer;
 
     vlc_mutex_unlock(&stream->lock);
+
+    httpd_HostWakeup(stream->url->host);
     return VLC_SUCCESS;
 }
 
@@ -850,14 +980,123 @@ void httpd_StreamDelete(httpd_stream_t *stream)
     vlc_mutex_destroy(&stream->lock);
     free(stream->psz_mime);
     free(stream->p_header);
-    free(stream->p_buffer);
+    for (size_t i = 0; i < stream->i_chunk; i++)
+        httpd_ChunkRelease(httpd_StreamChunk(stream, i));
+    free(stream->pp_chunk);
     free(stream);
 }
 
 /*****************************************************************************
  * Low level
  *****************************************************************************/
-static void* httpd_HostThread(void *);
+static void *httpd_WorkerThread(void *);
+
+static void httpd_WorkerWakeup(httpd_worker_t *worker)
+{
+    static const uint64_t one = 1;
+
+    /* Only one pending wakeup is needed */
+    if (worker->wakeup[1] == -1 || atomic_exchange(&worker->b_wakeup, true))
+        return;
+    if (write(worker->wakeup[1], &one, sizeof (one)) < 0)
+        atomic_store(&worker->b_wakeup, false);
+}
+
+static void httpd_HostWakeup(httpd_host_t *host)
+{
+    for (unsigned i = 0; i < host->i_worker; i++)
+        httpd_WorkerWakeup(&host->worker[i]);
+}
+
+static int httpd_WorkerInit(httpd_host_t *host, httpd_worker_t *worker)
+{
+    worker->host = host;
+    vlc_mutex_init(&worker->lock);
+    worker->i_client = 0;
+    worker->client = NULL;
+    worker->wakeup[0] = worker->wakeup[1] = -1;
+    atomic_init(&worker->b_wakeup, false);
+
+#ifndef _WIN32
+    /* Without it, the clients waiting for stream data are polled */
+# if defined (HAVE_EVENTFD) && defined (EFD_CLOEXEC)
+    worker->wakeup[0] = eventfd(0, EFD_CLOEXEC);
+    if (worker->wakeup[0] != -1)
+        worker->wakeup[1] = worker->wakeup[0];
+    else
+# endif
+    if (vlc_pipe(worker->wakeup))
+        worker->wakeup[0] = worker->wakeup[1] = -1;
+#endif
+
+    /* Without it, a worker would not notice the clients handed over to it
+     * before its next socket event: only the first worker can do without. */
+    if (worker->wakeup[0] == -1 && worker != host->worker) {
+        vlc_mutex_destroy(&worker->lock);
+        return -1;
+    }
+
+#ifdef HAVE_SYS_EPOLL_H
+    worker->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (worker->epfd == -1)
+        goto error;
+
+    struct epoll_event ev = { .events = EPOLLIN };
+
+    if (worker->wakeup[0] != -1) {
+        ev.data.ptr = worker;
+        if (epoll_ctl(worker->epfd, EPOLL_CTL_ADD, worker->wakeup[0], &ev))
+            goto error;
+    }
+
+    /* The first worker accepts the connections */
+    if (worker == host->worker) {
+        ev.data.ptr = host;
+        for (unsigned i = 0; i < host->nfd; i++)
+            if (epoll_ctl(worker->epfd, EPOLL_CTL_ADD, host->fds[i], &ev))
+                goto error;
+    }
+#endif
+
+    if (vlc_clone(&worker->thread, httpd_WorkerThread, worker,
+                  VLC_THREAD_PRIORITY_LOW))
+        goto error;
+    return 0;
+
+error:
+#ifdef HAVE_SYS_EPOLL_H
+    if (worker->epfd != -1)
+        vlc_close(worker->epfd);
+#endif
+    if (worker->wakeup[1] != worker->wakeup[0])
+        vlc_close(worker->wakeup[1]);
+    if (worker->wakeup[0] != -1)
+        vlc_close(worker->wakeup[0]);
+    vlc_mutex_destroy(&worker->lock);
+    return -1;
+}
+
+static void httpd_WorkerClean(httpd_worker_t *worker)
+{
+    vlc_cancel(worker->thread);
+    httpd_WorkerWakeup(worker);
+    vlc_join(worker->thread, NULL);
+
+    for (int i = 0; i < worker->i_client; i++) {
+        msg_Warn(worker->host, "client still connected");
+        httpd_ClientDestroy(worker->client[i]);
+    }
+    TAB_CLEAN(worker->i_client, worker->client);
+
+#ifdef HAVE_SYS_EPOLL_H
+    vlc_close(worker->epfd);
+#endif
+    if (worker->wakeup[1] != worker->wakeup[0])
+        vlc_close(worker->wakeup[1]);
+    if (worker->wakeup[0] != -1)
+        vlc_close(worker->wakeup[0]);
+    vlc_mutex_destroy(&worker->lock);
+}
 static httpd_host_t *httpd_HostCreate(vlc_object_t *, const char *,
                                        const char *, vlc_tls_creds_t *);
 
@@ -957,6 +1196,8 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     vlc_mutex_init(&host->lock);
     vlc_cond_init(&host->wait);
     host->i_ref = 1;
+    host->i_worker = 0;
+    host->worker = NULL;
 
     host->fds = net_ListenTCP(p_this, url.psz_host, port);
     if (!host->fds) {
@@ -968,13 +1209,24 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     host->port     = port;
     host->i_url    = 0;
     host->url      = NULL;
-    host->i_client = 0;
-    host->client   = NULL;
     host->p_tls    = p_tls;
 
-    /* create the thread */
-    if (vlc_clone(&host->thread, httpd_HostThread, host,
-                   VLC_THREAD_PRIORITY_LOW)) {
+    /* create the threads */
+    unsigned i_worker = var_InheritInteger(p_this, "http-threads");
+    if (i_worker == 0)
+        i_worker = vlc_GetCPUCount();
+
+    host->worker = vlc_alloc(i_worker, sizeof (*host->worker));
+    if (unlikely(host->worker == NULL))
+        goto error;
+
+    while (host->i_worker < i_worker
+        && !httpd_WorkerInit(host, &host->worker[host->i_worker]))
+        /* Without a wakeup descriptor, the first worker serves all clients */
+        if (host->worker[host->i_worker++].wakeup[0] == -1)
+            break;
+
+    if (host->i_worker == 0) {
         msg_Err(p_this, "cannot spawn http host thread");
         goto error;
     }
@@ -991,6 +1243,9 @@ error:
     vlc_mutex_unlock(&httpd.mutex);
 
     if (host) {
+        for (unsigned i = 0; i < host->i_worker; i++)
+            httpd_WorkerClean(&host->worker[i]);
+        free(host->worker);
         net_ListenClose(host->fds);
         vlc_cond_destroy(&host->wait);
         vlc_mutex_destroy(&host->lock);
@@ -1022,20 +1277,15 @@ void httpd_HostDelete(httpd_host_t *host)
     }
     TAB_REMOVE(httpd.i_host, httpd.host, host);
 
-    vlc_cancel(host->thread);
-    vlc_join(host->thread, NULL);
+    for (unsigned i = 0; i < host->i_worker; i++)
+        httpd_WorkerClean(&host->worker[i]);
+    free(host->worker);
 
     msg_Dbg(host, "HTTP host removed");
 
     for (int i = 0; i < host->i_url; i++)
         msg_Err(host, "url still registered: %s", host->url[i]->psz_url);
 
-    for (int i = 0; i < host->i_client; i++) {
-        msg_Warn(host, "client still connected");
-        httpd_ClientDestroy(host->client[i]);
-    }
-    TAB_CLEAN(host->i_client, host->client);
-
     vlc_tls_Delete(host->p_tls);
     net_ListenClose(host->fds);
     vlc_cond_destroy(&host->wait);
@@ -1073,7 +1323,7 @@ httpd_url_t *httpd_UrlNew(httpd_host_t *host, const char *psz_url,
     }
 
     TAB_APPEND(host->i_url, host->url, url);
-    vlc_cond_signal(&host->wait);
+    vlc_cond_broadcast(&host->wait);
     vlc_mutex_unlock(&host->lock);
 
     return url;
@@ -1098,26 +1348,38 @@ void httpd_UrlDelete(httpd_url_t *url)
 
     vlc_mutex_lock(&host->lock);
     TAB_REMOVE(host->i_url, host->url, url);
+    vlc_mutex_unlock(&host->lock);
 
-    vlc_mutex_destroy(&url->lock);
-    free(url->psz_url);
-    free(url->psz_user);
-    free(url->psz_password);
+    for (unsigned i = 0; i < host->i_worker; i++) {
+        httpd_worker_t *worker = &host->worker[i];
+        bool b_wakeup = false;
 
-    for (int i = 0; i < host->i_client; i++) {
-        httpd_client_t *client = host->client[i];
+        vlc_mutex_lock(&worker->lock);
+        for (int j = 0; j < worker->i_client; j++) {
+            httpd_client_t *client = worker->client[j];
 
-        if (client->url != url)
-            continue;
+            if (client->url != url)
+                continue;
 
-        /* TODO complete it */
-        msg_Warn(host, "force closing connections");
-        TAB_REMOVE(host->i_client, host->client, client);
-        httpd_ClientDestroy(client);
-        i--;
+            /* TODO complete it */
+            msg_Warn(host, "force closing connections");
+            /* the worker destroys dead clients */
+            client->url = NULL;
+            client->stream = NULL;
+            client->i_state = HTTPD_CLIENT_DEAD;
+            b_wakeup = true;
+        }
+        vlc_mutex_unlock(&worker->lock);
+
+        if (b_wakeup)
+            httpd_WorkerWakeup(worker);
     }
+
+    vlc_mutex_destroy(&url->lock);
+    free(url->psz_url);
+    free(url->psz_user);
+    free(url->psz_password);
     free(url);
-    vlc_mutex_unlock(&host->lock);
 }
 
 static void httpd_MsgInit(httpd_message_t *msg)
@@ -1199,6 +1461,9 @@ static void httpd_ClientInit(httpd_client_t *cl, mtime_t now)
     cl->p_buffer = xmalloc(cl->i_buffer_size);
     cl->i_keyframe_wait_to_pass = -1;
     cl->b_stream_mode = false;
+    cl->stream = NULL;
+    cl->i_chunk = 0;
+    cl->i_chunks = 0;
 
     httpd_MsgInit(&cl->query);
     httpd_MsgInit(&cl->answer);
@@ -1216,6 +1481,8 @@ char* httpd_ServerIP(const httpd_client_t *cl, char *ip, int *port)
 
 static void httpd_ClientDestroy(httpd_client_t *cl)
 {
+    for (unsigned i = cl->i_chunk; i < cl->i_chunks; i++)
+        httpd_ChunkRelease(cl->chunks[i]);
     vlc_tls_Close(cl->sock);
     httpd_MsgClean(&cl->answer);
     httpd_MsgClean(&cl->query);
@@ -1558,10 +1825,51 @@ static void httpd_ClientRecv(httpd_client_t *cl)
         cl->i_activity_timeout = 0;
 }
 
+static void httpd_ClientSendChunks(httpd_client_t *cl)
+{
+    vlc_tls_t *sock = cl->sock;
+    ssize_t val = sock->writev(sock, &cl->iov[cl->i_chunk],
+                               cl->i_chunks - cl->i_chunk);
+    if (val < 0) {
+#if defined(_WIN32)
+        if (WSAGetLastError() != WSAEWOULDBLOCK)
+#else
+        if (errno != EAGAIN)
+#endif
+            cl->i_state = HTTPD_CLIENT_DEAD;
+        return;
+    }
+
+    size_t i_len = val;
+    while (cl->i_chunk < cl->i_chunks
+        && i_len >= cl->iov[cl->i_chunk].iov_len) {
+        i_len -= cl->iov[cl->i_chunk].iov_len;
+        httpd_ChunkRelease(cl->chunks[cl->i_chunk++]);
+    }
+
+    if (cl->i_chunk < cl->i_chunks) {
+        /* partial write */
+        cl->iov[cl->i_chunk].iov_base =
+            (uint8_t *)cl->iov[cl->i_chunk].iov_base + i_len;
+        cl->iov[cl->i_chunk].iov_len -= i_len;
+        return;
+    }
+
+    /* Keep sending as long as the stream has data for this client */
+    cl->i_chunk = cl->i_chunks = 0;
+    if (cl->stream == NULL || httpd_StreamPull(cl->stream, cl) == 0)
+        cl->i_state = HTTPD_CLIENT_SEND_DONE;
+}
+
 static void httpd_ClientSend(httpd_client_t *cl)
 {
     int i_len;
 
+    if (cl->i_chunks > 0) {
+        httpd_ClientSendChunks(cl);
+        return;
+    }
+
     if (cl->i_buffer < 0) {
         /* We need to create the header */
         int i_size = 0;
@@ -1600,15 +1908,24 @@ static void httpd_ClientSend(httpd_client_t *cl)
 
         if (cl->i_buffer >= cl->i_buffer_size) {
             if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0) {
-                /* catch more body data */
-                int     i_msg = cl->query.i_type;
-                int64_t i_offset = cl->answer.i_body_offset;
+                if (cl->stream != NULL) {
+                    /* send the stream data */
+                    if (httpd_StreamPull(cl->stream, cl) > 0)
+                        return;
+                } else {
+                    /* catch more body data */
+                    httpd_host_t *host = cl->url->host;
+                    int     i_msg = cl->query.i_type;
+                    int64_t i_offset = cl->answer.i_body_offset;
 
-                httpd_MsgClean(&cl->answer);
-                cl->answer.i_body_offset = i_offset;
+                    httpd_MsgClean(&cl->answer);
+                    cl->answer.i_body_offset = i_offset;
 
-                cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
-                                          &cl->answer, &cl->query);
+                    vlc_mutex_lock(&host->lock);
+                    cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
+                                              &cl->answer, &cl->query);
+                    vlc_mutex_unlock(&host->lock);
+                }
             }
 
             if (cl->answer.i_body > 0) {
@@ -1687,57 +2004,138 @@ auth_failed:
     return false;
 }
 
-static void httpdLoop(httpd_host_t *host)
+static void httpd_ClientEvent(httpd_host_t *host, httpd_client_t *cl,
+                              mtime_t now)
+{
+    cl->i_activity_date = now;
+
+    switch (cl->i_state) {
+        case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
+        case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
+        case HTTPD_CLIENT_TLS_HS_IN:
+        case HTTPD_CLIENT_TLS_HS_OUT:
+            httpd_ClientTlsHandshake(host, cl);
+            break;
+        case HTTPD_CLIENT_WAITING:
+            /* not polled: error or hang-up while waiting for stream data */
+            cl->i_state = HTTPD_CLIENT_DEAD;
+            break;
+    }
+}
+
+static void httpd_HostAccept(httpd_host_t *host, int fd, mtime_t now)
 {
-    struct pollfd ufd[host->nfd + host->i_client];
+    httpd_client_t *cl;
+
+    /* */
+    fd = vlc_accept (fd, NULL, NULL, true);
+    if (fd == -1)
+        return;
+    setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
+            &(int){ 1 }, sizeof(int));
+
+    vlc_tls_t *sk = vlc_tls_SocketOpen(fd);
+    if (unlikely(sk == NULL))
+    {
+        vlc_close(fd);
+        return;
+    }
+
+    if (host->p_tls != NULL)
+    {
+        const char *alpn[] = { "http/1.1", NULL };
+        vlc_tls_t *tls;
+
+        tls = vlc_tls_ServerSessionCreate(host->p_tls, sk, alpn);
+        if (tls == NULL)
+        {
+            vlc_tls_SessionDelete(sk);
+            return;
+        }
+        sk = tls;
+    }
+
+    cl = httpd_ClientNew(sk, now);
+
+    if (host->p_tls != NULL)
+        cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
+
+    /* give the client to the least busy worker */
+    httpd_worker_t *worker = NULL;
+    int i_client = 0;
+
+    for (unsigned i = 0; i < host->i_worker; i++) {
+        vlc_mutex_lock(&host->worker[i].lock);
+        if (worker == NULL || host->worker[i].i_client < i_client) {
+            worker = &host->worker[i];
+            i_client = worker->i_client;
+        }
+        vlc_mutex_unlock(&host->worker[i].lock);
+    }
+
+    vlc_mutex_lock(&worker->lock);
+    TAB_APPEND(worker->i_client, worker->client, cl);
+#ifdef HAVE_SYS_EPOLL_H
+    /* the worker registers the events it waits for */
+    struct epoll_event ev = { .events = 0, .data.ptr = cl };
+
+    cl->i_events = 0;
+    if (epoll_ctl(worker->epfd, EPOLL_CTL_ADD, vlc_tls_GetFD(sk), &ev))
+        cl->i_state = HTTPD_CLIENT_DEAD;
+#endif
+    vlc_mutex_unlock(&worker->lock);
+    httpd_WorkerWakeup(worker);
+}
+
+static void httpdLoop(httpd_worker_t *worker)
+{
+    httpd_host_t *host = worker->host;
+    /* The first worker accepts the connections */
+    const unsigned nlisten = (worker == host->worker) ? host->nfd : 0;
+
+    int canc = vlc_savecancel();
+    vlc_mutex_lock(&worker->lock);
+
+#ifndef HAVE_SYS_EPOLL_H
+    struct pollfd ufd[nlisten + 1 + worker->i_client];
     unsigned nfd;
-    for (nfd = 0; nfd < host->nfd; nfd++) {
+    for (nfd = 0; nfd < nlisten; nfd++) {
         ufd[nfd].fd = host->fds[nfd];
         ufd[nfd].events = POLLIN;
         ufd[nfd].revents = 0;
     }
-
-    /* add all socket that should be read/write and close dead connection */
-    while (host->i_url <= 0) {
-        mutex_cleanup_push(&host->lock);
-        vlc_cond_wait(&host->wait, &host->lock);
-        vlc_cleanup_pop();
+    if (worker->wakeup[0] != -1) {
+        ufd[nfd].fd = worker->wakeup[0];
+        ufd[nfd].events = POLLIN;
+        ufd[nfd].revents = 0;
+        nfd++;
     }
+    const unsigned nclient = nfd;
+#endif
 
+    /* add all socket that should be read/write and close dead connection */
     mtime_t now = mdate();
     bool b_low_delay = false;
+    bool b_pending = false;
 
-    int canc = vlc_savecancel();
-    for (int i_client = 0; i_client < host->i_client; i_client++) {
+    for (int i_client = 0; i_client < worker->i_client; i_client++) {
         int64_t i_offset;
-        httpd_client_t *cl = host->client[i_client];
+        httpd_client_t *cl = worker->client[i_client];
         if (cl->i_ref < 0 || (cl->i_ref == 0 &&
                     (cl->i_state == HTTPD_CLIENT_DEAD ||
                       (cl->i_activity_timeout > 0 &&
                         cl->i_activity_date+cl->i_activity_timeout < now)))) {
-            TAB_REMOVE(host->i_client, host->client, cl);
+            TAB_REMOVE(worker->i_client, worker->client, cl);
             i_client--;
+#ifdef HAVE_SYS_EPOLL_H
+            epoll_ctl(worker->epfd, EPOLL_CTL_DEL, vlc_tls_GetFD(cl->sock),
+                      NULL);
+#endif
             httpd_ClientDestroy(cl);
             continue;
         }
 
-        struct pollfd *pufd = ufd + nfd;
-        assert (pufd < ufd + (sizeof (ufd) / sizeof (ufd[0])));
-
-        pufd->fd = vlc_tls_GetFD(cl->sock);
-        pufd->events = pufd->revents = 0;
-
         switch (cl->i_state) {
-            case HTTPD_CLIENT_RECEIVING:
-            case HTTPD_CLIENT_TLS_HS_IN:
-                pufd->events = POLLIN;
-                break;
-
-            case HTTPD_CLIENT_SENDING:
-            case HTTPD_CLIENT_TLS_HS_OUT:
-                pufd->events = POLLOUT;
-                break;
-
             case HTTPD_CLIENT_RECEIVE_DONE: {
                 httpd_message_t *answer = &cl->answer;
                 httpd_message_t *query  = &cl->query;
@@ -1823,6 +2221,7 @@ static void httpdLoop(httpd_host_t *host)
                         bool b_auth_failed = false;
 
                         /* Search the url and trigger callbacks */
+                        vlc_mutex_lock(&host->lock);
                         for (int i = 0; i < host->i_url; i++) {
                             httpd_url_t *url = host->url[i];
 
@@ -1852,6 +2251,7 @@ static void httpdLoop(httpd_host_t *host)
                             if (!cl->url)
                                 cl->url = url;
                         }
+                        vlc_mutex_unlock(&host->lock);
 
                         if (answer) {
                             answer->i_proto  = query->i_proto;
@@ -1927,127 +2327,170 @@ static void httpdLoop(httpd_host_t *host)
                 break;
 
             case HTTPD_CLIENT_WAITING:
-                i_offset = cl->answer.i_body_offset;
-                int i_msg = cl->query.i_type;
-
-                httpd_MsgInit(&cl->answer);
-                cl->answer.i_body_offset = i_offset;
-
-                cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
-                        &cl->answer, &cl->query);
-                if (cl->answer.i_type != HTTPD_MSG_NONE) {
+                assert(cl->stream != NULL);
+                if (httpd_StreamPull(cl->stream, cl) > 0) {
                     /* we have new data, so re-enter send mode */
+                    free(cl->p_buffer);
+                    cl->p_buffer      = NULL;
                     cl->i_buffer      = 0;
-                    cl->p_buffer      = cl->answer.p_body;
-                    cl->i_buffer_size = cl->answer.i_body;
-                    cl->answer.p_body = NULL;
-                    cl->answer.i_body = 0;
+                    cl->i_buffer_size = 0;
                     cl->i_state = HTTPD_CLIENT_SENDING;
                 }
         }
 
-        if (pufd->events != 0)
+        short events = 0;
+
+        switch (cl->i_state) {
+            case HTTPD_CLIENT_RECEIVING:
+            case HTTPD_CLIENT_TLS_HS_IN:
+                events = POLLIN;
+                break;
+
+            case HTTPD_CLIENT_SENDING:
+            case HTTPD_CLIENT_TLS_HS_OUT:
+                events = POLLOUT;
+                break;
+
+            case HTTPD_CLIENT_WAITING:
+                /* woken up by httpd_StreamSend(), if possible */
+                if (worker->wakeup[0] == -1)
+                    b_low_delay = true;
+                break;
+
+            default:
+                b_pending = true;
+        }
+
+#ifdef HAVE_SYS_EPOLL_H
+        if (events != cl->i_events) {
+            struct epoll_event ev = {
+                .events = ((events & POLLIN) ? EPOLLIN : 0)
+                        | ((events & POLLOUT) ? EPOLLOUT : 0),
+                .data.ptr = cl,
+            };
+
+            if (epoll_ctl(worker->epfd, EPOLL_CTL_MOD,
+                          vlc_tls_GetFD(cl->sock), &ev) == 0)
+                cl->i_events = events;
+            else {
+                cl->i_state = HTTPD_CLIENT_DEAD;
+                b_pending = true;
+            }
+        }
+#else
+        if (events != 0) {
+            struct pollfd *pufd = ufd + nfd;
+            assert (pufd < ufd + (sizeof (ufd) / sizeof (ufd[0])));
+
+            pufd->fd = vlc_tls_GetFD(cl->sock);
+            pufd->events = events;
+            pufd->revents = 0;
             nfd++;
-        else
-            b_low_delay = true;
+        }
+#endif
     }
-    vlc_mutex_unlock(&host->lock);
+    vlc_mutex_unlock(&worker->lock);
     vlc_restorecancel(canc);
 
-    /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
-    while (poll(ufd, nfd, b_low_delay ? 20 : -1) < 0)
+    /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING and no wakeup */
+    int timeout = b_pending ? 0 : b_low_delay ? 20 : -1;
+    bool b_accept = false;
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event ev[64];
+    int n;
+
+    while ((n = epoll_wait(worker->epfd, ev, ARRAY_SIZE(ev), timeout)) < 0)
+    {
+        if (errno != EINTR)
+            msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+    }
+#else
+    while (poll(ufd, nfd, timeout) < 0)
     {
         if (errno != EINTR)
             msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
     }
+#endif
+    vlc_testcancel();
 
     canc = vlc_savecancel();
-    vlc_mutex_lock(&host->lock);
+    vlc_mutex_lock(&worker->lock);
 
     /* Handle client sockets */
     now = mdate();
-    nfd = host->nfd;
 
-    for (int i_client = 0; i_client < host->i_client; i_client++) {
-        httpd_client_t *cl = host->client[i_client];
-        const struct pollfd *pufd = &ufd[nfd];
+#ifdef HAVE_SYS_EPOLL_H
+    for (int i = 0; i < n; i++) {
+        void *ptr = ev[i].data.ptr;
 
-        assert(pufd < &ufd[sizeof(ufd) / sizeof(ufd[0])]);
+        if (ptr == host)
+            b_accept = true;
+        else if (ptr == worker) {
+            uint64_t dummy;
+
+            atomic_store(&worker->b_wakeup, false);
+            if (read(worker->wakeup[0], &dummy, sizeof (dummy)) < 0)
+                msg_Err(host, "wakeup error: %s", vlc_strerror_c(errno));
+        } else
+            httpd_ClientEvent(host, ptr, now);
+    }
+#else
+    if (worker->wakeup[0] != -1 && ufd[nclient - 1].revents) {
+        uint64_t dummy;
+
+        atomic_store(&worker->b_wakeup, false);
+        if (read(worker->wakeup[0], &dummy, sizeof (dummy)) < 0)
+            msg_Err(host, "wakeup error: %s", vlc_strerror_c(errno));
+    }
+
+    /* Clients accepted while polling are at the end of the list */
+    unsigned i_fd = nclient;
+    for (int i_client = 0; i_client < worker->i_client && i_fd < nfd;
+         i_client++) {
+        httpd_client_t *cl = worker->client[i_client];
+        const struct pollfd *pufd = &ufd[i_fd];
 
         if (vlc_tls_GetFD(cl->sock) != pufd->fd)
             continue; // we were not waiting for this client
-        ++nfd;
+        ++i_fd;
         if (pufd->revents == 0)
             continue; // no event received
 
-        cl->i_activity_date = now;
-
-        switch (cl->i_state) {
-            case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
-            case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
-            case HTTPD_CLIENT_TLS_HS_IN:
-            case HTTPD_CLIENT_TLS_HS_OUT:
-                httpd_ClientTlsHandshake(host, cl);
-                break;
-        }
+        httpd_ClientEvent(host, cl, now);
     }
 
-    /* Handle server sockets (accept new connections) */
-    for (nfd = 0; nfd < host->nfd; nfd++) {
-        httpd_client_t *cl;
-        int fd = ufd[nfd].fd;
-
-        assert (fd == host->fds[nfd]);
-
-        if (ufd[nfd].revents == 0)
-            continue;
-
-        /* */
-        fd = vlc_accept (fd, NULL, NULL, true);
-        if (fd == -1)
-            continue;
-        setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
-                &(int){ 1 }, sizeof(int));
-
-        vlc_tls_t *sk = vlc_tls_SocketOpen(fd);
-        if (unlikely(sk == NULL))
-        {
-            vlc_close(fd);
-            continue;
-        }
-
-        if (host->p_tls != NULL)
-        {
-            const char *alpn[] = { "http/1.1", NULL };
-            vlc_tls_t *tls;
-
-            tls = vlc_tls_ServerSessionCreate(host->p_tls, sk, alpn);
-            if (tls == NULL)
-            {
-                vlc_tls_SessionDelete(sk);
-                continue;
-            }
-            sk = tls;
-        }
-
-        cl = httpd_ClientNew(sk, now);
-
-        if (host->p_tls != NULL)
-            cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
+    for (unsigned i = 0; i < nlisten; i++)
+        if (ufd[i].revents != 0)
+            b_accept = true;
+#endif
+    vlc_mutex_unlock(&worker->lock);
 
-        TAB_APPEND(host->i_client, host->client, cl);
-    }
+    /* Handle server sockets (accept new connections) */
+    if (b_accept)
+        for (unsigned i = 0; i < nlisten; i++)
+            httpd_HostAccept(host, host->fds[i], now);
 
     vlc_restorecancel(canc);
 }
 
-static void* httpd_HostThread(void *data)
+static void *httpd_WorkerThread(void *data)
 {
-    httpd_host_t *host = data;
+    httpd_worker_t *worker = data;
+    httpd_host_t *host = worker->host;
 
     vlc_mutex_lock(&host->lock);
-    while (host->i_ref > 0)
-        httpdLoop(host);
+    while (host->i_ref > 0) {
+        while (host->i_url <= 0) {
+            mutex_cleanup_push(&host->lock);
+            vlc_cond_wait(&host->wait, &host->lock);
+            vlc_cleanup_pop();
+        }
+        vlc_mutex_unlock(&host->lock);
+
+        httpdLoop(worker);
+
+        vlc_mutex_lock(&host->lock);
+    }
     vlc_mutex_unlock(&host->lock);
     return NULL;
 }
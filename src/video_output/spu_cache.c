@@ -0,0 +1,479 @@
+/*****************************************************************************
+ * spu_cache.c : subpicture render cache
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_list.h>
+#include <vlc_memstream.h>
+#include <vlc_picture.h>
+#include <vlc_subpicture.h>
+#include <vlc_text_style.h>
+
+#include "spu_cache.h"
+
+typedef struct {
+    struct vlc_list node;
+
+    uint64_t  hash;
+    char      *key;
+    size_t    key_size;
+    size_t    cost;                     /**< bytes accounted to this entry */
+
+    picture_t *picture;                 /**< rendered or scaled picture */
+
+    /* Text entries */
+    bool           is_text;
+    video_format_t fmt;                 /**< rendered format (own palette) */
+    int            x;
+    int            y;
+
+    /* Scale entries */
+    picture_t *source;                  /**< held to verify the pixels */
+    uint64_t  pixels_hash;
+} spu_cache_entry_t;
+
+struct spu_cache_t {
+    vlc_object_t    *obj;
+    struct vlc_list entries;            /**< most recently used first */
+    size_t          size;
+    size_t          max_size;
+
+    struct {
+        unsigned hits;
+        unsigned misses;
+    } text, scale;
+    unsigned evictions;
+};
+
+/*****************************************************************************
+ * Hashing
+ *****************************************************************************/
+#define HASH_SEED  UINT64_C(0xcbf29ce484222325)
+#define HASH_PRIME UINT64_C(0x100000001b3)
+
+static uint64_t Hash(uint64_t h, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+
+    /* FNV-1a on 64-bit words, then on the remaining bytes */
+    for (; size >= 8; size -= 8, p += 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        h = (h ^ w) * HASH_PRIME;
+        h ^= h >> 29;
+    }
+    for (; size > 0; size--, p++)
+        h = (h ^ *p) * HASH_PRIME;
+    return h;
+}
+
+static uint64_t HashPixels(const picture_t *picture)
+{
+    uint64_t h = HASH_SEED;
+
+    for (int i = 0; i < picture->i_planes; i++) {
+        const plane_t *p = &picture->p[i];
+
+        for (int y = 0; y < p->i_visible_lines; y++)
+            h = Hash(h, &p->p_pixels[y * p->i_pitch], p->i_visible_pitch);
+    }
+    return h;
+}
+
+static bool SamePixels(const picture_t *a, const picture_t *b)
+{
+    if (a == b)
+        return true;
+    if (a->i_planes != b->i_planes)
+        return false;
+
+    for (int i = 0; i < a->i_planes; i++) {
+        const plane_t *pa = &a->p[i];
+        const plane_t *pb = &b->p[i];
+
+        if (pa->i_visible_lines != pb->i_visible_lines ||
+            pa->i_visible_pitch != pb->i_visible_pitch)
+            return false;
+
+        for (int y = 0; y < pa->i_visible_lines; y++)
+            if (memcmp(&pa->p_pixels[y * pa->i_pitch],
+                       &pb->p_pixels[y * pb->i_pitch], pa->i_visible_pitch))
+                return false;
+    }
+    return true;
+}
+
+static size_t PictureCost(const picture_t *picture)
+{
+    size_t cost = sizeof(*picture);
+
+    for (int i = 0; i < picture->i_planes; i++)
+        cost += (size_t)picture->p[i].i_pitch * picture->p[i].i_lines;
+    return cost;
+}
+
+/*****************************************************************************
+ * Keys
+ *****************************************************************************/
+#define KEY_PUT(ms, v) vlc_memstream_write(ms, &(v), sizeof(v))
+
+static void KeyPutString(struct vlc_memstream *ms, const char *str)
+{
+    /* The NUL terminator delimits consecutive strings */
+    if (str)
+        vlc_memstream_write(ms, str, strlen(str) + 1);
+    else
+        vlc_memstream_putc(ms, 0xff);
+}
+
+static void KeyPutStyle(struct vlc_memstream *ms, const text_style_t *style)
+{
+    if (!style) {
+        vlc_memstream_putc(ms, 0);
+        return;
+    }
+    vlc_memstream_putc(ms, 1);
+    KeyPutString(ms, style->psz_fontname);
+    KeyPutString(ms, style->psz_monofontname);
+    KEY_PUT(ms, style->i_features);
+    KEY_PUT(ms, style->i_style_flags);
+    KEY_PUT(ms, style->f_font_relsize);
+    KEY_PUT(ms, style->i_font_size);
+    KEY_PUT(ms, style->i_font_color);
+    KEY_PUT(ms, style->i_font_alpha);
+    KEY_PUT(ms, style->i_spacing);
+    KEY_PUT(ms, style->i_outline_color);
+    KEY_PUT(ms, style->i_outline_alpha);
+    KEY_PUT(ms, style->i_outline_width);
+    KEY_PUT(ms, style->i_shadow_color);
+    KEY_PUT(ms, style->i_shadow_alpha);
+    KEY_PUT(ms, style->i_shadow_width);
+    KEY_PUT(ms, style->i_background_color);
+    KEY_PUT(ms, style->i_background_alpha);
+    KEY_PUT(ms, style->i_karaoke_background_color);
+    KEY_PUT(ms, style->i_karaoke_background_alpha);
+    int wrap = style->e_wrapinfo;
+    KEY_PUT(ms, wrap);
+}
+
+static void KeyPutFormat(struct vlc_memstream *ms, const video_format_t *fmt)
+{
+    KEY_PUT(ms, fmt->i_chroma);
+    KEY_PUT(ms, fmt->i_width);
+    KEY_PUT(ms, fmt->i_height);
+    KEY_PUT(ms, fmt->i_x_offset);
+    KEY_PUT(ms, fmt->i_y_offset);
+    KEY_PUT(ms, fmt->i_visible_width);
+    KEY_PUT(ms, fmt->i_visible_height);
+    KEY_PUT(ms, fmt->i_sar_num);
+    KEY_PUT(ms, fmt->i_sar_den);
+    int colors[] = { fmt->primaries, fmt->transfer, fmt->space,
+                     fmt->b_color_range_full, fmt->orientation };
+    KEY_PUT(ms, colors);
+}
+
+static int KeyClose(spu_cache_key_t *key, struct vlc_memstream *ms)
+{
+    key->has_pixels = false;
+    if (vlc_memstream_close(ms)) {
+        key->data = NULL;
+        key->size = 0;
+        return VLC_ENOMEM;
+    }
+    key->data = ms->ptr;
+    key->size = ms->length;
+    key->hash = Hash(HASH_SEED, key->data, key->size);
+    return VLC_SUCCESS;
+}
+
+void spu_cache_KeyClean(spu_cache_key_t *key)
+{
+    free(key->data);
+    key->data = NULL;
+}
+
+int spu_cache_TextKey(spu_cache_key_t *key, const subpicture_region_t *region,
+                      const video_format_t *renderer_fmt,
+                      const vlc_fourcc_t *chroma_list, int text_scale)
+{
+    struct vlc_memstream ms;
+
+    if (vlc_memstream_open(&ms))
+        return VLC_ENOMEM;
+
+    vlc_memstream_putc(&ms, 'T');
+    for (const text_segment_t *s = region->p_text; s; s = s->p_next) {
+        vlc_memstream_putc(&ms, 's');
+        KeyPutString(&ms, s->psz_text);
+        KeyPutStyle(&ms, s->style);
+        for (const text_segment_ruby_t *r = s->p_ruby; r; r = r->p_next) {
+            vlc_memstream_putc(&ms, 'r');
+            KeyPutString(&ms, r->psz_base);
+            KeyPutString(&ms, r->psz_rt);
+        }
+    }
+    vlc_memstream_putc(&ms, 0);
+
+    int params[] = {
+        region->i_x, region->i_y, region->i_align, region->i_text_align,
+        region->b_noregionbg, region->b_gridmode, region->b_balanced_text,
+        region->i_max_width, region->i_max_height, text_scale,
+    };
+    KEY_PUT(&ms, params);
+    KeyPutFormat(&ms, &region->fmt);
+    KeyPutFormat(&ms, renderer_fmt);
+    for (const vlc_fourcc_t *c = chroma_list; *c; c++)
+        KEY_PUT(&ms, *c);
+
+    return KeyClose(key, &ms);
+}
+
+int spu_cache_ScaleKey(spu_cache_key_t *key, const video_format_t *fmt,
+                       unsigned dst_width, unsigned dst_height,
+                       vlc_fourcc_t dst_chroma)
+{
+    struct vlc_memstream ms;
+
+    /* The pixels are compared over the visible planes only */
+    if (fmt->i_x_offset || fmt->i_y_offset)
+        return VLC_EGENERIC;
+
+    if (vlc_memstream_open(&ms))
+        return VLC_ENOMEM;
+
+    vlc_memstream_putc(&ms, 'S');
+    KeyPutFormat(&ms, fmt);
+    if (fmt->p_palette)
+        vlc_memstream_write(&ms, fmt->p_palette, sizeof(*fmt->p_palette));
+    KEY_PUT(&ms, dst_width);
+    KEY_PUT(&ms, dst_height);
+    KEY_PUT(&ms, dst_chroma);
+
+    return KeyClose(key, &ms);
+}
+
+/*****************************************************************************
+ * Entries
+ *****************************************************************************/
+static void EntryDelete(spu_cache_t *cache, spu_cache_entry_t *entry)
+{
+    vlc_list_remove(&entry->node);
+    cache->size -= entry->cost;
+
+    if (entry->is_text)
+        video_format_Clean(&entry->fmt);
+    if (entry->source)
+        picture_Release(entry->source);
+    picture_Release(entry->picture);
+    free(entry->key);
+    free(entry);
+}
+
+static spu_cache_entry_t *EntryFind(spu_cache_t *cache,
+                                    const spu_cache_key_t *key,
+                                    spu_cache_entry_t *from)
+{
+    spu_cache_entry_t *entry = from
+        ? vlc_list_next_entry_or_null(&cache->entries, from, spu_cache_entry_t, node)
+        : vlc_list_first_entry_or_null(&cache->entries, spu_cache_entry_t, node);
+
+    for (; entry; entry = vlc_list_next_entry_or_null(&cache->entries, entry,
+                                                      spu_cache_entry_t, node)) {
+        if (entry->hash == key->hash && entry->key_size == key->size &&
+            !memcmp(entry->key, key->data, key->size))
+            return entry;
+    }
+    return NULL;
+}
+
+static void EntryUse(spu_cache_t *cache, spu_cache_entry_t *entry)
+{
+    vlc_list_remove(&entry->node);
+    vlc_list_prepend(&entry->node, &cache->entries);
+}
+
+static void EntryAdd(spu_cache_t *cache, spu_cache_entry_t *entry,
+                     spu_cache_key_t *key)
+{
+    entry->hash     = key->hash;
+    entry->key      = key->data;
+    entry->key_size = key->size;
+    key->data = NULL;
+
+    while (cache->size + entry->cost > cache->max_size) {
+        spu_cache_entry_t *last =
+            vlc_list_last_entry_or_null(&cache->entries, spu_cache_entry_t, node);
+        assert(last);
+        EntryDelete(cache, last);
+        cache->evictions++;
+    }
+
+    vlc_list_prepend(&entry->node, &cache->entries);
+    cache->size += entry->cost;
+}
+
+/*****************************************************************************
+ * Public functions
+ *****************************************************************************/
+spu_cache_t *spu_cache_New(vlc_object_t *obj, size_t max_size)
+{
+    if (max_size == 0)
+        return NULL;
+
+    spu_cache_t *cache = malloc(sizeof(*cache));
+    if (!cache)
+        return NULL;
+
+    cache->obj      = obj;
+    cache->size     = 0;
+    cache->max_size = max_size;
+    cache->text.hits    = cache->text.misses  = 0;
+    cache->scale.hits   = cache->scale.misses = 0;
+    cache->evictions    = 0;
+    vlc_list_init(&cache->entries);
+    return cache;
+}
+
+void spu_cache_Delete(spu_cache_t *cache)
+{
+    spu_cache_entry_t *entry;
+
+    msg_Dbg(cache->obj, "render cache: text %u/%u hits, scale %u/%u hits, "
+            "%u evictions, %zu KiB used",
+            cache->text.hits, cache->text.hits + cache->text.misses,
+            cache->scale.hits, cache->scale.hits + cache->scale.misses,
+            cache->evictions, cache->size / 1024);
+
+    vlc_list_foreach(entry, &cache->entries, node)
+        EntryDelete(cache, entry);
+    free(cache);
+}
+
+bool spu_cache_GetText(spu_cache_t *cache, const spu_cache_key_t *key,
+                       subpicture_region_t *region)
+{
+    spu_cache_entry_t *entry = EntryFind(cache, key, NULL);
+    if (!entry) {
+        cache->text.misses++;
+        return false;
+    }
+    assert(entry->is_text);
+
+    video_format_t fmt;
+    if (video_format_Copy(&fmt, &entry->fmt))
+        return false;
+
+    video_format_Clean(&region->fmt);
+    region->fmt = fmt;
+    if (region->p_picture)
+        picture_Release(region->p_picture);
+    region->p_picture = picture_Hold(entry->picture);
+    region->i_x = entry->x;
+    region->i_y = entry->y;
+
+    EntryUse(cache, entry);
+    cache->text.hits++;
+    return true;
+}
+
+void spu_cache_PutText(spu_cache_t *cache, spu_cache_key_t *key,
+                       const subpicture_region_t *region)
+{
+    if (!region->p_picture)
+        return;
+
+    spu_cache_entry_t *entry = malloc(sizeof(*entry));
+    if (!entry)
+        return;
+
+    if (video_format_Copy(&entry->fmt, &region->fmt)) {
+        free(entry);
+        return;
+    }
+    entry->cost    = PictureCost(region->p_picture) + key->size;
+    if (entry->cost > cache->max_size) {
+        video_format_Clean(&entry->fmt);
+        free(entry);
+        return;
+    }
+    entry->is_text = true;
+    entry->picture = picture_Hold(region->p_picture);
+    entry->x       = region->i_x;
+    entry->y       = region->i_y;
+    entry->source  = NULL;
+
+    EntryAdd(cache, entry, key);
+}
+
+picture_t *spu_cache_GetScaled(spu_cache_t *cache, spu_cache_key_t *key,
+                               picture_t *source)
+{
+    for (spu_cache_entry_t *entry = EntryFind(cache, key, NULL);
+         entry; entry = EntryFind(cache, key, entry)) {
+        assert(!entry->is_text);
+
+        /* Same picture object: no need to look at the pixels */
+        if (entry->source != source) {
+            if (!key->has_pixels) {
+                key->pixels_hash = HashPixels(source);
+                key->has_pixels = true;
+            }
+            if (entry->pixels_hash != key->pixels_hash ||
+                !SamePixels(entry->source, source))
+                continue;
+        }
+
+        EntryUse(cache, entry);
+        cache->scale.hits++;
+        return picture_Hold(entry->picture);
+    }
+    cache->scale.misses++;
+    return NULL;
+}
+
+void spu_cache_PutScaled(spu_cache_t *cache, spu_cache_key_t *key,
+                         picture_t *source, picture_t *scaled)
+{
+    spu_cache_entry_t *entry = malloc(sizeof(*entry));
+    if (!entry)
+        return;
+
+    entry->cost = PictureCost(scaled) + PictureCost(source) + key->size;
+    if (entry->cost > cache->max_size) {
+        free(entry);
+        return;
+    }
+    if (!key->has_pixels) {
+        key->pixels_hash = HashPixels(source);
+        key->has_pixels = true;
+    }
+    entry->is_text     = false;
+    entry->picture     = picture_Hold(scaled);
+    entry->source      = picture_Hold(source);
+    entry->pixels_hash = key->pixels_hash;
+
+    EntryAdd(cache, entry, key);
+}
@@ -0,0 +1,99 @@
+/*****************************************************************************
+ * spu_cache.h : subpicture render cache
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_VOUT_INTERNAL_SPU_CACHE_H
+#define LIBVLC_VOUT_INTERNAL_SPU_CACHE_H
+
+#include <vlc_picture.h>
+#include <vlc_subpicture.h>
+
+/**
+ * The SPU cache keeps the result of text rendering and of region
+ * conversion/scaling across subpictures, so that regions with the same
+ * content and output size are not rendered again (repeated subtitles,
+ * regions recreated by an updater, vout resized back and forth).
+ *
+ * Entries are evicted in least recently used order once the memory limit is
+ * reached. The cache is not thread-safe: the SPU lock protects it.
+ */
+typedef struct spu_cache_t spu_cache_t;
+
+typedef struct {
+    char     *data;          /**< serialized key */
+    size_t   size;
+    uint64_t hash;           /**< hash of the serialized key */
+    bool     has_pixels;     /**< pixels_hash is valid (scale keys only) */
+    uint64_t pixels_hash;
+} spu_cache_key_t;
+
+/**
+ * Creates a cache using at most max_size bytes of pictures.
+ *
+ * It returns NULL if max_size is 0 (the cache is disabled) or on error.
+ */
+spu_cache_t *spu_cache_New(vlc_object_t *, size_t max_size);
+void spu_cache_Delete(spu_cache_t *);
+
+void spu_cache_KeyClean(spu_cache_key_t *);
+
+/**
+ * It builds the key of a text region to be rendered by a renderer using the
+ * given output format, chroma list and text scale.
+ */
+int spu_cache_TextKey(spu_cache_key_t *, const subpicture_region_t *,
+                      const video_format_t *renderer_fmt,
+                      const vlc_fourcc_t *chroma_list, int text_scale);
+
+/**
+ * It replaces the text of the region by a previously rendered picture.
+ *
+ * \return true on hit, false if the region was left untouched
+ */
+bool spu_cache_GetText(spu_cache_t *, const spu_cache_key_t *,
+                       subpicture_region_t *);
+
+/**
+ * It stores the rendered region. The key data is consumed.
+ */
+void spu_cache_PutText(spu_cache_t *, spu_cache_key_t *,
+                       const subpicture_region_t *);
+
+/**
+ * It builds the key of a region picture converted and scaled to the given
+ * size and chroma.
+ */
+int spu_cache_ScaleKey(spu_cache_key_t *, const video_format_t *,
+                       unsigned dst_width, unsigned dst_height,
+                       vlc_fourcc_t dst_chroma);
+
+/**
+ * It returns a held scaled picture with the same pixels as the source, or
+ * NULL.
+ */
+picture_t *spu_cache_GetScaled(spu_cache_t *, spu_cache_key_t *,
+                               picture_t *source);
+
+/**
+ * It stores a scaled picture. The key data is consumed.
+ */
+void spu_cache_PutScaled(spu_cache_t *, spu_cache_key_t *,
+                         picture_t *source, picture_t *scaled);
+
+#endif
@@ -43,6 +43,7 @@
 #include "../libvlc.h"
 #include "vout_internal.h"
 #include "../misc/subpicture.h"
+#include "spu_cache.h"
 
 /*****************************************************************************
  * Local prototypes
@@ -71,6 +72,7 @@ struct spu_private_t {
     filter_t *text;                              /**< text renderer module */
     filter_t *scale_yuvp;                     /**< scaling module for YUVP */
     filter_t *scale;                    /**< scaling module (all but YUVP) */
+    spu_cache_t *cache;                     /**< rendered/scaled pictures */
     bool force_crop;                     /**< force cropping of subpicture */
     struct {
         int x;
@@ -282,9 +284,33 @@ static void SpuRenderText(spu_t *spu, bool *rerender_text,
     var_SetInteger(text, "spu-elapsed", elapsed_time);
     var_SetBool(text, "text-rerender", false);
 
-    if ( region->p_text )
-        text->pf_render(text, region, region, chroma_list);
+    if (!region->p_text) {
+        *rerender_text = var_GetBool(text, "text-rerender");
+        return;
+    }
+
+    /* Reuse an earlier rendering of the same text at the same size */
+    spu_cache_t *cache = spu->p->cache;
+    spu_cache_key_t key;
+    if (cache && spu_cache_TextKey(&key, region, &text->fmt_out.video,
+                                   chroma_list,
+                                   var_InheritInteger(text, "sub-text-scale")))
+        cache = NULL;
+
+    if (cache && spu_cache_GetText(cache, &key, region)) {
+        spu_cache_KeyClean(&key);
+        return;
+    }
+
+    text->pf_render(text, region, region, chroma_list);
     *rerender_text = var_GetBool(text, "text-rerender");
+
+    if (cache) {
+        /* Time-dependent renderings cannot be reused */
+        if (!*rerender_text && region->fmt.i_chroma != VLC_CODEC_TEXT)
+            spu_cache_PutText(cache, &key, region);
+        spu_cache_KeyClean(&key);
+    }
 }
 
 /**
@@ -833,11 +859,24 @@ static void SpuRenderRegion(spu_t *spu,
         if (!region->p_private && dst_width > 0 && dst_height > 0) {
             filter_t *scale = sys->scale;
 
-            picture_t *picture = region->p_picture;
-            picture_Hold(picture);
+            /* Look for the same pixels already scaled to this size */
+            spu_cache_t *cache = sys->cache;
+            spu_cache_key_t key;
+            if (cache && spu_cache_ScaleKey(&key, &region->fmt,
+                                            dst_width, dst_height,
+                                            using_palette || convert_chroma ?
+                                            chroma_list[0] : region->fmt.i_chroma))
+                cache = NULL;
+
+            picture_t *picture = NULL;
+            if (cache)
+                picture = spu_cache_GetScaled(cache, &key, region->p_picture);
+            const bool is_cached = picture != NULL;
+            if (!is_cached)
+                picture = picture_Hold(region->p_picture);
 
             /* Convert YUVP to YUVA/RGBA first for better scaling quality */
-            if (using_palette) {
+            if (!is_cached && using_palette) {
                 filter_t *scale_yuvp = sys->scale_yuvp;
 
                 scale_yuvp->fmt_in.video = region->fmt;
@@ -855,7 +894,7 @@ static void SpuRenderRegion(spu_t *spu,
             }
 
             /* Conversion(except from YUVP)/Scaling */
-            if (picture &&
+            if (!is_cached && picture &&
                 (picture->format.i_visible_width  != dst_width ||
                  picture->format.i_visible_height != dst_height ||
                  (convert_chroma && !using_palette)))
@@ -881,6 +920,12 @@ static void SpuRenderRegion(spu_t *spu,
                     msg_Err(spu, "scaling failed");
             }
 
+            if (cache) {
+                if (!is_cached && picture && picture != region->p_picture)
+                    spu_cache_PutScaled(cache, &key, region->p_picture, picture);
+                spu_cache_KeyClean(&key);
+            }
+
             /* */
             if (picture) {
                 region->p_private = subpicture_region_private_New(&picture->format);
@@ -1308,6 +1353,8 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     sys->scale_yuvp = NULL;
 
     sys->margin = var_InheritInteger(spu, "sub-margin");
+    sys->cache = spu_cache_New(VLC_OBJECT(spu),
+                               (size_t)var_InheritInteger(spu, "sub-cache-size") << 20);
 
     /* Register the default subpicture channel */
     sys->channel = VOUT_SPU_CHANNEL_AVAIL_FIRST;
@@ -1357,6 +1404,9 @@ void spu_Destroy(spu_t *spu)
     if (sys->scale)
         FilterRelease(sys->scale);
 
+    if (sys->cache)
+        spu_cache_Delete(sys->cache);
+
     filter_chain_ForEach(sys->source_chain, SubSourceClean, spu);
     if (sys->vout)
         filter_chain_ForEach(sys->source_chain,
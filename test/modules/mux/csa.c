@@ -0,0 +1,135 @@
+/*****************************************************************************
+ * csa.c: test of the batched CSA scrambling and descrambling
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <vlc_common.h>
+
+/* No object to log the keys with */
+#define TS_NO_CSA_CK_MSG
+#include "../../../modules/mux/mpeg/csa.c"
+
+const char vlc_module_name[] = "test_csa";
+
+/*
+ * Checks csa_EncryptBatch() and csa_DecryptBatch() against csa_Encrypt() and
+ * csa_Decrypt() called on each packet, for batch sizes going through the
+ * per-packet fallback and each bitsliced engine, with both keys, adaptation
+ * fields of all sizes and partially scrambled packets.
+ */
+
+#define PACKETS 300
+
+static uint8_t orig[PACKETS][188];
+static uint8_t ref[PACKETS][188];
+static uint8_t test[PACKETS][188];
+
+static unsigned seed = 1;
+
+static uint8_t rand8( void )
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+static void fill_packets( unsigned i_pkts )
+{
+    for( unsigned i = 0; i < i_pkts; i++ )
+    {
+        uint8_t *p = orig[i];
+
+        for( unsigned j = 0; j < 188; j++ )
+            p[j] = rand8();
+        p[0] = 0x47;
+        p[1] &= 0x1f;
+        p[3] = 0x10 | (i & 0x0f);
+        if( i % 3 == 0 )
+        {
+            /* up to adaptation field only */
+            p[3] |= 0x20;
+            p[4] = rand8() % 184;
+        }
+    }
+}
+
+static void check_batch( csa_t *c, unsigned i_pkts, int i_pkt_size )
+{
+    uint8_t *pp_pkt[PACKETS];
+
+    for( unsigned i = 0; i < PACKETS; i++ )
+        pp_pkt[i] = test[i];
+    fill_packets( i_pkts );
+    memcpy( ref, orig, sizeof(ref) );
+    memcpy( test, orig, sizeof(test) );
+
+    for( unsigned i = 0; i < i_pkts; i++ )
+        csa_Encrypt( c, ref[i], i_pkt_size );
+    csa_EncryptBatch( c, pp_pkt, i_pkts, i_pkt_size );
+    assert( !memcmp( ref, test, sizeof(ref) ) );
+
+    /* Leave a few packets in the clear */
+    for( unsigned i = 0; i < i_pkts; i += 7 )
+    {
+        memcpy( ref[i], orig[i], 188 );
+        memcpy( test[i], orig[i], 188 );
+    }
+
+    for( unsigned i = 0; i < i_pkts; i++ )
+        csa_Decrypt( c, ref[i], i_pkt_size );
+    csa_DecryptBatch( c, pp_pkt, i_pkts, i_pkt_size );
+    assert( !memcmp( ref, test, sizeof(ref) ) );
+    assert( !memcmp( orig, test, sizeof(orig) ) );
+}
+
+int main( void )
+{
+    static const unsigned counts[] = {
+        1, 2, 15, 16, 17, 64, 65, 128, 129, 200, 256, 257, 271, PACKETS,
+    };
+    csa_t *c = csa_New();
+    char odd[] = "0x0123456789abcdef", even[] = "fedcba9876543210";
+
+    assert( c != NULL );
+    assert( csa_SetCW( NULL, c, odd, true ) == VLC_SUCCESS );
+    assert( csa_SetCW( NULL, c, even, false ) == VLC_SUCCESS );
+
+    for( unsigned k = 0; k < 2; k++ )
+    {
+        csa_UseKey( NULL, c, k );
+        for( size_t i = 0; i < ARRAY_SIZE(counts); i++ )
+        {
+            printf( "%s key, %u packets\n", k ? "odd" : "even", counts[i] );
+            check_batch( c, counts[i], 188 );
+            check_batch( c, counts[i], 100 );
+        }
+    }
+
+    csa_Delete( c );
+    return 0;
+}
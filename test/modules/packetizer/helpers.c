@@ -90,6 +90,71 @@ static int run_annexb_sets( const uint8_t *p_set, const uint8_t *p_end,
     return 0;
 }
 
+static int run_bytestream_chain( void )
+{
+    /* Compares the chains of block_GetChain() with the bytes of
+     * block_GetBytes() over blocks of various sizes */
+    static const size_t sizes[] = { 7, 1, 64, 3, 200, 13, 1, 48 };
+    static const size_t reads[] = { 3, 4, 1, 60, 5, 100, 1, 150, 2, 11, 1 };
+    block_bytestream_t chain, bytes;
+    uint8_t val = 0;
+
+    block_BytestreamInit( &chain );
+    block_BytestreamInit( &bytes );
+
+    for( size_t i = 0; i < ARRAY_SIZE(sizes); i++ )
+    {
+        block_t *p_a = block_Alloc( sizes[i] );
+        block_t *p_b = block_Alloc( sizes[i] );
+        assert( p_a && p_b );
+        for( size_t j = 0; j < sizes[i]; j++ )
+            p_a->p_buffer[j] = p_b->p_buffer[j] = val++;
+        block_BytestreamPush( &chain, p_a );
+        block_BytestreamPush( &bytes, p_b );
+    }
+
+    block_t *p_slices = NULL;
+    block_t **pp_slices_last = &p_slices;
+    for( size_t i = 0; i < ARRAY_SIZE(reads); i++ )
+    {
+        uint8_t buf[512];
+        printf("- chain read %zu bytes\n", reads[i]);
+
+        block_t *p_got = block_GetChain( &chain, reads[i] );
+        if( block_GetBytes( &bytes, buf, reads[i] ) )
+        {
+            assert( p_got == NULL );
+            break;
+        }
+        assert( p_got != NULL );
+
+        size_t i_got;
+        block_ChainProperties( p_got, NULL, &i_got, NULL );
+        assert( i_got == reads[i] );
+        block_ChainExtract( p_got, &buf[reads[i]], reads[i] );
+        if( memcmp( buf, &buf[reads[i]], reads[i] ) )
+            return 1;
+        assert( block_BytestreamRemaining( &chain ) ==
+                block_BytestreamRemaining( &bytes ) );
+
+        /* Flushing must not release the referenced data */
+        block_BytestreamFlush( &chain );
+        block_BytestreamFlush( &bytes );
+        block_ChainLastAppend( &pp_slices_last, p_got );
+    }
+
+    block_BytestreamRelease( &chain );
+    block_BytestreamRelease( &bytes );
+
+    val = 0;
+    for( const block_t *p = p_slices; p != NULL; p = p->p_next )
+        for( size_t j = 0; j < p->i_buffer; j++ )
+            if( p->p_buffer[j] != val++ )
+                return 1;
+    block_ChainRelease( p_slices );
+    return 0;
+}
+
 int main( void )
 {
     const uint8_t test1_annexbdata[] = { 0, 0, 0, 1, 0x55, 0x55, 0x55, 0x55, 0x55, // 9
@@ -134,5 +199,6 @@ int main( void )
             return i_ret;
     }
 
-    return 0;
+    printf("* Running byte stream chain tests:\n");
+    return run_bytestream_chain();
 }
@@ -0,0 +1,330 @@
+/*****************************************************************************
+ * freetype.c: test and benchmark of the freetype text renderer
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_filter.h>
+#include <vlc_subpicture.h>
+#include <vlc_text_style.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/*
+ * Renders subtitles with and without the glyph cache, checks that the
+ * pictures are identical and prints the throughput.
+ *
+ * Benchmark on a SRT file:
+ * $ cd vlc/build-<name>/test
+ * $ make test_modules_text_renderer_freetype
+ * $ ./test_modules_text_renderer_freetype file.srt [passes]
+ */
+
+static const char *const words[] = {
+    "the", "subtitles", "are", "rendered", "again", "with", "some", "longer",
+    "words", "and", "a", "few", "accents:", "été", "déjà", "naïve", "über",
+    "outline", "shadow", "italic", "text", "on", "two", "lines",
+};
+
+typedef struct
+{
+    char   **ppsz_cues;
+    size_t   i_count;
+} cues_t;
+
+static void cues_Add(cues_t *cues, const char *psz_text)
+{
+    char **pp = realloc(cues->ppsz_cues,
+                        (cues->i_count + 1) * sizeof (*cues->ppsz_cues));
+    assert(pp != NULL);
+    cues->ppsz_cues = pp;
+    cues->ppsz_cues[cues->i_count] = strdup(psz_text);
+    assert(cues->ppsz_cues[cues->i_count] != NULL);
+    cues->i_count++;
+}
+
+static void cues_Generate(cues_t *cues, size_t i_count)
+{
+    unsigned i_seed = 1;
+
+    for (size_t i = 0; i < i_count; i++)
+    {
+        char psz_text[256] = "";
+        unsigned i_words = 4 + i % 9;
+
+        for (unsigned j = 0; j < i_words; j++)
+        {
+            i_seed = i_seed * 1103515245 + 12345;
+            strcat(psz_text, words[(i_seed >> 16) % ARRAY_SIZE(words)]);
+            strcat(psz_text, j == i_words / 2 && i % 3 == 0 ? "\n" : " ");
+        }
+        cues_Add(cues, psz_text);
+    }
+}
+
+/* Reads the text of the cues of a SRT file, ignoring the markup */
+static void cues_Load(cues_t *cues, const char *psz_path)
+{
+    FILE *file = fopen(psz_path, "r");
+    assert(file != NULL);
+
+    char psz_line[1024];
+    char *psz_text = NULL;
+    size_t i_text = 0;
+    int i_state = 0; /* 0: index, 1: timing, 2: text */
+
+    while (fgets(psz_line, sizeof (psz_line), file))
+    {
+        psz_line[strcspn(psz_line, "\r\n")] = '\0';
+
+        if (psz_line[0] == '\0')
+        {
+            if (i_text > 0)
+                cues_Add(cues, psz_text);
+            i_text = 0;
+            i_state = 0;
+            continue;
+        }
+
+        if (i_state < 2)
+        {
+            if (strstr(psz_line, "-->"))
+                i_state = 2;
+            continue;
+        }
+
+        size_t i_line = strlen(psz_line);
+        psz_text = realloc(psz_text, i_text + i_line + 2);
+        assert(psz_text != NULL);
+        if (i_text > 0)
+            psz_text[i_text++] = '\n';
+        memcpy(&psz_text[i_text], psz_line, i_line + 1);
+        i_text += i_line;
+    }
+    if (i_text > 0)
+        cues_Add(cues, psz_text);
+
+    free(psz_text);
+    fclose(file);
+}
+
+static filter_t *renderer_New(vlc_object_t *obj, int i_cache_size)
+{
+    filter_t *text = vlc_object_create(obj, sizeof (*text));
+    assert(text != NULL);
+
+    es_format_Init(&text->fmt_in, VIDEO_ES, 0);
+    es_format_Init(&text->fmt_out, VIDEO_ES, 0);
+    text->fmt_out.video.i_width  = text->fmt_out.video.i_visible_width  = 1920;
+    text->fmt_out.video.i_height = text->fmt_out.video.i_visible_height = 1080;
+
+    var_Create(text, "spu-elapsed", VLC_VAR_INTEGER);
+    var_Create(text, "text-rerender", VLC_VAR_BOOL);
+    var_Create(text, "freetype-cache-size", VLC_VAR_INTEGER);
+    var_SetInteger(text, "freetype-cache-size", i_cache_size);
+
+    text->p_module = module_need(text, "text renderer", "freetype", true);
+    if (text->p_module == NULL)
+    {
+        vlc_object_release(text);
+        return NULL;
+    }
+    return text;
+}
+
+static void renderer_Delete(filter_t *text)
+{
+    module_unneed(text, text->p_module);
+    es_format_Clean(&text->fmt_in);
+    es_format_Clean(&text->fmt_out);
+    vlc_object_release(text);
+}
+
+static uint64_t Checksum(const subpicture_region_t *region)
+{
+    uint64_t i_sum = 14695981039346656037ULL;
+    const picture_t *pic = region->p_picture;
+
+    if (pic == NULL)
+        return 0;
+
+    for (int i = 0; i < pic->i_planes; i++)
+        for (int y = 0; y < pic->p[i].i_visible_lines; y++)
+        {
+            const uint8_t *p = &pic->p[i].p_pixels[y * pic->p[i].i_pitch];
+            for (int x = 0; x < pic->p[i].i_visible_pitch; x++)
+                i_sum = (i_sum ^ p[x]) * 1099511628211ULL;
+        }
+    return i_sum ^ ((uint64_t)region->i_x << 32) ^ region->i_y;
+}
+
+static uint64_t Render(filter_t *text, const char *psz_text, size_t i_cue)
+{
+    static const vlc_fourcc_t chroma_list[] = { VLC_CODEC_YUVA, 0 };
+
+    video_format_t fmt;
+    video_format_Init(&fmt, VLC_CODEC_TEXT);
+    subpicture_region_t *region = subpicture_region_New(&fmt);
+    assert(region != NULL);
+
+    /* One cue out of two has a styled second segment */
+    const char *psz_split = strchr(psz_text, ' ');
+    if (psz_split == NULL || i_cue % 2)
+        region->p_text = text_segment_New(psz_text);
+    else
+    {
+        char *psz_first = strndup(psz_text, psz_split - psz_text);
+        assert(psz_first != NULL);
+        region->p_text = text_segment_New(psz_first);
+        free(psz_first);
+
+        text_segment_t *second = text_segment_New(psz_split);
+        assert(second != NULL);
+        second->style = text_style_Create(STYLE_NO_DEFAULTS);
+        assert(second->style != NULL);
+        second->style->i_features |= STYLE_HAS_FLAGS;
+        second->style->i_style_flags |= STYLE_ITALIC | STYLE_BOLD;
+        region->p_text->p_next = second;
+    }
+    assert(region->p_text != NULL);
+    region->i_align = SUBPICTURE_ALIGN_BOTTOM;
+    region->i_text_align = SUBPICTURE_ALIGN_BOTTOM;
+
+    assert(text->pf_render(text, region, region, chroma_list) == VLC_SUCCESS);
+
+    uint64_t i_sum = Checksum(region);
+    subpicture_region_Delete(region);
+    return i_sum;
+}
+
+static mtime_t RenderAll(filter_t *text, const cues_t *cues, uint64_t *pi_sums,
+                         bool b_check)
+{
+    mtime_t i_start = mdate();
+
+    for (size_t i = 0; i < cues->i_count; i++)
+    {
+        uint64_t i_sum = Render(text, cues->ppsz_cues[i], i);
+        if (b_check)
+            assert(pi_sums[i] == i_sum);
+        else
+            pi_sums[i] = i_sum;
+    }
+    return mdate() - i_start;
+}
+
+static void Report(const char *psz_name, const cues_t *cues,
+                   unsigned i_passes, mtime_t i_duration)
+{
+    size_t i_cues = cues->i_count * i_passes;
+
+    printf("%-24s %7zu cues %8.1f us/cue %8.0f cues/s\n", psz_name, i_cues,
+           (double)i_duration / i_cues,
+           i_duration > 0 ? (double)CLOCK_FREQ * i_cues / i_duration : 0.);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *psz_srt = argc > 1 ? argv[1] : NULL;
+    unsigned i_passes = argc > 2 ? strtoul(argv[2], NULL, 10) : 3;
+
+    if (psz_srt == NULL)
+        alarm(10);
+    if (i_passes == 0)
+        i_passes = 1;
+
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    static const char *const args[] = { "--ignore-config", "--quiet" };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    if (!module_exists("freetype"))
+    {
+        printf("freetype module not found, skipping\n");
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    cues_t cues = { NULL, 0 };
+    if (psz_srt != NULL)
+        cues_Load(&cues, psz_srt);
+    else
+        cues_Generate(&cues, 60);
+    assert(cues.i_count > 0);
+
+    uint64_t *pi_sums = calloc(cues.i_count, sizeof (*pi_sums));
+    assert(pi_sums != NULL);
+
+    /* Reference rendering, without cache */
+    filter_t *text = renderer_New(obj, 0);
+    if (text == NULL)
+    {
+        printf("no usable font, skipping\n");
+        free(pi_sums);
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    mtime_t i_duration = RenderAll(text, &cues, pi_sums, false);
+    for (unsigned i = 1; i < i_passes; i++)
+        i_duration += RenderAll(text, &cues, pi_sums, true);
+    Report("no cache", &cues, i_passes, i_duration);
+    renderer_Delete(text);
+
+    /* With the cache: the first pass fills it */
+    text = renderer_New(obj, 4096);
+    assert(text != NULL);
+
+    i_duration = RenderAll(text, &cues, pi_sums, true);
+    Report("cache, first pass", &cues, 1, i_duration);
+
+    i_duration = 0;
+    for (unsigned i = 1; i < i_passes; i++)
+        i_duration += RenderAll(text, &cues, pi_sums, true);
+    if (i_passes > 1)
+        Report("cache, next passes", &cues, i_passes - 1, i_duration);
+    renderer_Delete(text);
+
+    /* With a cache too small to hold the glyphs of a pass */
+    text = renderer_New(obj, 64);
+    assert(text != NULL);
+    i_duration = RenderAll(text, &cues, pi_sums, true);
+    Report("small cache", &cues, 1, i_duration);
+    renderer_Delete(text);
+
+    for (size_t i = 0; i < cues.i_count; i++)
+        free(cues.ppsz_cues[i]);
+    free(cues.ppsz_cues);
+    free(pi_sums);
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,390 @@
+/*****************************************************************************
+ * deinterlace.c: test and benchmark of the deinterlace filter
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <vlc/vlc.h>
+
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+#include <vlc_cpu.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+/*
+ * Checks the vectorised Yadif line filters against the generic one, then
+ * runs all the deinterlace modes on synthetic interlaced frames, with one
+ * and several filter threads, checks that the outputs are identical and
+ * prints the throughput.
+ *
+ * Benchmark on 2160i frames:
+ * $ cd vlc/build-<name>/test
+ * $ make test_modules_video_filter_deinterlace
+ * $ ./test_modules_video_filter_deinterlace 2160 [frames] [threads]
+ */
+
+#include "../../../modules/video_filter/deinterlace/common.h"
+#include "../../../modules/video_filter/deinterlace/yadif.h"
+#ifdef CAN_COMPILE_MMX
+# include "../../../modules/video_filter/deinterlace/mmx.h"
+#endif
+
+typedef void (*yadif_filter_line_t)(uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                                    uint8_t *next, int w, int prefs, int mrefs,
+                                    int parity, int mode);
+
+static unsigned seed = 1;
+
+static unsigned Random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+#define LINE_WIDTH   1003 /* not a multiple of the vector sizes */
+#define LINE_MARGIN  16
+#define LINE_STRIDE  (LINE_WIDTH + 2 * LINE_MARGIN)
+
+/* Runs a line filter on the middle line of 5 lines of 3 pictures */
+static void FilterLine(yadif_filter_line_t filter, uint8_t *dst,
+                       uint8_t *const src[3], size_t pixel_size,
+                       int parity, int mode, bool edge)
+{
+    const size_t offset = (2 * LINE_STRIDE + LINE_MARGIN) * pixel_size;
+    const int stride = LINE_STRIDE * pixel_size;
+
+    filter(dst, src[0] + offset, src[1] + offset, src[2] + offset,
+           LINE_WIDTH, edge ? -stride : stride, -stride, parity, mode);
+}
+
+static void CheckLineFilter(const char *name, yadif_filter_line_t ref,
+                            yadif_filter_line_t filter, size_t pixel_size,
+                            unsigned max)
+{
+    const size_t size = 5 * LINE_STRIDE * pixel_size;
+    uint8_t *src[3], dst_ref[LINE_WIDTH * 2], dst[LINE_WIDTH * 2];
+
+    for (int i = 0; i < 3; i++) {
+        src[i] = malloc(size);
+        assert(src[i] != NULL);
+    }
+
+    for (unsigned pass = 0; pass < 64; pass++) {
+        /* Noise, then smooth pictures with a little noise */
+        for (int i = 0; i < 3; i++)
+            for (size_t j = 0; j < size / pixel_size; j++) {
+                unsigned v = pass < 32 ? Random()
+                           : j * 7 + i * 50 + pass + Random() % 8;
+                v %= max + 1;
+                if (pixel_size == 2)
+                    ((uint16_t *)src[i])[j] = v;
+                else
+                    src[i][j] = v;
+            }
+
+        const int parity = pass % 2;
+        const int mode = pass % 4 < 2 ? 0 : 2;
+        const bool edge = pass % 8 >= 6;
+
+        FilterLine(ref, dst_ref, src, pixel_size, parity, mode, edge);
+        FilterLine(filter, dst, src, pixel_size, parity, mode, edge);
+        if (memcmp(dst_ref, dst, LINE_WIDTH * pixel_size)) {
+            fprintf(stderr, "%s: mismatch at pass %u\n", name, pass);
+            abort();
+        }
+    }
+
+    for (int i = 0; i < 3; i++)
+        free(src[i]);
+    printf("%-24s matches the generic filter\n", name);
+}
+
+static void CheckLineFilters(void)
+{
+#if defined(HAVE_YADIF_MMX)
+    if (vlc_CPU_MMX())
+        CheckLineFilter("yadif mmx", yadif_filter_line_c,
+                        yadif_filter_line_mmx, 1, 255);
+#endif
+#if defined(HAVE_YADIF_SSE2)
+    if (vlc_CPU_SSE2())
+        CheckLineFilter("yadif sse2", yadif_filter_line_c,
+                        yadif_filter_line_sse2, 1, 255);
+#endif
+#if defined(HAVE_YADIF_SSSE3)
+    if (vlc_CPU_SSSE3())
+        CheckLineFilter("yadif ssse3", yadif_filter_line_c,
+                        yadif_filter_line_ssse3, 1, 255);
+#endif
+#if defined(HAVE_YADIF_AVX2)
+    if (vlc_CPU_AVX2())
+    {
+        CheckLineFilter("yadif avx2", yadif_filter_line_c,
+                        yadif_filter_line_avx2, 1, 255);
+        CheckLineFilter("yadif avx2 10 bits", yadif_filter_line_c_16bit,
+                        yadif_filter_line_avx2_16bit, 2, 1023);
+        CheckLineFilter("yadif avx2 16 bits", yadif_filter_line_c_16bit,
+                        yadif_filter_line_avx2_16bit, 2, 65535);
+    }
+#endif
+#if defined(HAVE_YADIF_MMX)
+    if (vlc_CPU_MMX())
+        emms();
+#endif
+}
+
+static picture_t *BufferNew(filter_t *filter)
+{
+    return picture_NewFromFormat(&filter->fmt_out.video);
+}
+
+static const struct filter_video_callbacks buffer_cbs = { BufferNew };
+
+static filter_t *deinterlace_New(vlc_object_t *obj, const video_format_t *fmt,
+                                 const char *psz_mode)
+{
+    filter_t *filter = vlc_object_create(obj, sizeof (*filter));
+    assert(filter != NULL);
+
+    es_format_Init(&filter->fmt_in, VIDEO_ES, fmt->i_chroma);
+    filter->fmt_in.video = *fmt;
+    es_format_Copy(&filter->fmt_out, &filter->fmt_in);
+    filter->b_allow_fmt_out_change = true;
+    filter->owner.video = &buffer_cbs;
+
+    var_Create(filter, "sout-deinterlace-mode", VLC_VAR_STRING);
+    var_SetString(filter, "sout-deinterlace-mode", psz_mode);
+
+    filter->p_module = module_need(filter, "video filter", "deinterlace",
+                                   true);
+    if (filter->p_module == NULL)
+    {
+        es_format_Clean(&filter->fmt_in);
+        es_format_Clean(&filter->fmt_out);
+        vlc_object_release(filter);
+        return NULL;
+    }
+    return filter;
+}
+
+static void deinterlace_Delete(filter_t *filter)
+{
+    module_unneed(filter, filter->p_module);
+    es_format_Clean(&filter->fmt_in);
+    es_format_Clean(&filter->fmt_out);
+    vlc_object_release(filter);
+}
+
+/* Draws a frame whose fields are sampled at two different times: diagonal
+ * stripes and a box moving horizontally */
+static void DrawFrame(picture_t *pic, unsigned i_frame, unsigned max)
+{
+    for (int i = 0; i < pic->i_planes; i++) {
+        plane_t *p = &pic->p[i];
+        const int pixel_size = p->i_pixel_pitch;
+        const int width = p->i_visible_pitch / pixel_size;
+
+        for (int y = 0; y < p->i_visible_lines; y++) {
+            const int t = 2 * i_frame + (y & 1);
+            uint8_t *line = &p->p_pixels[y * p->i_pitch];
+
+            for (int x = 0; x < width; x++) {
+                int box = x - t * 12 % width;
+                unsigned v = (x + 2 * y + 3 * t + 40 * i) % 128 * 2
+                           + (box >= 0 && box < width / 8 ? 64 : 0);
+                v = v * max / 320;
+                if (pixel_size == 2)
+                    ((uint16_t *)line)[x] = v;
+                else
+                    line[x] = v;
+            }
+        }
+    }
+}
+
+static uint64_t Checksum(const picture_t *pic, uint64_t sum)
+{
+    for (int i = 0; i < pic->i_planes; i++)
+        for (int y = 0; y < pic->p[i].i_visible_lines; y++) {
+            const uint8_t *p = &pic->p[i].p_pixels[y * pic->p[i].i_pitch];
+            for (int x = 0; x < pic->p[i].i_visible_pitch; x++)
+                sum = (sum ^ p[x]) * 1099511628211ULL;
+        }
+    return sum;
+}
+
+static const struct
+{
+    const char *psz_name;
+    bool        b_high_bit_depth; /* other modes fall back to another one */
+} modes[] = {
+    { "discard", true }, { "bob", true }, { "linear", true },
+    { "mean", true }, { "blend", true }, { "yadif", true },
+    { "yadif2x", true }, { "x", false }, { "phosphor", false },
+    { "ivtc", false },
+};
+
+struct format
+{
+    vlc_fourcc_t i_chroma;
+    unsigned     i_max;
+};
+
+static const struct format formats[] = {
+    { VLC_CODEC_I420, 255 },
+    { VLC_CODEC_I420_10L, 1023 },
+};
+
+/* Runs the modes on the frames, and returns the checksums of the outputs */
+static void Run(vlc_object_t *obj, picture_t *const *frames, unsigned i_frames,
+                unsigned i_count, uint64_t *sums)
+{
+    const video_format_t *fmt = &frames[0]->format;
+    const unsigned i_threads = var_InheritInteger(obj, "filter-threads");
+
+    for (size_t m = 0; m < ARRAY_SIZE(modes); m++) {
+        filter_t *filter = NULL;
+        if (modes[m].b_high_bit_depth
+         || vlc_fourcc_GetChromaDescription(fmt->i_chroma)->pixel_size == 1)
+            filter = deinterlace_New(obj, fmt, modes[m].psz_name);
+        if (filter == NULL) {
+            sums[m] = 0;
+            continue;
+        }
+
+        uint64_t sum = 14695981039346656037ULL;
+        unsigned i_outputs = 0;
+        mtime_t i_duration = 0;
+
+        for (unsigned i = 0; i < i_count; i++) {
+            picture_t *in = picture_NewFromFormat(fmt);
+            assert(in != NULL);
+            picture_Copy(in, frames[i % i_frames]);
+            in->date = VLC_TS_0 + i * CLOCK_FREQ / 25;
+            in->b_progressive = false;
+            in->b_top_field_first = true;
+            in->i_nb_fields = 2;
+
+            mtime_t i_start = mdate();
+            picture_t *out = filter->pf_video_filter(filter, in);
+            i_duration += mdate() - i_start;
+
+            while (out != NULL) {
+                picture_t *next = out->p_next;
+                out->p_next = NULL;
+                sum = Checksum(out, sum);
+                picture_Release(out);
+                out = next;
+                i_outputs++;
+            }
+        }
+        deinterlace_Delete(filter);
+        sums[m] = sum;
+
+        printf("%4.4s %4ux%-4u %2u threads %-8s %4u frames %8.2f ms/frame "
+               "%7.1f fps\n", (const char *)&fmt->i_chroma,
+               fmt->i_visible_width, fmt->i_visible_height, i_threads,
+               modes[m].psz_name, i_outputs,
+               i_outputs ? i_duration / 1000. / i_outputs : 0.,
+               i_duration ? (double)CLOCK_FREQ * i_outputs / i_duration : 0.);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned i_height = argc > 1 ? strtoul(argv[1], NULL, 10) : 1080;
+    unsigned i_count = argc > 2 ? strtoul(argv[2], NULL, 10) : 4;
+    unsigned i_threads = argc > 3 ? strtoul(argv[3], NULL, 10) : 4;
+
+    if (argc <= 1)
+        alarm(30);
+    if (i_height < 16)
+        i_height = 1080;
+    if (i_count < 4)
+        i_count = 4;
+
+    CheckLineFilters();
+
+    setenv("VLC_PLUGIN_PATH", "../modules", 1);
+
+    char psz_threads[32];
+    snprintf(psz_threads, sizeof (psz_threads), "--filter-threads=%u",
+             i_threads);
+    const char *const args[2][3] = {
+        { "--ignore-config", "--quiet", "--filter-threads=1" },
+        { "--ignore-config", "--quiet", psz_threads },
+    };
+    libvlc_instance_t *vlc[2];
+
+    for (int t = 0; t < 2; t++) {
+        vlc[t] = libvlc_new(ARRAY_SIZE(args[t]), args[t]);
+        assert(vlc[t] != NULL);
+    }
+
+    if (!module_exists("deinterlace"))
+    {
+        printf("deinterlace module not found, skipping\n");
+        for (int t = 0; t < 2; t++)
+            libvlc_release(vlc[t]);
+        return 77;
+    }
+
+    for (size_t f = 0; f < ARRAY_SIZE(formats); f++) {
+        video_format_t fmt;
+        video_format_Init(&fmt, formats[f].i_chroma);
+        video_format_Setup(&fmt, formats[f].i_chroma, i_height * 16 / 9,
+                           i_height, i_height * 16 / 9, i_height, 1, 1);
+
+        picture_t *frames[4];
+        for (unsigned i = 0; i < ARRAY_SIZE(frames); i++) {
+            frames[i] = picture_NewFromFormat(&fmt);
+            assert(frames[i] != NULL);
+            DrawFrame(frames[i], i, formats[f].i_max);
+        }
+
+        uint64_t sums[2][ARRAY_SIZE(modes)];
+        for (int t = 0; t < 2; t++)
+            Run(VLC_OBJECT(vlc[t]->p_libvlc_int), frames, ARRAY_SIZE(frames),
+                i_count, sums[t]);
+
+        for (size_t m = 0; m < ARRAY_SIZE(modes); m++)
+            if (sums[0][m] != sums[1][m]) {
+                fprintf(stderr, "%s: the output depends on the threads\n",
+                        modes[m].psz_name);
+                abort();
+            }
+
+        for (unsigned i = 0; i < ARRAY_SIZE(frames); i++)
+            picture_Release(frames[i]);
+    }
+
+    for (int t = 0; t < 2; t++)
+        libvlc_release(vlc[t]);
+    return 0;
+}
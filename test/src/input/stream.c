@@ -31,6 +31,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef HAVE_LINUX_IO_URING_H
+# include <linux/io_uring.h>
+# include <sys/syscall.h>
+#endif
 
 #ifndef TEST_NET
 #define RAND_FILE_SIZE (25 * 1024 * 1024)
@@ -47,10 +51,13 @@ struct reader
         stream_t *s;
     } u;
     void *p_data;
+    block_t *p_block;
 
     void        (*pf_close)( struct reader * );
     uint64_t    (*pf_getsize)( struct reader * );
     ssize_t     (*pf_read)( struct reader *, void *, size_t );
+    ssize_t     (*pf_block)( struct reader *, void *, size_t );
+    ssize_t     (*pf_chain)( struct reader *, void *, size_t );
     ssize_t     (*pf_peek)( struct reader *, const uint8_t **, size_t );
     uint64_t    (*pf_tell)( struct reader * );
     int         (*pf_seek)( struct reader *, uint64_t );
@@ -131,6 +138,8 @@ libc_open( const char *psz_file )
     p_reader->pf_close = libc_close;
     p_reader->pf_getsize = libc_getsize;
     p_reader->pf_read = libc_read;
+    p_reader->pf_block = libc_read;
+    p_reader->pf_chain = libc_read;
     p_reader->pf_peek = libc_peek;
     p_reader->pf_tell = libc_tell;
     p_reader->pf_seek = libc_seek;
@@ -155,6 +164,33 @@ stream_read( struct reader *p_reader, void *p_buf, size_t i_len )
     return vlc_stream_Read( p_reader->u.s, p_buf, i_len );
 }
 
+static ssize_t
+stream_block( struct reader *p_reader, void *p_buf, size_t i_len )
+{
+    block_t *p_block = vlc_stream_Block( p_reader->u.s, i_len );
+
+    /* Keep the last block, its data must stay valid over the next reads */
+    if( p_reader->p_block )
+        block_ChainRelease( p_reader->p_block );
+    p_reader->p_block = p_block;
+    if( !p_block )
+        return 0;
+    memcpy( p_buf, p_block->p_buffer, p_block->i_buffer );
+    return p_block->i_buffer;
+}
+
+static ssize_t
+stream_chain( struct reader *p_reader, void *p_buf, size_t i_len )
+{
+    block_t *p_chain = vlc_stream_ReadChain( p_reader->u.s, i_len );
+
+    /* Keep the last chain, its data must stay valid over the next reads */
+    if( p_reader->p_block )
+        block_ChainRelease( p_reader->p_block );
+    p_reader->p_block = p_chain;
+    return block_ChainExtract( p_chain, p_buf, i_len );
+}
+
 static ssize_t
 stream_peek( struct reader *p_reader, const uint8_t **pp_buf, size_t i_len )
 {
@@ -177,12 +213,15 @@ static void
 stream_close( struct reader *p_reader )
 {
     vlc_stream_Delete( p_reader->u.s );
+    if( p_reader->p_block )
+        block_ChainRelease( p_reader->p_block );
     libvlc_release( p_reader->p_data );
     free( p_reader );
 }
 
 static struct reader *
-stream_open( const char *psz_url )
+stream_open( const char *psz_url, const char *psz_filter,
+             const char *psz_option )
 {
     libvlc_instance_t *p_vlc;
     struct reader *p_reader;
@@ -194,12 +233,14 @@ stream_open( const char *psz_url )
         "--no-media-library",
         "--vout=dummy",
         "--aout=dummy",
+        psz_option,
     };
+    int i_argc = sizeof(argv) / sizeof(argv[0]) - ( psz_option ? 0 : 1 );
 
     p_reader = calloc( 1, sizeof(struct reader) );
     assert( p_reader );
 
-    p_vlc = libvlc_new( sizeof(argv) / sizeof(argv[0]), argv );
+    p_vlc = libvlc_new( i_argc, argv );
     assert( p_vlc != NULL );
 
     p_reader->u.s = vlc_stream_NewURL( p_vlc->p_libvlc_int, psz_url );
@@ -209,20 +250,42 @@ stream_open( const char *psz_url )
         free( p_reader );
         return NULL;
     }
+    if( psz_filter )
+    {
+        stream_t *p_filter = vlc_stream_FilterNew( p_reader->u.s, psz_filter );
+        if( !p_filter )
+        {
+            vlc_stream_Delete( p_reader->u.s );
+            libvlc_release( p_vlc );
+            free( p_reader );
+            return NULL;
+        }
+        p_reader->u.s = p_filter;
+    }
     p_reader->pf_close = stream_close;
     p_reader->pf_getsize = stream_getsize;
     p_reader->pf_read = stream_read;
+    p_reader->pf_block = stream_block;
+    p_reader->pf_chain = stream_chain;
     p_reader->pf_peek = stream_peek;
     p_reader->pf_tell = stream_tell;
     p_reader->pf_seek = stream_seek;
     p_reader->p_data = p_vlc;
-    p_reader->psz_name = "stream";
+    p_reader->psz_name = psz_filter ? psz_filter
+                       : psz_option ? psz_option : "stream";
     return p_reader;
 }
 
+enum read_mode
+{
+    READ_BYTES,
+    READ_BLOCK,
+    READ_CHAIN,
+};
+
 static ssize_t
 read_at( struct reader **pp_readers, unsigned int i_readers,
-         void *p_buf, uint64_t i_offset,
+         void *p_buf, enum read_mode i_mode, uint64_t i_offset,
          size_t i_read, uint64_t i_size )
 {
     void *p_cmp_buf = NULL;
@@ -235,7 +298,9 @@ read_at( struct reader **pp_readers, unsigned int i_readers,
         struct reader *p_reader = pp_readers[i];
 
         log( "%s: %s %zu @ %"PRIu64" (size: %" PRIu64 ")\n", p_reader->psz_name,
-              p_buf ? "read" : "peek", i_read, i_offset, i_size );
+              !p_buf ? "peek" : i_mode == READ_BLOCK ? "block"
+                     : i_mode == READ_CHAIN ? "chain" : "read", i_read,
+              i_offset, i_size );
         assert( p_reader->pf_seek( p_reader, i_offset ) != -1 );
 
         i_last_pos = p_reader->pf_tell( p_reader );
@@ -243,7 +308,18 @@ read_at( struct reader **pp_readers, unsigned int i_readers,
 
         if( p_buf )
         {
-            i_ret = p_reader->pf_read( p_reader, p_buf, i_read );
+            switch( i_mode )
+            {
+                case READ_BLOCK:
+                    i_ret = p_reader->pf_block( p_reader, p_buf, i_read );
+                    break;
+                case READ_CHAIN:
+                    i_ret = p_reader->pf_chain( p_reader, p_buf, i_read );
+                    break;
+                default:
+                    i_ret = p_reader->pf_read( p_reader, p_buf, i_read );
+                    break;
+            }
             assert( i_ret >= 0 );
             assert( p_reader->pf_tell( p_reader ) == i_ret + i_last_pos );
         }
@@ -287,9 +363,13 @@ static void
 test( struct reader **pp_readers, unsigned int i_readers, const char *psz_md5 )
 {
 #define READ_AT( i_offset, i_read ) \
-    read_at( pp_readers, i_readers, p_buf, i_offset, i_read, i_size )
+    read_at( pp_readers, i_readers, p_buf, READ_BYTES, i_offset, i_read, i_size )
+#define BLOCK_AT( i_offset, i_read ) \
+    read_at( pp_readers, i_readers, p_buf, READ_BLOCK, i_offset, i_read, i_size )
+#define CHAIN_AT( i_offset, i_read ) \
+    read_at( pp_readers, i_readers, p_buf, READ_CHAIN, i_offset, i_read, i_size )
 #define PEEK_AT( i_offset, i_read ) \
-    read_at( pp_readers, i_readers, NULL, i_offset, i_read, i_size )
+    read_at( pp_readers, i_readers, NULL, READ_BYTES, i_offset, i_read, i_size )
     uint8_t p_buf[4096];
     ssize_t i_ret = 0;
     uint64_t i_offset = 0;
@@ -323,6 +403,21 @@ test( struct reader **pp_readers, unsigned int i_readers, const char *psz_md5 )
         free( psz_read_md5 );
     }
 
+    /* Read a part of the file in blocks of a size unrelated to the back-end
+     * one, and compare between each readers */
+    i_offset = 0;
+    while( i_offset < i_size / 4
+        && ( i_ret = BLOCK_AT( i_offset, 7 * 188 ) ) > 0 )
+        i_offset += i_ret;
+    BLOCK_AT( i_size - 100, 4096 );
+
+    /* Same with chains spanning several back-end blocks */
+    i_offset = i_size / 4;
+    while( i_offset < i_size / 2
+        && ( i_ret = CHAIN_AT( i_offset, 3 * 1024 + 17 ) ) > 0 )
+        i_offset += i_ret;
+    CHAIN_AT( i_size - 100, 4096 );
+
     /* Test cache skip */
     i_offset = 9 * i_size / 10;
     while( i_offset < i_size && ( i_ret = READ_AT( i_offset, 4096 ) ) > 0 )
@@ -360,40 +455,169 @@ fill_rand( int i_fd, size_t i_size )
     }
     assert( i_written == i_size );
 }
+
+/* Checks that the blocks of a mapped file are views of the mapping */
+static void
+test_mmap_views( const char *psz_url, int i_fd )
+{
+    struct reader *p_reader = stream_open( psz_url, NULL, "--file-mmap" );
+    assert( p_reader );
+
+    stream_t *s = p_reader->u.s;
+    const size_t i_len = 7 * 188;
+
+    assert( vlc_stream_Seek( s, 4096 ) == VLC_SUCCESS );
+    block_t *p_first = vlc_stream_Block( s, i_len );
+    block_t *p_second = vlc_stream_Block( s, i_len );
+    assert( p_first && p_first->i_buffer == i_len );
+    assert( p_second && p_second->i_buffer == i_len );
+    /* Separate copies could not be contiguous */
+    assert( p_second->p_buffer == p_first->p_buffer + i_len );
+
+    uint8_t p_buf[7 * 188];
+    assert( pread( i_fd, p_buf, i_len, 4096 ) == (ssize_t)i_len );
+    assert( memcmp( p_first->p_buffer, p_buf, i_len ) == 0 );
+
+    /* The views stay valid after the stream moves on */
+    block_Release( p_first );
+    assert( vlc_stream_Seek( s, 0 ) == VLC_SUCCESS );
+    p_first = vlc_stream_Block( s, i_len );
+    assert( p_first );
+    block_Release( p_first );
+    assert( pread( i_fd, p_buf, i_len, 4096 + i_len ) == (ssize_t)i_len );
+    assert( memcmp( p_second->p_buffer, p_buf, i_len ) == 0 );
+    block_Release( p_second );
+
+    p_reader->pf_close( p_reader );
+}
+
+#define SPLIT_COUNT 9
+
+/* Splits the file in parts of uneven sizes, and returns their list */
+static char *
+split_file( int i_fd, size_t i_size, char pp_paths[][19] )
+{
+    char *psz_list = NULL;
+    size_t i_offset = 0;
+
+    for( unsigned i = 0; i < SPLIT_COUNT; ++i )
+    {
+        size_t i_end = i + 1 < SPLIT_COUNT
+                     ? i_size / SPLIT_COUNT * (i + 1) + i * 1013 : i_size;
+        uint8_t p_buf[4096];
+
+        strcpy( pp_paths[i], "/tmp/libvlc_XXXXXX" );
+        int i_part_fd = vlc_mkstemp( pp_paths[i] );
+        assert( i_part_fd != -1 );
+        while( i_offset < i_end )
+        {
+            ssize_t i_ret = pread( i_fd, p_buf,
+                                   __MIN( i_end - i_offset, 4096 ), i_offset );
+            assert( i_ret > 0 );
+            assert( write( i_part_fd, p_buf, i_ret ) == i_ret );
+            i_offset += i_ret;
+        }
+        close( i_part_fd );
+
+        char *psz_prev = psz_list;
+        assert( asprintf( &psz_list, "%s%sfile://%s", psz_prev ? psz_prev : "",
+                          psz_prev ? "," : "", pp_paths[i] ) != -1 );
+        free( psz_prev );
+    }
+    return psz_list;
+}
 #endif
 
+/* Tells whether the kernel can set up an io_uring */
+static bool
+uring_supported( void )
+{
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+    struct io_uring_params params;
+
+    memset( &params, 0, sizeof(params) );
+    int i_fd = syscall( __NR_io_uring_setup, 1, &params );
+    if( i_fd == -1 )
+        return false;
+    close( i_fd );
+    return true;
+#else
+    return false;
+#endif
+}
+
+/* Returns the access at the bottom of a stream filter chain */
+static stream_t *
+stream_access( stream_t *s )
+{
+    while( s->s != NULL )
+        s = s->s;
+    return s;
+}
+
 int
 main( void )
 {
-    struct reader *pp_readers[3];
+    struct reader *pp_readers[6];
 
     test_init();
 
 #ifndef TEST_NET
     char psz_tmp_path[] = "/tmp/libvlc_XXXXXX";
-    char *psz_url;
+    char pp_split_paths[SPLIT_COUNT][19];
+    char *psz_url, *psz_split, *psz_concat;
     int i_tmp_fd;
 
-    log( "Test random file with libc, and stream\n" );
+    log( "Test random file with libc, stream, readahead, io_uring, mmap "
+         "and concat\n" );
     i_tmp_fd = vlc_mkstemp( psz_tmp_path );
     fill_rand( i_tmp_fd, RAND_FILE_SIZE );
     assert( i_tmp_fd != -1 );
     assert( asprintf( &psz_url, "file://%s", psz_tmp_path ) != -1 );
-
-    assert( ( pp_readers[0] = libc_open( psz_tmp_path ) ) );
-    assert( ( pp_readers[1] = stream_open( psz_url ) ) );
-
-    test( pp_readers, 2, NULL );
-    for( unsigned int i = 0; i < 2; ++i )
+    psz_split = split_file( i_tmp_fd, RAND_FILE_SIZE, pp_split_paths );
+    assert( asprintf( &psz_concat, "--concat-list=%s", psz_split ) != -1 );
+
+    unsigned int i_readers = 0;
+    assert( ( pp_readers[i_readers++] = libc_open( psz_tmp_path ) ) );
+    assert( ( pp_readers[i_readers++] = stream_open( psz_url, NULL, NULL ) ) );
+    assert( ( pp_readers[i_readers++] = stream_open( psz_url, "readahead",
+                                                     NULL ) ) );
+    if( uring_supported() )
+    {
+        struct reader *p_uring = stream_open( psz_url, NULL, "--file-uring" );
+        assert( p_uring );
+        /* The file input only returns blocks when it maps the file: this
+         * one must be the io_uring input, not its fallback */
+        stream_t *p_access = stream_access( p_uring->u.s );
+        assert( p_access->pf_block != NULL && p_access->pf_read == NULL );
+        pp_readers[i_readers++] = p_uring;
+    }
+    else
+        log( "io_uring not supported, skipping its reader\n" );
+    assert( ( pp_readers[i_readers++] = stream_open( psz_url, NULL,
+                                                     "--file-mmap" ) ) );
+    assert( ( pp_readers[i_readers] = stream_open( "list://", NULL,
+                                                   psz_concat ) ) );
+    pp_readers[i_readers++]->psz_name = "concat";
+
+    test( pp_readers, i_readers, NULL );
+    for( unsigned int i = 0; i < i_readers; ++i )
         pp_readers[i]->pf_close( pp_readers[i] );
+
+    log( "Test zero-copy blocks of a mapped file\n" );
+    test_mmap_views( psz_url, i_tmp_fd );
     free( psz_url );
+    free( psz_concat );
+    free( psz_split );
+    for( unsigned int i = 0; i < SPLIT_COUNT; ++i )
+        unlink( pp_split_paths[i] );
 
     close( i_tmp_fd );
 #else
 
     log( "Test http url with stream\n" );
     alarm( 0 );
-    if( !( pp_readers[0] = stream_open( HTTP_URL ) ) )
+    if( !( pp_readers[0] = stream_open( HTTP_URL, NULL, NULL ) ) )
     {
         log( "WARNING: can't test http url" );
         return 0;